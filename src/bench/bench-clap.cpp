@@ -0,0 +1,356 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+
+#include <clap/entry.h>
+#include <clap/ext/params.h>
+#include <clap/ext/state.h>
+#include <clap/factory/plugin-factory.h>
+#include <clap/plugin.h>
+
+// Generated inside of the build directory
+#include <config.h>
+#include <version.h>
+
+#include "../common/serialization/clap/events.h"
+#include "../common/serialization/clap/stream.h"
+#include "bench.h"
+
+// A minimal CLAP host for `yabridge-bench`. This loads the null plugin from
+// `null-plugin-clap.cpp` through `libyabridge-clap.so`. Parameter changes,
+// note events, and the transport are sent as part of the `clap_process_t`, so
+// this exercises yabridge's CLAP event serialization and the delta encoded
+// transport. yabridge's own event list and stream implementations are reused
+// for the host's side of things.
+
+namespace fs = ghc::filesystem;
+
+namespace {
+
+using ModuleInit = void* (*)(const char*);
+using ModuleFree = void (*)(void*);
+using ModuleGetFactory = const void* (*)(void*, const char*);
+
+class ClapBenchInstance : public BenchInstance {
+   public:
+    ClapBenchInstance(const clap_plugin_factory_t& factory,
+                      const char* plugin_id,
+                      const Options& options)
+        : BenchInstance(options),
+          host_(clap_host_t{
+              .clap_version = CLAP_VERSION_INIT,
+              .host_data = this,
+              .name = "yabridge-bench",
+              .vendor = "yabridge",
+              .url = "https://github.com/robbert-vdh/yabridge",
+              .version = yabridge_git_version,
+              .get_extension = host_get_extension,
+              .request_restart = host_request,
+              .request_process = host_request,
+              .request_callback = host_request,
+          }),
+          plugin_(factory.create_plugin(&factory, &host_, plugin_id)) {
+        if (!plugin_ || !plugin_->init(plugin_)) {
+            throw std::runtime_error(
+                "Could not initialize the CLAP null plugin through yabridge, "
+                "check the output above for more information");
+        }
+
+        params_ = static_cast<const clap_plugin_params_t*>(
+            plugin_->get_extension(plugin_, CLAP_EXT_PARAMS));
+        state_ext_ = static_cast<const clap_plugin_state_t*>(
+            plugin_->get_extension(plugin_, CLAP_EXT_STATE));
+        if (!params_ || !state_ext_) {
+            throw std::runtime_error(
+                "The CLAP null plugin does not implement the params and state "
+                "extensions");
+        }
+
+        const uint32_t num_params = params_->count(plugin_);
+        for (uint32_t i = 0; i < num_params; i++) {
+            clap_param_info_t info{};
+            if (params_->get_info(plugin_, i, &info)) {
+                param_ids_.push_back(info.id);
+            }
+        }
+    }
+
+    ~ClapBenchInstance() noexcept override {
+        if (active_) {
+            plugin_->deactivate(plugin_);
+        }
+        plugin_->destroy(plugin_);
+    }
+
+    void set_buffer_size(int buffer_size) override {
+        if (active_) {
+            plugin_->deactivate(plugin_);
+        }
+        active_ = plugin_->activate(plugin_, options_.sample_rate, 1,
+                                    static_cast<uint32_t>(buffer_size));
+        if (!active_) {
+            throw std::runtime_error("Could not activate the CLAP null plugin");
+        }
+
+        BenchInstance::set_buffer_size(buffer_size);
+
+        steady_time_ = 0;
+        transport_ = clap_event_transport_t{};
+        transport_.header = clap_event_header_t{
+            .size = sizeof(clap_event_transport_t),
+            .time = 0,
+            .space_id = CLAP_CORE_EVENT_SPACE_ID,
+            .type = CLAP_EVENT_TRANSPORT,
+            .flags = 0,
+        };
+        transport_.flags = CLAP_TRANSPORT_HAS_TEMPO |
+                           CLAP_TRANSPORT_HAS_BEATS_TIMELINE |
+                           CLAP_TRANSPORT_HAS_SECONDS_TIMELINE |
+                           CLAP_TRANSPORT_HAS_TIME_SIGNATURE |
+                           CLAP_TRANSPORT_IS_PLAYING;
+        transport_.tempo = 120.0;
+        transport_.tsig_num = 4;
+        transport_.tsig_denom = 4;
+    }
+
+   protected:
+    void start_processing() override { plugin_->start_processing(plugin_); }
+    void stop_processing() override { plugin_->stop_processing(plugin_); }
+
+    void process_cycle(int cycle) override {
+        // CLAP events need to be sorted by their timestamps, so the parameter
+        // changes all go at the start of the buffer
+        input_events_.clear();
+        for (size_t i = 0;
+             i < std::min(static_cast<size_t>(options_.automated_parameters),
+                          param_ids_.size());
+             i++) {
+            const clap_event_param_value_t event{
+                .header =
+                    clap_event_header_t{
+                        .size = sizeof(clap_event_param_value_t),
+                        .time = 0,
+                        .space_id = CLAP_CORE_EVENT_SPACE_ID,
+                        .type = CLAP_EVENT_PARAM_VALUE,
+                        .flags = 0,
+                    },
+                .param_id = param_ids_[i],
+                .cookie = nullptr,
+                .note_id = -1,
+                .port_index = -1,
+                .channel = -1,
+                .key = -1,
+                .value = static_cast<double>((cycle + i) % 100) / 100.0,
+            };
+            input_events_.push(event.header);
+        }
+
+        for (int i = 0; i < options_.midi_events; i++) {
+            const clap_event_note_t event{
+                .header =
+                    clap_event_header_t{
+                        .size = sizeof(clap_event_note_t),
+                        .time = static_cast<uint32_t>(
+                            (i * buffer_size_) / options_.midi_events),
+                        .space_id = CLAP_CORE_EVENT_SPACE_ID,
+                        .type = static_cast<uint16_t>(
+                            i % 2 == 0 ? CLAP_EVENT_NOTE_ON
+                                       : CLAP_EVENT_NOTE_OFF),
+                        .flags = 0,
+                    },
+                .note_id = -1,
+                .port_index = 0,
+                .channel = 0,
+                .key = static_cast<int16_t>(60 + (i / 2) % 12),
+                .velocity = i % 2 == 0 ? 0.8 : 0.0,
+            };
+            input_events_.push(event.header);
+        }
+
+        output_events_.clear();
+
+        clap_audio_buffer_t inputs{};
+        inputs.data32 = input_pointers_.data();
+        inputs.channel_count = num_channels;
+        clap_audio_buffer_t outputs{};
+        outputs.data32 = output_pointers_.data();
+        outputs.channel_count = num_channels;
+
+        const clap_process_t process{
+            .steady_time = steady_time_,
+            .frames_count = static_cast<uint32_t>(buffer_size_),
+            .transport = &transport_,
+            .audio_inputs = &inputs,
+            .audio_outputs = &outputs,
+            .audio_inputs_count = 1,
+            .audio_outputs_count = 1,
+            .in_events = input_events_.input_events(),
+            .out_events = output_events_.output_events(),
+        };
+
+        plugin_->process(plugin_, &process);
+
+        echoed_midi_events_.fetch_add(output_events_.size(),
+                                      std::memory_order_relaxed);
+
+        steady_time_ += buffer_size_;
+
+        const double seconds = buffer_size_ / options_.sample_rate;
+        seconds_ += seconds;
+        beats_ += seconds * (transport_.tempo / 60.0);
+        transport_.song_pos_seconds =
+            static_cast<clap_sectime>(seconds_ * CLAP_SECTIME_FACTOR);
+        transport_.song_pos_beats =
+            static_cast<clap_beattime>(beats_ * CLAP_BEATTIME_FACTOR);
+    }
+
+    void save_state() override {
+        state_.emplace();
+        state_ext_->save(plugin_, state_->ostream());
+    }
+
+    void load_state() override {
+        // The stream's read position cannot be rewound, so the plugin reads
+        // from a fresh copy every time
+        clap::stream::Stream stream = *state_;
+        state_ext_->load(plugin_, stream.istream());
+    }
+
+   private:
+    static const void* CLAP_ABI
+    host_get_extension(const clap_host_t* /*host*/,
+                       const char* /*extension_id*/) {
+        return nullptr;
+    }
+
+    static void CLAP_ABI host_request(const clap_host_t* /*host*/) {}
+
+    clap_host_t host_;
+    const clap_plugin_t* plugin_;
+
+    const clap_plugin_params_t* params_ = nullptr;
+    const clap_plugin_state_t* state_ext_ = nullptr;
+
+    std::vector<clap_id> param_ids_;
+
+    bool active_ = false;
+
+    int64_t steady_time_ = 0;
+    double seconds_ = 0.0;
+    double beats_ = 0.0;
+    clap_event_transport_t transport_{};
+
+    clap::events::EventList input_events_;
+    clap::events::EventList output_events_;
+
+    std::optional<clap::stream::Stream> state_;
+};
+
+class ClapBenchPlugin : public BenchPlugin {
+   public:
+    ClapBenchPlugin(ModuleFree module_free,
+                    void* bridge,
+                    const clap_plugin_factory_t& factory)
+        : module_free_(module_free), bridge_(bridge), factory_(factory) {
+        // The null plugin only contains a single plugin
+        const clap_plugin_descriptor_t* descriptor =
+            factory_.get_plugin_count(&factory_) > 0
+                ? factory_.get_plugin_descriptor(&factory_, 0)
+                : nullptr;
+        if (!descriptor) {
+            throw std::runtime_error(
+                "The CLAP null plugin does not contain any plugins");
+        }
+
+        plugin_id_ = descriptor->id;
+    }
+
+    ~ClapBenchPlugin() noexcept override { module_free_(bridge_); }
+
+    std::unique_ptr<BenchInstance> create_instance(
+        const Options& options) override {
+        return std::make_unique<ClapBenchInstance>(factory_, plugin_id_.c_str(),
+                                                   options);
+    }
+
+   private:
+    ModuleFree module_free_;
+    void* bridge_;
+    const clap_plugin_factory_t& factory_;
+
+    std::string plugin_id_;
+};
+
+}  // namespace
+
+std::unique_ptr<BenchPlugin> load_clap_plugin(const Options& options,
+                                              const fs::path& directory) {
+    const fs::path yabridge_path =
+        options.build_directory / yabridge_clap_plugin_name;
+    void* yabridge_library = dlopen(yabridge_path.c_str(), RTLD_NOW);
+    if (!yabridge_library) {
+        throw std::runtime_error("Could not load '" + yabridge_path.string() +
+                                 "': " + dlerror());
+    }
+
+    // These are the same functions the chainloaders use. That lets us pass the
+    // path to the plugin directly, instead of relying on the location of the
+    // library like `clap_entry` does.
+    const auto module_init = reinterpret_cast<ModuleInit>(
+        dlsym(yabridge_library, "yabridge_module_init"));
+    const auto module_free = reinterpret_cast<ModuleFree>(
+        dlsym(yabridge_library, "yabridge_module_free"));
+    const auto module_get_factory = reinterpret_cast<ModuleGetFactory>(
+        dlsym(yabridge_library, "yabridge_module_get_factory"));
+    if (!module_init || !module_free || !module_get_factory) {
+        throw std::runtime_error("'" + yabridge_path.string() +
+                                 "' does not export the chainloader functions");
+    }
+
+    // yabridge finds the Windows plugin by replacing the `.clap` extension of
+    // the native plugin's path with `.clap-win`
+    const fs::path plugin_path =
+        directory / (std::string(null_plugin_name) + ".clap");
+    fs::create_symlink(yabridge_path, plugin_path);
+    fs::create_symlink(
+        options.build_directory /
+            (std::string(null_plugin_name) + "-clap.clap-win"),
+        directory / (std::string(null_plugin_name) + ".clap-win"));
+
+    void* bridge = module_init(plugin_path.c_str());
+    if (!bridge) {
+        throw std::runtime_error(
+            "Could not initialize yabridge's CLAP plugin, check the output "
+            "above for more information");
+    }
+
+    const auto factory = static_cast<const clap_plugin_factory_t*>(
+        module_get_factory(bridge, CLAP_PLUGIN_FACTORY_ID));
+    if (!factory) {
+        module_free(bridge);
+        throw std::runtime_error(
+            "yabridge's CLAP plugin does not provide a plugin factory");
+    }
+
+    return std::make_unique<ClapBenchPlugin>(module_free, bridge, *factory);
+}
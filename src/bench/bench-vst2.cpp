@@ -0,0 +1,249 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+
+#include <vestige/aeffectx.h>
+
+// Generated inside of the build directory
+#include <config.h>
+
+#include "bench.h"
+
+// A minimal VST2 host for `yabridge-bench`. This loads the null plugin from
+// `null-plugin.cpp` through `libyabridge-vst2.so`.
+
+namespace fs = ghc::filesystem;
+
+namespace {
+
+using PluginInit = AEffect* (*)(audioMasterCallback, const char*);
+
+class Vst2BenchInstance : public BenchInstance {
+   public:
+    Vst2BenchInstance(PluginInit plugin_init,
+                      const fs::path& plugin_path,
+                      const Options& options)
+        : BenchInstance(options),
+          effect_(plugin_init(host_callback, plugin_path.c_str())) {
+        if (!effect_) {
+            throw std::runtime_error(
+                "Could not initialize the VST2 null plugin through yabridge, "
+                "check the output above for more information");
+        }
+        if (effect_->numInputs != num_channels ||
+            effect_->numOutputs != num_channels) {
+            throw std::runtime_error("Unexpected channel layout");
+        }
+
+        // The `resvd1` field is reserved for the host
+        effect_->ptr1 = this;
+
+        effect_->dispatcher(effect_, effOpen, 0, 0, nullptr, 0.0f);
+        effect_->dispatcher(effect_, effSetSampleRate, 0, 0, nullptr,
+                            static_cast<float>(options_.sample_rate));
+
+        midi_events_.resize(options_.midi_events);
+        events_buffer_.resize(sizeof(VstEvents) +
+                              sizeof(VstEvent*) * options_.midi_events);
+    }
+
+    ~Vst2BenchInstance() noexcept override {
+        effect_->dispatcher(effect_, effMainsChanged, 0, 0, nullptr, 0.0f);
+        effect_->dispatcher(effect_, effClose, 0, 0, nullptr, 0.0f);
+    }
+
+    void set_buffer_size(int buffer_size) override {
+        effect_->dispatcher(effect_, effMainsChanged, 0, 0, nullptr, 0.0f);
+        effect_->dispatcher(effect_, effSetBlockSize, 0, buffer_size, nullptr,
+                            0.0f);
+        effect_->dispatcher(effect_, effMainsChanged, 0, 1, nullptr, 0.0f);
+
+        BenchInstance::set_buffer_size(buffer_size);
+
+        time_info_ = VstTimeInfo{};
+        time_info_.sampleRate = options_.sample_rate;
+        time_info_.tempo = 120.0;
+        time_info_.timeSigNumerator = 4;
+        time_info_.timeSigDenominator = 4;
+        time_info_.flags = kVstTransportPlaying | kVstPpqPosValid |
+                           kVstTempoValid | kVstTimeSigValid;
+    }
+
+   protected:
+    void process_cycle(int cycle) override {
+        for (int i = 0;
+             i < std::min(options_.automated_parameters, effect_->numParams);
+             i++) {
+            effect_->setParameter(
+                effect_, i, static_cast<float>((cycle + i) % 100) / 100.0f);
+        }
+
+        if (options_.midi_events > 0) {
+            auto& events =
+                *reinterpret_cast<VstEvents*>(events_buffer_.data());
+            events.numEvents = options_.midi_events;
+            events.reserved = nullptr;
+            for (int i = 0; i < options_.midi_events; i++) {
+                VstMidiEvent& event = midi_events_[i];
+                event = VstMidiEvent{};
+                event.type = kVstMidiType;
+                event.byteSize = sizeof(VstMidiEvent);
+                event.deltaFrames = (i * buffer_size_) / options_.midi_events;
+                event.midiData[0] = static_cast<char>(i % 2 == 0 ? 0x90 : 0x80);
+                event.midiData[1] = static_cast<char>(60 + (i / 2) % 12);
+                event.midiData[2] = 100;
+
+                events.events[i] = reinterpret_cast<VstEvent*>(&event);
+            }
+
+            effect_->dispatcher(effect_, effProcessEvents, 0, 0, &events,
+                                0.0f);
+        }
+
+        effect_->processReplacing(effect_, input_pointers_.data(),
+                                  output_pointers_.data(), buffer_size_);
+
+        time_info_.samplePos += buffer_size_;
+        time_info_.ppqPos += (buffer_size_ / options_.sample_rate) *
+                             (time_info_.tempo / 60.0);
+    }
+
+    void save_state() override {
+        void* chunk_data = nullptr;
+        const intptr_t chunk_size = effect_->dispatcher(
+            effect_, effGetChunk, 0, 0, &chunk_data, 0.0f);
+
+        chunk_.assign(static_cast<char*>(chunk_data),
+                      static_cast<char*>(chunk_data) + chunk_size);
+    }
+
+    void load_state() override {
+        effect_->dispatcher(effect_, effSetChunk, 0, chunk_.size(),
+                            chunk_.data(), 0.0f);
+    }
+
+   private:
+    static intptr_t host_callback(AEffect* effect,
+                                  int opcode,
+                                  int /*index*/,
+                                  intptr_t /*value*/,
+                                  void* data,
+                                  float /*option*/) {
+        Vst2BenchInstance* instance =
+            effect ? static_cast<Vst2BenchInstance*>(effect->ptr1) : nullptr;
+
+        switch (opcode) {
+            case audioMasterVersion:
+                return 2400;
+            case audioMasterGetTime:
+                return instance
+                           ? reinterpret_cast<intptr_t>(&instance->time_info_)
+                           : 0;
+            case audioMasterProcessEvents:
+                if (instance) {
+                    instance->echoed_midi_events_.fetch_add(
+                        static_cast<VstEvents*>(data)->numEvents,
+                        std::memory_order_relaxed);
+                }
+                return 1;
+            case audioMasterGetSampleRate:
+                return instance ? static_cast<intptr_t>(
+                                      instance->options_.sample_rate)
+                                : 0;
+            case audioMasterGetBlockSize:
+                return instance ? instance->buffer_size_ : 0;
+            case audioMasterGetCurrentProcessLevel:
+                // Realtime
+                return 2;
+            case audioMasterGetProductString:
+                std::strcpy(static_cast<char*>(data), "yabridge-bench");
+                return 1;
+            case audioMasterGetVendorString:
+                std::strcpy(static_cast<char*>(data), "yabridge");
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    AEffect* effect_;
+
+    VstTimeInfo time_info_{};
+
+    std::vector<VstMidiEvent> midi_events_;
+    /**
+     * Storage for the variable length `VstEvents` struct.
+     */
+    std::vector<char> events_buffer_;
+
+    std::vector<char> chunk_;
+};
+
+class Vst2BenchPlugin : public BenchPlugin {
+   public:
+    Vst2BenchPlugin(PluginInit plugin_init, fs::path plugin_path)
+        : plugin_init_(plugin_init), plugin_path_(std::move(plugin_path)) {}
+
+    std::unique_ptr<BenchInstance> create_instance(
+        const Options& options) override {
+        return std::make_unique<Vst2BenchInstance>(plugin_init_, plugin_path_,
+                                                   options);
+    }
+
+   private:
+    PluginInit plugin_init_;
+    fs::path plugin_path_;
+};
+
+}  // namespace
+
+std::unique_ptr<BenchPlugin> load_vst2_plugin(const Options& options,
+                                              const fs::path& directory) {
+    const fs::path yabridge_path =
+        options.build_directory / yabridge_vst2_plugin_name;
+    void* yabridge_library = dlopen(yabridge_path.c_str(), RTLD_NOW);
+    if (!yabridge_library) {
+        throw std::runtime_error("Could not load '" + yabridge_path.string() +
+                                 "': " + dlerror());
+    }
+
+    const auto plugin_init = reinterpret_cast<PluginInit>(
+        dlsym(yabridge_library, "yabridge_plugin_init"));
+    if (!plugin_init) {
+        throw std::runtime_error("'" + yabridge_path.string() +
+                                 "' does not export 'yabridge_plugin_init()'");
+    }
+
+    // yabridge finds the Windows plugin by replacing the extension of the
+    // native plugin library's path with `.dll`. The symlink to
+    // `libyabridge-vst2.so` gets resolved when searching for
+    // `yabridge-host.exe`, so that will be found in the build directory.
+    const fs::path plugin_path =
+        directory / (std::string(null_plugin_name) + ".so");
+    fs::create_symlink(yabridge_path, plugin_path);
+    fs::create_symlink(
+        options.build_directory / (std::string(null_plugin_name) + ".dll"),
+        directory / (std::string(null_plugin_name) + ".dll"));
+
+    return std::make_unique<Vst2BenchPlugin>(plugin_init, plugin_path);
+}
@@ -0,0 +1,370 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <dlfcn.h>
+
+#include <pluginterfaces/base/ipluginbase.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivsthostapplication.h>
+#include <pluginterfaces/vst/ivstprocesscontext.h>
+
+// Generated inside of the build directory
+#include <config.h>
+
+#include "../common/serialization/vst3/bstream.h"
+#include "../common/serialization/vst3/event-list.h"
+#include "../common/serialization/vst3/parameter-changes.h"
+#include "bench.h"
+
+// A minimal VST3 host for `yabridge-bench`. This loads the null plugin from
+// `null-plugin-vst3.cpp` through `libyabridge-vst3.so`. Unlike the VST2 host,
+// parameter changes and MIDI events are sent as part of the `ProcessData`
+// object, so this exercises yabridge's `YaProcessData` serialization and the
+// delta encoded `ProcessContext`. yabridge's own implementations of the
+// parameter change, event list, and stream interfaces are reused as the
+// host's objects here, just like in the serialization benchmark.
+
+namespace fs = ghc::filesystem;
+
+namespace {
+
+using ModuleInit = void* (*)(const char*);
+using ModuleFree = void (*)(void*);
+using ModuleGetPluginFactory = Steinberg::IPluginFactory* (*)(void*);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+
+/**
+ * The host context passed to `IPluginBase::initialize()`. yabridge requires a
+ * host context, and the null plugin never calls back into it.
+ */
+class BenchHostApplication : public Steinberg::Vst::IHostApplication {
+   public:
+    BenchHostApplication() noexcept {FUNKNOWN_CTOR}
+    virtual ~BenchHostApplication() noexcept {FUNKNOWN_DTOR}
+
+    DECLARE_FUNKNOWN_METHODS
+
+    tresult PLUGIN_API getName(Steinberg::Vst::String128 name) override {
+        constexpr char16_t host_name[] = u"yabridge-bench";
+        std::copy(std::begin(host_name), std::end(host_name), name);
+
+        return Steinberg::kResultOk;
+    }
+
+    tresult PLUGIN_API createInstance(Steinberg::TUID /*cid*/,
+                                      Steinberg::TUID /*_iid*/,
+                                      void** obj) override {
+        *obj = nullptr;
+
+        return Steinberg::kNotImplemented;
+    }
+};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
+IMPLEMENT_FUNKNOWN_METHODS(BenchHostApplication,
+                           Steinberg::Vst::IHostApplication,
+                           Steinberg::Vst::IHostApplication::iid)
+#pragma GCC diagnostic pop
+
+#pragma GCC diagnostic pop
+
+class Vst3BenchInstance : public BenchInstance {
+   public:
+    Vst3BenchInstance(Steinberg::IPluginFactory& factory,
+                      const Steinberg::TUID cid,
+                      Steinberg::FUnknown* host_context,
+                      const Options& options)
+        : BenchInstance(options) {
+        Steinberg::Vst::IComponent* component = nullptr;
+        if (factory.createInstance(cid, Steinberg::Vst::IComponent::iid,
+                                   reinterpret_cast<void**>(&component)) !=
+                Steinberg::kResultOk ||
+            !component) {
+            throw std::runtime_error(
+                "Could not initialize the VST3 null plugin through yabridge, "
+                "check the output above for more information");
+        }
+        component_ = Steinberg::owned(component);
+
+        // The null plugin implements the processor and the edit controller in
+        // a single object
+        processor_ =
+            Steinberg::FUnknownPtr<Steinberg::Vst::IAudioProcessor>(component_);
+        edit_controller_ =
+            Steinberg::FUnknownPtr<Steinberg::Vst::IEditController>(component_);
+        if (!processor_ || !edit_controller_) {
+            throw std::runtime_error(
+                "The VST3 null plugin does not implement 'IAudioProcessor' and "
+                "'IEditController'");
+        }
+
+        if (component_->initialize(host_context) != Steinberg::kResultOk) {
+            throw std::runtime_error(
+                "Could not initialize the VST3 null plugin");
+        }
+
+        for (const auto direction :
+             {Steinberg::Vst::kInput, Steinberg::Vst::kOutput}) {
+            component_->activateBus(Steinberg::Vst::kAudio, direction, 0, true);
+            component_->activateBus(Steinberg::Vst::kEvent, direction, 0, true);
+        }
+
+        num_parameters_ = edit_controller_->getParameterCount();
+    }
+
+    ~Vst3BenchInstance() noexcept override {
+        processor_->setProcessing(false);
+        component_->setActive(false);
+        component_->terminate();
+    }
+
+    void set_buffer_size(int buffer_size) override {
+        processor_->setProcessing(false);
+        component_->setActive(false);
+
+        Steinberg::Vst::ProcessSetup setup{
+            .processMode = Steinberg::Vst::kRealtime,
+            .symbolicSampleSize = Steinberg::Vst::kSample32,
+            .maxSamplesPerBlock = buffer_size,
+            .sampleRate = options_.sample_rate};
+        processor_->setupProcessing(setup);
+
+        component_->setActive(true);
+        processor_->setProcessing(true);
+
+        BenchInstance::set_buffer_size(buffer_size);
+
+        process_context_ = Steinberg::Vst::ProcessContext{};
+        process_context_.state =
+            Steinberg::Vst::ProcessContext::kPlaying |
+            Steinberg::Vst::ProcessContext::kProjectTimeMusicValid |
+            Steinberg::Vst::ProcessContext::kTempoValid |
+            Steinberg::Vst::ProcessContext::kTimeSigValid;
+        process_context_.sampleRate = options_.sample_rate;
+        process_context_.tempo = 120.0;
+        process_context_.timeSigNumerator = 4;
+        process_context_.timeSigDenominator = 4;
+    }
+
+   protected:
+    void process_cycle(int cycle) override {
+        input_parameter_changes_.clear();
+        for (int i = 0; i < std::min(options_.automated_parameters,
+                                     static_cast<int>(num_parameters_));
+             i++) {
+            int32 queue_index;
+            Steinberg::Vst::IParamValueQueue* queue =
+                input_parameter_changes_.addParameterData(
+                    static_cast<Steinberg::Vst::ParamID>(i), queue_index);
+
+            int32 point_index;
+            queue->addPoint(0, static_cast<double>((cycle + i) % 100) / 100.0,
+                            point_index);
+        }
+
+        input_events_.clear();
+        for (int i = 0; i < options_.midi_events; i++) {
+            Steinberg::Vst::Event event{};
+            event.sampleOffset = (i * buffer_size_) / options_.midi_events;
+            if (i % 2 == 0) {
+                event.type = Steinberg::Vst::Event::kNoteOnEvent;
+                event.noteOn.pitch = static_cast<int16>(60 + (i / 2) % 12);
+                event.noteOn.velocity = 0.8f;
+                event.noteOn.noteId = -1;
+            } else {
+                event.type = Steinberg::Vst::Event::kNoteOffEvent;
+                event.noteOff.pitch = static_cast<int16>(60 + (i / 2) % 12);
+                event.noteOff.velocity = 0.0f;
+                event.noteOff.noteId = -1;
+            }
+
+            input_events_.addEvent(event);
+        }
+
+        output_parameter_changes_.clear();
+        output_events_.clear();
+
+        Steinberg::Vst::AudioBusBuffers inputs{};
+        inputs.numChannels = num_channels;
+        inputs.channelBuffers32 = input_pointers_.data();
+        Steinberg::Vst::AudioBusBuffers outputs{};
+        outputs.numChannels = num_channels;
+        outputs.channelBuffers32 = output_pointers_.data();
+
+        Steinberg::Vst::ProcessData data{};
+        data.processMode = Steinberg::Vst::kRealtime;
+        data.symbolicSampleSize = Steinberg::Vst::kSample32;
+        data.numSamples = buffer_size_;
+        data.numInputs = 1;
+        data.numOutputs = 1;
+        data.inputs = &inputs;
+        data.outputs = &outputs;
+        data.inputParameterChanges = &input_parameter_changes_;
+        data.outputParameterChanges = &output_parameter_changes_;
+        data.inputEvents = &input_events_;
+        data.outputEvents = &output_events_;
+        data.processContext = &process_context_;
+
+        processor_->process(data);
+
+        echoed_midi_events_.fetch_add(output_events_.getEventCount(),
+                                      std::memory_order_relaxed);
+
+        process_context_.projectTimeSamples += buffer_size_;
+        process_context_.projectTimeMusic +=
+            (buffer_size_ / options_.sample_rate) *
+            (process_context_.tempo / 60.0);
+    }
+
+    void save_state() override {
+        state_.emplace();
+        component_->getState(&*state_);
+    }
+
+    void load_state() override {
+        state_->seek(0, Steinberg::IBStream::kIBSeekSet, nullptr);
+        component_->setState(&*state_);
+    }
+
+   private:
+    Steinberg::IPtr<Steinberg::Vst::IComponent> component_;
+    Steinberg::FUnknownPtr<Steinberg::Vst::IAudioProcessor> processor_;
+    Steinberg::FUnknownPtr<Steinberg::Vst::IEditController> edit_controller_;
+
+    int32 num_parameters_ = 0;
+
+    Steinberg::Vst::ProcessContext process_context_{};
+
+    YaParameterChanges input_parameter_changes_;
+    YaParameterChanges output_parameter_changes_;
+    YaEventList input_events_;
+    YaEventList output_events_;
+
+    std::optional<YaBStream> state_;
+};
+
+class Vst3BenchPlugin : public BenchPlugin {
+   public:
+    Vst3BenchPlugin(ModuleFree module_free,
+                    void* bridge,
+                    Steinberg::IPtr<Steinberg::IPluginFactory> factory)
+        : module_free_(module_free),
+          bridge_(bridge),
+          factory_(std::move(factory)) {
+        // The null plugin only has a single audio effect class
+        const int32 num_classes = factory_->countClasses();
+        for (int32 i = 0; i < num_classes; i++) {
+            Steinberg::PClassInfo info{};
+            if (factory_->getClassInfo(i, &info) == Steinberg::kResultOk &&
+                std::strcmp(info.category, kVstAudioEffectClass) == 0) {
+                std::copy(std::begin(info.cid), std::end(info.cid),
+                          std::begin(cid_));
+                return;
+            }
+        }
+
+        throw std::runtime_error(
+            "The VST3 null plugin does not contain an audio effect class");
+    }
+
+    ~Vst3BenchPlugin() noexcept override {
+        factory_ = nullptr;
+        module_free_(bridge_);
+    }
+
+    std::unique_ptr<BenchInstance> create_instance(
+        const Options& options) override {
+        return std::make_unique<Vst3BenchInstance>(*factory_, cid_,
+                                                   &host_application_, options);
+    }
+
+   private:
+    ModuleFree module_free_;
+    void* bridge_;
+    Steinberg::IPtr<Steinberg::IPluginFactory> factory_;
+
+    Steinberg::TUID cid_{};
+    BenchHostApplication host_application_;
+};
+
+}  // namespace
+
+std::unique_ptr<BenchPlugin> load_vst3_plugin(const Options& options,
+                                              const fs::path& directory) {
+    const fs::path yabridge_path =
+        options.build_directory / yabridge_vst3_plugin_name;
+    void* yabridge_library = dlopen(yabridge_path.c_str(), RTLD_NOW);
+    if (!yabridge_library) {
+        throw std::runtime_error("Could not load '" + yabridge_path.string() +
+                                 "': " + dlerror());
+    }
+
+    // These are the same functions the chainloaders use. That lets us pass the
+    // path to the plugin bundle directly, instead of relying on the location
+    // of the library like `ModuleEntry()` does.
+    const auto module_init = reinterpret_cast<ModuleInit>(
+        dlsym(yabridge_library, "yabridge_module_init"));
+    const auto module_free = reinterpret_cast<ModuleFree>(
+        dlsym(yabridge_library, "yabridge_module_free"));
+    const auto module_get_plugin_factory =
+        reinterpret_cast<ModuleGetPluginFactory>(
+            dlsym(yabridge_library, "yabridge_module_get_plugin_factory"));
+    if (!module_init || !module_free || !module_get_plugin_factory) {
+        throw std::runtime_error("'" + yabridge_path.string() +
+                                 "' does not export the chainloader functions");
+    }
+
+    // yabridge's VST3 plugins need to be inside of a bundle, with the Windows
+    // plugin in `Contents/x86_64-win`
+    const fs::path bundle_contents =
+        directory / (std::string(null_plugin_name) + ".vst3") / "Contents";
+    fs::create_directories(bundle_contents / "x86_64-linux");
+    fs::create_directories(bundle_contents / "x86_64-win");
+
+    const fs::path plugin_path = bundle_contents / "x86_64-linux" /
+                                 (std::string(null_plugin_name) + ".so");
+    fs::create_symlink(yabridge_path, plugin_path);
+    fs::create_symlink(
+        options.build_directory /
+            (std::string(null_plugin_name) + "-vst3.vst3"),
+        bundle_contents / "x86_64-win" /
+            (std::string(null_plugin_name) + ".vst3"));
+
+    void* bridge = module_init(plugin_path.c_str());
+    if (!bridge) {
+        throw std::runtime_error(
+            "Could not initialize yabridge's VST3 plugin, check the output "
+            "above for more information");
+    }
+
+    // The returned factory already has a reference for us
+    Steinberg::IPtr<Steinberg::IPluginFactory> factory =
+        Steinberg::owned(module_get_plugin_factory(bridge));
+
+    return std::make_unique<Vst3BenchPlugin>(module_free, bridge,
+                                             std::move(factory));
+}
@@ -0,0 +1,468 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Generated inside of the build directory
+#include <version.h>
+
+#include "bench.h"
+#include "latency-summary.h"
+
+// `yabridge-bench` is a minimal headless VST2, VST3, and CLAP host that loads
+// yabridge's plugin libraries together with the null plugins from
+// `null-plugin{,-vst3,-clap}.cpp`, and measures how long yabridge takes to
+// bridge audio processing calls. Since the null plugins do virtually no work,
+// these timings are a direct measure of yabridge's own overhead. The results
+// are written to STDOUT as JSON so they can be compared between builds, while
+// progress is written to STDERR. The format specific hosts can be found in
+// `bench-{vst2,vst3,clap}.cpp`.
+//
+// This does not need a display server or any plugin besides the null plugins,
+// so it can run on a headless machine with only Wine installed.
+
+namespace fs = ghc::filesystem;
+
+BenchInstance::BenchInstance(const Options& options) : options_(options) {}
+
+void BenchInstance::set_buffer_size(int buffer_size) {
+    buffer_size_ = buffer_size;
+    inputs_.assign(num_channels, std::vector<float>(buffer_size, 0.0f));
+    outputs_.assign(num_channels, std::vector<float>(buffer_size, 0.0f));
+    for (int channel = 0; channel < num_channels; channel++) {
+        input_pointers_[channel] = inputs_[channel].data();
+        output_pointers_[channel] = outputs_[channel].data();
+
+        // Some noise, so we're not just processing silence
+        for (int sample = 0; sample < buffer_size; sample++) {
+            inputs_[channel][sample] =
+                std::sin(static_cast<float>(sample + channel) * 0.1f);
+        }
+    }
+}
+
+void BenchInstance::run() {
+    durations_ns_.clear();
+    durations_ns_.reserve(options_.cycles);
+    echoed_midi_events_.store(0, std::memory_order_relaxed);
+
+    start_processing();
+    for (int cycle = 0; cycle < options_.warmup_cycles + options_.cycles;
+         cycle++) {
+        const auto start = std::chrono::steady_clock::now();
+        process_cycle(cycle);
+        const auto end = std::chrono::steady_clock::now();
+
+        if (cycle >= options_.warmup_cycles) {
+            durations_ns_.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                     start)
+                    .count());
+        }
+    }
+    stop_processing();
+}
+
+void BenchInstance::run_state(std::vector<uint64_t>& save_state_ns,
+                              std::vector<uint64_t>& load_state_ns) {
+    for (int i = 0; i < options_.state_cycles; i++) {
+        const auto save_start = std::chrono::steady_clock::now();
+        save_state();
+        const auto save_end = std::chrono::steady_clock::now();
+
+        const auto load_start = std::chrono::steady_clock::now();
+        load_state();
+        const auto load_end = std::chrono::steady_clock::now();
+
+        save_state_ns.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(save_end -
+                                                                 save_start)
+                .count());
+        load_state_ns.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(load_end -
+                                                                 load_start)
+                .count());
+    }
+}
+
+namespace {
+
+/**
+ * The results for a single combination of plugin format, instance count, and
+ * buffer size.
+ */
+struct ProcessResult {
+    std::string format;
+    int instances;
+    int buffer_size;
+    LatencySummary latency_us;
+    /**
+     * The number of processing cycles completed per second, summed over all
+     * instances.
+     */
+    double cycles_per_second;
+    /**
+     * How much faster than real time the instances processed audio. If this
+     * drops below 1 then a host with this many instances would produce xruns.
+     */
+    double realtime_factor;
+    uint64_t echoed_midi_events;
+};
+
+/**
+ * The time it took to save and restore a plugin's state in a single plugin
+ * format.
+ */
+struct StateResult {
+    std::string format;
+    LatencySummary save_us;
+    LatencySummary load_us;
+};
+
+/**
+ * Parse a comma separated list of positive integers.
+ */
+std::vector<int> parse_int_list(const std::string& value) {
+    std::vector<int> result;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        const int number = std::stoi(item);
+        if (number <= 0) {
+            throw std::invalid_argument("'" + item +
+                                        "' is not a positive integer");
+        }
+
+        result.push_back(number);
+    }
+
+    return result;
+}
+
+/**
+ * Parse a comma separated list of plugin formats.
+ */
+std::vector<std::string> parse_format_list(const std::string& value) {
+    std::vector<std::string> result;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item != "vst2"
+#ifdef WITH_VST3
+            && item != "vst3"
+#endif
+#ifdef WITH_CLAP
+            && item != "clap"
+#endif
+        ) {
+            throw std::invalid_argument("'" + item +
+                                        "' is not a supported plugin format");
+        }
+
+        result.push_back(item);
+    }
+
+    return result;
+}
+
+void print_usage(const char* program_name) {
+    std::cerr
+        << "yabridge benchmark version " << yabridge_git_version << "\n\n"
+        << "Usage: " << program_name << " [options]\n\n"
+        << "Options:\n"
+        << "  --build-directory <dir>  Directory containing yabridge's plugin\n"
+        << "                           libraries, yabridge-host.exe and the\n"
+        << "                           null plugins\n"
+        << "  --formats <format,...>   Plugin formats to test, out of vst2"
+#ifdef WITH_VST3
+        << ", vst3"
+#endif
+#ifdef WITH_CLAP
+        << ", clap"
+#endif
+        << "\n"
+        << "  --instances <n,...>      Instance counts to test\n"
+        << "  --buffer-sizes <n,...>   Buffer sizes to test\n"
+        << "  --sample-rate <hz>       Sample rate\n"
+        << "  --cycles <n>             Measured processing cycles per run\n"
+        << "  --warmup-cycles <n>      Unmeasured cycles before every run\n"
+        << "  --parameters <n>         Number of parameters on the plugin\n"
+        << "  --automated-parameters <n>\n"
+        << "                           Parameters changed every cycle\n"
+        << "  --midi-events <n>        MIDI events sent every cycle\n"
+        << "  --state-size <bytes>     Size of the plugin's state\n"
+        << "  --state-cycles <n>       Number of state save/restore cycles\n"
+        << std::flush;
+}
+
+Options parse_options(int argc, char* argv[]) {
+    Options options{};
+    options.build_directory = fs::canonical("/proc/self/exe").parent_path();
+    options.formats = {"vst2"};
+#ifdef WITH_VST3
+    options.formats.push_back("vst3");
+#endif
+#ifdef WITH_CLAP
+    options.formats.push_back("clap");
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        const std::string argument(argv[i]);
+        if (argument == "--help" || argument == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for '" + argument + "'");
+        }
+
+        const std::string value(argv[++i]);
+        if (argument == "--build-directory") {
+            options.build_directory = fs::canonical(value);
+        } else if (argument == "--formats") {
+            options.formats = parse_format_list(value);
+        } else if (argument == "--instances") {
+            options.instance_counts = parse_int_list(value);
+        } else if (argument == "--buffer-sizes") {
+            options.buffer_sizes = parse_int_list(value);
+        } else if (argument == "--sample-rate") {
+            options.sample_rate = std::stod(value);
+        } else if (argument == "--cycles") {
+            options.cycles = std::stoi(value);
+        } else if (argument == "--warmup-cycles") {
+            options.warmup_cycles = std::stoi(value);
+        } else if (argument == "--parameters") {
+            options.parameters = std::stoi(value);
+        } else if (argument == "--automated-parameters") {
+            options.automated_parameters = std::stoi(value);
+        } else if (argument == "--midi-events") {
+            options.midi_events = std::stoi(value);
+        } else if (argument == "--state-size") {
+            options.state_size = std::stoi(value);
+        } else if (argument == "--state-cycles") {
+            options.state_cycles = std::stoi(value);
+        } else {
+            throw std::invalid_argument("Unknown option '" + argument + "'");
+        }
+    }
+
+    return options;
+}
+
+/**
+ * Load yabridge's plugin library for `format`, and set up `directory` so it
+ * loads that format's null plugin. `format` has already been validated in
+ * `parse_format_list()`.
+ */
+std::unique_ptr<BenchPlugin> load_plugin(
+    [[maybe_unused]] const std::string& format,
+    const Options& options,
+    const fs::path& directory) {
+#ifdef WITH_VST3
+    if (format == "vst3") {
+        return load_vst3_plugin(options, directory);
+    }
+#endif
+#ifdef WITH_CLAP
+    if (format == "clap") {
+        return load_clap_plugin(options, directory);
+    }
+#endif
+
+    return load_vst2_plugin(options, directory);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl << std::endl;
+        print_usage(argv[0]);
+
+        return 1;
+    }
+
+    // The null plugins read their configuration from the environment, and the
+    // Wine plugin host inherits our environment
+    setenv("YABRIDGE_BENCH_PARAMETERS",
+           std::to_string(options.parameters).c_str(), true);
+    setenv("YABRIDGE_BENCH_STATE_SIZE",
+           std::to_string(options.state_size).c_str(), true);
+    setenv("YABRIDGE_BENCH_MIDI_ECHO", "1", true);
+
+    // The null plugins and symlinks to yabridge's plugin libraries are set up
+    // in a temporary directory. The symlinks to yabridge's libraries get
+    // resolved when searching for `yabridge-host.exe`, so that will be found
+    // in the build directory.
+    std::string directory_template =
+        (fs::temp_directory_path() / "yabridge-bench-XXXXXX").string();
+    if (!mkdtemp(directory_template.data())) {
+        std::cerr << "Could not create a temporary directory" << std::endl;
+        return 1;
+    }
+    const fs::path plugin_directory(directory_template);
+
+    std::vector<ProcessResult> results;
+    std::vector<StateResult> state_results;
+    int exit_code = 0;
+    try {
+        for (const std::string& format : options.formats) {
+            std::cerr << "Loading the " << format << " null plugin..."
+                      << std::endl;
+
+            // The instances need to be destroyed before the plugin library
+            std::unique_ptr<BenchPlugin> plugin =
+                load_plugin(format, options, plugin_directory);
+            for (const int instance_count : options.instance_counts) {
+                std::cerr << "Starting " << instance_count << " " << format
+                          << " instance(s)..." << std::endl;
+
+                std::vector<std::unique_ptr<BenchInstance>> instances;
+                for (int i = 0; i < instance_count; i++) {
+                    instances.push_back(plugin->create_instance(options));
+                }
+
+                for (const int buffer_size : options.buffer_sizes) {
+                    std::cerr << "  Processing " << options.cycles
+                              << " cycles at a buffer size of " << buffer_size
+                              << std::endl;
+
+                    for (auto& instance : instances) {
+                        instance->set_buffer_size(buffer_size);
+                    }
+
+                    const auto start = std::chrono::steady_clock::now();
+                    {
+                        std::vector<std::jthread> threads;
+                        for (auto& instance : instances) {
+                            threads.emplace_back(
+                                [&instance]() { instance->run(); });
+                        }
+                    }
+                    const std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+
+                    std::vector<uint64_t> durations_ns;
+                    uint64_t echoed_midi_events = 0;
+                    for (auto& instance : instances) {
+                        durations_ns.insert(durations_ns.end(),
+                                            instance->durations_ns().begin(),
+                                            instance->durations_ns().end());
+                        echoed_midi_events += instance->echoed_midi_events();
+                    }
+
+                    // The warmup cycles are included in the elapsed time, so
+                    // the throughput is based on all cycles
+                    const double total_cycles =
+                        static_cast<double>(instance_count) *
+                        (options.warmup_cycles + options.cycles);
+                    const double audio_seconds =
+                        ((options.warmup_cycles + options.cycles) *
+                         static_cast<double>(buffer_size)) /
+                        options.sample_rate;
+
+                    results.push_back(ProcessResult{
+                        .format = format,
+                        .instances = instance_count,
+                        .buffer_size = buffer_size,
+                        .latency_us = LatencySummary(durations_ns),
+                        .cycles_per_second = total_cycles / elapsed.count(),
+                        .realtime_factor = audio_seconds / elapsed.count(),
+                        .echoed_midi_events = echoed_midi_events});
+                }
+
+                // Saving and loading state only needs to be measured once per
+                // plugin format
+                if (options.state_cycles > 0 &&
+                    (state_results.empty() ||
+                     state_results.back().format != format)) {
+                    std::cerr << "  Saving and restoring "
+                              << options.state_size << " bytes of state "
+                              << options.state_cycles << " times" << std::endl;
+
+                    std::vector<uint64_t> save_state_ns;
+                    std::vector<uint64_t> load_state_ns;
+                    instances.front()->run_state(save_state_ns, load_state_ns);
+
+                    state_results.push_back(
+                        StateResult{.format = format,
+                                    .save_us = LatencySummary(save_state_ns),
+                                    .load_us = LatencySummary(load_state_ns)});
+                }
+            }
+        }
+    } catch (const std::exception& error) {
+        std::cerr << "Error while running the benchmark: " << error.what()
+                  << std::endl;
+        exit_code = 1;
+    }
+
+    std::error_code err;
+    fs::remove_all(plugin_directory, err);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\n"
+              << "  \"version\": \"" << yabridge_git_version << "\",\n"
+              << "  \"sample_rate\": " << options.sample_rate << ",\n"
+              << "  \"cycles\": " << options.cycles << ",\n"
+              << "  \"parameters\": " << options.parameters << ",\n"
+              << "  \"automated_parameters\": "
+              << options.automated_parameters << ",\n"
+              << "  \"midi_events\": " << options.midi_events << ",\n"
+              << "  \"process\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const ProcessResult& result = results[i];
+        std::cout << (i == 0 ? "\n" : ",\n") << "    {\"format\": \""
+                  << result.format << "\", \"instances\": " << result.instances
+                  << ", \"buffer_size\": " << result.buffer_size
+                  << ", \"cycles_per_second\": " << result.cycles_per_second
+                  << ", \"realtime_factor\": " << result.realtime_factor
+                  << ", \"echoed_midi_events\": " << result.echoed_midi_events
+                  << ", \"latency_us\": ";
+        result.latency_us.write_json(std::cout);
+        std::cout << "}";
+    }
+    std::cout << "\n  ],\n"
+              << "  \"state_size\": " << options.state_size << ",\n"
+              << "  \"state\": [";
+    for (size_t i = 0; i < state_results.size(); i++) {
+        const StateResult& result = state_results[i];
+        std::cout << (i == 0 ? "\n" : ",\n") << "    {\"format\": \""
+                  << result.format << "\", \"save_us\": ";
+        result.save_us.write_json(std::cout);
+        std::cout << ", \"load_us\": ";
+        result.load_us.write_json(std::cout);
+        std::cout << "}";
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return exit_code;
+}
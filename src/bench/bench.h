@@ -0,0 +1,232 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ghc/filesystem.hpp>
+
+// The declarations shared between `yabridge-bench`'s main function in
+// `bench.cpp` and the minimal VST2, VST3, and CLAP hosts in `bench-vst2.cpp`,
+// `bench-vst3.cpp`, and `bench-clap.cpp`.
+
+/**
+ * The name used for the null plugin in every plugin format. The actual Windows
+ * plugin files are named `yabridge-null-plugin.dll`,
+ * `yabridge-null-plugin-vst3.vst3`, and `yabridge-null-plugin-clap.clap-win`
+ * in the build directory.
+ */
+constexpr char null_plugin_name[] = "yabridge-null-plugin";
+
+/**
+ * The number of input and output channels on the null plugin's single main
+ * audio bus.
+ */
+constexpr int num_channels = 2;
+
+/**
+ * The options that can be changed through the command line.
+ */
+struct Options {
+    /**
+     * The directory containing yabridge's plugin libraries,
+     * `yabridge-host.exe`, and the null plugins. Defaults to the directory this
+     * executable is in, which is the build directory.
+     */
+    ghc::filesystem::path build_directory;
+
+    /**
+     * The plugin formats to benchmark. Defaults to all formats yabridge was
+     * built with.
+     */
+    std::vector<std::string> formats;
+
+    std::vector<int> instance_counts{1, 2, 4, 8};
+    std::vector<int> buffer_sizes{32, 64, 128, 256, 512, 1024, 2048};
+    double sample_rate = 48000.0;
+
+    /**
+     * The number of processing cycles per instance to measure for every
+     * combination of instance count and buffer size. These are preceded by
+     * `warmup_cycles` cycles that are not measured.
+     */
+    int cycles = 2000;
+    int warmup_cycles = 200;
+
+    /**
+     * The number of parameters the null plugin should expose, and the number of
+     * those parameters that get automated before every processing cycle.
+     */
+    int parameters = 16;
+    int automated_parameters = 4;
+
+    /**
+     * The number of MIDI note events sent to the plugin before every
+     * processing cycle. The null plugin echoes these back to the host.
+     */
+    int midi_events = 8;
+
+    /**
+     * The size of the null plugin's state in bytes, and the number of times to
+     * save and restore that state.
+     */
+    int state_size = 1 << 16;
+    int state_cycles = 50;
+};
+
+/**
+ * A single instance of the null plugin, loaded through yabridge. Every instance
+ * is processed on its own thread, like a multithreaded DAW would do. The
+ * format specific subclasses only need to implement a single processing cycle
+ * and saving and restoring the plugin's state, while this class takes care of
+ * the timing and the audio buffers.
+ */
+class BenchInstance {
+   public:
+    explicit BenchInstance(const Options& options);
+    virtual ~BenchInstance() noexcept = default;
+
+    BenchInstance(const BenchInstance&) = delete;
+    BenchInstance& operator=(const BenchInstance&) = delete;
+
+    /**
+     * Suspend the plugin, change the buffer size, and resume it again. The
+     * implementations should call `BenchInstance::set_buffer_size()` to resize
+     * the audio buffers.
+     */
+    virtual void set_buffer_size(int buffer_size);
+
+    /**
+     * Run `options.warmup_cycles + options.cycles` processing cycles, and
+     * record the duration of the last `options.cycles` cycles. This is called
+     * from the instance's processing thread.
+     */
+    void run();
+
+    /**
+     * Measure how long it takes to save and restore the plugin's state.
+     */
+    void run_state(std::vector<uint64_t>& save_state_ns,
+                   std::vector<uint64_t>& load_state_ns);
+
+    std::vector<uint64_t>& durations_ns() { return durations_ns_; }
+    uint64_t echoed_midi_events() const {
+        return echoed_midi_events_.load(std::memory_order_relaxed);
+    }
+
+   protected:
+    /**
+     * Called on the processing thread before the first and after the last
+     * processing cycle in `run()`. CLAP requires `start_processing()` to be
+     * called from the audio thread.
+     */
+    virtual void start_processing() {}
+    virtual void stop_processing() {}
+
+    /**
+     * Send parameter changes and MIDI events to the plugin, and then process a
+     * single buffer of audio. This should mimic what a DAW would do during
+     * playback with some automation. Any MIDI events the plugin sends back
+     * should be added to `echoed_midi_events_`.
+     */
+    virtual void process_cycle(int cycle) = 0;
+
+    /**
+     * Save the plugin's state to a buffer in the subclass.
+     */
+    virtual void save_state() = 0;
+
+    /**
+     * Restore the state last saved with `save_state()`.
+     */
+    virtual void load_state() = 0;
+
+    const Options& options_;
+
+    int buffer_size_ = 0;
+    std::vector<std::vector<float>> inputs_;
+    std::vector<std::vector<float>> outputs_;
+    std::array<float*, num_channels> input_pointers_{};
+    std::array<float*, num_channels> output_pointers_{};
+
+    /**
+     * The number of MIDI events the plugin sent back to us. With VST2 this is
+     * incremented from yabridge's host callback thread while the benchmark
+     * thread reads and resets it.
+     */
+    std::atomic<uint64_t> echoed_midi_events_ = 0;
+
+   private:
+    std::vector<uint64_t> durations_ns_;
+};
+
+/**
+ * yabridge's plugin library for a single plugin format, set up to load the
+ * null plugin.
+ */
+class BenchPlugin {
+   public:
+    virtual ~BenchPlugin() noexcept = default;
+
+    /**
+     * Create and initialize a new instance of the null plugin.
+     */
+    virtual std::unique_ptr<BenchInstance> create_instance(
+        const Options& options) = 0;
+};
+
+/**
+ * Load `libyabridge-vst2.so`, and set up `directory` so it loads the VST2 null
+ * plugin.
+ *
+ * @throw std::runtime_error If the library or the null plugin could not be
+ *   loaded.
+ */
+std::unique_ptr<BenchPlugin> load_vst2_plugin(
+    const Options& options,
+    const ghc::filesystem::path& directory);
+
+#ifdef WITH_VST3
+/**
+ * Load `libyabridge-vst3.so`, and create a VST3 bundle for the VST3 null
+ * plugin in `directory`.
+ *
+ * @throw std::runtime_error If the library or the null plugin could not be
+ *   loaded.
+ */
+std::unique_ptr<BenchPlugin> load_vst3_plugin(
+    const Options& options,
+    const ghc::filesystem::path& directory);
+#endif
+
+#ifdef WITH_CLAP
+/**
+ * Load `libyabridge-clap.so`, and set up `directory` so it loads the CLAP null
+ * plugin.
+ *
+ * @throw std::runtime_error If the library or the null plugin could not be
+ *   loaded.
+ */
+std::unique_ptr<BenchPlugin> load_clap_plugin(
+    const Options& options,
+    const ghc::filesystem::path& directory);
+#endif
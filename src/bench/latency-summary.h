@@ -0,0 +1,70 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * Summary statistics for a list of durations, in microseconds.
+ */
+struct LatencySummary {
+    explicit LatencySummary(std::vector<uint64_t>& durations_ns) {
+        if (durations_ns.empty()) {
+            return;
+        }
+
+        std::sort(durations_ns.begin(), durations_ns.end());
+        const auto percentile = [&](double p) {
+            const size_t index = std::min(
+                durations_ns.size() - 1,
+                static_cast<size_t>(std::ceil(p * durations_ns.size())) - 1);
+            return durations_ns[index] / 1000.0;
+        };
+
+        uint64_t total_ns = 0;
+        for (const uint64_t duration : durations_ns) {
+            total_ns += duration;
+        }
+
+        mean = (static_cast<double>(total_ns) / durations_ns.size()) / 1000.0;
+        min = durations_ns.front() / 1000.0;
+        p50 = percentile(0.50);
+        p90 = percentile(0.90);
+        p99 = percentile(0.99);
+        p999 = percentile(0.999);
+        max = durations_ns.back() / 1000.0;
+    }
+
+    void write_json(std::ostream& stream) const {
+        stream << "{\"mean\": " << mean << ", \"min\": " << min
+               << ", \"p50\": " << p50 << ", \"p90\": " << p90
+               << ", \"p99\": " << p99 << ", \"p999\": " << p999
+               << ", \"max\": " << max << "}";
+    }
+
+    double mean = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double max = 0.0;
+};
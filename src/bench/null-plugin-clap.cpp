@@ -0,0 +1,461 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// A minimal Windows CLAP plugin used by `yabridge-bench`. This is the CLAP
+// equivalent of `null-plugin.cpp`, and it's configured through the same
+// environment variables. Note events are echoed back to the host through the
+// process call's output event queue.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <clap/entry.h>
+#include <clap/ext/audio-ports.h>
+#include <clap/ext/note-ports.h>
+#include <clap/ext/params.h>
+#include <clap/ext/state.h>
+#include <clap/factory/plugin-factory.h>
+#include <clap/plugin.h>
+
+namespace {
+
+constexpr uint32_t num_channels = 2;
+
+int env_int(const char* name, int default_value) {
+    const char* value = std::getenv(name);
+    return value ? std::atoi(value) : default_value;
+}
+
+const char* const features[] = {CLAP_PLUGIN_FEATURE_AUDIO_EFFECT, nullptr};
+
+const clap_plugin_descriptor_t descriptor{
+    .clap_version = CLAP_VERSION_INIT,
+    .id = "yabridge.bench.null-plugin",
+    .name = "yabridge null plugin",
+    .vendor = "yabridge",
+    .url = "",
+    .manual_url = "",
+    .support_url = "",
+    .version = "1.0.0",
+    .description = "",
+    .features = features,
+};
+
+/**
+ * The plugin instance. The `clap_plugin_t` vtable's `plugin_data` points back
+ * to this object.
+ */
+struct NullPlugin {
+    explicit NullPlugin(const clap_host_t* host)
+        : host(host),
+          plugin(clap_plugin_t{
+              .desc = &descriptor,
+              .plugin_data = this,
+              .init = init,
+              .destroy = destroy,
+              .activate = activate,
+              .deactivate = deactivate,
+              .start_processing = start_processing,
+              .stop_processing = stop_processing,
+              .reset = reset,
+              .process = process,
+              .get_extension = get_extension,
+              .on_main_thread = on_main_thread,
+          }),
+          parameters(std::max(env_int("YABRIDGE_BENCH_PARAMETERS", 16), 0),
+                     0.0),
+          state(std::max(env_int("YABRIDGE_BENCH_STATE_SIZE", 4096), 0)),
+          midi_echo(env_int("YABRIDGE_BENCH_MIDI_ECHO", 1) != 0) {
+        for (size_t i = 0; i < state.size(); i++) {
+            state[i] = static_cast<char>(i);
+        }
+    }
+
+    static NullPlugin& get(const clap_plugin_t* plugin) {
+        return *static_cast<NullPlugin*>(plugin->plugin_data);
+    }
+
+    static bool CLAP_ABI init(const clap_plugin_t* /*plugin*/) { return true; }
+    static void CLAP_ABI destroy(const clap_plugin_t* plugin) {
+        delete &get(plugin);
+    }
+    static bool CLAP_ABI activate(const clap_plugin_t* /*plugin*/,
+                                  double /*sample_rate*/,
+                                  uint32_t /*min_frames_count*/,
+                                  uint32_t /*max_frames_count*/) {
+        return true;
+    }
+    static void CLAP_ABI deactivate(const clap_plugin_t* /*plugin*/) {}
+    static bool CLAP_ABI start_processing(const clap_plugin_t* /*plugin*/) {
+        return true;
+    }
+    static void CLAP_ABI stop_processing(const clap_plugin_t* /*plugin*/) {}
+    static void CLAP_ABI reset(const clap_plugin_t* /*plugin*/) {}
+    static clap_process_status CLAP_ABI process(const clap_plugin_t* plugin,
+                                                const clap_process_t* process);
+    static const void* CLAP_ABI get_extension(const clap_plugin_t* plugin,
+                                              const char* id);
+    static void CLAP_ABI on_main_thread(const clap_plugin_t* /*plugin*/) {}
+
+    static uint32_t CLAP_ABI ext_audio_ports_count(const clap_plugin_t* plugin,
+                                                   bool is_input);
+    static bool CLAP_ABI ext_audio_ports_get(const clap_plugin_t* plugin,
+                                             uint32_t index,
+                                             bool is_input,
+                                             clap_audio_port_info_t* info);
+
+    static uint32_t CLAP_ABI ext_note_ports_count(const clap_plugin_t* plugin,
+                                                  bool is_input);
+    static bool CLAP_ABI ext_note_ports_get(const clap_plugin_t* plugin,
+                                            uint32_t index,
+                                            bool is_input,
+                                            clap_note_port_info_t* info);
+
+    static uint32_t CLAP_ABI ext_params_count(const clap_plugin_t* plugin);
+    static bool CLAP_ABI ext_params_get_info(const clap_plugin_t* plugin,
+                                             uint32_t param_index,
+                                             clap_param_info_t* param_info);
+    static bool CLAP_ABI ext_params_get_value(const clap_plugin_t* plugin,
+                                              clap_id param_id,
+                                              double* out_value);
+    static bool CLAP_ABI ext_params_value_to_text(const clap_plugin_t* plugin,
+                                                  clap_id param_id,
+                                                  double value,
+                                                  char* out_buffer,
+                                                  uint32_t out_buffer_capacity);
+    static bool CLAP_ABI ext_params_text_to_value(const clap_plugin_t* plugin,
+                                                  clap_id param_id,
+                                                  const char* param_value_text,
+                                                  double* out_value);
+    static void CLAP_ABI ext_params_flush(const clap_plugin_t* plugin,
+                                          const clap_input_events_t* in,
+                                          const clap_output_events_t* out);
+
+    static bool CLAP_ABI ext_state_save(const clap_plugin_t* plugin,
+                                        const clap_ostream_t* stream);
+    static bool CLAP_ABI ext_state_load(const clap_plugin_t* plugin,
+                                        const clap_istream_t* stream);
+
+    /**
+     * Apply the parameter changes from an input event queue, and echo any note
+     * events back to the output event queue.
+     */
+    void handle_events(const clap_input_events_t& in,
+                       const clap_output_events_t* out);
+
+    const clap_host_t* host;
+    const clap_plugin_t plugin;
+
+    std::vector<double> parameters;
+    std::vector<char> state;
+    bool midi_echo;
+};
+
+const clap_plugin_audio_ports_t ext_audio_ports{
+    .count = NullPlugin::ext_audio_ports_count,
+    .get = NullPlugin::ext_audio_ports_get,
+};
+
+const clap_plugin_note_ports_t ext_note_ports{
+    .count = NullPlugin::ext_note_ports_count,
+    .get = NullPlugin::ext_note_ports_get,
+};
+
+const clap_plugin_params_t ext_params{
+    .count = NullPlugin::ext_params_count,
+    .get_info = NullPlugin::ext_params_get_info,
+    .get_value = NullPlugin::ext_params_get_value,
+    .value_to_text = NullPlugin::ext_params_value_to_text,
+    .text_to_value = NullPlugin::ext_params_text_to_value,
+    .flush = NullPlugin::ext_params_flush,
+};
+
+const clap_plugin_state_t ext_state{
+    .save = NullPlugin::ext_state_save,
+    .load = NullPlugin::ext_state_load,
+};
+
+clap_process_status CLAP_ABI
+NullPlugin::process(const clap_plugin_t* plugin,
+                    const clap_process_t* process) {
+    NullPlugin& self = get(plugin);
+
+    if (process->audio_inputs_count > 0 && process->audio_outputs_count > 0) {
+        const clap_audio_buffer_t& inputs = process->audio_inputs[0];
+        const clap_audio_buffer_t& outputs = process->audio_outputs[0];
+        for (uint32_t channel = 0; channel < num_channels; channel++) {
+            if (inputs.data64 && outputs.data64) {
+                std::memcpy(outputs.data64[channel], inputs.data64[channel],
+                            sizeof(double) * process->frames_count);
+            } else {
+                std::memcpy(outputs.data32[channel], inputs.data32[channel],
+                            sizeof(float) * process->frames_count);
+            }
+        }
+    }
+
+    self.handle_events(*process->in_events, process->out_events);
+
+    return CLAP_PROCESS_CONTINUE;
+}
+
+const void* CLAP_ABI NullPlugin::get_extension(const clap_plugin_t* /*plugin*/,
+                                               const char* id) {
+    if (std::strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) {
+        return &ext_audio_ports;
+    } else if (std::strcmp(id, CLAP_EXT_NOTE_PORTS) == 0) {
+        return &ext_note_ports;
+    } else if (std::strcmp(id, CLAP_EXT_PARAMS) == 0) {
+        return &ext_params;
+    } else if (std::strcmp(id, CLAP_EXT_STATE) == 0) {
+        return &ext_state;
+    } else {
+        return nullptr;
+    }
+}
+
+uint32_t CLAP_ABI
+NullPlugin::ext_audio_ports_count(const clap_plugin_t* /*plugin*/,
+                                  bool /*is_input*/) {
+    return 1;
+}
+
+bool CLAP_ABI NullPlugin::ext_audio_ports_get(const clap_plugin_t* /*plugin*/,
+                                              uint32_t index,
+                                              bool is_input,
+                                              clap_audio_port_info_t* info) {
+    if (index != 0) {
+        return false;
+    }
+
+    *info = clap_audio_port_info_t{};
+    info->id = is_input ? 0 : 1;
+    std::strcpy(info->name, "Main");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS;
+    info->channel_count = num_channels;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = CLAP_INVALID_ID;
+
+    return true;
+}
+
+uint32_t CLAP_ABI
+NullPlugin::ext_note_ports_count(const clap_plugin_t* /*plugin*/,
+                                 bool /*is_input*/) {
+    return 1;
+}
+
+bool CLAP_ABI NullPlugin::ext_note_ports_get(const clap_plugin_t* /*plugin*/,
+                                             uint32_t index,
+                                             bool is_input,
+                                             clap_note_port_info_t* info) {
+    if (index != 0) {
+        return false;
+    }
+
+    *info = clap_note_port_info_t{};
+    info->id = is_input ? 0 : 1;
+    info->supported_dialects = CLAP_NOTE_DIALECT_CLAP | CLAP_NOTE_DIALECT_MIDI;
+    info->preferred_dialect = CLAP_NOTE_DIALECT_CLAP;
+    std::strcpy(info->name, "Notes");
+
+    return true;
+}
+
+uint32_t CLAP_ABI NullPlugin::ext_params_count(const clap_plugin_t* plugin) {
+    return static_cast<uint32_t>(get(plugin).parameters.size());
+}
+
+bool CLAP_ABI NullPlugin::ext_params_get_info(const clap_plugin_t* plugin,
+                                              uint32_t param_index,
+                                              clap_param_info_t* param_info) {
+    if (param_index >= get(plugin).parameters.size()) {
+        return false;
+    }
+
+    *param_info = clap_param_info_t{};
+    param_info->id = param_index;
+    param_info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+    std::strcpy(param_info->name, "null");
+    param_info->min_value = 0.0;
+    param_info->max_value = 1.0;
+    param_info->default_value = 0.0;
+
+    return true;
+}
+
+bool CLAP_ABI NullPlugin::ext_params_get_value(const clap_plugin_t* plugin,
+                                               clap_id param_id,
+                                               double* out_value) {
+    NullPlugin& self = get(plugin);
+    if (param_id >= self.parameters.size()) {
+        return false;
+    }
+
+    *out_value = self.parameters[param_id];
+    return true;
+}
+
+bool CLAP_ABI
+NullPlugin::ext_params_value_to_text(const clap_plugin_t* /*plugin*/,
+                                     clap_id /*param_id*/,
+                                     double /*value*/,
+                                     char* out_buffer,
+                                     uint32_t out_buffer_capacity) {
+    if (out_buffer_capacity < 5) {
+        return false;
+    }
+
+    std::strcpy(out_buffer, "null");
+    return true;
+}
+
+bool CLAP_ABI
+NullPlugin::ext_params_text_to_value(const clap_plugin_t* /*plugin*/,
+                                     clap_id /*param_id*/,
+                                     const char* /*param_value_text*/,
+                                     double* /*out_value*/) {
+    return false;
+}
+
+void CLAP_ABI NullPlugin::ext_params_flush(const clap_plugin_t* plugin,
+                                           const clap_input_events_t* in,
+                                           const clap_output_events_t* out) {
+    get(plugin).handle_events(*in, out);
+}
+
+bool CLAP_ABI NullPlugin::ext_state_save(const clap_plugin_t* plugin,
+                                         const clap_ostream_t* stream) {
+    const NullPlugin& self = get(plugin);
+
+    size_t num_bytes_written = 0;
+    while (num_bytes_written < self.state.size()) {
+        const int64_t result =
+            stream->write(stream, self.state.data() + num_bytes_written,
+                          self.state.size() - num_bytes_written);
+        if (result <= 0) {
+            return false;
+        }
+
+        num_bytes_written += result;
+    }
+
+    return true;
+}
+
+bool CLAP_ABI NullPlugin::ext_state_load(const clap_plugin_t* plugin,
+                                         const clap_istream_t* stream) {
+    NullPlugin& self = get(plugin);
+
+    size_t num_bytes_read = 0;
+    while (num_bytes_read < self.state.size()) {
+        const int64_t result =
+            stream->read(stream, self.state.data() + num_bytes_read,
+                         self.state.size() - num_bytes_read);
+        if (result <= 0) {
+            return false;
+        }
+
+        num_bytes_read += result;
+    }
+
+    return true;
+}
+
+void NullPlugin::handle_events(const clap_input_events_t& in,
+                               const clap_output_events_t* out) {
+    const uint32_t num_events = in.size(&in);
+    for (uint32_t i = 0; i < num_events; i++) {
+        const clap_event_header_t* event = in.get(&in, i);
+        if (event->space_id != CLAP_CORE_EVENT_SPACE_ID) {
+            continue;
+        }
+
+        switch (event->type) {
+            case CLAP_EVENT_PARAM_VALUE: {
+                const auto& param_event =
+                    *reinterpret_cast<const clap_event_param_value_t*>(event);
+                if (param_event.param_id < parameters.size()) {
+                    parameters[param_event.param_id] = param_event.value;
+                }
+            } break;
+            case CLAP_EVENT_NOTE_ON:
+            case CLAP_EVENT_NOTE_OFF:
+                if (midi_echo && out) {
+                    out->try_push(out, event);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool CLAP_ABI factory_init(const char* /*plugin_path*/) {
+    return true;
+}
+
+void CLAP_ABI factory_deinit() {}
+
+uint32_t CLAP_ABI
+factory_get_plugin_count(const clap_plugin_factory_t* /*factory*/) {
+    return 1;
+}
+
+const clap_plugin_descriptor_t* CLAP_ABI
+factory_get_plugin_descriptor(const clap_plugin_factory_t* /*factory*/,
+                              uint32_t index) {
+    return index == 0 ? &descriptor : nullptr;
+}
+
+const clap_plugin_t* CLAP_ABI
+factory_create_plugin(const clap_plugin_factory_t* /*factory*/,
+                      const clap_host_t* host,
+                      const char* plugin_id) {
+    if (std::strcmp(plugin_id, descriptor.id) != 0) {
+        return nullptr;
+    }
+
+    return &(new NullPlugin(host))->plugin;
+}
+
+const clap_plugin_factory_t plugin_factory{
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin,
+};
+
+const void* CLAP_ABI factory_get_factory(const char* factory_id) {
+    return std::strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) == 0
+               ? &plugin_factory
+               : nullptr;
+}
+
+}  // namespace
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattributes"
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION_INIT,
+    .init = factory_init,
+    .deinit = factory_deinit,
+    .get_factory = factory_get_factory,
+};
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,422 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// A minimal Windows VST3 plugin used by `yabridge-bench`. This is the VST3
+// equivalent of `null-plugin.cpp`, and it's configured through the same
+// environment variables. The processor and the edit controller are
+// implemented by a single object, and note events are echoed back to the host
+// through the process data's output event list.
+//
+// This only uses the VST3 SDK's interface headers. The interface IDs are
+// compared against the `*_iid` constants directly so we don't need to link
+// against the SDK's `FUID` implementation from the MinGW build.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <pluginterfaces/base/ibstream.h>
+#include <pluginterfaces/base/ipluginbase.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstevents.h>
+#include <pluginterfaces/vst/ivstparameterchanges.h>
+#include <pluginterfaces/vst/vstspeaker.h>
+
+namespace {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+constexpr int num_channels = 2;
+
+const TUID null_plugin_cid =
+    INLINE_UID(0x79624e6c, 0x4e756c6c, 0x50726f63, 0x65737321);
+
+int env_int(const char* name, int default_value) {
+    const char* value = std::getenv(name);
+    return value ? std::atoi(value) : default_value;
+}
+
+bool iid_equal(const TUID lhs, const TUID rhs) {
+    return std::memcmp(lhs, rhs, sizeof(TUID)) == 0;
+}
+
+/**
+ * Copy an ASCII string to one of the VST3 SDK's fixed size UTF-16 strings.
+ */
+void copy_string(const char* source, String128 destination) {
+    size_t i = 0;
+    for (; source[i] != '\0' && i < 127; i++) {
+        destination[i] = static_cast<TChar>(source[i]);
+    }
+    destination[i] = 0;
+}
+
+/**
+ * The plugin instance, implementing both the component and the edit
+ * controller. `setState()` and `getState()` are shared between the two
+ * interfaces.
+ */
+class NullPlugin : public IComponent,
+                   public IAudioProcessor,
+                   public IEditController {
+   public:
+    NullPlugin()
+        : parameters_(std::max(env_int("YABRIDGE_BENCH_PARAMETERS", 16), 0),
+                      0.0),
+          state_(std::max(env_int("YABRIDGE_BENCH_STATE_SIZE", 4096), 0)),
+          midi_echo_(env_int("YABRIDGE_BENCH_MIDI_ECHO", 1) != 0) {
+        for (size_t i = 0; i < state_.size(); i++) {
+            state_[i] = static_cast<char>(i);
+        }
+    }
+
+    virtual ~NullPlugin() = default;
+
+    // FUnknown
+    tresult PLUGIN_API queryInterface(const TUID _iid, void** obj) override {
+        if (iid_equal(_iid, FUnknown_iid) || iid_equal(_iid, IPluginBase_iid) ||
+            iid_equal(_iid, IComponent_iid)) {
+            *obj = static_cast<IComponent*>(this);
+        } else if (iid_equal(_iid, IAudioProcessor_iid)) {
+            *obj = static_cast<IAudioProcessor*>(this);
+        } else if (iid_equal(_iid, IEditController_iid)) {
+            *obj = static_cast<IEditController*>(this);
+        } else {
+            *obj = nullptr;
+            return kNoInterface;
+        }
+
+        addRef();
+        return kResultOk;
+    }
+
+    uint32 PLUGIN_API addRef() override { return ++ref_count_; }
+
+    uint32 PLUGIN_API release() override {
+        const uint32 ref_count = --ref_count_;
+        if (ref_count == 0) {
+            delete this;
+        }
+
+        return ref_count;
+    }
+
+    // IPluginBase
+    tresult PLUGIN_API initialize(FUnknown* /*context*/) override {
+        return kResultOk;
+    }
+    tresult PLUGIN_API terminate() override { return kResultOk; }
+
+    // IComponent
+    tresult PLUGIN_API getControllerClassId(TUID /*classId*/) override {
+        return kResultFalse;
+    }
+    tresult PLUGIN_API setIoMode(IoMode /*mode*/) override {
+        return kNotImplemented;
+    }
+    int32 PLUGIN_API getBusCount(MediaType /*type*/,
+                                 BusDirection /*dir*/) override {
+        return 1;
+    }
+    tresult PLUGIN_API getBusInfo(MediaType type,
+                                  BusDirection dir,
+                                  int32 index,
+                                  BusInfo& bus) override {
+        if (index != 0) {
+            return kInvalidArgument;
+        }
+
+        bus.mediaType = type;
+        bus.direction = dir;
+        bus.channelCount = type == kAudio ? num_channels : 16;
+        copy_string(type == kAudio ? "Main" : "MIDI", bus.name);
+        bus.busType = kMain;
+        bus.flags = BusInfo::kDefaultActive;
+
+        return kResultOk;
+    }
+    tresult PLUGIN_API getRoutingInfo(RoutingInfo& /*inInfo*/,
+                                      RoutingInfo& /*outInfo*/) override {
+        return kNotImplemented;
+    }
+    tresult PLUGIN_API activateBus(MediaType /*type*/,
+                                   BusDirection /*dir*/,
+                                   int32 index,
+                                   TBool /*state*/) override {
+        return index == 0 ? kResultOk : kInvalidArgument;
+    }
+    tresult PLUGIN_API setActive(TBool /*state*/) override { return kResultOk; }
+    tresult PLUGIN_API setState(IBStream* state) override {
+        if (!state) {
+            return kInvalidArgument;
+        }
+
+        int32 num_bytes_read = 0;
+        return state->read(state_.data(), static_cast<int32>(state_.size()),
+                           &num_bytes_read);
+    }
+    tresult PLUGIN_API getState(IBStream* state) override {
+        if (!state) {
+            return kInvalidArgument;
+        }
+
+        int32 num_bytes_written = 0;
+        return state->write(state_.data(), static_cast<int32>(state_.size()),
+                            &num_bytes_written);
+    }
+
+    // IAudioProcessor
+    tresult PLUGIN_API setBusArrangements(SpeakerArrangement* inputs,
+                                          int32 numIns,
+                                          SpeakerArrangement* outputs,
+                                          int32 numOuts) override {
+        return numIns == 1 && numOuts == 1 &&
+                       inputs[0] == SpeakerArr::kStereo &&
+                       outputs[0] == SpeakerArr::kStereo
+                   ? kResultTrue
+                   : kResultFalse;
+    }
+    tresult PLUGIN_API getBusArrangement(BusDirection /*dir*/,
+                                         int32 index,
+                                         SpeakerArrangement& arr) override {
+        if (index != 0) {
+            return kInvalidArgument;
+        }
+
+        arr = SpeakerArr::kStereo;
+        return kResultOk;
+    }
+    tresult PLUGIN_API canProcessSampleSize(int32 symbolicSampleSize) override {
+        return symbolicSampleSize == kSample32 ||
+                       symbolicSampleSize == kSample64
+                   ? kResultTrue
+                   : kResultFalse;
+    }
+    uint32 PLUGIN_API getLatencySamples() override { return 0; }
+    tresult PLUGIN_API setupProcessing(ProcessSetup& /*setup*/) override {
+        return kResultOk;
+    }
+    tresult PLUGIN_API setProcessing(TBool /*state*/) override {
+        return kResultOk;
+    }
+    tresult PLUGIN_API process(ProcessData& data) override;
+    uint32 PLUGIN_API getTailSamples() override { return kNoTail; }
+
+    // IEditController
+    tresult PLUGIN_API setComponentState(IBStream* /*state*/) override {
+        return kResultOk;
+    }
+    int32 PLUGIN_API getParameterCount() override {
+        return static_cast<int32>(parameters_.size());
+    }
+    tresult PLUGIN_API getParameterInfo(int32 paramIndex,
+                                        ParameterInfo& info) override {
+        if (paramIndex < 0 ||
+            paramIndex >= static_cast<int32>(parameters_.size())) {
+            return kInvalidArgument;
+        }
+
+        info = ParameterInfo{};
+        info.id = static_cast<ParamID>(paramIndex);
+        copy_string("null", info.title);
+        copy_string("null", info.shortTitle);
+        info.flags = ParameterInfo::kCanAutomate;
+
+        return kResultOk;
+    }
+    tresult PLUGIN_API getParamStringByValue(ParamID /*id*/,
+                                             ParamValue /*valueNormalized*/,
+                                             String128 string) override {
+        copy_string("null", string);
+        return kResultOk;
+    }
+    tresult PLUGIN_API getParamValueByString(
+        ParamID /*id*/,
+        TChar* /*string*/,
+        ParamValue& /*valueNormalized*/) override {
+        return kResultFalse;
+    }
+    ParamValue PLUGIN_API normalizedParamToPlain(ParamID /*id*/,
+                                                 ParamValue value) override {
+        return value;
+    }
+    ParamValue PLUGIN_API plainParamToNormalized(ParamID /*id*/,
+                                                 ParamValue value) override {
+        return value;
+    }
+    ParamValue PLUGIN_API getParamNormalized(ParamID id) override {
+        return id < parameters_.size() ? parameters_[id] : 0.0;
+    }
+    tresult PLUGIN_API setParamNormalized(ParamID id,
+                                          ParamValue value) override {
+        if (id >= parameters_.size()) {
+            return kInvalidArgument;
+        }
+
+        parameters_[id] = value;
+        return kResultOk;
+    }
+    tresult PLUGIN_API
+    setComponentHandler(IComponentHandler* /*handler*/) override {
+        return kResultOk;
+    }
+    IPlugView* PLUGIN_API createView(FIDString /*name*/) override {
+        return nullptr;
+    }
+
+   private:
+    std::atomic<uint32> ref_count_ = 1;
+
+    std::vector<ParamValue> parameters_;
+    std::vector<char> state_;
+    bool midi_echo_;
+};
+
+tresult PLUGIN_API NullPlugin::process(ProcessData& data) {
+    if (data.inputParameterChanges) {
+        const int32 num_queues =
+            data.inputParameterChanges->getParameterCount();
+        for (int32 i = 0; i < num_queues; i++) {
+            IParamValueQueue* queue =
+                data.inputParameterChanges->getParameterData(i);
+            const int32 num_points = queue ? queue->getPointCount() : 0;
+            if (num_points <= 0 ||
+                queue->getParameterId() >= parameters_.size()) {
+                continue;
+            }
+
+            int32 sample_offset;
+            ParamValue value;
+            if (queue->getPoint(num_points - 1, sample_offset, value) ==
+                kResultOk) {
+                parameters_[queue->getParameterId()] = value;
+            }
+        }
+    }
+
+    if (data.numInputs > 0 && data.numOutputs > 0) {
+        const AudioBusBuffers& inputs = data.inputs[0];
+        AudioBusBuffers& outputs = data.outputs[0];
+        for (int channel = 0; channel < num_channels; channel++) {
+            if (data.symbolicSampleSize == kSample64) {
+                std::memcpy(outputs.channelBuffers64[channel],
+                            inputs.channelBuffers64[channel],
+                            sizeof(Sample64) * data.numSamples);
+            } else {
+                std::memcpy(outputs.channelBuffers32[channel],
+                            inputs.channelBuffers32[channel],
+                            sizeof(Sample32) * data.numSamples);
+            }
+        }
+
+        outputs.silenceFlags = inputs.silenceFlags;
+    }
+
+    if (midi_echo_ && data.inputEvents && data.outputEvents) {
+        const int32 num_events = data.inputEvents->getEventCount();
+        for (int32 i = 0; i < num_events; i++) {
+            Event event;
+            if (data.inputEvents->getEvent(i, event) == kResultOk &&
+                (event.type == Event::kNoteOnEvent ||
+                 event.type == Event::kNoteOffEvent)) {
+                data.outputEvents->addEvent(event);
+            }
+        }
+    }
+
+    return kResultOk;
+}
+
+/**
+ * The plugin factory. There's only a single static instance, so this doesn't
+ * do any reference counting.
+ */
+class NullPluginFactory : public IPluginFactory {
+   public:
+    virtual ~NullPluginFactory() = default;
+
+    tresult PLUGIN_API queryInterface(const TUID _iid, void** obj) override {
+        if (iid_equal(_iid, FUnknown_iid) ||
+            iid_equal(_iid, IPluginFactory_iid)) {
+            *obj = static_cast<IPluginFactory*>(this);
+            return kResultOk;
+        }
+
+        *obj = nullptr;
+        return kNoInterface;
+    }
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    tresult PLUGIN_API getFactoryInfo(PFactoryInfo* info) override {
+        *info = PFactoryInfo{};
+        std::strcpy(info->vendor, "yabridge");
+        info->flags = PFactoryInfo::kUnicode;
+
+        return kResultOk;
+    }
+    int32 PLUGIN_API countClasses() override { return 1; }
+    tresult PLUGIN_API getClassInfo(int32 index, PClassInfo* info) override {
+        if (index != 0) {
+            return kInvalidArgument;
+        }
+
+        *info = PClassInfo{};
+        std::memcpy(info->cid, null_plugin_cid, sizeof(TUID));
+        info->cardinality = PClassInfo::kManyInstances;
+        std::strcpy(info->category, kVstAudioEffectClass);
+        std::strcpy(info->name, "yabridge null plugin");
+
+        return kResultOk;
+    }
+    tresult PLUGIN_API createInstance(FIDString cid,
+                                      FIDString _iid,
+                                      void** obj) override {
+        *obj = nullptr;
+        if (!iid_equal(cid, null_plugin_cid)) {
+            return kInvalidArgument;
+        }
+
+        // The reference from the constructor is dropped again after querying
+        // the requested interface
+        NullPlugin* plugin = new NullPlugin();
+        const tresult result = plugin->queryInterface(_iid, obj);
+        static_cast<IComponent*>(plugin)->release();
+
+        return result;
+    }
+};
+
+NullPluginFactory factory;
+
+}  // namespace
+
+extern "C" __declspec(dllexport) bool InitDll() {
+    return true;
+}
+
+extern "C" __declspec(dllexport) bool ExitDll() {
+    return true;
+}
+
+extern "C" __declspec(dllexport) IPluginFactory* PLUGIN_API GetPluginFactory() {
+    return &factory;
+}
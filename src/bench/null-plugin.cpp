@@ -0,0 +1,270 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// A minimal Windows VST2 plugin used by `yabridge-bench`. It copies its inputs
+// to its outputs, optionally echoes any MIDI events it receives back to the
+// host, and exposes a configurable number of parameters and a configurable
+// amount of state. Because this plugin does close to no work, the time spent
+// in a processing cycle is almost entirely yabridge's own overhead.
+//
+// This is configured through environment variables, since the Wine plugin host
+// inherits the environment from the process that loads yabridge:
+//
+// - `YABRIDGE_BENCH_PARAMETERS`: the number of parameters, defaults to 16.
+// - `YABRIDGE_BENCH_STATE_SIZE`: the size of the chunk returned from
+//   `effGetChunk()` in bytes, defaults to 4096.
+// - `YABRIDGE_BENCH_MIDI_ECHO`: whether MIDI events should be sent back to the
+//   host, enabled unless this is set to `0`.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <vestige/aeffectx.h>
+
+namespace {
+
+constexpr int num_channels = 2;
+constexpr int max_echoed_events = 512;
+
+int env_int(const char* name, int default_value) {
+    const char* value = std::getenv(name);
+    return value ? std::atoi(value) : default_value;
+}
+
+/**
+ * The plugin instance. The `AEffect` is the first member so we can cast back
+ * and forth between the two.
+ */
+struct NullPlugin {
+    explicit NullPlugin(audioMasterCallback host_callback)
+        : host_callback(host_callback),
+          parameters(std::max(env_int("YABRIDGE_BENCH_PARAMETERS", 16), 0),
+                     0.0f),
+          state(std::max(env_int("YABRIDGE_BENCH_STATE_SIZE", 4096), 0)),
+          midi_echo(env_int("YABRIDGE_BENCH_MIDI_ECHO", 1) != 0) {
+        std::memset(&effect, 0, sizeof(effect));
+        effect.magic = kEffectMagic;
+        effect.dispatcher = dispatch;
+        effect.process = process;
+        effect.setParameter = set_parameter;
+        effect.getParameter = get_parameter;
+        effect.numPrograms = 1;
+        effect.numParams = static_cast<int>(parameters.size());
+        effect.numInputs = num_channels;
+        effect.numOutputs = num_channels;
+        effect.flags = effFlagsCanReplacing | effFlagsProgramChunks;
+        effect.unkown_float = 1.0f;
+        effect.uniqueID = CCONST('y', 'b', 'N', 'l');
+        effect.version = 1;
+        effect.processReplacing = process;
+        effect.processDoubleReplacing = process_double;
+
+        for (size_t i = 0; i < state.size(); i++) {
+            state[i] = static_cast<char>(i);
+        }
+
+        echoed_events.reserve(max_echoed_events);
+    }
+
+    static NullPlugin& get(AEffect* effect) {
+        return *reinterpret_cast<NullPlugin*>(effect);
+    }
+
+    static intptr_t VST_CALL_CONV dispatch(AEffect* effect,
+                                           int opcode,
+                                           int index,
+                                           intptr_t value,
+                                           void* data,
+                                           float option);
+    static void VST_CALL_CONV process(AEffect* effect,
+                                      float** inputs,
+                                      float** outputs,
+                                      int sample_frames);
+    static void VST_CALL_CONV process_double(AEffect* effect,
+                                             double** inputs,
+                                             double** outputs,
+                                             int sample_frames);
+    static void VST_CALL_CONV set_parameter(AEffect* effect,
+                                            int index,
+                                            float value);
+    static float VST_CALL_CONV get_parameter(AEffect* effect, int index);
+
+    /**
+     * Send the events received during the last `effProcessEvents()` call back
+     * to the host. Called at the end of the processing cycle, like a real MIDI
+     * effect would.
+     */
+    void echo_events();
+
+    AEffect effect;
+    audioMasterCallback host_callback;
+
+    std::vector<float> parameters;
+    std::vector<char> state;
+    bool midi_echo;
+
+    /**
+     * Copies of the MIDI events received in the last `effProcessEvents()` call.
+     */
+    std::vector<VstMidiEvent> echoed_events;
+};
+
+intptr_t VST_CALL_CONV NullPlugin::dispatch(AEffect* effect,
+                                            int opcode,
+                                            int index,
+                                            intptr_t value,
+                                            void* data,
+                                            float /*option*/) {
+    NullPlugin& plugin = get(effect);
+
+    switch (opcode) {
+        case effClose:
+            delete &plugin;
+            return 1;
+        case effGetParamName:
+        case effGetParamLabel:
+        case effGetParamDisplay:
+            std::strcpy(static_cast<char*>(data), "null");
+            return 0;
+        case effGetChunk:
+            *static_cast<void**>(data) = plugin.state.data();
+            return static_cast<intptr_t>(plugin.state.size());
+        case effSetChunk:
+            plugin.state.assign(static_cast<char*>(data),
+                                static_cast<char*>(data) + value);
+            return 1;
+        case effProcessEvents: {
+            if (!plugin.midi_echo) {
+                return 1;
+            }
+
+            const auto& events = *static_cast<VstEvents*>(data);
+            for (int i = 0; i < events.numEvents &&
+                            plugin.echoed_events.size() < max_echoed_events;
+                 i++) {
+                const auto& event =
+                    *reinterpret_cast<const VstMidiEvent*>(events.events[i]);
+                if (event.type == kVstMidiType) {
+                    plugin.echoed_events.push_back(event);
+                }
+            }
+
+            return 1;
+        } break;
+        case effCanBeAutomated:
+            return index < effect->numParams;
+        case effGetEffectName:
+        case effGetProductString:
+            std::strcpy(static_cast<char*>(data), "yabridge null plugin");
+            return 1;
+        case effGetVendorString:
+            std::strcpy(static_cast<char*>(data), "yabridge");
+            return 1;
+        case effGetPlugCategory:
+            return kPlugCategEffect;
+        case effCanDo: {
+            const char* can_do = static_cast<const char*>(data);
+            if (std::strcmp(can_do, "receiveVstEvents") == 0 ||
+                std::strcmp(can_do, "receiveVstMidiEvent") == 0 ||
+                std::strcmp(can_do, "sendVstEvents") == 0 ||
+                std::strcmp(can_do, "sendVstMidiEvent") == 0) {
+                return 1;
+            }
+
+            return 0;
+        } break;
+        case effGetVstVersion:
+            return 2400;
+        default:
+            return 0;
+    }
+}
+
+void VST_CALL_CONV NullPlugin::process(AEffect* effect,
+                                       float** inputs,
+                                       float** outputs,
+                                       int sample_frames) {
+    for (int channel = 0; channel < num_channels; channel++) {
+        std::memcpy(outputs[channel], inputs[channel],
+                    sizeof(float) * sample_frames);
+    }
+
+    get(effect).echo_events();
+}
+
+void VST_CALL_CONV NullPlugin::process_double(AEffect* effect,
+                                              double** inputs,
+                                              double** outputs,
+                                              int sample_frames) {
+    for (int channel = 0; channel < num_channels; channel++) {
+        std::memcpy(outputs[channel], inputs[channel],
+                    sizeof(double) * sample_frames);
+    }
+
+    get(effect).echo_events();
+}
+
+void VST_CALL_CONV NullPlugin::set_parameter(AEffect* effect,
+                                             int index,
+                                             float value) {
+    NullPlugin& plugin = get(effect);
+    if (index >= 0 && index < static_cast<int>(plugin.parameters.size())) {
+        plugin.parameters[index] = value;
+    }
+}
+
+float VST_CALL_CONV NullPlugin::get_parameter(AEffect* effect, int index) {
+    NullPlugin& plugin = get(effect);
+    if (index >= 0 && index < static_cast<int>(plugin.parameters.size())) {
+        return plugin.parameters[index];
+    } else {
+        return 0.0f;
+    }
+}
+
+void NullPlugin::echo_events() {
+    if (echoed_events.empty()) {
+        return;
+    }
+
+    // `VstEvents` is a variable length struct, so we'll allocate enough space
+    // for all of the event pointers. Since the events are echoed from the
+    // audio thread, this avoids allocations after the first cycle.
+    static thread_local std::vector<char> events_buffer;
+    events_buffer.resize(sizeof(VstEvents) +
+                         sizeof(VstEvent*) * echoed_events.size());
+
+    auto& events = *reinterpret_cast<VstEvents*>(events_buffer.data());
+    events.numEvents = static_cast<int>(echoed_events.size());
+    events.reserved = nullptr;
+    for (size_t i = 0; i < echoed_events.size(); i++) {
+        events.events[i] = reinterpret_cast<VstEvent*>(&echoed_events[i]);
+    }
+
+    host_callback(&effect, audioMasterProcessEvents, 0, 0, &events, 0.0f);
+    echoed_events.clear();
+}
+
+}  // namespace
+
+extern "C" __declspec(dllexport) AEffect* VSTPluginMain(
+    audioMasterCallback host_callback) {
+    NullPlugin* plugin = new NullPlugin(host_callback);
+
+    return &plugin->effect;
+}
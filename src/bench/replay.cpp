@@ -0,0 +1,1218 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ghc/filesystem.hpp>
+
+// Generated inside of the build directory
+#include <version.h>
+
+#include "../common/communication/recorder.h"
+#include "latency-summary.h"
+
+// `yabridge-replay` works with the capture files written by yabridge when the
+// `YABRIDGE_CAPTURE_DIR` environment variable is set. See
+// `src/common/communication/recorder.h` for the format.
+//
+// - `yabridge-replay summary <capture>` prints statistics for every socket
+//   connection in the capture, like the number of messages, the number of
+//   threads that sent them, and how long the other side took to respond.
+// - `yabridge-replay replay <capture>` launches a new Wine plugin host for the
+//   recorded plugin and then takes the place of the native plugin. The recorded
+//   requests are sent to the Wine plugin host in their original order, the Wine
+//   plugin host's callbacks are answered with the recorded responses, and the
+//   round trip times are compared to the recorded ones. This makes it possible
+//   to reproduce and profile a session without the DAW that produced it.
+//
+// Replaying is best effort. Requests are sent in the order they were recorded
+// in, and a request is only sent once every response that was received before
+// it in the original session has been received again. Callbacks from the Wine
+// plugin host are answered with the responses recorded for that connection
+// without looking at their contents, so if the Wine plugin host behaves
+// differently than it did during the recording (for instance because the
+// plugin's state differs), then the replay can diverge. The results are
+// written to STDOUT as JSON.
+
+namespace fs = ghc::filesystem;
+
+namespace {
+
+/**
+ * A single record from a capture file.
+ */
+struct Record {
+    CaptureRecordType type;
+    uint32_t channel;
+    uint64_t timestamp_ns;
+    uint64_t thread_id;
+    std::vector<uint8_t> payload;
+};
+
+/**
+ * A recorded socket connection, and the messages sent over it in order.
+ */
+struct Channel {
+    uint32_t id;
+    CaptureChannelKind kind;
+    std::string endpoint;
+    std::vector<const Record*> messages;
+
+    /**
+     * Whether the native plugin sent the first message on this connection.
+     * Otherwise the Wine plugin host sends the requests and the native plugin
+     * responds to them.
+     */
+    bool native_initiated() const noexcept {
+        return !messages.empty() &&
+               messages.front()->type == CaptureRecordType::sent;
+    }
+
+    /**
+     * The secondary connections made by the Wine plugin host need to be
+     * accepted, the others need to be connected to.
+     */
+    bool is_primary() const noexcept {
+        return kind == CaptureChannelKind::primary_accepted ||
+               kind == CaptureChannelKind::primary_connected;
+    }
+};
+
+struct Capture {
+    /**
+     * The key value pairs from the capture's `info` record.
+     */
+    std::map<std::string, std::string> info;
+
+    /**
+     * All records in the capture. This is a deque so the pointers in
+     * `Channel::messages` stay valid.
+     */
+    std::deque<Record> records;
+
+    /**
+     * All connections, in the order they were established in.
+     */
+    std::vector<Channel> channels;
+};
+
+Capture read_capture(const fs::path& path) {
+    std::ifstream file(path.string(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open '" + path.string() + "'");
+    }
+
+    char magic[sizeof(capture_magic)];
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, capture_magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("'" + path.string() +
+                                 "' is not a yabridge capture file, or it was "
+                                 "written by an incompatible version");
+    }
+
+    Capture capture;
+    std::unordered_map<uint32_t, size_t> channel_indices;
+    CaptureRecordHeader header;
+    while (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        Record& record = capture.records.emplace_back(
+            Record{.type = static_cast<CaptureRecordType>(header.type),
+                   .channel = header.channel,
+                   .timestamp_ns = header.timestamp_ns,
+                   .thread_id = header.thread_id,
+                   .payload = std::vector<uint8_t>(header.size)});
+        if (!file.read(reinterpret_cast<char*>(record.payload.data()),
+                       static_cast<std::streamsize>(header.size))) {
+            // This happens when the host crashed or got killed while recording
+            std::cerr << "Warning: the capture file is truncated" << std::endl;
+            capture.records.pop_back();
+            break;
+        }
+
+        switch (record.type) {
+            case CaptureRecordType::info: {
+                std::istringstream lines(std::string(record.payload.begin(),
+                                                     record.payload.end()));
+                std::string line;
+                while (std::getline(lines, line)) {
+                    if (const size_t separator = line.find('=');
+                        separator != std::string::npos) {
+                        capture.info[line.substr(0, separator)] =
+                            line.substr(separator + 1);
+                    }
+                }
+            } break;
+            case CaptureRecordType::channel: {
+                if (record.payload.empty()) {
+                    throw std::runtime_error("Malformed channel record");
+                }
+
+                channel_indices[record.channel] = capture.channels.size();
+                capture.channels.push_back(Channel{
+                    .id = record.channel,
+                    .kind = static_cast<CaptureChannelKind>(record.payload[0]),
+                    .endpoint = std::string(record.payload.begin() + 1,
+                                            record.payload.end()),
+                    .messages = {}});
+            } break;
+            case CaptureRecordType::sent:
+            case CaptureRecordType::received: {
+                const auto index = channel_indices.find(record.channel);
+                if (index == channel_indices.end()) {
+                    throw std::runtime_error(
+                        "Message for unknown channel " +
+                        std::to_string(record.channel));
+                }
+
+                capture.channels[index->second].messages.push_back(&record);
+            } break;
+            default:
+                // Unknown record types from newer versions can be skipped
+                break;
+        }
+    }
+
+    return capture;
+}
+
+const char* kind_to_string(CaptureChannelKind kind) {
+    switch (kind) {
+        case CaptureChannelKind::primary_accepted:
+            return "primary_accepted";
+        case CaptureChannelKind::primary_connected:
+            return "primary_connected";
+        case CaptureChannelKind::secondary_accepted:
+            return "secondary_accepted";
+        case CaptureChannelKind::secondary_connected:
+            return "secondary_connected";
+        default:
+            return "unknown";
+    }
+}
+
+std::string json_string(const std::string& value) {
+    std::ostringstream result;
+    result << '"';
+    for (const char c : value) {
+        switch (c) {
+            case '"':
+                result << "\\\"";
+                break;
+            case '\\':
+                result << "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    result << "\\u" << std::hex << std::setw(4)
+                           << std::setfill('0') << static_cast<int>(c)
+                           << std::dec;
+                } else {
+                    result << c;
+                }
+                break;
+        }
+    }
+    result << '"';
+
+    return result.str();
+}
+
+/**
+ * The time between every request on a channel and the response to that
+ * request, in nanoseconds. For channels where the native plugin sends the
+ * requests these are round trip times. When the Wine plugin host sends the
+ * requests, this is how long the native plugin took to respond.
+ */
+std::vector<uint64_t> response_times(const Channel& channel) {
+    std::vector<uint64_t> result;
+    if (channel.messages.empty()) {
+        return result;
+    }
+
+    const CaptureRecordType request_type = channel.messages.front()->type;
+    for (size_t i = 1; i < channel.messages.size(); i++) {
+        if (channel.messages[i - 1]->type == request_type &&
+            channel.messages[i]->type != request_type) {
+            result.push_back(channel.messages[i]->timestamp_ns -
+                             channel.messages[i - 1]->timestamp_ns);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Messages using the fixed layout wire format start with a 16 byte
+ * `FixedLayoutHeader` (a tag, a version, and a 64-bit size) instead of a 64-bit
+ * length prefix. We can tell the two apart by checking which of the sizes
+ * matches the recorded message.
+ */
+bool is_fixed_layout_message(const std::vector<uint8_t>& message) {
+    if (message.size() < sizeof(uint64_t) * 2) {
+        return false;
+    }
+
+    uint64_t length_prefix;
+    uint64_t fixed_layout_size;
+    std::memcpy(&length_prefix, message.data(), sizeof(uint64_t));
+    std::memcpy(&fixed_layout_size, message.data() + sizeof(uint64_t),
+                sizeof(uint64_t));
+
+    return length_prefix != message.size() - sizeof(uint64_t) &&
+           fixed_layout_size == message.size() - (sizeof(uint64_t) * 2);
+}
+
+int print_summary(const fs::path& capture_path, const Capture& capture) {
+    uint64_t first_timestamp = 0;
+    uint64_t last_timestamp = 0;
+    if (!capture.records.empty()) {
+        first_timestamp = capture.records.front().timestamp_ns;
+        last_timestamp = capture.records.back().timestamp_ns;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\n"
+              << "  \"capture\": " << json_string(capture_path.string())
+              << ",\n"
+              << "  \"version\": "
+              << json_string(capture.info.contains("version")
+                                 ? capture.info.at("version")
+                                 : "")
+              << ",\n"
+              << "  \"plugin_type\": "
+              << json_string(capture.info.contains("plugin_type")
+                                 ? capture.info.at("plugin_type")
+                                 : "")
+              << ",\n"
+              << "  \"plugin_path\": "
+              << json_string(capture.info.contains("plugin_path")
+                                 ? capture.info.at("plugin_path")
+                                 : "")
+              << ",\n"
+              << "  \"duration_s\": "
+              << (last_timestamp - first_timestamp) / 1e9 << ",\n"
+              << "  \"channels\": [";
+    for (size_t i = 0; i < capture.channels.size(); i++) {
+        const Channel& channel = capture.channels[i];
+
+        uint64_t bytes = 0;
+        std::set<uint64_t> threads;
+        for (const Record* message : channel.messages) {
+            bytes += message->payload.size();
+            threads.insert(message->thread_id);
+        }
+
+        std::vector<uint64_t> durations_ns = response_times(channel);
+        std::cout << (i == 0 ? "\n" : ",\n") << "    {\"id\": " << channel.id
+                  << ", \"endpoint\": " << json_string(channel.endpoint)
+                  << ", \"kind\": \"" << kind_to_string(channel.kind)
+                  << "\", \"initiator\": \""
+                  << (channel.native_initiated() ? "native" : "wine")
+                  << "\", \"messages\": " << channel.messages.size()
+                  << ", \"bytes\": " << bytes
+                  << ", \"threads\": " << threads.size()
+                  << ", \"response_time_us\": ";
+        LatencySummary(durations_ns).write_json(std::cout);
+        std::cout << "}";
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return 0;
+}
+
+/**
+ * Set when the replay should stop, either because it's done or because the
+ * Wine plugin host exited. All blocking socket operations check this
+ * periodically.
+ */
+std::atomic_bool stopping = false;
+
+/**
+ * Thrown from the socket functions below when `stopping` gets set.
+ */
+class ReplayStopped : public std::runtime_error {
+   public:
+    ReplayStopped() : std::runtime_error("The replay was stopped") {}
+};
+
+/**
+ * Make blocking reads and writes on `fd` time out periodically so they can
+ * check `stopping`.
+ */
+void set_socket_timeouts(int fd) {
+    const timeval timeout{.tv_sec = 0, .tv_usec = 100'000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+void read_exact(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t result = recv(fd, data, size, 0);
+        if (result > 0) {
+            data += result;
+            size -= static_cast<size_t>(result);
+        } else if (result == 0) {
+            throw std::runtime_error(
+                "The Wine plugin host closed the connection");
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            if (stopping) {
+                throw ReplayStopped();
+            }
+        } else {
+            throw std::system_error(errno, std::generic_category(), "recv()");
+        }
+    }
+}
+
+void write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t result = send(fd, data, size, MSG_NOSIGNAL);
+        if (result >= 0) {
+            data += result;
+            size -= static_cast<size_t>(result);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            if (stopping) {
+                throw ReplayStopped();
+            }
+        } else {
+            throw std::system_error(errno, std::generic_category(), "send()");
+        }
+    }
+}
+
+/**
+ * Read a single message from a socket. The format of the message (either a
+ * regular length prefixed message, or a fixed layout message) is taken from
+ * the message that was received at this point during the recording.
+ */
+void read_message(int fd,
+                  const Record& recorded,
+                  std::vector<uint8_t>& buffer) {
+    const size_t header_size = is_fixed_layout_message(recorded.payload)
+                                   ? sizeof(uint64_t) * 2
+                                   : sizeof(uint64_t);
+
+    buffer.resize(header_size);
+    read_exact(fd, buffer.data(), header_size);
+
+    // The size is always the last field in the header
+    uint64_t size;
+    std::memcpy(&size, buffer.data() + header_size - sizeof(uint64_t),
+                sizeof(uint64_t));
+    buffer.resize(header_size + size);
+    read_exact(fd, buffer.data() + header_size, size);
+}
+
+sockaddr_un make_address(const fs::path& endpoint) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    const std::string path = endpoint.string();
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path '" + path + "' is too long");
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    return address;
+}
+
+int listen_on(const fs::path& endpoint) {
+    const sockaddr_un address = make_address(endpoint);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "socket()");
+    }
+
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) == -1 ||
+        listen(fd, SOMAXCONN) == -1) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "Could not listen on '" + endpoint.string() +
+                                    "'");
+    }
+
+    return fd;
+}
+
+int accept_on(int listener) {
+    pollfd poll_fd{.fd = listener, .events = POLLIN, .revents = 0};
+    while (true) {
+        if (stopping) {
+            throw ReplayStopped();
+        }
+
+        if (poll(&poll_fd, 1, 100) > 0) {
+            const int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd != -1) {
+                set_socket_timeouts(fd);
+                return fd;
+            }
+        }
+    }
+}
+
+/**
+ * Connect to a socket the Wine plugin host is listening on. The Wine plugin
+ * host may not be listening yet, so this retries for a while.
+ */
+int connect_to(const fs::path& endpoint, std::chrono::seconds timeout) {
+    const sockaddr_un address = make_address(endpoint);
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        if (stopping) {
+            throw ReplayStopped();
+        }
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "socket()");
+        }
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                    sizeof(address)) == 0) {
+            set_socket_timeouts(fd);
+            return fd;
+        }
+
+        close(fd);
+        if (std::chrono::steady_clock::now() > deadline) {
+            throw std::runtime_error("Timed out while connecting to '" +
+                                     endpoint.string() + "'");
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+/**
+ * Decides when the requests sent by the native plugin can be replayed. Request
+ * `i`, in the order they were recorded in, is sent once requests `0` through
+ * `i - 1` have been sent, and once every response that the native plugin
+ * received before sending request `i` during the recording has also been
+ * received during the replay. This preserves the causal order between
+ * connections without needing to know anything about the messages themselves.
+ */
+class ReplayOrder {
+   public:
+    explicit ReplayOrder(const Capture& capture) {
+        std::vector<const Record*> requests;
+        std::vector<const Record*> responses;
+        for (const Channel& channel : capture.channels) {
+            if (!channel.native_initiated()) {
+                continue;
+            }
+
+            for (const Record* message : channel.messages) {
+                if (message->type == CaptureRecordType::sent) {
+                    requests.push_back(message);
+                } else {
+                    responses.push_back(message);
+                }
+            }
+        }
+
+        const auto by_timestamp = [](const Record* a, const Record* b) {
+            return a->timestamp_ns < b->timestamp_ns;
+        };
+        std::stable_sort(requests.begin(), requests.end(), by_timestamp);
+        std::stable_sort(responses.begin(), responses.end(), by_timestamp);
+
+        for (size_t i = 0; i < requests.size(); i++) {
+            const auto preceding_responses = std::lower_bound(
+                responses.begin(), responses.end(), requests[i],
+                by_timestamp);
+            requests_[requests[i]] = Request{
+                .index = i,
+                .required_responses = static_cast<size_t>(
+                    preceding_responses - responses.begin())};
+        }
+        for (size_t i = 0; i < responses.size(); i++) {
+            response_indices_[responses[i]] = i;
+        }
+        received_.assign(responses.size(), false);
+
+        if (!requests.empty()) {
+            first_request_ns_ = requests.front()->timestamp_ns;
+        }
+    }
+
+    /**
+     * Block until `request` can be sent.
+     *
+     * @param pace If set, also wait until the same amount of time has passed
+     *   since `start` as there was between the first request and this request
+     *   during the recording.
+     *
+     * @throw ReplayStopped If the replay gets stopped while waiting.
+     */
+    void wait_for_turn(
+        const Record* request,
+        std::optional<std::chrono::steady_clock::time_point> pace) {
+        const Request& info = requests_.at(request);
+
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [&]() {
+            return stopping || (next_request_ == info.index &&
+                                received_prefix_ >= info.required_responses);
+        });
+        if (stopping) {
+            throw ReplayStopped();
+        }
+
+        if (pace) {
+            std::this_thread::sleep_until(
+                *pace + std::chrono::nanoseconds(request->timestamp_ns -
+                                                 first_request_ns_));
+        }
+    }
+
+    /**
+     * Allow the next request to be sent. Called after `request` has been
+     * written to the socket.
+     */
+    void mark_sent() {
+        {
+            std::lock_guard lock(mutex_);
+            next_request_++;
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * Mark a response as received.
+     */
+    void mark_received(const Record* response) {
+        {
+            std::lock_guard lock(mutex_);
+            received_[response_indices_.at(response)] = true;
+            while (received_prefix_ < received_.size() &&
+                   received_[received_prefix_]) {
+                received_prefix_++;
+            }
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * Wake up all waiting threads after setting `stopping`.
+     */
+    void stop() {
+        { std::lock_guard lock(mutex_); }
+        cv_.notify_all();
+    }
+
+   private:
+    struct Request {
+        size_t index;
+        size_t required_responses;
+    };
+
+    std::unordered_map<const Record*, Request> requests_;
+    std::unordered_map<const Record*, size_t> response_indices_;
+    uint64_t first_request_ns_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t next_request_ = 0;
+    std::vector<bool> received_;
+    /**
+     * The number of responses at the start of `received_` that have all been
+     * received.
+     */
+    size_t received_prefix_ = 0;
+};
+
+/**
+ * After the native plugin accepts the primary socket connection of an
+ * `AdHocSocketHandler`, the Wine plugin host may make additional connections
+ * to the same endpoint when the primary socket is busy. These connections are
+ * handed to the recorded secondary connections in the order they were
+ * recorded in.
+ */
+struct SecondaryListener {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int fd = -1;
+    size_t next_turn = 0;
+};
+
+struct ChannelResult {
+    std::vector<uint64_t> recorded_ns;
+    std::vector<uint64_t> replayed_ns;
+    size_t replayed_messages = 0;
+    /**
+     * The number of received messages with a different size than the one
+     * received during the recording. A large number here means that the replay
+     * diverged from the recording.
+     */
+    size_t size_mismatches = 0;
+    std::optional<std::string> error;
+};
+
+struct Options {
+    fs::path capture_path;
+    bool summary_only = false;
+    /**
+     * Overrides the recorded Wine plugin host path.
+     */
+    std::optional<fs::path> host_path;
+    /**
+     * Whether to keep the original timing between requests. Otherwise requests
+     * are sent as soon as their dependencies have been met.
+     */
+    bool pace = true;
+};
+
+class Replay {
+   public:
+    Replay(const Capture& capture, const Options& options)
+        : capture_(capture), options_(options), order_(capture) {
+        const char* temp_dir = getenv("YABRIDGE_TEMP_DIR");
+        if (!temp_dir) {
+            temp_dir = getenv("XDG_RUNTIME_DIR");
+        }
+        std::string directory_template =
+            ((temp_dir ? fs::path(temp_dir) : fs::temp_directory_path()) /
+             "yabridge-replay-XXXXXX")
+                .string();
+        if (!mkdtemp(directory_template.data())) {
+            throw std::runtime_error("Could not create a temporary directory");
+        }
+        base_dir_ = directory_template;
+
+        // The Wine plugin host connects to these right after it starts, so
+        // they need to exist before launching it
+        for (const Channel& channel : capture_.channels) {
+            if (channel.kind == CaptureChannelKind::primary_accepted) {
+                if (listeners_.contains(channel.endpoint)) {
+                    throw std::runtime_error(
+                        "Replaying captures with recreated sockets is not "
+                        "supported ('" +
+                        channel.endpoint + "')");
+                }
+
+                listeners_[channel.endpoint] =
+                    listen_on(base_dir_ / channel.endpoint);
+            } else if (channel.kind ==
+                       CaptureChannelKind::secondary_accepted) {
+                auto& listener = secondary_listeners_[channel.endpoint];
+                if (!listener) {
+                    listener = std::make_unique<SecondaryListener>();
+                }
+
+                secondary_turns_[channel.id] =
+                    secondary_turn_counts_[channel.endpoint]++;
+            }
+        }
+    }
+
+    ~Replay() noexcept {
+        for (const auto& [_, fd] : listeners_) {
+            close(fd);
+        }
+        for (const auto& [_, listener] : secondary_listeners_) {
+            if (listener->fd != -1) {
+                close(listener->fd);
+            }
+        }
+
+        std::error_code err;
+        fs::remove_all(base_dir_, err);
+    }
+
+    /**
+     * Launch the Wine plugin host and replay the capture.
+     *
+     * @return Whether every native plugin request was replayed successfully.
+     */
+    bool run() {
+        fs::path host_path =
+            options_.host_path.value_or(capture_.info.at("host_path"));
+
+        // Plugins hosted in a plugin group are replayed using an individual
+        // plugin host, since the group host is launched with different
+        // arguments. The communication with the plugin is the same.
+        if (std::string host_name = host_path.filename().string();
+            host_name.starts_with("yabridge-group")) {
+            host_name.replace(0, std::strlen("yabridge-group"),
+                              "yabridge-host");
+            host_path.replace_filename(host_name);
+        }
+        const std::string pid = std::to_string(getpid());
+        const std::vector<std::string> arguments{
+            host_path.string(), capture_.info.at("plugin_type"),
+            capture_.info.at("plugin_path"), base_dir_.string(), pid};
+        std::vector<char*> argv;
+        for (const std::string& argument : arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        // The Wine plugin host's output should not end up in our JSON output
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, STDERR_FILENO,
+                                         STDOUT_FILENO);
+
+        pid_t host_pid;
+        const int spawn_result =
+            posix_spawn(&host_pid, host_path.c_str(), &actions, nullptr,
+                        argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (spawn_result != 0) {
+            throw std::system_error(spawn_result, std::generic_category(),
+                                    "Could not launch '" + host_path.string() +
+                                        "'");
+        }
+
+        std::cerr << "Launched '" << host_path.string() << "', replaying "
+                  << capture_.channels.size() << " connections..."
+                  << std::endl;
+
+        start_ = std::chrono::steady_clock::now();
+        results_.resize(capture_.channels.size());
+        {
+            std::vector<std::jthread> threads;
+            for (size_t i = 0; i < capture_.channels.size(); i++) {
+                threads.emplace_back([this, i]() { run_channel(i); });
+            }
+
+            // We're done once every request has been answered, or when the Wine
+            // plugin host exits early
+            bool host_exited = false;
+            {
+                std::unique_lock lock(done_mutex_);
+                while (native_channels_done_ < count_native_channels()) {
+                    if (waitpid(host_pid, nullptr, WNOHANG) == host_pid) {
+                        host_exited = true;
+                        break;
+                    }
+
+                    done_cv_.wait_for(lock, std::chrono::milliseconds(50));
+                }
+            }
+            end_ = std::chrono::steady_clock::now();
+
+            // Closing the primary sockets causes the Wine plugin host to shut
+            // down
+            stopping = true;
+            order_.stop();
+            {
+                std::lock_guard lock(done_mutex_);
+                finished_ = true;
+            }
+            done_cv_.notify_all();
+            for (const auto& [_, listener] : secondary_listeners_) {
+                listener->cv.notify_all();
+            }
+
+            if (host_exited) {
+                std::cerr << "The Wine plugin host exited before the replay "
+                             "finished"
+                          << std::endl;
+            } else {
+                const auto deadline = std::chrono::steady_clock::now() +
+                                      std::chrono::seconds(10);
+                while (waitpid(host_pid, nullptr, WNOHANG) != host_pid) {
+                    if (std::chrono::steady_clock::now() > deadline) {
+                        kill(host_pid, SIGKILL);
+                        waitpid(host_pid, nullptr, 0);
+                        break;
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
+        }
+
+        return std::none_of(
+            capture_.channels.begin(), capture_.channels.end(),
+            [&](const Channel& channel) {
+                return channel.native_initiated() &&
+                       results_[&channel - capture_.channels.data()].error;
+            });
+    }
+
+    void write_json(std::ostream& stream) const {
+        uint64_t recorded_ns = 0;
+        if (!capture_.records.empty()) {
+            recorded_ns = capture_.records.back().timestamp_ns -
+                          capture_.records.front().timestamp_ns;
+        }
+        const std::chrono::duration<double> replayed = end_ - start_;
+
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\n"
+               << "  \"capture\": "
+               << json_string(options_.capture_path.string()) << ",\n"
+               << "  \"version\": \"" << yabridge_git_version << "\",\n"
+               << "  \"recorded_version\": "
+               << json_string(capture_.info.contains("version")
+                                  ? capture_.info.at("version")
+                                  : "")
+               << ",\n"
+               << "  \"plugin_path\": "
+               << json_string(capture_.info.at("plugin_path")) << ",\n"
+               << "  \"paced\": " << (options_.pace ? "true" : "false")
+               << ",\n"
+               << "  \"recorded_duration_s\": " << recorded_ns / 1e9 << ",\n"
+               << "  \"replayed_duration_s\": " << replayed.count() << ",\n"
+               << "  \"channels\": [";
+        for (size_t i = 0; i < capture_.channels.size(); i++) {
+            const Channel& channel = capture_.channels[i];
+            ChannelResult result = results_[i];
+
+            stream << (i == 0 ? "\n" : ",\n")
+                   << "    {\"id\": " << channel.id
+                   << ", \"endpoint\": " << json_string(channel.endpoint)
+                   << ", \"kind\": \"" << kind_to_string(channel.kind)
+                   << "\", \"initiator\": \""
+                   << (channel.native_initiated() ? "native" : "wine")
+                   << "\", \"messages\": " << channel.messages.size()
+                   << ", \"replayed_messages\": " << result.replayed_messages
+                   << ", \"size_mismatches\": " << result.size_mismatches;
+            if (channel.native_initiated()) {
+                stream << ", \"recorded_latency_us\": ";
+                LatencySummary(result.recorded_ns).write_json(stream);
+                stream << ", \"replayed_latency_us\": ";
+                LatencySummary(result.replayed_ns).write_json(stream);
+            }
+            if (result.error) {
+                stream << ", \"error\": " << json_string(*result.error);
+            }
+            stream << "}";
+        }
+        stream << "\n  ]\n}" << std::endl;
+    }
+
+   private:
+    size_t count_native_channels() const {
+        return static_cast<size_t>(
+            std::count_if(capture_.channels.begin(), capture_.channels.end(),
+                          [](const Channel& channel) {
+                              return channel.native_initiated();
+                          }));
+    }
+
+    void run_channel(size_t index) {
+        const Channel& channel = capture_.channels[index];
+        ChannelResult& result = results_[index];
+
+        int fd = -1;
+        try {
+            fd = establish_connection(channel);
+            replay_messages(channel, fd, result);
+        } catch (const ReplayStopped&) {
+            if (channel.native_initiated()) {
+                result.error = "Stopped before all requests were replayed";
+            }
+        } catch (const std::exception& error) {
+            result.error = error.what();
+            std::cerr << "Error while replaying connection " << channel.id
+                      << " ('" << channel.endpoint << "'): " << error.what()
+                      << std::endl;
+        }
+
+        {
+            std::unique_lock lock(done_mutex_);
+            if (channel.native_initiated()) {
+                native_channels_done_++;
+                done_cv_.notify_all();
+            }
+
+            // Like in yabridge itself, the primary sockets stay open until
+            // everything shuts down
+            if (channel.is_primary()) {
+                done_cv_.wait(lock, [&]() { return finished_; });
+            }
+        }
+
+        if (fd != -1) {
+            shutdown(fd, SHUT_RDWR);
+            close(fd);
+        }
+    }
+
+    /**
+     * Set up the socket connection for a channel. Connections we make
+     * ourselves are made right before the first request is sent.
+     */
+    int establish_connection(const Channel& channel) {
+        switch (channel.kind) {
+            case CaptureChannelKind::primary_accepted: {
+                const int fd = accept_on(listeners_.at(channel.endpoint));
+
+                // This is what `AdHocSocketHandler::connect()` does. If the
+                // Wine plugin host connects to this endpoint again, then we'll
+                // need to listen for those connections ourselves.
+                const fs::path endpoint = base_dir_ / channel.endpoint;
+                fs::remove(endpoint);
+                if (auto listener =
+                        secondary_listeners_.find(channel.endpoint);
+                    listener != secondary_listeners_.end()) {
+                    {
+                        std::lock_guard lock(listener->second->mutex);
+                        listener->second->fd = listen_on(endpoint);
+                    }
+                    listener->second->cv.notify_all();
+                }
+
+                return fd;
+            } break;
+            case CaptureChannelKind::primary_connected:
+                return connect_to(base_dir_ / channel.endpoint,
+                                  std::chrono::seconds(60));
+                break;
+            case CaptureChannelKind::secondary_accepted: {
+                SecondaryListener& listener =
+                    *secondary_listeners_.at(channel.endpoint);
+                const size_t turn = secondary_turns_.at(channel.id);
+
+                std::unique_lock lock(listener.mutex);
+                listener.cv.wait(lock, [&]() {
+                    return stopping ||
+                           (listener.fd != -1 && listener.next_turn == turn);
+                });
+                if (stopping) {
+                    throw ReplayStopped();
+                }
+
+                const int fd = accept_on(listener.fd);
+                listener.next_turn++;
+                lock.unlock();
+                listener.cv.notify_all();
+
+                return fd;
+            } break;
+            case CaptureChannelKind::secondary_connected:
+            default:
+                // This happens in `replay_messages()`
+                return -1;
+                break;
+        }
+    }
+
+    void replay_messages(const Channel& channel,
+                         int& fd,
+                         ChannelResult& result) {
+        const bool native_initiated = channel.native_initiated();
+        const std::optional<std::chrono::steady_clock::time_point> pace =
+            options_.pace ? std::optional(start_) : std::nullopt;
+
+        std::vector<uint8_t> buffer;
+        const Record* last_request = nullptr;
+        std::chrono::steady_clock::time_point last_request_time;
+        for (const Record* message : channel.messages) {
+            if (message->type == CaptureRecordType::sent) {
+                if (native_initiated) {
+                    order_.wait_for_turn(message, pace);
+                }
+                if (fd == -1) {
+                    fd = connect_to(base_dir_ / channel.endpoint,
+                                    std::chrono::seconds(5));
+                }
+
+                last_request_time = std::chrono::steady_clock::now();
+                write_all(fd, message->payload.data(),
+                          message->payload.size());
+                last_request = message;
+                if (native_initiated) {
+                    order_.mark_sent();
+                }
+            } else {
+                read_message(fd, *message, buffer);
+                if (buffer.size() != message->payload.size()) {
+                    result.size_mismatches++;
+                }
+
+                if (native_initiated) {
+                    if (last_request) {
+                        result.replayed_ns.push_back(static_cast<uint64_t>(
+                            std::chrono::duration_cast<
+                                std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() -
+                                last_request_time)
+                                .count()));
+                        result.recorded_ns.push_back(
+                            message->timestamp_ns -
+                            last_request->timestamp_ns);
+                        last_request = nullptr;
+                    }
+
+                    order_.mark_received(message);
+                }
+            }
+
+            result.replayed_messages++;
+        }
+    }
+
+    const Capture& capture_;
+    const Options& options_;
+    ReplayOrder order_;
+
+    fs::path base_dir_;
+
+    /**
+     * Listening sockets for all primary connections made by the Wine plugin
+     * host, keyed by endpoint name.
+     */
+    std::unordered_map<std::string, int> listeners_;
+    std::unordered_map<std::string, std::unique_ptr<SecondaryListener>>
+        secondary_listeners_;
+    std::unordered_map<std::string, size_t> secondary_turn_counts_;
+    std::unordered_map<uint32_t, size_t> secondary_turns_;
+
+    std::vector<ChannelResult> results_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point end_;
+
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    size_t native_channels_done_ = 0;
+    bool finished_ = false;
+};
+
+void print_usage(const char* program_name) {
+    std::cerr
+        << "yabridge replay tool version " << yabridge_git_version << "\n\n"
+        << "Usage: " << program_name << " summary <capture>\n"
+        << "       " << program_name << " replay [options] <capture>\n\n"
+        << "Captures are written by yabridge when the YABRIDGE_CAPTURE_DIR\n"
+        << "environment variable is set.\n\n"
+        << "Replay options:\n"
+        << "  --host <path>      Use this Wine plugin host instead of the\n"
+        << "                     recorded one\n"
+        << "  --no-pacing        Send requests as soon as possible instead of\n"
+        << "                     keeping the recorded timing\n"
+        << std::flush;
+}
+
+Options parse_options(int argc, char* argv[]) {
+    if (argc < 2) {
+        throw std::invalid_argument("Missing command");
+    }
+
+    Options options{};
+    const std::string command(argv[1]);
+    if (command == "--help" || command == "-h") {
+        print_usage(argv[0]);
+        std::exit(0);
+    } else if (command == "summary") {
+        options.summary_only = true;
+    } else if (command != "replay") {
+        throw std::invalid_argument("Unknown command '" + command + "'");
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const std::string argument(argv[i]);
+        if (argument == "--help" || argument == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else if (argument == "--no-pacing" && !options.summary_only) {
+            options.pace = false;
+        } else if (argument == "--host" && !options.summary_only) {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for '" + argument +
+                                            "'");
+            }
+
+            options.host_path = fs::path(argv[++i]);
+        } else if (argument.starts_with("--")) {
+            throw std::invalid_argument("Unknown option '" + argument + "'");
+        } else if (options.capture_path.empty()) {
+            options.capture_path = argument;
+        } else {
+            throw std::invalid_argument("Unexpected argument '" + argument +
+                                        "'");
+        }
+    }
+
+    if (options.capture_path.empty()) {
+        throw std::invalid_argument("Missing capture file");
+    }
+
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n\n";
+        print_usage(argv[0]);
+
+        return 1;
+    }
+
+    try {
+        const Capture capture = read_capture(options.capture_path);
+        if (options.summary_only) {
+            return print_summary(options.capture_path, capture);
+        }
+
+        for (const char* key : {"plugin_type", "plugin_path", "host_path"}) {
+            if (!capture.info.contains(key)) {
+                throw std::runtime_error(
+                    "The capture does not contain the '" + std::string(key) +
+                    "' needed to launch the Wine plugin host");
+            }
+        }
+
+        Replay replay(capture, options);
+        const bool success = replay.run();
+        replay.write_json(std::cout);
+
+        return success ? 0 : 1;
+    } catch (const std::exception& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+
+        return 1;
+    }
+}
@@ -0,0 +1,506 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../common/communication/common.h"
+#include "../common/serialization/vst2.h"
+
+#ifdef WITH_VST3
+#include "../common/serialization/vst3/event-list.h"
+#include "../common/serialization/vst3/parameter-changes.h"
+#include "../common/serialization/vst3/process-data.h"
+#endif
+
+#ifdef WITH_CLAP
+#include "../common/serialization/clap/events.h"
+#endif
+
+// Microbenchmarks for the messages sent during every audio processing cycle.
+// Every case round trips a realistic payload through the same bitsery adapters
+// `write_object()` and `read_object()` use, just without the socket in
+// between, and reports the time per round trip and the number of heap
+// allocations per round trip. Both the sending and the receiving side reuse
+// their objects and buffers between iterations like the bridges do, so once
+// warmed up none of these round trips should allocate. If one does, this
+// benchmark fails, since allocating on the audio thread is not real time safe.
+
+namespace {
+
+/**
+ * The number of heap allocations made since the program started. Counted by
+ * the replaced global `operator new` below.
+ */
+std::atomic_size_t num_allocations = 0;
+
+constexpr int warmup_iterations = 1000;
+constexpr int iterations = 20000;
+
+/**
+ * The results for a single benchmark case.
+ */
+struct CaseResult {
+    std::string name;
+    size_t serialized_size;
+    double ns_per_op;
+    double allocations_per_op;
+};
+
+/**
+ * Serialize `object` to `buffer` and deserialize it again into `received`,
+ * exactly like `write_object()` and `read_object()` would do.
+ *
+ * @return The size of the serialized object.
+ */
+template <typename T>
+size_t round_trip(const T& object,
+                  SerializationBufferBase& buffer,
+                  T& received) {
+    const size_t size =
+        bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
+            buffer, object);
+
+    auto [_, success] =
+        bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
+            {buffer.begin(), size}, received);
+    if (!success) [[unlikely]] {
+        throw std::runtime_error("Deserialization failure in call: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    return size;
+}
+
+/**
+ * `round_trip()` for objects using the fixed layout wire format. Those are
+ * copied as is together with their header.
+ *
+ * @overload
+ */
+template <FixedLayoutMessage T>
+size_t round_trip(const T& object,
+                  SerializationBufferBase& buffer,
+                  T& received) {
+    const FixedLayoutHeader header{
+        .tag = T::wire_tag, .version = T::wire_version, .size = sizeof(T)};
+    buffer.resize_for_overwrite(sizeof(header) + sizeof(T));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + sizeof(header), &object, sizeof(T));
+
+    FixedLayoutHeader received_header;
+    std::memcpy(&received_header, buffer.data(), sizeof(header));
+    std::memcpy(&received, buffer.data() + sizeof(header), sizeof(T));
+    if (received_header.tag != T::wire_tag ||
+        received_header.version != T::wire_version ||
+        received_header.size != sizeof(T)) [[unlikely]] {
+        throw std::runtime_error("Unexpected fixed layout message header in: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    return sizeof(header) + sizeof(T);
+}
+
+/**
+ * Run `cycle()` `warmup_iterations` times, and then measure how long
+ * `iterations` calls take and how many allocations they make. `cycle()` should
+ * perform a single round trip and return the serialized size.
+ */
+CaseResult run_case(std::string name, const std::function<size_t()>& cycle) {
+    size_t serialized_size = 0;
+    for (int i = 0; i < warmup_iterations; i++) {
+        serialized_size = cycle();
+    }
+
+    const size_t allocations_before = num_allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        cycle();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const size_t allocations_after = num_allocations.load();
+
+    return CaseResult{
+        .name = std::move(name),
+        .serialized_size = serialized_size,
+        .ns_per_op = static_cast<double>(
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             end - start)
+                             .count()) /
+                     iterations,
+        .allocations_per_op =
+            static_cast<double>(allocations_after - allocations_before) /
+            iterations};
+}
+
+/**
+ * A VST2 MIDI event list with `num_events` note on and note off events, and
+ * optionally a single SysEx event.
+ */
+DynamicVstEvents make_vst2_events(int num_events, bool with_sysex) {
+    DynamicVstEvents events{};
+    for (int i = 0; i < num_events; i++) {
+        VstMidiEvent event{};
+        event.type = kVstMidiType;
+        event.byteSize = sizeof(VstMidiEvent);
+        event.deltaFrames = i % 512;
+        event.midiData[0] = static_cast<char>(i % 2 == 0 ? 0x90 : 0x80);
+        event.midiData[1] = static_cast<char>(i % 128);
+        event.midiData[2] = 100;
+
+        VstEvent& generic_event = events.events_.emplace_back();
+        std::memcpy(&generic_event, &event, sizeof(event));
+    }
+
+    if (with_sysex) {
+        // A typical bulk dump a hardware controller might send
+        std::string sysex_data(1024, '\0');
+        sysex_data.front() = static_cast<char>(0xf0);
+        sysex_data.back() = static_cast<char>(0xf7);
+
+        VstMidiSysExEvent event{};
+        event.type = kVstSysExType;
+        event.byteSize = sizeof(VstMidiSysExEvent);
+        event.dumpBytes = static_cast<int>(sysex_data.size());
+
+        // Like in `DynamicVstEvents`'s constructor, only the first
+        // `sizeof(VstEvent)` bytes are stored. The pointer to the data gets
+        // restored in `DynamicVstEvents::as_c_events()`.
+        const native_size_t index = events.events_.size();
+        VstEvent& generic_event = events.events_.emplace_back();
+        std::memcpy(&generic_event, &event,
+                    std::min(sizeof(event), sizeof(generic_event)));
+        events.sysex_data_.emplace_back(index, std::move(sysex_data));
+    }
+
+    return events;
+}
+
+/**
+ * A VST2 audio processing request with a typical set of transport information.
+ */
+Vst2ProcessRequest make_vst2_process_request() {
+    VstTimeInfo time_info{};
+    time_info.samplePos = 48000.0;
+    time_info.sampleRate = 48000.0;
+    time_info.ppqPos = 2.0;
+    time_info.tempo = 120.0;
+    time_info.timeSigNumerator = 4;
+    time_info.timeSigDenominator = 4;
+    time_info.flags = kVstTransportPlaying | kVstPpqPosValid | kVstTempoValid |
+                      kVstTimeSigValid;
+
+    Vst2ProcessRequest request{};
+    request.current_time_info = time_info;
+    request.has_current_time_info = true;
+    request.sample_frames = 512;
+    request.current_process_level = 2;
+
+    return request;
+}
+
+std::vector<CaseResult> run_vst2_cases() {
+    std::vector<CaseResult> results;
+    SerializationBuffer<256> buffer{};
+
+    for (const auto& [name, num_events, with_sysex] :
+         {std::tuple("DynamicVstEvents (64 MIDI events)", 64, false),
+          std::tuple("DynamicVstEvents (512 MIDI events)", 512, false),
+          std::tuple("DynamicVstEvents (64 MIDI events + SysEx)", 64, true)}) {
+        const DynamicVstEvents events = make_vst2_events(num_events, with_sysex);
+        DynamicVstEvents received{};
+        results.push_back(run_case(
+            name, [&]() { return round_trip(events, buffer, received); }));
+    }
+
+    {
+        const Vst2ProcessRequest request = make_vst2_process_request();
+        Vst2ProcessRequest received{};
+        results.push_back(run_case("Vst2ProcessRequest", [&]() {
+            return round_trip(request, buffer, received);
+        }));
+    }
+
+    return results;
+}
+
+#ifdef WITH_VST3
+
+/**
+ * Dense automation: `num_parameters` parameters with a point on every
+ * `1 / points_per_parameter`th of a 512 sample buffer.
+ */
+void make_vst3_parameter_changes(YaParameterChanges& changes,
+                                 int num_parameters,
+                                 int points_per_parameter) {
+    for (int parameter = 0; parameter < num_parameters; parameter++) {
+        int32 queue_index;
+        Steinberg::Vst::IParamValueQueue* queue = changes.addParameterData(
+            static_cast<Steinberg::Vst::ParamID>(1000 + parameter),
+            queue_index);
+        for (int point = 0; point < points_per_parameter; point++) {
+            int32 point_index;
+            queue->addPoint((point * 512) / points_per_parameter,
+                            static_cast<double>(point) / points_per_parameter,
+                            point_index);
+        }
+    }
+}
+
+void make_vst3_events(YaEventList& events, int num_events) {
+    for (int i = 0; i < num_events; i++) {
+        Steinberg::Vst::Event event{};
+        event.sampleOffset = i % 512;
+        if (i % 2 == 0) {
+            event.type = Steinberg::Vst::Event::kNoteOnEvent;
+            event.noteOn.pitch = static_cast<int16>(i % 128);
+            event.noteOn.velocity = 0.8f;
+            event.noteOn.noteId = i;
+        } else {
+            event.type = Steinberg::Vst::Event::kNoteOffEvent;
+            event.noteOff.pitch = static_cast<int16>(i % 128);
+            event.noteOff.velocity = 0.0f;
+            event.noteOff.noteId = i - 1;
+        }
+
+        events.addEvent(event);
+    }
+}
+
+std::vector<CaseResult> run_vst3_cases() {
+    std::vector<CaseResult> results;
+    SerializationBuffer<256> buffer{};
+
+    // The sending side copies the host's objects into persistent objects every
+    // cycle using `repopulate()`, so that's part of the round trip as well
+    {
+        YaParameterChanges host_changes{};
+        make_vst3_parameter_changes(host_changes, 64, 32);
+
+        YaParameterChanges changes{};
+        YaParameterChanges received{};
+        results.push_back(run_case(
+            "YaParameterChanges (64 parameters, 32 points each)", [&]() {
+                changes.repopulate(host_changes);
+                return round_trip(changes, buffer, received);
+            }));
+    }
+
+    {
+        YaEventList host_events{};
+        make_vst3_events(host_events, 512);
+
+        YaEventList events{};
+        YaEventList received{};
+        results.push_back(run_case("YaEventList (512 note events)", [&]() {
+            events.repopulate(host_events);
+            return round_trip(events, buffer, received);
+        }));
+    }
+
+    {
+        // A 64 channel input and output bus together with the above automation
+        // and events. The audio itself is sent through shared memory.
+        YaProcessData process_data{};
+        process_data.process_mode_ = Steinberg::Vst::kRealtime;
+        process_data.symbolic_sample_size_ = Steinberg::Vst::kSample32;
+        process_data.num_samples_ = 512;
+        process_data.inputs_.emplace_back().numChannels = 64;
+        process_data.outputs_.emplace_back().numChannels = 64;
+        make_vst3_parameter_changes(process_data.input_parameter_changes_, 64,
+                                    32);
+        process_data.output_parameter_changes_.emplace();
+        make_vst3_events(process_data.input_events_.emplace(), 512);
+        process_data.output_events_.emplace();
+
+        Steinberg::Vst::ProcessContext context{};
+        context.state = Steinberg::Vst::ProcessContext::kPlaying |
+                        Steinberg::Vst::ProcessContext::kTempoValid |
+                        Steinberg::Vst::ProcessContext::kProjectTimeMusicValid;
+        context.sampleRate = 48000.0;
+        context.projectTimeSamples = 48000;
+        context.projectTimeMusic = 2.0;
+        context.tempo = 120.0;
+        TransportDeltaState<Steinberg::Vst::ProcessContext> context_state{};
+        context_state.encode(process_data.process_context_, &context, 512);
+
+        YaProcessData received{};
+        results.push_back(run_case(
+            "YaProcessData (64 channel buses, automation, 512 events)",
+            [&]() { return round_trip(process_data, buffer, received); }));
+    }
+
+    return results;
+}
+
+#endif
+
+#ifdef WITH_CLAP
+
+std::vector<CaseResult> run_clap_cases() {
+    std::vector<CaseResult> results;
+    SerializationBuffer<256> buffer{};
+
+    // The host's event list. We'll add the events through the output events
+    // vtable, and the sending side then copies them from the input events
+    // vtable like it would with the host's events.
+    clap::events::EventList host_events{};
+    const clap_output_events_t* out_events = host_events.output_events();
+    for (uint32_t i = 0; i < 512; i++) {
+        if (i % 4 == 3) {
+            const clap_event_param_value_t event{
+                .header = {.size = sizeof(clap_event_param_value_t),
+                           .time = i % 512,
+                           .space_id = CLAP_CORE_EVENT_SPACE_ID,
+                           .type = CLAP_EVENT_PARAM_VALUE,
+                           .flags = 0},
+                .param_id = 1000 + (i % 64),
+                .cookie = nullptr,
+                .note_id = -1,
+                .port_index = -1,
+                .channel = -1,
+                .key = -1,
+                .value = static_cast<double>(i) / 512.0};
+            out_events->try_push(out_events, &event.header);
+        } else {
+            const clap_event_note_t event{
+                .header = {.size = sizeof(clap_event_note_t),
+                           .time = i % 512,
+                           .space_id = CLAP_CORE_EVENT_SPACE_ID,
+                           .type = static_cast<uint16_t>(
+                               i % 2 == 0 ? CLAP_EVENT_NOTE_ON
+                                          : CLAP_EVENT_NOTE_OFF),
+                           .flags = 0},
+                .note_id = static_cast<int32_t>(i),
+                .port_index = 0,
+                .channel = 0,
+                .key = static_cast<int16_t>(i % 128),
+                .velocity = 0.8};
+            out_events->try_push(out_events, &event.header);
+        }
+    }
+
+    clap::events::EventList events{};
+    clap::events::EventList received{};
+    results.push_back(run_case(
+        "clap::events::EventList (384 note and 128 parameter events)", [&]() {
+            events.repopulate(*host_events.input_events());
+            return round_trip(events, buffer, received);
+        }));
+
+    return results;
+}
+
+#endif
+
+}  // namespace
+
+// The allocation counter. The other forms of `operator new` all end up calling
+// one of these two.
+void* operator new(std::size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(
+            align, ((std::max<size_t>(size, 1) + align - 1) / align) * align)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr,
+                     std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+    std::free(ptr);
+}
+
+int main() {
+    std::vector<CaseResult> results;
+    try {
+        for (auto& result : run_vst2_cases()) {
+            results.push_back(std::move(result));
+        }
+#ifdef WITH_VST3
+        for (auto& result : run_vst3_cases()) {
+            results.push_back(std::move(result));
+        }
+#endif
+#ifdef WITH_CLAP
+        for (auto& result : run_clap_cases()) {
+            results.push_back(std::move(result));
+        }
+#endif
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    bool allocated = false;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const CaseResult& result : results) {
+        std::cout << std::left << std::setw(64) << result.name << std::right
+                  << std::setw(10) << result.ns_per_op << " ns/op"
+                  << std::setw(10) << result.serialized_size << " bytes"
+                  << std::setw(8) << std::setprecision(2)
+                  << result.allocations_per_op << " allocs/op"
+                  << std::setprecision(1) << std::endl;
+
+        if (result.allocations_per_op > 0.0) {
+            allocated = true;
+        }
+    }
+
+    if (allocated) {
+        std::cerr << std::endl
+                  << "One or more audio processing messages allocated during "
+                     "steady state operation"
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -16,21 +16,31 @@
 
 #include "audio-shm.h"
 
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <unistd.h>
 #include <iostream>
 
 #include "logging/common.h"
 
 using namespace std::literals::string_literals;
 
-AudioShmBuffer::AudioShmBuffer(const Config& config)
-    : config_(config),
-      shm_fd_(shm_open(config.name.c_str(), O_RDWR | O_CREAT, 0600)) {
-    if (shm_fd_ == -1) {
-        throw std::system_error(
-            std::error_code(errno, std::system_category()),
-            "Could not create shared memory object " + config_.name);
-    }
+/**
+ * The size of the huge pages used with `Backing::memfd_hugetlb`. The mapped
+ * size needs to be a multiple of this.
+ */
+constexpr size_t huge_page_size = 2 << 20;
+
+namespace {
+
+size_t round_up(size_t size, size_t multiple) noexcept {
+    return ((size + multiple - 1) / multiple) * multiple;
+}
+
+}  // namespace
 
+AudioShmBuffer::AudioShmBuffer(const Config& config) : config_(config) {
+    open_backing();
     setup_mapping();
 }
 
@@ -39,15 +49,17 @@ AudioShmBuffer::~AudioShmBuffer() noexcept {
     // removed, so we'll do it on both sides to reduce the chance that we leak
     // shared memory
     if (!is_moved_) {
-        munmap(shm_bytes_, config_.size);
-        close(shm_fd_);
-        shm_unlink(config_.name.c_str());
+        if (shm_bytes_) {
+            munmap(shm_bytes_, shm_size_);
+        }
+        close_backing();
     }
 }
 
 AudioShmBuffer::AudioShmBuffer(AudioShmBuffer&& o) noexcept
     : config_(std::move(o.config_)),
       shm_fd_(std::move(o.shm_fd_)),
+      owns_memfd_(std::move(o.owns_memfd_)),
       shm_bytes_(std::move(o.shm_bytes_)),
       shm_size_(std::move(o.shm_size_)) {
     o.is_moved_ = true;
@@ -56,6 +68,7 @@ AudioShmBuffer::AudioShmBuffer(AudioShmBuffer&& o) noexcept
 AudioShmBuffer& AudioShmBuffer::operator=(AudioShmBuffer&& o) noexcept {
     config_ = std::move(o.config_);
     shm_fd_ = std::move(o.shm_fd_);
+    owns_memfd_ = std::move(o.owns_memfd_);
     shm_bytes_ = std::move(o.shm_bytes_);
     shm_size_ = std::move(o.shm_size_);
     o.is_moved_ = true;
@@ -70,52 +83,181 @@ void AudioShmBuffer::resize(const Config& new_config) {
                                     new_config.name + "\"");
     }
 
+    // The side that created the memfd keeps using it. The Wine plugin host
+    // computes the new configuration from scratch, so it won't contain the
+    // memfd's path.
+    Config old_config = std::move(config_);
     config_ = new_config;
+    if (owns_memfd_) {
+        config_.backing = old_config.backing;
+        config_.memfd_path = old_config.memfd_path;
+    } else if (config_.backing != old_config.backing ||
+               config_.memfd_path != old_config.memfd_path) {
+        // The Wine plugin host may have had to fall back from huge pages to a
+        // regular memfd. POSIX shared memory objects are never swapped out
+        // like this, so there's nothing to unlink here.
+        if (shm_bytes_) {
+            munmap(shm_bytes_, shm_size_);
+            shm_bytes_ = nullptr;
+            shm_size_ = 0;
+        }
+        close(shm_fd_);
+        shm_fd_ = -1;
+
+        open_backing();
+    }
+
     setup_mapping();
 }
 
+void AudioShmBuffer::open_backing() {
+    if (config_.backing != Config::Backing::posix_shm) {
+        if (!config_.memfd_path.empty()) {
+            shm_fd_ = open(config_.memfd_path.c_str(), O_RDWR | O_CLOEXEC);
+            if (shm_fd_ == -1) {
+                throw std::system_error(
+                    std::error_code(errno, std::system_category()),
+                    "Could not open shared memory object " +
+                        config_.memfd_path);
+            }
+
+            return;
+        }
+
+        // If explicit huge pages are not available then we'll fall back to a
+        // regular memfd, and to POSIX shared memory if that also fails
+        if (config_.backing == Config::Backing::memfd_hugetlb) {
+            shm_fd_ = memfd_create(config_.name.c_str(),
+                                   MFD_CLOEXEC | MFD_HUGETLB | MFD_HUGE_2MB);
+            if (shm_fd_ == -1) {
+                config_.backing = Config::Backing::memfd;
+            }
+        }
+        if (config_.backing == Config::Backing::memfd) {
+            shm_fd_ = memfd_create(config_.name.c_str(), MFD_CLOEXEC);
+        }
+
+        if (shm_fd_ != -1) {
+            owns_memfd_ = true;
+            config_.memfd_path = "/proc/" + std::to_string(getpid()) +
+                                 "/fd/" + std::to_string(shm_fd_);
+
+            return;
+        }
+
+        config_.backing = Config::Backing::posix_shm;
+        config_.memfd_path.clear();
+    }
+
+    shm_fd_ = shm_open(config_.name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (shm_fd_ == -1) {
+        throw std::system_error(
+            std::error_code(errno, std::system_category()),
+            "Could not create shared memory object " + config_.name);
+    }
+}
+
+void AudioShmBuffer::close_backing() noexcept {
+    if (shm_fd_ != -1) {
+        close(shm_fd_);
+        shm_fd_ = -1;
+    }
+    if (config_.backing == Config::Backing::posix_shm) {
+        shm_unlink(config_.name.c_str());
+    }
+
+    owns_memfd_ = false;
+}
+
 void AudioShmBuffer::setup_mapping() {
+    // We always create a new mapping instead of growing the old one with
+    // `mremap()`. Huge page mappings can't always be grown in place, and a
+    // fresh mapping lets `MAP_POPULATE` prefault the entire buffer so the
+    // first processing cycle after a resize won't trigger any page faults.
+    if (shm_bytes_) {
+        munmap(shm_bytes_, shm_size_);
+        shm_bytes_ = nullptr;
+        shm_size_ = 0;
+    }
+
     // Apparently you get a `Resource temporarily unavailable` when calling
     // `ftruncate()` with a size of 0 on shared memory
-    if (config_.size > 0) {
-        // I don't think this can fail
-        assert(ftruncate(shm_fd_, config_.size) == 0);
-
-        // But this can, if the user does not have permissions to use (enough)
-        // locked emmory, we'll try it without locking memory and show a big
-        // obnoxious warning and try again without locking the memory.
-        uint8_t* old_shm_bytes = shm_bytes_;
+    if (config_.size == 0) {
+        return;
+    }
+
+    // Explicit huge pages need to be mapped in their entirety. Reserving huge
+    // pages happens when mapping the memfd, so if there are not enough huge
+    // pages available we'll fall back to a regular memfd with transparent
+    // huge pages if we're the side that created it. The other side will then
+    // reopen the new memfd when it receives the updated configuration.
+    if (config_.backing == Config::Backing::memfd_hugetlb) {
+        const size_t mapping_size = round_up(config_.size, huge_page_size);
+        if (ftruncate(shm_fd_, mapping_size) == 0) {
+            shm_bytes_ = static_cast<uint8_t*>(
+                mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, shm_fd_, 0));
+            if (shm_bytes_ != MAP_FAILED) {
+                shm_size_ = mapping_size;
+                return;
+            }
+        }
+
+        shm_bytes_ = nullptr;
+        if (!owns_memfd_) {
+            throw std::system_error(
+                std::error_code(errno, std::system_category()),
+                "Could not map huge page backed shared memory");
+        }
+
+        close_backing();
+        config_.backing = Config::Backing::memfd;
+        config_.memfd_path.clear();
+        open_backing();
+    }
+
+    const size_t mapping_size =
+        round_up(config_.size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+
+    // I don't think this can fail
+    assert(ftruncate(shm_fd_, mapping_size) == 0);
+
+    // But this can, if the user does not have permissions to use (enough)
+    // locked emmory, we'll try it without locking memory and show a big
+    // obnoxious warning and try again without locking the memory. Locked
+    // mappings are prefaulted by the kernel, and `MAP_POPULATE` does the same
+    // for the unlocked fallback.
+    shm_bytes_ = static_cast<uint8_t*>(
+        mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_LOCKED | MAP_POPULATE, shm_fd_, 0));
+    if (shm_bytes_ == MAP_FAILED) {
+        Logger logger = Logger::create_exception_logger();
+
+        logger.log("");
+        logger.log("ERROR: Could not map shared memory. This means that");
+        logger.log("       your user's memory locking limit has been");
+        logger.log("       reached. Check your distro's documentation or");
+        logger.log("       wiki for instructions on how to set up");
+        logger.log("       realtime privileges and memlock limits.");
+        logger.log("");
+
         shm_bytes_ = static_cast<uint8_t*>(
-            old_shm_bytes
-                ? mremap(old_shm_bytes, shm_size_, config_.size, MREMAP_MAYMOVE)
-                : mmap(nullptr, config_.size, PROT_READ | PROT_WRITE,
-                       MAP_SHARED | MAP_LOCKED, shm_fd_, 0));
+            mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, shm_fd_, 0));
         if (shm_bytes_ == MAP_FAILED) {
-            Logger logger = Logger::create_exception_logger();
-
-            logger.log("");
-            logger.log("ERROR: Could not map shared memory. This means that");
-            logger.log("       your user's memory locking limit has been");
-            logger.log("       reached. Check your distro's documentation or");
-            logger.log("       wiki for instructions on how to set up");
-            logger.log("       realtime privileges and memlock limits.");
-            logger.log("");
-
-            // Growing into a size that we cannot lock sounds like a super rare
-            // edge case, but let's handle it anyways
-            if (old_shm_bytes) {
-                assert(munmap(old_shm_bytes, shm_size_) == 0);
-            }
-            shm_bytes_ = static_cast<uint8_t*>(mmap(nullptr, config_.size,
-                                                    PROT_READ | PROT_WRITE,
-                                                    MAP_SHARED, shm_fd_, 0));
-            if (shm_bytes_ == MAP_FAILED) {
-                throw std::system_error(
-                    std::error_code(errno, std::system_category()),
-                    "Could not map shared memory");
-            }
+            shm_bytes_ = nullptr;
+            throw std::system_error(
+                std::error_code(errno, std::system_category()),
+                "Could not map shared memory");
         }
     }
 
-    shm_size_ = config_.size;
+    // Whether this results in huge pages depends on
+    // `/sys/kernel/mm/transparent_hugepage/shmem_enabled`, so this is only a
+    // hint
+    if (config_.backing == Config::Backing::memfd) {
+        madvise(shm_bytes_, mapping_size, MADV_HUGEPAGE);
+    }
+
+    shm_size_ = mapping_size;
 }
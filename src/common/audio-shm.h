@@ -60,12 +60,52 @@ class AudioShmBuffer {
      * sent as part of the `Steinberg::Vst::ProcessSetup` object.
      */
     struct Config {
+        /**
+         * How the buffer's memory is shared between the two processes.
+         */
+        enum class Backing : uint8_t {
+            /**
+             * A POSIX shared memory object in `/dev/shm` that both sides open
+             * using `name`. This is the default.
+             */
+            posix_shm,
+            /**
+             * A memfd backed by explicitly reserved 2 MiB huge pages, created
+             * by the Wine plugin host. The native plugin opens it through
+             * `memfd_path`. Requested through the `audio_buffer_huge_pages`
+             * option.
+             */
+            memfd_hugetlb,
+            /**
+             * A regular memfd that has been marked as a candidate for
+             * transparent huge pages. This is used instead of `memfd_hugetlb`
+             * when no huge pages have been reserved.
+             */
+            memfd,
+        };
+
         /**
          * The unique identifier for this shared memory object. The backing file
-         * will be created in `/dev/shm` by the operating system.
+         * will be created in `/dev/shm` by the operating system when using
+         * `Backing::posix_shm`.
          */
         std::string name;
 
+        /**
+         * The requested backing. The Wine plugin host will downgrade this when
+         * the requested backing is not available, and the native plugin will
+         * then receive the backing that's actually used.
+         */
+        Backing backing = Backing::posix_shm;
+
+        /**
+         * For the memfd backings, the path through which the other process can
+         * open the memfd, e.g. `/proc/<pid>/fd/<fd>`. This is filled in by
+         * the side that creates the memfd. This won't work when the Wine
+         * plugin host runs in a different PID namespace.
+         */
+        std::string memfd_path;
+
         /**
          * The size of the shared memory object **in bytes** (so not samples).
          * This should be large enough to hold all input and output buffers, and
@@ -97,6 +137,8 @@ class AudioShmBuffer {
         template <typename S>
         void serialize(S& s) {
             s.text1b(name, 1024);
+            s.value1b(backing);
+            s.text1b(memfd_path, 1024);
             s.value4b(size);
             s.container(input_offsets, 8192, [](S& s, auto& offsets) {
                 s.container4b(offsets, 8192);
@@ -107,10 +149,37 @@ class AudioShmBuffer {
         }
     };
 
+    /**
+     * Every channel's offset and size is rounded up to a multiple of this
+     * value so channels never share a cache line, and so SIMD loads and stores
+     * on the start of every channel are aligned.
+     */
+    static constexpr uint32_t channel_alignment = 64;
+
+    /**
+     * The number of bytes to reserve for a single channel with `num_samples`
+     * samples of `sample_size` bytes, including padding up to
+     * `channel_alignment`. The Wine plugin host should use this when computing
+     * the channel offsets.
+     */
+    static constexpr uint32_t aligned_channel_size(
+        size_t num_samples,
+        size_t sample_size) noexcept {
+        const size_t size = num_samples * sample_size;
+
+        return static_cast<uint32_t>(
+            ((size + channel_alignment - 1) / channel_alignment) *
+            channel_alignment);
+    }
+
     /**
      * Connect to or create the shared memory object and map it to this
      * process's memory. The configuration is created on the Wine side using the
-     * process described in `Config`'s docstring.
+     * process described in `Config`'s docstring. When a memfd backing is
+     * requested and `config.memfd_path` is empty, a new memfd will be created
+     * and `config_` will contain the path the other side should open, so the
+     * Wine plugin host should send `config_` back instead of the configuration
+     * it passed to this constructor.
      *
      * @throw std::system_error If the shared memory object could not be
      *   created or mapped.
@@ -132,7 +201,8 @@ class AudioShmBuffer {
 
     /**
      * Adapt to a new buffer size or channel layout. The name of the buffer
-     * needs to remain the same.
+     * needs to remain the same. Like with the constructor, `config_` will
+     * contain the backing that's actually in use afterwards.
      *
      * @throw `std::invalid_argument` If the config is for a buffer with a
      *   different name.
@@ -192,7 +262,23 @@ class AudioShmBuffer {
 
    private:
     /**
-     * Resize the shared memory object, and set up the memory mapping.
+     * Open or create the file descriptor for the backing described in
+     * `config_`, setting `shm_fd_`.
+     *
+     * @throw std::system_error If the shared memory object could not be
+     *   opened.
+     */
+    void open_backing();
+
+    /**
+     * Close the current file descriptor. For POSIX shared memory objects this
+     * also unlinks the object.
+     */
+    void close_backing() noexcept;
+
+    /**
+     * Resize the shared memory object, and set up the memory mapping. The
+     * entire buffer gets prefaulted here so the audio thread never has to.
      *
      * @throw std::system_error If the shared memory object could not be mapped.
      */
@@ -201,13 +287,19 @@ class AudioShmBuffer {
     /**
      * The file descriptor for our shared memory object.
      */
-    int shm_fd_ = 0;
+    int shm_fd_ = -1;
+    /**
+     * Whether this side created the memfd in `shm_fd_`. Only that side may
+     * downgrade the backing when huge pages run out.
+     */
+    bool owns_memfd_ = false;
     /**
      * A pointer to our mapped shared memory region.
      */
     uint8_t* shm_bytes_ = nullptr;
     /**
-     * The size of the mapped shared memory area, used for remapping.
+     * The size of the mapped shared memory area. This is `config_.size` rounded
+     * up to the backing's page size.
      */
     size_t shm_size_ = 0;
 
@@ -0,0 +1,94 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <bitsery/details/serialization_common.h>
+#include <bitsery/traits/core/traits.h>
+
+namespace bitsery {
+namespace ext {
+
+/**
+ * An adapter for serializing a container of trivially copyable structs as a
+ * length prefix followed by a single block of bytes, instead of serializing
+ * every field of every element separately. This is used for the dense arrays
+ * sent along with every audio processing request.
+ *
+ * Since the elements are copied as is, their layout needs to be the same on
+ * every architecture we bridge between. In practice this means that `double`
+ * fields need to be explicitly eight byte aligned for the 32-bit builds. This
+ * also assumes that both sides use the same endianness, which is always the
+ * case for us.
+ */
+class PackedContainer {
+   public:
+    /**
+     * @param max_size The maximum number of elements that can be deserialized.
+     */
+    explicit PackedContainer(size_t max_size) : max_size_(max_size) {}
+
+    template <typename Ser, typename C, typename Fnc>
+    void serialize(Ser& ser, const C& container, Fnc&&) const {
+        using T = typename C::value_type;
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "PackedContainer only works with trivially copyable "
+                      "elements");
+
+        details::writeSize(ser.adapter(), container.size());
+        ser.adapter().template writeBuffer<1>(
+            reinterpret_cast<const uint8_t*>(container.data()),
+            container.size() * sizeof(T));
+    }
+
+    template <typename Des, typename C, typename Fnc>
+    void deserialize(Des& des, C& container, Fnc&&) const {
+        using T = typename C::value_type;
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "PackedContainer only works with trivially copyable "
+                      "elements");
+
+        size_t size{};
+        details::readSize(
+            des.adapter(), size, max_size_,
+            std::integral_constant<bool, Des::TConfig::CheckDataErrors>{});
+
+        container.resize(size);
+        des.adapter().template readBuffer<1>(
+            reinterpret_cast<uint8_t*>(container.data()), size * sizeof(T));
+    }
+
+   private:
+    size_t max_size_;
+};
+
+}  // namespace ext
+
+namespace traits {
+
+template <typename C>
+struct ExtensionTraits<ext::PackedContainer, C> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+
+}  // namespace traits
+}  // namespace bitsery
@@ -112,7 +112,7 @@ class ClapAudioThreadSockets {
  * they can be addressed concurrently.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class ClapSockets final : public Sockets {
@@ -16,8 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
 #include <mutex>
+#include <type_traits>
+#include <unordered_map>
 #include <variant>
 
 #include <bitsery/adapter/buffer.h>
@@ -33,10 +40,12 @@
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 #include <ghc/filesystem.hpp>
+#include <rigtorp/MPMCQueue.h>
 
 #include "../bitsery/traits/small-vector.h"
 #include "../logging/common.h"
 #include "../utils.h"
+#include "recorder.h"
 
 // Our input and output adapters for binary serialization always expect the data
 // to be encoded in little endian format. This should not make any difference
@@ -116,9 +125,52 @@ inline ASIO_MUTABLE_BUFFER buffer(llvm::SmallVectorImpl<PodType>& data,
 
 }  // namespace asio
 
+/**
+ * Messages that are sent during every audio processing cycle and that consist
+ * only of fixed size fields don't need to go through bitsery at all. Types that
+ * satisfy this concept are written to the socket as is, prefixed by a
+ * `FixedLayoutHeader`, by the `write_object()` and `read_object()` overloads
+ * below. This means that sending and receiving such a message is a single
+ * gathered `sendmsg()` and a single scattered `recvmsg()` without any
+ * serialization step in between.
+ *
+ * A type opts into this by being trivially copyable and by defining two
+ * `uint32_t` constants:
+ *
+ * - `wire_tag`, a unique four character code identifying the message type.
+ * - `wire_version`, which should be bumped every time the struct's layout
+ *   changes.
+ *
+ * Since the 32-bit bitbridge and 32-bit yabridge builds don't necessarily agree
+ * with the 64-bit builds on the alignment of `double`s, these structs should
+ * be laid out so that every field is naturally aligned regardless of the ABI,
+ * and they should have a `static_assert()` on their size.
+ */
+template <typename T>
+concept FixedLayoutMessage = std::is_trivially_copyable_v<T> && requires {
+    { T::wire_tag } -> std::convertible_to<uint32_t>;
+    { T::wire_version } -> std::convertible_to<uint32_t>;
+};
+
+/**
+ * The header written in front of every `FixedLayoutMessage`. This takes the
+ * place of the length prefix used for bitsery encoded objects, and it lets the
+ * receiving side verify that both sides agree on the message's layout.
+ */
+struct FixedLayoutHeader {
+    uint32_t tag;
+    uint32_t version;
+    // NOTE: Like the length prefix for regular objects, this is always a 64-bit
+    //       integer for compatibility with the 32-bit bitbridge
+    uint64_t size;
+};
+
+static_assert(sizeof(FixedLayoutHeader) == 16);
+
 /**
  * Serialize an object using bitsery and write it to a socket. This will write
- * both the size of the serialized object and the object itself over the socket.
+ * both the size of the serialized object and the object itself over the socket
+ * using a single gathered write.
  *
  * @param socket The Asio socket to write to.
  * @param object The object to write to the stream.
@@ -140,16 +192,53 @@ inline void write_object(Socket& socket,
             buffer, object);
 
     // Tell the other side how large the object is so it can prepare a buffer
-    // large enough before sending the data
+    // large enough before sending the data. The size and the data are sent
+    // together so this is a single `sendmsg()` call.
     // NOTE: We're writing these sizes as a 64 bit integers, **not** as pointer
     //       sized integers. This is to provide compatibility with the 32-bit
     //       bit bridge. This won't make any function difference aside from the
     //       32-bit host application having to convert between 64 and 32 bit
     //       integers.
-    asio::write(socket, asio::buffer(std::array<uint64_t, 1>{size}));
-    const size_t bytes_written =
-        asio::write(socket, asio::buffer(buffer, size));
-    assert(bytes_written == size);
+    const uint64_t message_length = size;
+    const std::array<asio::const_buffer, 2> buffers{
+        asio::buffer(&message_length, sizeof(message_length)),
+        asio::buffer(buffer, size)};
+    const size_t bytes_written = asio::write(socket, buffers);
+    assert(bytes_written == sizeof(message_length) + size);
+
+    if (MessageRecorder::active()) [[unlikely]] {
+        MessageRecorder::record(socket.native_handle(),
+                                CaptureRecordType::sent, &message_length,
+                                sizeof(message_length), buffer.data(), size);
+    }
+}
+
+/**
+ * `write_object()` for objects using the fixed layout wire format. The object
+ * is written to the socket as is together with its header in a single write,
+ * so `buffer` is not used here.
+ *
+ * @overload
+ * @see FixedLayoutMessage
+ */
+template <FixedLayoutMessage T, typename Socket>
+inline void write_object(Socket& socket,
+                         const T& object,
+                         SerializationBufferBase& /*buffer*/) {
+    const FixedLayoutHeader header{
+        .tag = T::wire_tag, .version = T::wire_version, .size = sizeof(T)};
+
+    const std::array<asio::const_buffer, 2> buffers{
+        asio::buffer(&header, sizeof(header)),
+        asio::buffer(&object, sizeof(T))};
+    const size_t bytes_written = asio::write(socket, buffers);
+    assert(bytes_written == sizeof(header) + sizeof(T));
+
+    if (MessageRecorder::active()) [[unlikely]] {
+        MessageRecorder::record(socket.native_handle(),
+                                CaptureRecordType::sent, &header,
+                                sizeof(header), &object, sizeof(T));
+    }
 }
 
 /**
@@ -167,6 +256,13 @@ inline void write_object(Socket& socket, const T& object) {
  * Deserialize an object by reading it from a socket. This should be used
  * together with `write_object`. This will block until the object is available.
  *
+ * To avoid separate reads for the message's length and its contents, we'll
+ * speculatively read as much data as fits in `buffer`'s current capacity. If
+ * the message fits, then that's the only read needed. This relies on there
+ * never being more than a single unread message in flight in one direction on
+ * a socket, which holds for all of our sockets since every message is answered
+ * by a response before the next message gets sent.
+ *
  * @param socket The Asio socket to read from.
  * @param object The object to serialize into. There are also overrides that
  *   create a new default initialized `T`
@@ -186,22 +282,48 @@ inline T& read_object(Socket& socket,
                       T& object,
                       SerializationBufferBase& buffer) {
     // See the note above on the use of `uint64_t` instead of `size_t`
-    std::array<uint64_t, 1> message_length;
-    asio::read(socket, asio::buffer(message_length),
-               asio::transfer_exactly(sizeof(message_length)));
+    uint64_t message_length;
+    constexpr size_t header_size = sizeof(message_length);
+
+    // We'll read the length prefix along with as much of the message as fits in
+    // the buffer without reallocating
+    buffer.resize_for_overwrite(std::max(buffer.capacity(), header_size));
+    size_t bytes_read = 0;
+    while (bytes_read < header_size) {
+        bytes_read += socket.read_some(asio::buffer(
+            buffer.data() + bytes_read, buffer.size() - bytes_read));
+    }
 
-    // Make sure the buffer is large enough
-    const size_t size = message_length[0];
-    buffer.resize(size);
+    std::memcpy(&message_length, buffer.data(), header_size);
+    const size_t size = message_length;
+    if (bytes_read > header_size + size) [[unlikely]] {
+        throw std::runtime_error(
+            "Read past the end of the message, the other side sent more than "
+            "one message at once in call: " +
+            std::string(__PRETTY_FUNCTION__));
+    }
 
-    // `asio::read/write` will handle all the packet splitting and
-    // merging for us, since local domain sockets have packet limits somewhere
-    // in the hundreds of kilobytes
-    asio::read(socket, asio::buffer(buffer), asio::transfer_exactly(size));
+    // If the message did not fit in the first read, we'll grow the buffer and
+    // read the rest of it. `asio::read/write` will handle all the packet
+    // splitting and merging for us, since local domain sockets have packet
+    // limits somewhere in the hundreds of kilobytes
+    if (bytes_read < header_size + size) {
+        buffer.resize_for_overwrite(header_size + size);
+        asio::read(socket,
+                   asio::buffer(buffer.data() + bytes_read,
+                                header_size + size - bytes_read),
+                   asio::transfer_exactly(header_size + size - bytes_read));
+    }
+
+    if (MessageRecorder::active()) [[unlikely]] {
+        MessageRecorder::record(socket.native_handle(),
+                                CaptureRecordType::received, buffer.data(),
+                                header_size, buffer.data() + header_size, size);
+    }
 
     auto [_, success] =
         bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
-            {buffer.begin(), size}, object);
+            {buffer.begin() + header_size, size}, object);
 
     if (!success) [[unlikely]] {
         throw std::runtime_error("Deserialization failure in call: " +
@@ -211,6 +333,42 @@ inline T& read_object(Socket& socket,
     return object;
 }
 
+/**
+ * `read_object()` for objects using the fixed layout wire format. The header
+ * and the object are read directly into place, so `buffer` is not used here.
+ *
+ * @throw std::runtime_error If the other side sent a different message type or
+ *   a different version of this message.
+ *
+ * @overload
+ * @see FixedLayoutMessage
+ */
+template <FixedLayoutMessage T, typename Socket>
+inline T& read_object(Socket& socket,
+                      T& object,
+                      SerializationBufferBase& /*buffer*/) {
+    FixedLayoutHeader header;
+    const std::array<asio::mutable_buffer, 2> buffers{
+        asio::buffer(&header, sizeof(header)),
+        asio::buffer(&object, sizeof(T))};
+    asio::read(socket, buffers,
+               asio::transfer_exactly(sizeof(header) + sizeof(T)));
+
+    if (header.tag != T::wire_tag || header.version != T::wire_version ||
+        header.size != sizeof(T)) [[unlikely]] {
+        throw std::runtime_error("Unexpected fixed layout message header in: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    if (MessageRecorder::active()) [[unlikely]] {
+        MessageRecorder::record(socket.native_handle(),
+                                CaptureRecordType::received, &header,
+                                sizeof(header), &object, sizeof(T));
+    }
+
+    return object;
+}
+
 /**
  * `read_object()` into a new default initialized object with an existing
  * buffer.
@@ -385,8 +543,12 @@ class SocketHandler {
     void connect() {
         if (acceptor_) {
             acceptor_->accept(socket_);
+            MessageRecorder::attach(socket_.native_handle(), endpoint_.path(),
+                                    CaptureChannelKind::primary_accepted);
         } else {
             socket_.connect(endpoint_);
+            MessageRecorder::attach(socket_.native_handle(), endpoint_.path(),
+                                    CaptureChannelKind::primary_connected);
         }
     }
 
@@ -395,6 +557,8 @@ class SocketHandler {
      * `std::system_error` when this happens.
      */
     void close() {
+        MessageRecorder::detach(socket_.native_handle());
+
         // The shutdown can fail when the socket is already closed
         std::error_code err;
         socket_.shutdown(asio::local::stream_protocol::socket::shutdown_both,
@@ -527,6 +691,200 @@ class SocketHandler {
     std::optional<asio::local::stream_protocol::acceptor> acceptor_;
 };
 
+/**
+ * A pool of long lived worker threads that handle the secondary socket
+ * connections accepted in `AdHocSocketHandler::receive_multi()`. We used to
+ * spawn a new thread for every accepted connection, but under Wine creating a
+ * thread can take multiple milliseconds, and some hosts will open hundreds of
+ * these connections in quick succession (for instance while browsing presets).
+ *
+ * Accepted sockets are pushed to a lock-free queue, and idle workers pick them
+ * up from there. If there are no idle workers, then a new worker is spawned.
+ * The number of workers is thus never capped, since requests made over these
+ * sockets can be mutually recursive and limiting the number of concurrent
+ * requests could cause deadlocks. Instead, at most `max_idle_workers` workers
+ * are kept around once they run out of work, and the others will exit.
+ *
+ * @tparam Thread The thread implementation to use. On the Linux side this
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
+ * @tparam F The callback that handles a single secondary socket connection.
+ */
+template <typename Thread,
+          std::invocable<asio::local::stream_protocol::socket&> F>
+class AdHocWorkerPool {
+   public:
+    /**
+     * The maximum number of workers that are kept around while they're idle.
+     */
+    static constexpr size_t max_idle_workers = 4;
+
+    /**
+     * Create an empty worker pool. Workers are only spawned once we receive
+     * the first connection.
+     *
+     * @param io_context The IO context the accepted secondary sockets are bound
+     *   to. This context's thread is also used to join workers that exit.
+     * @param callback The function that handles a single secondary socket
+     *   connection. This should outlive the pool.
+     * @param logger The logger used to report the pool's size when the number
+     *   of workers reaches a new high-water mark.
+     * @param name The name shown in those log messages.
+     */
+    AdHocWorkerPool(asio::io_context& io_context,
+                    F& callback,
+                    Logger logger,
+                    std::string name)
+        : io_context_(io_context),
+          callback_(callback),
+          logger_(std::move(logger)),
+          name_(std::move(name)),
+          pending_sockets_(64) {}
+
+    /**
+     * Wake up and join all workers. The sockets they're currently handling
+     * should have been closed at this point, and the IO context should no
+     * longer be running.
+     */
+    ~AdHocWorkerPool() noexcept {
+        {
+            std::lock_guard lock(idle_mutex_);
+            stopping_ = true;
+        }
+        worker_available_.notify_all();
+
+        // The join is implicit because we're using `NativeThread`/`Win32Thread`
+        std::lock_guard lock(workers_mutex_);
+        workers_.clear();
+    }
+
+    AdHocWorkerPool(const AdHocWorkerPool&) = delete;
+    AdHocWorkerPool& operator=(const AdHocWorkerPool&) = delete;
+
+    /**
+     * Hand a newly accepted socket connection off to an idle worker, or spawn a
+     * new worker if every worker is currently busy.
+     */
+    void dispatch(asio::local::stream_protocol::socket socket) {
+        // The socket's file descriptor is moved to the queue, and the worker
+        // picking it up will create a new socket object from it
+        pending_sockets_.push(socket.release());
+
+        bool should_spawn_worker = true;
+        {
+            std::lock_guard lock(idle_mutex_);
+            if (idle_workers_ > 0) {
+                idle_workers_--;
+                pending_wakeups_++;
+                should_spawn_worker = false;
+            }
+        }
+
+        if (should_spawn_worker) {
+            spawn_worker();
+        } else {
+            worker_available_.notify_one();
+        }
+    }
+
+   private:
+    using native_handle_type =
+        asio::local::stream_protocol::socket::native_handle_type;
+
+    void spawn_worker() {
+        const size_t worker_id = next_worker_id_++;
+        const size_t num_workers = num_workers_.fetch_add(1) + 1;
+        {
+            std::lock_guard lock(workers_mutex_);
+            workers_[worker_id] =
+                Thread([this, worker_id]() { run_worker(worker_id); });
+        }
+
+        // This is only called from the thread that accepts the connections, so
+        // this doesn't need to be atomic
+        if (num_workers > high_water_mark_) {
+            high_water_mark_ = num_workers;
+            if (logger_.verbosity_ >= Logger::Verbosity::most_events) {
+                logger_.log("[" + name_ + "] Ad-hoc worker pool grew to " +
+                            std::to_string(num_workers) + " threads");
+            }
+        }
+    }
+
+    void run_worker(size_t worker_id) {
+        pthread_setname_np(pthread_self(), "adhoc-worker");
+
+        native_handle_type native_socket;
+        while (true) {
+            while (pending_sockets_.try_pop(native_socket)) {
+                asio::local::stream_protocol::socket socket(
+                    io_context_, asio::local::stream_protocol(), native_socket);
+                callback_(socket);
+                MessageRecorder::detach(native_socket);
+            }
+
+            std::unique_lock lock(idle_mutex_);
+            if (stopping_ || idle_workers_ >= max_idle_workers) {
+                break;
+            }
+
+            idle_workers_++;
+            worker_available_.wait(
+                lock, [&]() { return pending_wakeups_ > 0 || stopping_; });
+            if (stopping_) {
+                break;
+            }
+
+            pending_wakeups_--;
+        }
+
+        // Like in `GroupBridge`, the thread that's handling the IO context
+        // will join this thread again. If the context is no longer running
+        // then this happens in the destructor instead.
+        num_workers_--;
+        asio::post(io_context_, [this, worker_id]() {
+            std::lock_guard lock(workers_mutex_);
+            workers_.erase(worker_id);
+        });
+    }
+
+    asio::io_context& io_context_;
+    F& callback_;
+    Logger logger_;
+    const std::string name_;
+
+    /**
+     * File descriptors for accepted sockets that still need to be handled by a
+     * worker.
+     */
+    rigtorp::MPMCQueue<native_handle_type> pending_sockets_;
+
+    /**
+     * Protects `idle_workers_`, `pending_wakeups_`, and `stopping_`. Idle
+     * workers wait on `worker_available_` until `dispatch()` hands them a
+     * wakeup.
+     */
+    std::mutex idle_mutex_;
+    std::condition_variable worker_available_;
+    size_t idle_workers_ = 0;
+    size_t pending_wakeups_ = 0;
+    bool stopping_ = false;
+
+    /**
+     * The worker threads. This works the exact same was as `active_plugins`
+     * and `next_plugin_id` in `GroupBridge`.
+     */
+    std::unordered_map<size_t, Thread> workers_;
+    std::mutex workers_mutex_;
+    size_t next_worker_id_ = 0;
+
+    /**
+     * The current number of workers, and the largest number of workers we've
+     * seen at once. Used for logging.
+     */
+    std::atomic_size_t num_workers_ = 0;
+    size_t high_water_mark_ = 0;
+};
+
 /**
  * There are situations where we can not know in advance how many sockets we
  * need. The main example of this are VST2 `dispatcher()` and `audioMaster()`
@@ -544,11 +902,11 @@ class SocketHandler {
  *   send data and the primary socket is in use, it will instantiate a new
  *   connection to same socket endpoint and it will send the data over that
  *   socket instead. On the listening side the new connection will be accepted,
- *   and a newly spawned thread will handle incoming connection just like it
- *   would for the primary socket.
+ *   and a thread from an `AdHocWorkerPool` will handle incoming connection
+ *   just like it would for the primary socket.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class AdHocSocketHandler {
@@ -587,6 +945,8 @@ class AdHocSocketHandler {
     void connect() {
         if (acceptor_) {
             acceptor_->accept(socket_);
+            MessageRecorder::attach(socket_.native_handle(), endpoint_.path(),
+                                    CaptureChannelKind::primary_accepted);
 
             // As mentioned in `acceptor's` docstring, this acceptor will be
             // recreated in `receive_multi()` on another context, and
@@ -596,6 +956,8 @@ class AdHocSocketHandler {
             ghc::filesystem::remove(endpoint_.path());
         } else {
             socket_.connect(endpoint_);
+            MessageRecorder::attach(socket_.native_handle(), endpoint_.path(),
+                                    CaptureChannelKind::primary_connected);
         }
     }
 
@@ -604,6 +966,8 @@ class AdHocSocketHandler {
      * `std::system_error` when this happens.
      */
     void close() {
+        MessageRecorder::detach(socket_.native_handle());
+
         // The shutdown can fail when the socket is already closed
         std::error_code err;
         socket_.shutdown(asio::local::stream_protocol::socket::shutdown_both,
@@ -665,6 +1029,9 @@ class AdHocSocketHandler {
                 asio::local::stream_protocol::socket secondary_socket(
                     io_context_);
                 secondary_socket.connect(endpoint_);
+                const ScopedRecording recording(
+                    secondary_socket.native_handle(), endpoint_.path(),
+                    CaptureChannelKind::secondary_connected);
 
                 return callback(secondary_socket);
             } catch (const std::system_error&) {
@@ -729,47 +1096,27 @@ class AdHocSocketHandler {
 
         // As described above we'll handle incoming requests for `socket` on
         // this thread. We'll also listen for incoming connections on `endpoint`
-        // on another thread. For any incoming connection we'll spawn a new
-        // thread to handle the request. When `socket` closes and this loop
-        // breaks, the listener and any still active threads will be cleaned up
-        // before this function exits.
+        // on another thread. Any incoming connection is handed off to a pool of
+        // worker threads. When `socket` closes and this loop breaks, the
+        // listener and the workers will be cleaned up before this function
+        // exits.
         asio::io_context secondary_context{};
 
         // The previous acceptor has already been shut down by
         // `AdHocSocketHandler::connect()`
         acceptor_.emplace(secondary_context, endpoint_);
 
-        // This works the exact same was as `active_plugins` and
-        // `next_plugin_id` in `GroupBridge`
-        std::unordered_map<size_t, Thread> active_secondary_requests{};
-        std::atomic_size_t next_request_id{};
-        std::mutex active_secondary_requests_mutex{};
+        AdHocWorkerPool<Thread, std::remove_reference_t<G>> worker_pool(
+            secondary_context, secondary_callback,
+            logger ? logger->get() : Logger::create_exception_logger(),
+            ghc::filesystem::path(endpoint_.path()).filename().string());
         accept_requests(
             *acceptor_, logger,
             [&](asio::local::stream_protocol::socket secondary_socket) {
-                const size_t request_id = next_request_id.fetch_add(1);
-
-                // We have to make sure to keep moving these sockets into the
-                // threads that will handle them
-                std::lock_guard lock(active_secondary_requests_mutex);
-                active_secondary_requests[request_id] = Thread(
-                    [&, request_id](
-                        asio::local::stream_protocol::socket secondary_socket) {
-                        secondary_callback(secondary_socket);
-
-                        // When we have processed this request, we'll join the
-                        // thread again with the thread that's handling
-                        // `secondary_context`
-                        asio::post(secondary_context, [&, request_id]() {
-                            std::lock_guard lock(
-                                active_secondary_requests_mutex);
-
-                            // The join is implicit because we're using
-                            // `std::jthread`/`Win32Thread`
-                            active_secondary_requests.erase(request_id);
-                        });
-                    },
-                    std::move(secondary_socket));
+                MessageRecorder::attach(secondary_socket.native_handle(),
+                                        endpoint_.path(),
+                                        CaptureChannelKind::secondary_accepted);
+                worker_pool.dispatch(std::move(secondary_socket));
             });
 
         Thread secondary_requests_handler([&]() {
@@ -793,10 +1140,9 @@ class AdHocSocketHandler {
             }
         }
 
-        // After the primary socket gets terminated (during shutdown) we'll make
-        // sure all outstanding jobs have been processed and then drop all work
-        // from the IO context
-        std::lock_guard lock(active_secondary_requests_mutex);
+        // After the primary socket gets terminated (during shutdown) we'll drop
+        // all work from the IO context. The worker pool will join the remaining
+        // workers when it goes out of scope.
         secondary_context.stop();
         acceptor_.reset();
 
@@ -914,7 +1260,7 @@ class AdHocSocketHandler {
  * This is shared for both VST3 and CLAP.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  * @tparam LoggerImpl The logger instead to use. This should have
  *   `log_request(bool, T)` methods for every T in `Request`, as well as
  *   corresponding `log_response(bool, T::Response)` methods.
@@ -0,0 +1,229 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "recorder.h"
+
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <version.h>
+
+#include "../logging/common.h"
+
+namespace fs = ghc::filesystem;
+
+std::atomic_size_t MessageRecorder::num_active_ = 0;
+
+namespace {
+
+/**
+ * A recorded socket connection.
+ */
+struct RecordedChannel {
+    MessageRecorder* recorder;
+    uint32_t id;
+};
+
+/**
+ * All active recorders and the socket connections they're recording, keyed by
+ * file descriptor. `record()` only needs a shared lock.
+ */
+std::shared_mutex registry_mutex;
+std::vector<std::pair<std::string, MessageRecorder*>> active_recorders;
+std::unordered_map<int, RecordedChannel> recorded_channels;
+
+uint64_t monotonic_time_ns() noexcept {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 +
+           static_cast<uint64_t>(now.tv_nsec);
+}
+
+uint64_t current_thread_id() noexcept {
+    // `gettid()` has only been part of glibc since 2.30
+    return static_cast<uint64_t>(syscall(SYS_gettid));
+}
+
+}  // namespace
+
+MessageRecorder::MessageRecorder(const fs::path& directory,
+                                 const fs::path& endpoint_base_dir,
+                                 const std::string& plugin_type,
+                                 const std::string& plugin_path,
+                                 const fs::path& host_path)
+    : endpoint_base_dir_(endpoint_base_dir.string()) {
+    fs::create_directories(directory);
+
+    const fs::path capture_path =
+        directory / (endpoint_base_dir.filename().string() + ".ybcap");
+    file_.open(capture_path.string(), std::ios::out | std::ios::binary);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Could not open '" + capture_path.string() +
+                                 "' for writing");
+    }
+
+    file_.write(capture_magic, sizeof(capture_magic));
+
+    std::ostringstream info;
+    info << "plugin_type=" << plugin_type << "\n";
+    info << "plugin_path=" << plugin_path << "\n";
+    info << "host_path=" << host_path.string() << "\n";
+    info << "version=" << yabridge_git_version << "\n";
+
+    const std::string info_str = info.str();
+    write_record(CaptureRecordType::info, 0, nullptr, 0, info_str.data(),
+                 info_str.size());
+
+    std::unique_lock lock(registry_mutex);
+    active_recorders.emplace_back(endpoint_base_dir_ + "/", this);
+    num_active_.fetch_add(1, std::memory_order_relaxed);
+}
+
+MessageRecorder::~MessageRecorder() noexcept {
+    {
+        std::unique_lock lock(registry_mutex);
+        std::erase_if(active_recorders,
+                      [&](const auto& entry) { return entry.second == this; });
+        std::erase_if(recorded_channels, [&](const auto& entry) {
+            return entry.second.recorder == this;
+        });
+        num_active_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::lock_guard lock(mutex_);
+    file_.flush();
+}
+
+std::unique_ptr<MessageRecorder> MessageRecorder::create_from_environment(
+    const fs::path& endpoint_base_dir,
+    const std::string& plugin_type,
+    const std::string& plugin_path,
+    const fs::path& host_path,
+    Logger& logger) {
+    const char* directory = getenv(capture_directory_environment_variable);
+    if (!directory || directory[0] == '\0') {
+        return nullptr;
+    }
+
+    try {
+        auto recorder = std::make_unique<MessageRecorder>(
+            directory, endpoint_base_dir, plugin_type, plugin_path, host_path);
+        logger.log("Recording all messages to '" + std::string(directory) +
+                   "/" + endpoint_base_dir.filename().string() + ".ybcap'");
+
+        return recorder;
+    } catch (const std::exception& error) {
+        logger.log("WARNING: Could not start recording messages: " +
+                   std::string(error.what()));
+
+        return nullptr;
+    }
+}
+
+void MessageRecorder::attach(int fd,
+                             const std::string& endpoint,
+                             CaptureChannelKind kind) noexcept {
+    if (!active()) {
+        return;
+    }
+
+    std::unique_lock lock(registry_mutex);
+    for (const auto& [base_dir, recorder] : active_recorders) {
+        if (!endpoint.starts_with(base_dir)) {
+            continue;
+        }
+
+        try {
+            std::lock_guard recorder_lock(recorder->mutex_);
+            const uint32_t channel = recorder->next_channel_++;
+            const std::string endpoint_name =
+                fs::path(endpoint).filename().string();
+            recorder->write_record(CaptureRecordType::channel, channel, &kind,
+                                   sizeof(kind), endpoint_name.data(),
+                                   endpoint_name.size());
+
+            recorded_channels[fd] =
+                RecordedChannel{.recorder = recorder, .id = channel};
+        } catch (const std::exception&) {
+            // Recording is best effort, and we should never interfere with
+            // the actual communication
+        }
+
+        return;
+    }
+}
+
+void MessageRecorder::detach(int fd) noexcept {
+    if (!active()) {
+        return;
+    }
+
+    std::unique_lock lock(registry_mutex);
+    recorded_channels.erase(fd);
+}
+
+void MessageRecorder::record(int fd,
+                             CaptureRecordType type,
+                             const void* header,
+                             size_t header_size,
+                             const void* data,
+                             size_t data_size) noexcept {
+    std::shared_lock lock(registry_mutex);
+    const auto channel = recorded_channels.find(fd);
+    if (channel == recorded_channels.end()) {
+        return;
+    }
+
+    MessageRecorder& recorder = *channel->second.recorder;
+    try {
+        std::lock_guard recorder_lock(recorder.mutex_);
+        recorder.write_record(type, channel->second.id, header, header_size,
+                              data, data_size);
+    } catch (const std::exception&) {
+        // See above
+    }
+}
+
+void MessageRecorder::write_record(CaptureRecordType type,
+                                   uint32_t channel,
+                                   const void* header,
+                                   size_t header_size,
+                                   const void* data,
+                                   size_t data_size) {
+    const CaptureRecordHeader record_header{
+        .type = static_cast<uint8_t>(type),
+        .reserved = {},
+        .channel = channel,
+        .timestamp_ns = monotonic_time_ns(),
+        .thread_id = current_thread_id(),
+        .size = header_size + data_size};
+
+    file_.write(reinterpret_cast<const char*>(&record_header),
+                sizeof(record_header));
+    if (header_size > 0) {
+        file_.write(static_cast<const char*>(header), header_size);
+    }
+    if (data_size > 0) {
+        file_.write(static_cast<const char*>(data), data_size);
+    }
+}
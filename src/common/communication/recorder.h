@@ -0,0 +1,314 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <ghc/filesystem.hpp>
+
+// This header is also used by `yabridge-replay`, which does not link against
+// the rest of yabridge
+class Logger;
+
+// The message recorder writes every message sent and received by the native
+// plugin side to a binary capture file, so a session can later be inspected and
+// replayed against a Wine plugin host with `yabridge-replay` without needing
+// the original DAW. Since it sits below all of the typed message handlers, it
+// records messages exactly as they went over the wire.
+//
+// A capture file starts with `capture_magic`, followed by a sequence of
+// records. Every record consists of a `CaptureRecordHeader` followed by
+// `CaptureRecordHeader::size` bytes of payload. All integers are stored in
+// little endian.
+
+/**
+ * The first eight bytes of every capture file. The last three digits act as
+ * the format's version number.
+ */
+constexpr char capture_magic[8] = {'Y', 'B', 'C', 'A', 'P', '0', '0', '1'};
+
+/**
+ * The environment variable that enables the message recorder. If this is set
+ * to a directory, then every plugin instance writes its own capture file to
+ * that directory.
+ */
+constexpr char capture_directory_environment_variable[] =
+    "YABRIDGE_CAPTURE_DIR";
+
+enum class CaptureRecordType : uint8_t {
+    /**
+     * Information needed to relaunch the Wine plugin host, written once at the
+     * start of the capture. The payload consists of `key=value` lines with the
+     * `plugin_type`, `plugin_path`, `host_path` and `version` keys.
+     */
+    info = 0,
+    /**
+     * A socket connection was established. The payload is a single
+     * `CaptureChannelKind` byte, followed by the file name of the socket
+     * endpoint within the endpoint base directory. All following records for
+     * this connection use the channel number from this record's header.
+     */
+    channel = 1,
+    /**
+     * A message was written to a channel. The payload is the message exactly
+     * as it was sent, including its length prefix or `FixedLayoutHeader`.
+     */
+    sent = 2,
+    /**
+     * A message was read from a channel. The payload has the same format as
+     * for `sent` records.
+     */
+    received = 3,
+};
+
+/**
+ * How a channel's socket connection was established, from the native plugin's
+ * point of view. The replay tool needs this to reestablish the same
+ * connections.
+ */
+enum class CaptureChannelKind : uint8_t {
+    /**
+     * A long living socket we listened on and that the Wine plugin host
+     * connected to.
+     */
+    primary_accepted = 0,
+    /**
+     * A long living socket where the Wine plugin host was listening on and we
+     * connected to.
+     */
+    primary_connected = 1,
+    /**
+     * An ad hoc secondary socket connection made by the Wine plugin host while
+     * the primary socket was busy. See `AdHocSocketHandler`.
+     */
+    secondary_accepted = 2,
+    /**
+     * An ad hoc secondary socket connection we made while the primary socket
+     * was busy.
+     */
+    secondary_connected = 3,
+};
+
+/**
+ * The header in front of every record in a capture file.
+ */
+struct CaptureRecordHeader {
+    /**
+     * A `CaptureRecordType`.
+     */
+    uint8_t type;
+    uint8_t reserved[3];
+    /**
+     * The channel this record belongs to. Zero for `info` records.
+     */
+    uint32_t channel;
+    /**
+     * The value of `CLOCK_MONOTONIC` in nanoseconds at the time the message
+     * was written or after it was read completely.
+     */
+    uint64_t timestamp_ns;
+    /**
+     * The kernel thread ID of the thread that sent or received the message.
+     */
+    uint64_t thread_id;
+    /**
+     * The size of the payload following this header.
+     */
+    uint64_t size;
+};
+
+static_assert(sizeof(CaptureRecordHeader) == 32);
+
+/**
+ * Records the messages sent over a single plugin instance's sockets to a
+ * capture file. Recording is opt-in through the `YABRIDGE_CAPTURE_DIR`
+ * environment variable. When no recorders are active, the hooks in
+ * `write_object()` and `read_object()` only check a single atomic integer.
+ *
+ * Socket connections are attached to the recorder whose endpoint base
+ * directory contains their endpoint using `attach()`, and the file descriptors
+ * of recorded connections are then looked up in `record()`. Connections need
+ * to be detached again with `detach()` before they are closed so a reused file
+ * descriptor won't be mistaken for the old connection.
+ *
+ * @note Recording is only meant for diagnostics and performance analysis.
+ *   Writing to the capture file takes a lock and may block the audio thread.
+ */
+class MessageRecorder {
+   public:
+    /**
+     * Start recording to a new capture file in `directory`. Prefer using
+     * `create_from_environment()` instead.
+     *
+     * @param directory The directory to write the capture to. The file will be
+     *   named after the endpoint base directory, e.g.
+     *   `yabridge-<plugin_name>-<random_id>.ybcap`.
+     * @param endpoint_base_dir The socket endpoint base directory for the
+     *   plugin instance that's being recorded.
+     * @param plugin_type The plugin type, as returned by
+     *   `plugin_type_to_string()`.
+     * @param plugin_path The path to the Windows plugin, as passed to the Wine
+     *   plugin host.
+     * @param host_path The path to the Wine plugin host application.
+     *
+     * @throw std::runtime_error If the capture file could not be opened.
+     */
+    MessageRecorder(const ghc::filesystem::path& directory,
+                    const ghc::filesystem::path& endpoint_base_dir,
+                    const std::string& plugin_type,
+                    const std::string& plugin_path,
+                    const ghc::filesystem::path& host_path);
+
+    /**
+     * Stop recording and flush the capture file.
+     */
+    ~MessageRecorder() noexcept;
+
+    MessageRecorder(const MessageRecorder&) = delete;
+    MessageRecorder& operator=(const MessageRecorder&) = delete;
+
+    /**
+     * Create a recorder if the `YABRIDGE_CAPTURE_DIR` environment variable is
+     * set. See the constructor for the parameters. Any errors are logged to
+     * `logger`, and will result in recording being disabled.
+     *
+     * @return A recorder, or a null pointer if recording is not enabled.
+     */
+    static std::unique_ptr<MessageRecorder> create_from_environment(
+        const ghc::filesystem::path& endpoint_base_dir,
+        const std::string& plugin_type,
+        const std::string& plugin_path,
+        const ghc::filesystem::path& host_path,
+        Logger& logger);
+
+    /**
+     * Whether any recorder is currently active. This is what keeps the hooks
+     * in the serialization functions cheap. This is always false in the Wine
+     * plugin host, since only the native plugin records messages.
+     */
+    static inline bool active() noexcept {
+#ifdef __WINE__
+        return false;
+#else
+        return num_active_.load(std::memory_order_relaxed) > 0;
+#endif
+    }
+
+    /**
+     * Start recording the messages sent over a newly established socket
+     * connection if its endpoint belongs to a plugin instance that is being
+     * recorded. Does nothing otherwise.
+     *
+     * @param fd The socket's file descriptor.
+     * @param endpoint The path to the socket's endpoint.
+     * @param kind How the connection was established.
+     */
+    static void attach(int fd,
+                       const std::string& endpoint,
+                       CaptureChannelKind kind) noexcept;
+
+    /**
+     * Stop recording a socket connection. This should be called before the
+     * socket gets closed. Does nothing if the socket was not being recorded.
+     */
+    static void detach(int fd) noexcept;
+
+    /**
+     * Record a message written to or read from a socket, if that socket is
+     * being recorded. A message always consists of a header (a length prefix
+     * or a `FixedLayoutHeader`) followed by the message's contents, and they
+     * may not be contiguous in memory.
+     *
+     * @param fd The socket's file descriptor.
+     * @param type Either `CaptureRecordType::sent` or
+     *   `CaptureRecordType::received`.
+     */
+    static void record(int fd,
+                       CaptureRecordType type,
+                       const void* header,
+                       size_t header_size,
+                       const void* data,
+                       size_t data_size) noexcept;
+
+   private:
+    /**
+     * Write a record to the capture file. `mutex_` must be held.
+     */
+    void write_record(CaptureRecordType type,
+                      uint32_t channel,
+                      const void* header,
+                      size_t header_size,
+                      const void* data,
+                      size_t data_size);
+
+    const std::string endpoint_base_dir_;
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    uint32_t next_channel_ = 1;
+
+    /**
+     * The number of recorders currently alive.
+     */
+    static std::atomic_size_t num_active_;
+};
+
+#ifdef __WINE__
+// Only the native plugin records messages, so the Wine plugin host doesn't
+// compile `recorder.cpp`. The hooks in the socket handling code that's shared
+// between both sides compile down to nothing there.
+
+inline void MessageRecorder::attach(int,
+                                    const std::string&,
+                                    CaptureChannelKind) noexcept {}
+
+inline void MessageRecorder::detach(int) noexcept {}
+
+inline void MessageRecorder::record(int,
+                                    CaptureRecordType,
+                                    const void*,
+                                    size_t,
+                                    const void*,
+                                    size_t) noexcept {}
+#endif
+
+/**
+ * Records a socket connection for as long as this object is alive. Used for
+ * the short lived secondary sockets in `AdHocSocketHandler::send()`.
+ */
+class ScopedRecording {
+   public:
+    ScopedRecording(int fd,
+                    const std::string& endpoint,
+                    CaptureChannelKind kind) noexcept
+        : fd_(fd) {
+        MessageRecorder::attach(fd, endpoint, kind);
+    }
+
+    ~ScopedRecording() noexcept { MessageRecorder::detach(fd_); }
+
+    ScopedRecording(const ScopedRecording&) = delete;
+    ScopedRecording& operator=(const ScopedRecording&) = delete;
+
+   private:
+    int fd_;
+};
@@ -118,7 +118,7 @@ class DefaultDataConverter {
  * main socket is closed.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class Vst2EventHandler : public AdHocSocketHandler<Thread> {
@@ -327,7 +327,7 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
  * connections.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class Vst2Sockets final : public Sockets {
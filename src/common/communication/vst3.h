@@ -43,7 +43,7 @@
  * do anything that could increase latency there.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class Vst3Sockets final : public Sockets {
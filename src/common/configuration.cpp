@@ -16,6 +16,8 @@
 
 #include "configuration.h"
 
+#include <algorithm>
+#include <charconv>
 #include <fnmatch.h>
 #include <fstream>
 
@@ -24,11 +26,113 @@
 
 namespace fs = ghc::filesystem;
 
+namespace {
+
+/**
+ * Parse a CPU list in the format used by `isolcpus` and `taskset -c`, e.g.
+ * `"0,2-3,6"`. Returns a nullopt if the list is empty or malformed.
+ */
+std::optional<std::vector<uint16_t>> parse_cpu_list(std::string_view list) {
+    std::vector<uint16_t> cpus;
+    while (!list.empty()) {
+        const size_t separator_pos = list.find(',');
+        const std::string_view range = list.substr(0, separator_pos);
+        list = separator_pos == std::string_view::npos
+                   ? std::string_view()
+                   : list.substr(separator_pos + 1);
+
+        // Every item is either a single CPU number or an inclusive `first-last`
+        // range
+        const size_t dash_pos = range.find('-');
+        const std::string_view first_str = range.substr(0, dash_pos);
+        const std::string_view last_str =
+            dash_pos == std::string_view::npos ? first_str
+                                               : range.substr(dash_pos + 1);
+
+        const auto parse_cpu = [](std::string_view str,
+                                  uint16_t& cpu) -> bool {
+            const auto [ptr, error] =
+                std::from_chars(str.data(), str.data() + str.size(), cpu);
+            return !str.empty() && error == std::errc() &&
+                   ptr == str.data() + str.size();
+        };
+
+        uint16_t first = 0;
+        uint16_t last = 0;
+        if (!parse_cpu(first_str, first) || !parse_cpu(last_str, last) ||
+            first > last) {
+            return std::nullopt;
+        }
+
+        for (uint32_t cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(static_cast<uint16_t>(cpu));
+        }
+    }
+
+    if (cpus.empty()) {
+        return std::nullopt;
+    }
+
+    return cpus;
+}
+
+/**
+ * Parse the value of the `audio_thread_cpus` and `gui_thread_cpus` options.
+ * These can be either a CPU list string as described above, or an array of CPU
+ * numbers.
+ */
+std::optional<std::vector<uint16_t>> parse_cpu_option(const toml::node& value) {
+    if (const auto parsed_value = value.as_string()) {
+        return parse_cpu_list(parsed_value->get());
+    } else if (const auto parsed_value = value.as_array()) {
+        std::vector<uint16_t> cpus;
+        for (const auto& element : *parsed_value) {
+            const auto cpu = element.as_integer();
+            if (!cpu || cpu->get() < 0 || cpu->get() > UINT16_MAX) {
+                return std::nullopt;
+            }
+
+            cpus.push_back(static_cast<uint16_t>(cpu->get()));
+        }
+
+        if (cpus.empty()) {
+            return std::nullopt;
+        }
+
+        return cpus;
+    } else {
+        return std::nullopt;
+    }
+}
+
+}  // namespace
+
 Configuration::Configuration() noexcept {}
 
 Configuration::Configuration(const fs::path& config_path,
                              const fs::path& yabridge_path)
-    : Configuration() {
+    : Configuration(ConfigFile(config_path).match(yabridge_path)) {}
+
+std::chrono::steady_clock::duration Configuration::event_loop_interval()
+    const noexcept {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::milliseconds(1000) / frame_rate.value_or(60.0));
+}
+
+std::optional<std::chrono::steady_clock::duration>
+Configuration::idle_event_loop_interval() const noexcept {
+    if (!idle_frame_rate) {
+        return std::nullopt;
+    }
+
+    return std::max(
+        event_loop_interval(),
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::milliseconds(1000) / *idle_frame_rate));
+}
+
+ConfigFile::ConfigFile(const fs::path& config_path)
+    : config_path_(config_path) {
     // Will throw a `toml::parse_error` if the file cannot be parsed. Better
     // to throw here rather than failing silently since syntax errors would
     // otherwise be impossible to spot. We'll also have to sort all tables by
@@ -55,106 +159,172 @@ Configuration::Configuration(const fs::path& config_path,
                          b_pattern.source().begin.line;
               });
 
-    // This is the path of the current .so file relative to this `yabridge.toml`
-    // file
-    const fs::path relative_path =
-        yabridge_path.lexically_relative(config_path.parent_path());
+    // The options in every section are parsed up front, so matching a plugin
+    // to a section later only needs to copy the section's settings
     for (const auto& [pattern, table] : sorted_tables) {
-        // First try to match the glob pattern, allow matching an entire
-        // directory for ease of use. If none of the patterns in the file match
-        // the plugin path then everything will be left at the defaults.
-        const std::string key(pattern.str());
-        if (fnmatch(key.c_str(), relative_path.c_str(),
-                    FNM_PATHNAME | FNM_LEADING_DIR) != 0) {
-            continue;
-        }
+        Section& section = sections_.emplace_back();
+        section.pattern = pattern.str();
+        section.literal_prefix = section.pattern.substr(
+            0, section.pattern.find_first_of("*?[\\"));
 
-        matched_file = config_path;
-        matched_pattern = pattern;
+        Configuration& config = section.config;
+        config.matched_file = config_path;
+        config.matched_pattern = section.pattern;
 
         // If the table is missing some fields then they will simply be left at
         // their defaults. At this point I'd really wish C++ could do pattern
         // matching.
         for (const auto& [key, value] : table) {
-            if (key == "group") {
+            if (key == "audio_buffer_huge_pages") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    config.audio_buffer_huge_pages = parsed_value->get();
+                } else {
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "audio_thread_cpus") {
+                // In addition to a fixed set of CPUs, the audio threads can
+                // also mirror the host's audio thread's affinity
+                if (const auto parsed_value = value.as_string();
+                    parsed_value && parsed_value->get() == "host") {
+                    config.audio_thread_cpus_follow_host = true;
+                } else if (auto cpus = parse_cpu_option(value)) {
+                    config.audio_thread_cpus = std::move(cpus);
+                } else {
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "auto_group") {
+                // This can be enabled with a boolean, in which case the number
+                // of groups depends on the number of CPU cores, or it can be
+                // set to a fixed number of groups
+                if (const auto parsed_value = value.as_boolean()) {
+                    if (*parsed_value) {
+                        config.auto_group = 0;
+                    } else {
+                        config.auto_group = std::nullopt;
+                    }
+                } else if (const auto parsed_value = value.as_integer();
+                           parsed_value && parsed_value->get() > 0) {
+                    config.auto_group =
+                        static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "group") {
                 if (const auto parsed_value = value.as_string()) {
-                    group = parsed_value->get();
+                    config.group = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "share_plugin_image") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    config.share_plugin_image = parsed_value->get();
+                } else {
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "disable_pipes") {
                 // This option can be either enabled or disable with a boolean,
                 // or it can be set to an absolute path
                 if (const auto parsed_value = value.as_boolean()) {
                     if (*parsed_value) {
-                        disable_pipes = get_temporary_directory() /
-                                        "yabridge-plugin-output.log";
+                        config.disable_pipes = get_temporary_directory() /
+                                               "yabridge-plugin-output.log";
                     } else {
-                        disable_pipes = std::nullopt;
+                        config.disable_pipes = std::nullopt;
                     }
                 } else if (const auto parsed_value = value.as_string()) {
-                    disable_pipes = parsed_value->get();
+                    config.disable_pipes = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "editor_coordinate_hack") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    editor_coordinate_hack = parsed_value->get();
+                    config.editor_coordinate_hack = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "editor_disable_host_scaling") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    editor_disable_host_scaling = parsed_value->get();
+                    config.editor_disable_host_scaling = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "editor_force_dnd") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    editor_force_dnd = parsed_value->get();
+                    config.editor_force_dnd = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "editor_xembed") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    editor_xembed = parsed_value->get();
+                    config.editor_xembed = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "frame_rate") {
                 if (const auto parsed_value = value.as_floating_point()) {
-                    frame_rate = parsed_value->get();
+                    config.frame_rate = parsed_value->get();
                 } else if (const auto parsed_value = value.as_integer()) {
                     // For usability's sake we want to be a bit more lax than a
                     // normal TOML file would be and accept both floating point
                     // values and integers here
-                    frame_rate = parsed_value->get();
+                    config.frame_rate = parsed_value->get();
+                } else {
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "idle_frame_rate") {
+                // Just like `frame_rate`, this accepts both integers and
+                // floating point values
+                if (const auto parsed_value = value.as_floating_point();
+                    parsed_value && parsed_value->get() > 0.0) {
+                    config.idle_frame_rate = parsed_value->get();
+                } else if (const auto parsed_value = value.as_integer();
+                           parsed_value && parsed_value->get() > 0) {
+                    config.idle_frame_rate = parsed_value->get();
+                } else {
+                    config.invalid_options.emplace_back(key);
+                }
+            } else if (key == "gui_thread_cpus") {
+                if (auto cpus = parse_cpu_option(value)) {
+                    config.gui_thread_cpus = std::move(cpus);
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "hide_daw") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    hide_daw = parsed_value->get();
+                    config.hide_daw = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else if (key == "vst3_prefer_32bit") {
                 if (const auto parsed_value = value.as_boolean()) {
-                    vst3_prefer_32bit = parsed_value->get();
+                    config.vst3_prefer_32bit = parsed_value->get();
                 } else {
-                    invalid_options.emplace_back(key);
+                    config.invalid_options.emplace_back(key);
                 }
             } else {
-                unknown_options.emplace_back(key);
+                config.unknown_options.emplace_back(key);
             }
         }
-
-        break;
     }
 }
 
-std::chrono::steady_clock::duration Configuration::event_loop_interval()
-    const noexcept {
-    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-        std::chrono::milliseconds(1000) / frame_rate.value_or(60.0));
+Configuration ConfigFile::match(const fs::path& yabridge_path) const {
+    // This is the path of the current .so file relative to this `yabridge.toml`
+    // file
+    const std::string relative_path =
+        yabridge_path.lexically_relative(config_path_.parent_path()).string();
+    for (const Section& section : sections_) {
+        // First try to match the glob pattern, allow matching an entire
+        // directory for ease of use. If none of the patterns in the file match
+        // the plugin path then everything will be left at the defaults.
+        if (!relative_path.starts_with(section.literal_prefix) ||
+            fnmatch(section.pattern.c_str(), relative_path.c_str(),
+                    FNM_PATHNAME | FNM_LEADING_DIR) != 0) {
+            continue;
+        }
+
+        return section.config;
+    }
+
+    return Configuration();
 }
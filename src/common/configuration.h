@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <optional>
+#include <vector>
 
 #include <ghc/filesystem.hpp>
 
@@ -62,7 +63,8 @@ class Configuration {
      * Load the configuration for an instance of yabridge from a configuration
      * file by matching the plugin's relative path to the glob patterns in that
      * configuration file. Will leave the object empty if the plugin cannot be
-     * matched to any of the patterns. Not meant to be used directly.
+     * matched to any of the patterns. Not meant to be used directly. This is
+     * the same as `ConfigFile(config_path).match(yabridge_path)`.
      *
      * @throw toml::parse_error If the file could not be parsed.
      *
@@ -78,6 +80,36 @@ class Configuration {
      */
     std::optional<std::string> group;
 
+    /**
+     * If set and `group` is not, then plugins will automatically be distributed
+     * over a number of plugin groups based on how busy those groups are. This
+     * gives most of the memory savings of plugin groups without having every
+     * plugin share a single GUI thread. The value is the number of group host
+     * processes to use per Wine prefix and architecture. When the option is
+     * set to `true` this is stored as 0, which means that the number of group
+     * host processes should be derived from the number of CPU cores.
+     *
+     * @see choose_auto_group
+     */
+    std::optional<uint32_t> auto_group;
+
+    /**
+     * If set and neither `group` nor `auto_group` are, then all instances of
+     * this VST2 plugin will share a single dedicated plugin host process
+     * instead of each being hosted individually. The plugin's module is loaded
+     * once, so its code pages and any read-only data the plugin loads during
+     * initialization, like large sample tables, are shared between instances
+     * instead of being duplicated for every instance. This gives up
+     * per-instance crash isolation: if one instance crashes, then all other
+     * instances in that process go down with it. The module stays loaded until
+     * `pinned_module_idle_timeout` after the last instance has been closed.
+     * When combined with `group` or `auto_group`, the module is kept loaded
+     * within that group instead. Instances of a VST3 or CLAP plugin are always
+     * hosted in a single process, so this is rejected for those plugins unless
+     * they're in a plugin group.
+     */
+    bool share_plugin_image = false;
+
     /**
      * If enabled, we'll redirect the plugin's STDOUT and STDERR streams to this
      * file instead of using pipes to intersperse it with yabridge's other
@@ -132,6 +164,18 @@ class Configuration {
      */
     std::optional<float> frame_rate;
 
+    /**
+     * If set, plugin editors the user hasn't interacted with for a couple of
+     * seconds will be updated at this lower rate instead of at `frame_rate`.
+     * The editor switches back to the full rate as soon as the mouse cursor
+     * enters it. This is useful for plugins that only need a high frame rate
+     * while they're being used, but not for meters that should always update
+     * smoothly.
+     *
+     * @relates idle_event_loop_interval
+     */
+    std::optional<float> idle_frame_rate;
+
     /**
      * When this option is enabled, we'll report some random other string
      * instead of the actual name of the host when the plugin queries it. This
@@ -161,6 +205,42 @@ class Configuration {
      */
     bool vst3_prefer_32bit = false;
 
+    /**
+     * Back the shared audio buffers with explicitly reserved 2 MiB huge pages
+     * instead of regular POSIX shared memory. If no huge pages have been
+     * reserved, this falls back to a memfd with transparent huge pages. This
+     * reduces TLB pressure for plugins with very large channel counts.
+     *
+     * @see AudioShmBuffer::Config::Backing
+     */
+    bool audio_buffer_huge_pages = false;
+
+    /**
+     * The CPUs the Wine plugin host's audio threads should be restricted to.
+     * Threads spawned by the plugin from those threads will inherit this
+     * affinity. Set through the `audio_thread_cpus` option as either a list of
+     * CPU numbers or a string in the same format as `isolcpus` and `taskset
+     * -c`, e.g. `"2-3,6"`. If this is not set, the audio threads will use the
+     * affinity the Wine plugin host was started with.
+     */
+    std::optional<std::vector<uint16_t>> audio_thread_cpus;
+
+    /**
+     * Set when `audio_thread_cpus` is set to `"host"`. In that case the Wine
+     * plugin host's audio threads will periodically copy the CPU affinity of
+     * the host's audio thread, at the same time the realtime priority is
+     * synchronized. Only the first 64 CPUs can be mirrored this way.
+     */
+    bool audio_thread_cpus_follow_host = false;
+
+    /**
+     * The CPUs the Wine plugin host's main thread, and thus all editor and
+     * other GUI related work, should be restricted to. Uses the same format as
+     * `audio_thread_cpus`. When hosting multiple plugins in a plugin group,
+     * the last plugin to be initialized determines this setting.
+     */
+    std::optional<std::vector<uint16_t>> gui_thread_cpus;
+
     /**
      * The path to the configuration file that was parsed.
      */
@@ -190,10 +270,21 @@ class Configuration {
      */
     std::chrono::steady_clock::duration event_loop_interval() const noexcept;
 
+    /**
+     * The interval for a plugin editor's idle timer while the user is not
+     * interacting with it, if `idle_frame_rate` is set. This is never shorter
+     * than `event_loop_interval()`.
+     */
+    std::optional<std::chrono::steady_clock::duration>
+    idle_event_loop_interval() const noexcept;
+
     template <typename S>
     void serialize(S& s) {
         s.ext(group, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.text1b(v, 4096); });
+        s.ext(auto_group, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(share_plugin_image);
 
         s.ext(disable_pipes, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::GhcPath{}); });
@@ -202,9 +293,17 @@ class Configuration {
         s.value1b(editor_xembed);
         s.ext(frame_rate, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.value4b(v); });
+        s.ext(idle_frame_rate, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
         s.value1b(hide_daw);
         s.value1b(editor_disable_host_scaling);
         s.value1b(vst3_prefer_32bit);
+        s.value1b(audio_buffer_huge_pages);
+        s.ext(audio_thread_cpus, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.container2b(v, 8192); });
+        s.value1b(audio_thread_cpus_follow_host);
+        s.ext(gui_thread_cpus, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.container2b(v, 8192); });
 
         s.ext(matched_file, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::GhcPath{}); });
@@ -217,3 +316,56 @@ class Configuration {
                     [](S& s, auto& v) { s.text1b(v, 4096); });
     }
 };
+
+/**
+ * A parsed `yabridge.toml` file. The file is parsed and all of its sections
+ * are interpreted once when this object is created, after which `match()` can
+ * be used to find the settings for any number of plugins without touching the
+ * file again. `load_config_for()` keeps these objects around for as long as
+ * the file doesn't change, so loading hundreds of plugins that share the same
+ * `yabridge.toml` file only parses it once.
+ */
+class ConfigFile {
+   public:
+    /**
+     * Parse a `yabridge.toml` file.
+     *
+     * @throw toml::parse_error If the file could not be parsed.
+     */
+    explicit ConfigFile(const ghc::filesystem::path& config_path);
+
+    /**
+     * Find the settings for an instance of yabridge by matching the plugin's
+     * path relative to this file to the glob patterns in the file. The first
+     * section that matches is used, and the returned object contains the
+     * default settings if none of them match. See the docstring on
+     * `Configuration` for more information.
+     */
+    Configuration match(const ghc::filesystem::path& yabridge_path) const;
+
+   private:
+    struct Section {
+        /**
+         * The section's glob pattern.
+         */
+        std::string pattern;
+        /**
+         * The part of `pattern` before the first wildcard or escape character.
+         * A path that doesn't start with this prefix can never match the
+         * pattern, which lets us skip most `fnmatch()` calls.
+         */
+        std::string literal_prefix;
+        /**
+         * The settings from this section, with `matched_file` and
+         * `matched_pattern` already filled in.
+         */
+        Configuration config;
+    };
+
+    ghc::filesystem::path config_path_;
+
+    /**
+     * All sections in the file, in the order they appear in.
+     */
+    std::vector<Section> sections_;
+};
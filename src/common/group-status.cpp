@@ -0,0 +1,131 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "group-status.h"
+
+#include <fstream>
+#include <string>
+
+#include <time.h>
+
+namespace fs = ghc::filesystem;
+
+std::optional<GroupHostStatus> GroupHostStatus::read(
+    const fs::path& status_path) noexcept {
+    try {
+        std::ifstream file(status_path.string());
+        if (!file.is_open()) {
+            return std::nullopt;
+        }
+
+        GroupHostStatus status{};
+        for (std::string line; std::getline(file, line);) {
+            const size_t separator = line.find('=');
+            if (separator == std::string::npos) {
+                continue;
+            }
+
+            const std::string key = line.substr(0, separator);
+            const std::string value = line.substr(separator + 1);
+            if (key == "instances") {
+                status.num_instances = std::stoull(value);
+            } else if (key == "audio_load") {
+                status.audio_load = std::stod(value);
+            } else if (key == "gui_load") {
+                status.gui_load = std::stod(value);
+            } else if (key == "accepted") {
+                // The endpoint base directory may contain spaces, so only the
+                // first space separates the two fields
+                const size_t field_separator = value.find(' ');
+                if (field_separator == std::string::npos) {
+                    continue;
+                }
+
+                status.recently_accepted.push_back(AcceptedPlugin{
+                    .accepted_ns =
+                        std::stoull(value.substr(0, field_separator)),
+                    .endpoint_base_dir = value.substr(field_separator + 1)});
+            } else if (key == "updated_ns") {
+                status.updated_ns = std::stoull(value);
+            }
+        }
+
+        const uint64_t stale_after_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                group_status_stale_after)
+                .count();
+        if (status.updated_ns + stale_after_ns < group_status_time_ns()) {
+            return std::nullopt;
+        }
+
+        return status;
+    } catch (const std::exception&) {
+        // A partially written or otherwise malformed file is simply ignored
+        return std::nullopt;
+    }
+}
+
+void GroupHostStatus::write(const fs::path& status_path) noexcept {
+    updated_ns = group_status_time_ns();
+
+    const uint64_t accept_history_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            group_status_accept_history)
+            .count();
+    std::erase_if(recently_accepted, [&](const AcceptedPlugin& plugin) {
+        return plugin.accepted_ns + accept_history_ns < updated_ns;
+    });
+
+    try {
+        // Readers should never see a partially written file, so we'll write to
+        // a temporary file first and then rename it over the old one
+        fs::path temporary_path = status_path;
+        temporary_path += ".tmp";
+
+        {
+            std::ofstream file(temporary_path.string(),
+                               std::ios::out | std::ios::trunc);
+            file << "instances=" << num_instances << "\n";
+            file << "audio_load=" << audio_load << "\n";
+            file << "gui_load=" << gui_load << "\n";
+            for (const auto& plugin : recently_accepted) {
+                file << "accepted=" << plugin.accepted_ns << " "
+                     << plugin.endpoint_base_dir << "\n";
+            }
+            file << "updated_ns=" << updated_ns << "\n";
+        }
+
+        fs::rename(temporary_path, status_path);
+    } catch (const std::exception&) {
+        // These files are only a hint for the load balancing, so there's
+        // nothing useful we can do here
+    }
+}
+
+fs::path group_status_path(const fs::path& group_socket_path) {
+    fs::path status_path = group_socket_path;
+    status_path.replace_extension(".status");
+
+    return status_path;
+}
+
+uint64_t group_status_time_ns() noexcept {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 +
+           static_cast<uint64_t>(now.tv_nsec);
+}
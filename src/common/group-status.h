@@ -0,0 +1,136 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ghc/filesystem.hpp>
+
+/**
+ * The interval at which group host processes update their status file.
+ */
+constexpr std::chrono::seconds group_status_update_interval(1);
+
+/**
+ * Status files that have not been updated for this long belong to a group host
+ * process that is no longer running.
+ */
+constexpr std::chrono::seconds group_status_stale_after(5);
+
+/**
+ * Group host processes list the plugins they accepted during this period in
+ * their status file. Plugins placed in an automatic group by
+ * `choose_auto_group()` that haven't shown up in that list after this long are
+ * assumed to have failed to start.
+ */
+constexpr std::chrono::seconds group_status_accept_history(30);
+
+/**
+ * A snapshot of how busy a group host process is. Group host processes write
+ * this to a small text file next to their group socket every
+ * `group_status_update_interval`, and whenever they start or stop hosting a
+ * plugin. When using automatic plugin groups, the native plugin uses these to
+ * decide which group host process should host a new plugin instance. See
+ * `choose_auto_group()` in `src/plugin/utils.h`.
+ *
+ * The file consists of `key=value` lines, so it's also easy to inspect by hand.
+ */
+struct GroupHostStatus {
+    /**
+     * The number of plugins currently hosted by the group host process.
+     */
+    uint64_t num_instances = 0;
+
+    /**
+     * The average number of CPU cores used by the group host process outside
+     * of its main thread during the last update interval. This is almost
+     * entirely audio processing.
+     */
+    double audio_load = 0.0;
+
+    /**
+     * The fraction of time the group host's main thread was busy during the
+     * last update interval. All GUI and most other non-realtime work for every
+     * plugin in the group happens on this thread, so this is what limits how
+     * many plugins with open editors a single group can comfortably host.
+     */
+    double gui_load = 0.0;
+
+    /**
+     * A request to host a plugin accepted by the group host process.
+     */
+    struct AcceptedPlugin {
+        /**
+         * The `CLOCK_MONOTONIC` time in nanoseconds at which the request was
+         * accepted.
+         */
+        uint64_t accepted_ns;
+        /**
+         * The plugin's socket endpoint base directory, which uniquely
+         * identifies the plugin instance.
+         */
+        std::string endpoint_base_dir;
+    };
+
+    /**
+     * The plugins accepted during the last `group_status_accept_history`. These
+     * are included in `num_instances`, so `choose_auto_group()` uses this to
+     * tell which of its placements the group host process has already
+     * accounted for. Older entries are dropped in `write()`.
+     */
+    std::vector<AcceptedPlugin> recently_accepted;
+
+    /**
+     * The `CLOCK_MONOTONIC` time in nanoseconds at which this status was
+     * written.
+     */
+    uint64_t updated_ns = 0;
+
+    /**
+     * Read a status file written by `write()`. Returns a nullopt if the file
+     * does not exist, if it could not be parsed, or if it has not been updated
+     * for `group_status_stale_after`.
+     */
+    static std::optional<GroupHostStatus> read(
+        const ghc::filesystem::path& status_path) noexcept;
+
+    /**
+     * Atomically replace the status file at `status_path` with this status.
+     * `updated_ns` is set to the current time, and entries older than
+     * `group_status_accept_history` are removed from `recently_accepted`.
+     * Errors are ignored, since these files are only used as a hint.
+     */
+    void write(const ghc::filesystem::path& status_path) noexcept;
+};
+
+/**
+ * The path to the status file belonging to a group host process listening on
+ * `group_socket_path`.
+ */
+ghc::filesystem::path group_status_path(
+    const ghc::filesystem::path& group_socket_path);
+
+/**
+ * The current value of `CLOCK_MONOTONIC` in nanoseconds. This clock is shared
+ * by all processes, so these timestamps can be compared between the native
+ * plugins and the group host processes.
+ */
+uint64_t group_status_time_ns() noexcept;
@@ -511,8 +511,9 @@ bool ClapLogger::log_request(
                     << request.process.steady_time_
                     << ", frames_count = " << request.process.frames_count_
                     << ", transport = "
-                    << (request.process.transport_ ? "<clap_event_transport_t*>"
-                                                   : "<nullptr>")
+                    << (request.process.transport_.has_value
+                            ? "<clap_event_transport_t*>"
+                            : "<nullptr>")
                     << ", audio_input_channels = " << num_input_channels.str()
                     << ", audio_output_channels = " << num_output_channels.str()
                     << ", in_events = <clap_input_events* with "
@@ -545,18 +546,29 @@ bool ClapLogger::log_request(bool is_host_plugin, const WantsConfiguration&) {
 }
 
 bool ClapLogger::log_request(bool is_host_plugin,
-                             const clap::host::RequestRestart& request) {
+                             const clap::host::Notify& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host::request_restart()";
-    });
-}
+        message << request.owner_instance_id << ": ";
 
-bool ClapLogger::log_request(bool is_host_plugin,
-                             const clap::host::RequestProcess& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host::request_process()";
+        bool is_first = true;
+        for (const auto& [flag, function] :
+             {std::pair(clap::host::notify_request_restart,
+                        "clap_host::request_restart()"),
+              std::pair(clap::host::notify_request_process,
+                        "clap_host::request_process()"),
+              std::pair(clap::host::notify_latency_changed,
+                        "clap_host_latency::changed()"),
+              std::pair(clap::host::notify_note_name_changed,
+                        "clap_host_note_name::changed()"),
+              std::pair(clap::host::notify_state_mark_dirty,
+                        "clap_host_state::mark_dirty()"),
+              std::pair(clap::host::notify_voice_info_changed,
+                        "clap_host_voice_info::changed()")}) {
+            if (request.notifications & flag) {
+                message << (is_first ? "" : ", ") << function;
+                is_first = false;
+            }
+        }
     });
 }
 
@@ -633,15 +645,6 @@ bool ClapLogger::log_request(bool is_host_plugin,
     });
 }
 
-bool ClapLogger::log_request(
-    bool is_host_plugin,
-    const clap::ext::note_name::host::Changed& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host_note_name::changed()";
-    });
-}
-
 bool ClapLogger::log_request(
     bool is_host_plugin,
     const clap::ext::note_ports::host::SupportedDialects& request) {
@@ -680,31 +683,6 @@ bool ClapLogger::log_request(bool is_host_plugin,
     });
 }
 
-bool ClapLogger::log_request(bool is_host_plugin,
-                             const clap::ext::latency::host::Changed& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host_latency::changed()";
-    });
-}
-
-bool ClapLogger::log_request(bool is_host_plugin,
-                             const clap::ext::state::host::MarkDirty& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host_state::mark_dirty()";
-    });
-}
-
-bool ClapLogger::log_request(
-    bool is_host_plugin,
-    const clap::ext::voice_info::host::Changed& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id
-                << ": clap_host_voice_info::changed()";
-    });
-}
-
 bool ClapLogger::log_request(bool is_host_plugin,
                              const clap::ext::log::host::Log& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
@@ -749,13 +727,6 @@ bool ClapLogger::log_request(
     });
 }
 
-bool ClapLogger::log_request(bool is_host_plugin,
-                             const clap::ext::tail::host::Changed& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.owner_instance_id << ": clap_host_tail::changed()";
-    });
-}
-
 void ClapLogger::log_response(bool is_host_plugin, const Ack&) {
     log_response_base(is_host_plugin, [&](auto& message) { message << "ACK"; });
 }
@@ -1074,6 +1045,9 @@ void ClapLogger::log_response(bool is_host_plugin,
                 << num_output_channels.str()
                 << " channels>, <clap_output_events_t* with "
                 << response.output_data.out_events->size() << " events>";
+        if (response.tail_changed) {
+            message << ", clap_host_tail::changed()";
+        }
     });
 }
 
@@ -162,8 +162,7 @@ class ClapLogger {
 
     // Main thread callbacks
     bool log_request(bool is_host_plugin, const WantsConfiguration&);
-    bool log_request(bool is_host_plugin, const clap::host::RequestRestart&);
-    bool log_request(bool is_host_plugin, const clap::host::RequestProcess&);
+    bool log_request(bool is_host_plugin, const clap::host::Notify&);
     bool log_request(
         bool is_host_plugin,
         const clap::ext::audio_ports::host::IsRescanFlagSupported&);
@@ -180,8 +179,6 @@ class ClapLogger {
     bool log_request(bool is_host_plugin,
                      const clap::ext::gui::host::RequestHide&);
     bool log_request(bool is_host_plugin, const clap::ext::gui::host::Closed&);
-    bool log_request(bool is_host_plugin,
-                     const clap::ext::note_name::host::Changed&);
     bool log_request(bool is_host_plugin,
                      const clap::ext::note_ports::host::SupportedDialects&);
     bool log_request(bool is_host_plugin,
@@ -190,19 +187,11 @@ class ClapLogger {
                      const clap::ext::params::host::Rescan&);
     bool log_request(bool is_host_plugin,
                      const clap::ext::params::host::Clear&);
-    bool log_request(bool is_host_plugin,
-                     const clap::ext::latency::host::Changed&);
-    bool log_request(bool is_host_plugin,
-                     const clap::ext::state::host::MarkDirty&);
-    bool log_request(bool is_host_plugin,
-                     const clap::ext::voice_info::host::Changed&);
 
     // Audio thread callbacks
     bool log_request(bool is_host_plugin, const clap::ext::log::host::Log&);
     bool log_request(bool is_host_plugin,
                      const clap::ext::params::host::RequestFlush&);
-    bool log_request(bool is_host_plugin,
-                     const clap::ext::tail::host::Changed&);
 
     // Main thread control message responses
     void log_response(bool is_host_plugin, const Ack&);
@@ -16,11 +16,25 @@
 
 #include "common.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <concepts>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <string_view>
+
+#ifndef WITHOUT_ASIO
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#endif
 
 /**
  * The environment variable indicating whether to log to a file. Will log to
@@ -41,6 +55,474 @@ constexpr char logging_verbosity_environment_variable[] =
  */
 constexpr char editor_tracing_flag[] = "+editor";
 
+/**
+ * Format and write a single log line to `stream`. Used by both the synchronous
+ * and the asynchronous logging paths.
+ */
+static void write_log_line(std::ostream& stream,
+                           std::optional<std::chrono::system_clock::time_point>
+                               timestamp,
+                           std::string_view text) {
+    std::ostringstream formatted_message;
+
+    if (timestamp) {
+        const time_t time = std::chrono::system_clock::to_time_t(*timestamp);
+
+        // How did C++ manage to get time formatting libraries without a way to
+        // actually get a timestamp in a threadsafe way? `localtime_r` in C++ is
+        // not portable but luckily we only have to support GCC anyway.
+        std::tm tm;
+        localtime_r(&time, &tm);
+
+        formatted_message << std::put_time(&tm, "%T") << " ";
+    }
+
+    formatted_message << text;
+    // Flushing a stringstream doesn't do anything, but we need to put a
+    // linefeed in this string stream rather writing it sprightly to the output
+    // stream to prevent two messages from being put on the same row
+    formatted_message << std::endl;
+
+    stream << formatted_message.str();
+}
+
+// The chainloaders only ever log a handful of messages and they should stay as
+// lightweight as possible, so they always write synchronously
+#ifndef WITHOUT_ASIO
+
+namespace {
+
+/**
+ * The maximum length of a message, including the logger's prefix, that can be
+ * written asynchronously. The text is stored inline in the log records so
+ * handing off a message never allocates. Longer messages are written
+ * synchronously instead.
+ */
+constexpr size_t max_async_message_size = 512;
+
+/**
+ * A single log message waiting to be written by `AsyncLogWriter`.
+ */
+struct LogRecord {
+    /**
+     * When the message was logged. This is also used to write messages from
+     * different threads in the correct order.
+     */
+    std::chrono::system_clock::time_point time;
+    /**
+     * Whether `time` should be written in front of the message.
+     */
+    bool prefix_timestamp;
+    std::shared_ptr<std::ostream> stream;
+    size_t text_size;
+    std::array<char, max_async_message_size> text;
+};
+
+/**
+ * A fixed size single producer single consumer ring buffer of log records.
+ * Every realtime thread that logs something gets its own ring, and the only
+ * consumer is `AsyncLogWriter`'s background thread. When the ring is full, new
+ * messages are dropped and counted instead of blocking the logging thread.
+ */
+class LogRing {
+   public:
+    static constexpr size_t capacity = 64;
+
+    /**
+     * Try to add a record to the ring. `fill` gets called with the slot that
+     * should be overwritten. Returns `false` and increments the drop counter if
+     * the ring is full. Only the owning thread may call this.
+     */
+    template <std::invocable<LogRecord&> F>
+    bool try_push(F&& fill) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= capacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        fill(records_[head % capacity]);
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Call `f` on every record currently in the ring. These records can be
+     * safely read until they are marked as consumed by passing the returned
+     * value to `consume()`. Only the writer thread may call this.
+     */
+    template <std::invocable<LogRecord&> F>
+    size_t peek(F&& f) {
+        const size_t head = head_.load(std::memory_order_acquire);
+        for (size_t i = tail_.load(std::memory_order_relaxed); i != head; i++) {
+            f(records_[i % capacity]);
+        }
+
+        return head;
+    }
+
+    /**
+     * Mark all records up to `head` as consumed, allowing the producer to
+     * reuse them. `head` should be the value returned by `peek()`.
+     */
+    void consume(size_t head) noexcept {
+        tail_.store(head, std::memory_order_release);
+    }
+
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the number of dropped messages since the last call, and reset the
+     * counter.
+     */
+    uint64_t take_dropped() noexcept {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+    enum class State : uint8_t {
+        /**
+         * The ring is empty and can be claimed by any thread.
+         */
+        free,
+        /**
+         * The ring belongs to a thread that's still running.
+         */
+        owned,
+        /**
+         * The owning thread has exited. The writer will mark the ring as free
+         * again once it has written the remaining messages.
+         */
+        owner_exited,
+    };
+
+    /**
+     * Threads claim a free ring with a compare-and-swap, so handing out rings
+     * never needs a lock.
+     */
+    std::atomic<State> state = State::free;
+
+   private:
+    std::array<LogRecord, LogRing::capacity> records_;
+
+    std::atomic_size_t head_ = 0;
+    std::atomic_size_t tail_ = 0;
+    std::atomic_uint64_t dropped_ = 0;
+};
+
+/**
+ * The process wide background thread that writes the messages logged from
+ * realtime threads. This takes care of formatting timestamps and all file I/O,
+ * so verbose logging doesn't cause xruns when audio threads log. Messages from
+ * all other threads are written synchronously, since the whole point of the
+ * logs is to debug crashes and any messages still waiting to be written would
+ * be lost when the process crashes.
+ */
+class AsyncLogWriter {
+   public:
+    /**
+     * Hand off a message to the writer thread, starting the writer if it was
+     * not yet running. Returns `false` if the message should be written
+     * synchronously instead, either because it's too long or because the writer
+     * has already been shut down during static destruction.
+     */
+    static bool try_log(std::chrono::system_clock::time_point time,
+                        bool prefix_timestamp,
+                        const std::shared_ptr<std::ostream>& stream,
+                        std::string_view prefix,
+                        std::string_view message) {
+        if (prefix.size() + message.size() > max_async_message_size) {
+            return false;
+        }
+
+        if (!enter()) {
+            return false;
+        }
+
+        AsyncLogWriter& writer = instance();
+        if (LogRing* ring = writer.thread_ring()) [[likely]] {
+            ring->try_push([&](LogRecord& record) {
+                record.time = time;
+                record.prefix_timestamp = prefix_timestamp;
+                record.stream = stream;
+                record.text_size = prefix.size() + message.size();
+                std::copy(prefix.begin(), prefix.end(), record.text.begin());
+                std::copy(message.begin(), message.end(),
+                          record.text.begin() + prefix.size());
+            });
+        } else {
+            writer.dropped_without_ring_.fetch_add(1,
+                                                   std::memory_order_relaxed);
+        }
+        writer.notify();
+
+        leave();
+
+        return true;
+    }
+
+    /**
+     * Start the writer thread ahead of time so the first message logged from
+     * an audio thread doesn't have to. Does nothing if the writer is already
+     * running or if it has been shut down.
+     */
+    static void start() {
+        if (!enter()) {
+            return;
+        }
+
+        instance();
+
+        leave();
+    }
+
+   private:
+    /**
+     * Set in `users` once the writer has been shut down. The remaining bits
+     * count the threads that are currently using the writer.
+     */
+    static constexpr uint32_t shut_down_bit = uint32_t(1) << 31;
+
+    /**
+     * The number of rings in the pool. Rings are claimed by realtime threads
+     * the first time they log something, and they're returned to the pool
+     * when those threads exit. If a host has even more audio threads than
+     * this, then the messages from the threads that didn't get a ring are
+     * dropped and counted instead.
+     */
+    static constexpr size_t num_rings = 32;
+
+    /**
+     * This is kept outside of the writer itself so we can still tell whether
+     * the writer is usable during static destruction. See `shut_down_bit`.
+     */
+    static std::atomic_uint32_t users;
+
+    /**
+     * Register the calling thread as a user of the writer. Checking whether the
+     * writer has been shut down and registering ourselves is a single atomic
+     * operation, so the writer's destructor can't run until `leave()` has been
+     * called. Returns `false` if the writer has already been shut down, in
+     * which case `leave()` should not be called.
+     */
+    static bool enter() noexcept {
+        if (users.fetch_add(1, std::memory_order_acquire) & shut_down_bit) {
+            users.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        return true;
+    }
+
+    static void leave() noexcept {
+        users.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * Get the process wide writer, starting it if it was not yet running. The
+     * caller should be registered in `users`.
+     */
+    static AsyncLogWriter& instance() {
+        static AsyncLogWriter writer;
+        return writer;
+    }
+
+    // This thread only writes to streams and never calls into plugin code, so
+    // there's no need to use `Win32Thread` on the Wine side
+    AsyncLogWriter() {
+        writer_thread_ = std::thread([this]() {
+            pthread_setname_np(pthread_self(), "log-writer");
+
+            run();
+        });
+    }
+
+    /**
+     * Stop the writer thread after writing all pending messages. This happens
+     * during static destruction, including when the yabridge library gets
+     * unloaded. After this any messages will be written synchronously.
+     */
+    ~AsyncLogWriter() noexcept {
+        // Once this bit is set no new threads will start using the writer, so
+        // we only need to wait for the threads that are currently handing off
+        // a message
+        users.fetch_or(shut_down_bit, std::memory_order_acq_rel);
+        while ((users.load(std::memory_order_acquire) & ~shut_down_bit) != 0) {
+            std::this_thread::yield();
+        }
+
+        stopping_.store(true, std::memory_order_release);
+        pending_.store(1, std::memory_order_release);
+        pending_.notify_one();
+        writer_thread_.join();
+    }
+
+    /**
+     * Get the calling thread's ring, claiming a free ring from the pool on
+     * first use. This never blocks or allocates. Returns a null pointer if all
+     * rings are currently in use, in which case we'll try again the next time
+     * this thread logs something.
+     */
+    LogRing* thread_ring() noexcept {
+        thread_local struct RingOwner {
+            LogRing* ring = nullptr;
+
+            ~RingOwner() noexcept {
+                // The writer may already have been shut down if this thread
+                // outlives static destruction
+                if (ring && enter()) {
+                    ring->state.store(LogRing::State::owner_exited,
+                                      std::memory_order_release);
+                    leave();
+                }
+            }
+        } owner;
+
+        if (!owner.ring) [[unlikely]] {
+            for (LogRing& ring : rings_) {
+                LogRing::State expected = LogRing::State::free;
+                if (ring.state.compare_exchange_strong(
+                        expected, LogRing::State::owned,
+                        std::memory_order_acq_rel)) {
+                    owner.ring = &ring;
+                    break;
+                }
+            }
+        }
+
+        return owner.ring;
+    }
+
+    /**
+     * Wake up the writer thread if it's waiting for new messages. The writer
+     * only needs to be woken up when the first message gets pushed after it
+     * has gone to sleep, so this only does a system call if that's the case.
+     */
+    void notify() noexcept {
+        if (pending_.exchange(1, std::memory_order_acq_rel) == 0) {
+            pending_.notify_one();
+        }
+    }
+
+    void run() {
+        std::vector<LogRecord*> pending;
+        while (true) {
+            // Any messages pushed after resetting this flag will wake us up
+            // again, so we can't miss any messages
+            pending_.wait(0, std::memory_order_acquire);
+            pending_.exchange(0, std::memory_order_acq_rel);
+            const bool stopping = stopping_.load(std::memory_order_acquire);
+
+            write_pending(pending);
+
+            // Rings for threads that have exited can be reused once they're
+            // empty. The owner can't push any new messages at this point.
+            for (LogRing& ring : rings_) {
+                if (ring.state.load(std::memory_order_acquire) ==
+                        LogRing::State::owner_exited &&
+                    ring.empty()) {
+                    ring.state.store(LogRing::State::free,
+                                     std::memory_order_release);
+                }
+            }
+
+            if (stopping) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Write all messages that are currently in the rings. Messages from
+     * different threads are written in chronological order.
+     */
+    void write_pending(std::vector<LogRecord*>& pending) {
+        // We'll first collect pointers to all pending records, and the rings
+        // are only marked as consumed once those records have been written
+        pending.clear();
+        std::array<size_t, num_rings> heads{};
+        for (size_t i = 0; i < num_rings; i++) {
+            heads[i] = rings_[i].peek(
+                [&](LogRecord& record) { pending.push_back(&record); });
+        }
+
+        std::stable_sort(pending.begin(), pending.end(),
+                         [](const LogRecord* a, const LogRecord* b) {
+                             return a->time < b->time;
+                         });
+
+        std::ostream* last_stream = nullptr;
+        for (LogRecord* record : pending) {
+            if (last_stream && last_stream != record->stream.get()) {
+                last_stream->flush();
+            }
+            last_stream = record->stream.get();
+
+            write_log_line(
+                *record->stream,
+                record->prefix_timestamp ? std::optional(record->time)
+                                         : std::nullopt,
+                std::string_view(record->text.data(), record->text_size));
+        }
+
+        // Messages dropped because a ring was full will always have a stream
+        // we can report this on. Messages dropped because no ring was
+        // available are reported once there's a stream to report them on.
+        if (last_stream) {
+            uint64_t dropped =
+                dropped_without_ring_.exchange(0, std::memory_order_relaxed);
+            for (LogRing& ring : rings_) {
+                dropped += ring.take_dropped();
+            }
+
+            if (dropped > 0) {
+                *last_stream << "[" << dropped
+                             << " log messages were dropped]" << std::endl;
+            }
+
+            last_stream->flush();
+        }
+
+        // Don't keep the streams alive longer than necessary
+        for (LogRecord* record : pending) {
+            record->stream.reset();
+        }
+        for (size_t i = 0; i < num_rings; i++) {
+            rings_[i].consume(heads[i]);
+        }
+    }
+
+    /**
+     * The ring buffers realtime threads write their messages to. These are all
+     * allocated together with the writer, so no allocations happen on the
+     * audio threads.
+     */
+    std::array<LogRing, num_rings> rings_;
+    /**
+     * The number of messages dropped because all rings were in use.
+     */
+    std::atomic_uint64_t dropped_without_ring_ = 0;
+
+    /**
+     * Set to 1 when there are new messages, and reset by the writer thread
+     * before it starts writing them. The writer sleeps using `wait()` while
+     * this is 0.
+     */
+    std::atomic_uint32_t pending_ = 0;
+    std::atomic_bool stopping_ = false;
+
+    std::thread writer_thread_;
+};
+
+std::atomic_uint32_t AsyncLogWriter::users = 0;
+
+}  // namespace
+
+#endif  // WITHOUT_ASIO
+
 Logger::Logger(std::shared_ptr<std::ostream> stream,
                Verbosity verbosity_level,
                bool editor_tracing,
@@ -50,7 +532,15 @@ Logger::Logger(std::shared_ptr<std::ostream> stream,
       editor_tracing_(editor_tracing),
       stream_(stream),
       prefix_(prefix),
-      prefix_timestamp_(prefix_timestamp) {}
+      prefix_timestamp_(prefix_timestamp) {
+#ifndef WITHOUT_ASIO
+    // With these verbosity levels the audio threads will likely log something,
+    // so we'll start the writer now instead of from an audio thread
+    if (verbosity_ >= Verbosity::most_events) {
+        AsyncLogWriter::start();
+    }
+#endif
+}
 
 Logger Logger::create_from_environment(std::string prefix,
                                        std::shared_ptr<std::ostream> stream,
@@ -120,28 +610,22 @@ Logger Logger::create_exception_logger() {
 }
 
 void Logger::log(const std::string& message) {
-    std::ostringstream formatted_message;
-
-    if (prefix_timestamp_) {
-        const auto current_time = std::chrono::system_clock::now();
-        const time_t timestamp =
-            std::chrono::system_clock::to_time_t(current_time);
+    const auto now = std::chrono::system_clock::now();
 
-        // How did C++ manage to get time formatting libraries without a way to
-        // actually get a timestamp in a threadsafe way? `localtime_r` in C++ is
-        // not portable but luckily we only have to support GCC anyway.
-        std::tm tm;
-        localtime_r(&timestamp, &tm);
-
-        formatted_message << std::put_time(&tm, "%T") << " ";
+#ifndef WITHOUT_ASIO
+    // Messages logged from the audio threads are formatted and written to the
+    // stream on a background thread so logging never blocks those threads.
+    // Everything else is written right away so the messages don't get lost if
+    // the process crashes.
+    if (is_realtime_thread() &&
+        AsyncLogWriter::try_log(now, prefix_timestamp_, stream_, prefix_,
+                                message)) {
+        return;
     }
+#endif
 
-    formatted_message << prefix_;
-    formatted_message << message;
-    // Flushing a stringstream doesn't do anything, but we need to put a
-    // linefeed in this string stream rather writing it sprightly to the output
-    // stream to prevent two messages from being put on the same row
-    formatted_message << std::endl;
-
-    *stream_ << formatted_message.str() << std::flush;
+    write_log_line(*stream_,
+                   prefix_timestamp_ ? std::optional(now) : std::nullopt,
+                   prefix_ + message);
+    *stream_ << std::flush;
 }
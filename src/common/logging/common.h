@@ -39,11 +39,19 @@
  * because DAWs like Bitwig hide this from you, making it hard to debug
  * crashing plugins.
  *
- * @note This does not do any synchronisation. While this should technically
- *   be causing problems in concurrent use, writing strings to fstreams from
- *   multiple threads at the same time doesn't seem to produce corrupted text if
- *   you're writing an entire string at once even though the messages may be
- *   slightly out of order.
+ * @note Messages logged from realtime audio threads are written
+ *   asynchronously. `log()` only copies the message to a per-thread lock-free
+ *   ring buffer, and a single background thread takes care of timestamps,
+ *   ordering and the actual I/O. This way logging never blocks audio threads.
+ *   If a thread logs messages faster than they can be written and its ring
+ *   fills up, or if there are more realtime threads than there are rings,
+ *   then new messages are dropped and the number of dropped messages is logged
+ *   instead. All other messages are written synchronously so they
+ *   aren't lost when the process crashes. Writing strings to fstreams from
+ *   multiple threads at the same time doesn't seem to produce corrupted text
+ *   if you're writing an entire string at once, even though the messages may
+ *   be slightly out of order. The chainloaders (which are built without Asio)
+ *   always write synchronously.
  */
 class Logger {
    public:
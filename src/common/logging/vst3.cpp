@@ -16,6 +16,7 @@
 
 #include "vst3.h"
 
+#include <algorithm>
 #include <bitset>
 
 #include <public.sdk/source/vst/utility/stringconvert.h>
@@ -445,25 +446,25 @@ bool Vst3Logger::log_request(
 
 bool Vst3Logger::log_request(
     bool is_host_plugin,
-    const YaNoteExpressionController::GetNoteExpressionCount& request) {
+    const YaMidiMapping::GetMidiControllerAssignments& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
-        message
-            << request.instance_id
-            << ": INoteExpressionController::getNoteExpressionCount(busIndex = "
-            << request.bus_index << ", channel = " << request.channel << ")";
+        message << request.instance_id
+                << ": IMidiMapping::getMidiControllerAssignment(busIndex = "
+                << request.bus_index
+                << ", channel = ..., midiControllerNumber = ..., &id) "
+                   "(batched)";
     });
 }
 
 bool Vst3Logger::log_request(
     bool is_host_plugin,
-    const YaNoteExpressionController::GetNoteExpressionInfo& request) {
+    const YaNoteExpressionController::GetNoteExpressionInfos& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
         message
             << request.instance_id
             << ": INoteExpressionController::getNoteExpressionInfo(busIndex = "
             << request.bus_index << ", channel = " << request.channel
-            << ", noteExpressionIndex = " << request.note_expression_index
-            << ", &info)";
+            << ", ..., &info) (batched)";
     });
 }
 
@@ -770,34 +771,28 @@ bool Vst3Logger::log_request(bool is_host_plugin,
 }
 
 bool Vst3Logger::log_request(bool is_host_plugin,
-                             const YaUnitInfo::GetUnitCount& request) {
-    return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.instance_id << ": IUnitInfo::getUnitCount()";
-    });
-}
-
-bool Vst3Logger::log_request(bool is_host_plugin,
-                             const YaUnitInfo::GetUnitInfo& request) {
+                             const YaUnitInfo::GetUnitInfos& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
         message << request.instance_id
-                << ": IUnitInfo::getUnitInfo(unitIndex = " << request.unit_index
-                << ", &info)";
+                << ": IUnitInfo::getUnitInfo(..., &info) (batched)";
     });
 }
 
 bool Vst3Logger::log_request(bool is_host_plugin,
-                             const YaUnitInfo::GetProgramListCount& request) {
+                             const YaUnitInfo::GetProgramListInfos& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
-        message << request.instance_id << ": IUnitInfo::getProgramListCount()";
+        message << request.instance_id
+                << ": IUnitInfo::getProgramListInfo(..., &info) (batched)";
     });
 }
 
 bool Vst3Logger::log_request(bool is_host_plugin,
-                             const YaUnitInfo::GetProgramListInfo& request) {
+                             const YaUnitInfo::GetProgramNames& request) {
     return log_request_base(is_host_plugin, [&](auto& message) {
         message << request.instance_id
-                << ": IUnitInfo::getProgramListInfo(listIndex = "
-                << request.list_index << ", &info)";
+                << ": IUnitInfo::getProgramName(listId = " << request.list_id
+                << ", programIndex = 0.." << request.program_count
+                << ", &name) (batched)";
     });
 }
 
@@ -1056,8 +1051,9 @@ bool Vst3Logger::log_request(
                     << (request.data.output_events_ ? "<IEventList*>"
                                                     : "<nullptr>")
                     << ", process_context = "
-                    << (request.data.process_context_ ? "<ProcessContext*>"
-                                                      : "<nullptr>")
+                    << (request.data.process_context_.has_value
+                            ? "<ProcessContext*>"
+                            : "<nullptr>")
                     << ", process_mode = " << request.data.process_mode_
                     << ", symbolic_sample_size = "
                     << request.data.symbolic_sample_size_ << ">)";
@@ -1540,14 +1536,23 @@ void Vst3Logger::log_response(
 
 void Vst3Logger::log_response(
     bool is_host_plugin,
-    const YaNoteExpressionController::GetNoteExpressionInfoResponse& response) {
+    const YaMidiMapping::GetMidiControllerAssignmentsResponse& response) {
     log_response_base(is_host_plugin, [&](auto& message) {
-        message << response.result.string();
-        if (response.result == Steinberg::kResultOk) {
-            message << ", <NoteExpressionTypeInfo for \""
-                    << VST3::StringConvert::convert(response.info.title)
-                    << "\">";
-        }
+        const size_t num_assigned =
+            std::count_if(response.ids.begin(), response.ids.end(),
+                          [](const auto& id) { return id.has_value(); });
+        message << "<ParamID> for " << num_assigned << " of "
+                << response.ids.size() << " MIDI controllers";
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_plugin,
+    const YaNoteExpressionController::GetNoteExpressionInfosResponse&
+        response) {
+    log_response_base(is_host_plugin, [&](auto& message) {
+        message << "<NoteExpressionTypeInfo> for " << response.infos.size()
+                << " note expressions";
     });
 }
 
@@ -1672,28 +1677,28 @@ void Vst3Logger::log_response(bool is_host_plugin,
     });
 }
 
-void Vst3Logger::log_response(bool is_host_plugin,
-                              const YaUnitInfo::GetUnitInfoResponse& response) {
+void Vst3Logger::log_response(
+    bool is_host_plugin,
+    const YaUnitInfo::GetUnitInfosResponse& response) {
     log_response_base(is_host_plugin, [&](auto& message) {
-        message << response.result.string();
-        if (response.result == Steinberg::kResultOk) {
-            message << ", <UnitInfo for \""
-                    << VST3::StringConvert::convert(response.info.name)
-                    << "\">";
-        }
+        message << "<UnitInfo> for " << response.infos.size() << " units";
     });
 }
 
 void Vst3Logger::log_response(
     bool is_host_plugin,
-    const YaUnitInfo::GetProgramListInfoResponse& response) {
+    const YaUnitInfo::GetProgramListInfosResponse& response) {
     log_response_base(is_host_plugin, [&](auto& message) {
-        message << response.result.string();
-        if (response.result == Steinberg::kResultOk) {
-            message << ", <ProgramListInfo for \""
-                    << VST3::StringConvert::convert(response.info.name)
-                    << "\">";
-        }
+        message << "<ProgramListInfo> for " << response.infos.size()
+                << " program lists";
+    });
+}
+
+void Vst3Logger::log_response(
+    bool is_host_plugin,
+    const YaUnitInfo::GetProgramNamesResponse& response) {
+    log_response_base(is_host_plugin, [&](auto& message) {
+        message << "<String128> for " << response.names.size() << " programs";
     });
 }
 
@@ -1878,6 +1883,11 @@ void Vst3Logger::log_response(bool is_host_plugin,
                     << response.updated_audio_buffers_config->name << "\", "
                     << response.updated_audio_buffers_config->size << " bytes>";
         }
+        if (response.process_context_requirements) {
+            message << ", <process context requirements "
+                    << std::bitset<32>(*response.process_context_requirements)
+                    << ">";
+        }
     });
 }
 
@@ -118,9 +118,9 @@ class Vst3Logger {
     bool log_request(bool is_host_plugin,
                      const YaMidiMapping::GetMidiControllerAssignment&);
     bool log_request(bool is_host_plugin,
-                     const YaNoteExpressionController::GetNoteExpressionCount&);
+                     const YaMidiMapping::GetMidiControllerAssignments&);
     bool log_request(bool is_host_plugin,
-                     const YaNoteExpressionController::GetNoteExpressionInfo&);
+                     const YaNoteExpressionController::GetNoteExpressionInfos&);
     bool log_request(
         bool is_host_plugin,
         const YaNoteExpressionController::GetNoteExpressionStringByValue&);
@@ -167,12 +167,10 @@ class Vst3Logger {
     bool log_request(bool is_host_plugin, const YaUnitData::UnitDataSupported&);
     bool log_request(bool is_host_plugin, const YaUnitData::GetUnitData&);
     bool log_request(bool is_host_plugin, const YaUnitData::SetUnitData&);
-    bool log_request(bool is_host_plugin, const YaUnitInfo::GetUnitCount&);
-    bool log_request(bool is_host_plugin, const YaUnitInfo::GetUnitInfo&);
+    bool log_request(bool is_host_plugin, const YaUnitInfo::GetUnitInfos&);
     bool log_request(bool is_host_plugin,
-                     const YaUnitInfo::GetProgramListCount&);
-    bool log_request(bool is_host_plugin,
-                     const YaUnitInfo::GetProgramListInfo&);
+                     const YaUnitInfo::GetProgramListInfos&);
+    bool log_request(bool is_host_plugin, const YaUnitInfo::GetProgramNames&);
     bool log_request(bool is_host_plugin, const YaUnitInfo::GetProgramName&);
     bool log_request(bool is_host_plugin, const YaUnitInfo::GetProgramInfo&);
     bool log_request(bool is_host_plugin,
@@ -285,7 +283,10 @@ class Vst3Logger {
         const YaMidiMapping::GetMidiControllerAssignmentResponse&);
     void log_response(
         bool is_host_plugin,
-        const YaNoteExpressionController::GetNoteExpressionInfoResponse&);
+        const YaMidiMapping::GetMidiControllerAssignmentsResponse&);
+    void log_response(
+        bool is_host_plugin,
+        const YaNoteExpressionController::GetNoteExpressionInfosResponse&);
     void log_response(bool is_host_plugin,
                       const YaNoteExpressionController::
                           GetNoteExpressionStringByValueResponse&);
@@ -309,9 +310,11 @@ class Vst3Logger {
     void log_response(bool is_host_plugin,
                       const YaUnitData::GetUnitDataResponse&);
     void log_response(bool is_host_plugin,
-                      const YaUnitInfo::GetUnitInfoResponse&);
+                      const YaUnitInfo::GetUnitInfosResponse&);
+    void log_response(bool is_host_plugin,
+                      const YaUnitInfo::GetProgramListInfosResponse&);
     void log_response(bool is_host_plugin,
-                      const YaUnitInfo::GetProgramListInfoResponse&);
+                      const YaUnitInfo::GetProgramNamesResponse&);
     void log_response(bool is_host_plugin,
                       const YaUnitInfo::GetProgramNameResponse&);
     void log_response(bool is_host_plugin,
@@ -58,7 +58,7 @@
  * nested mutual recursion.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
- *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
+ *   should be `NativeThread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class MutualRecursionHelper {
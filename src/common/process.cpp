@@ -20,7 +20,15 @@
 #include <iostream>
 
 #include <spawn.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
+#include <unistd.h>
+
+// Older kernel headers don't define this yet. The syscall number is the same on
+// every architecture.
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
 
 namespace fs = ghc::filesystem;
 
@@ -40,6 +48,11 @@ bool pid_running(pid_t pid) {
     return !err || err.value() == EACCES;
 }
 
+int open_pidfd(pid_t pid) noexcept {
+    // glibc only added a wrapper for this in 2.36
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
 std::vector<fs::path> get_augmented_search_path() {
     // HACK: `std::locale("")` would return the current locale, but this
     //       overload is implementation specific, and libstdc++ returns an error
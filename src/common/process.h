@@ -45,6 +45,17 @@
  */
 bool pid_running(pid_t pid);
 
+/**
+ * Open a pidfd for a process using `pidfd_open()`. This file descriptor becomes
+ * readable once the process has exited, which lets us wait for a process to
+ * exit using epoll (or Asio) instead of periodically calling `pid_running()`.
+ * The caller is responsible for closing the file descriptor.
+ *
+ * @return The file descriptor, or -1 if the process does not exist or if the
+ *   kernel does not support pidfds (this requires Linux 5.3).
+ */
+int open_pidfd(pid_t pid) noexcept;
+
 /**
  * Return the search path as defined in `$PATH`, with `~/.local/share/yabridge`
  * appended to the end. Even though it likely won't be set, this does respect
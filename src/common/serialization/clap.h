@@ -173,9 +173,7 @@ struct ClapAudioThreadControlRequest {
  */
 using ClapMainThreadCallbackRequest =
     std::variant<WantsConfiguration,
-                 clap::host::RequestRestart,
-                 clap::host::RequestProcess,
-                 clap::ext::latency::host::Changed,
+                 clap::host::Notify,
                  clap::ext::audio_ports::host::IsRescanFlagSupported,
                  clap::ext::audio_ports::host::Rescan,
                  clap::ext::audio_ports_config::host::Rescan,
@@ -184,13 +182,10 @@ using ClapMainThreadCallbackRequest =
                  clap::ext::gui::host::RequestShow,
                  clap::ext::gui::host::RequestHide,
                  clap::ext::gui::host::Closed,
-                 clap::ext::note_name::host::Changed,
                  clap::ext::note_ports::host::SupportedDialects,
                  clap::ext::note_ports::host::Rescan,
                  clap::ext::params::host::Rescan,
-                 clap::ext::params::host::Clear,
-                 clap::ext::state::host::MarkDirty,
-                 clap::ext::voice_info::host::Changed>;
+                 clap::ext::params::host::Clear>;
 
 template <typename S>
 void serialize(S& s, ClapMainThreadCallbackRequest& payload) {
@@ -214,8 +209,7 @@ void serialize(S& s, ClapMainThreadCallbackRequest& payload) {
 using ClapAudioThreadCallbackRequest =
     std::variant<WantsConfiguration,
                  clap::ext::log::host::Log,
-                 clap::ext::params::host::RequestFlush,
-                 clap::ext::tail::host::Changed>;
+                 clap::ext::params::host::RequestFlush>;
 
 template <typename S>
 void serialize(S& s, ClapAudioThreadCallbackRequest& payload) {
@@ -16,16 +16,14 @@
 
 #pragma once
 
-#include <string>
-#include <variant>
+#include <type_traits>
 
-#include <bitsery/traits/string.h>
+#include <bitsery/details/serialization_common.h>
+#include <bitsery/traits/core/traits.h>
 #include <clap/events.h>
 #include <llvm/small-vector.h>
 
-#include "../bitsery/ext/in-place-variant.h"
 #include "../bitsery/ext/native-pointer.h"
-#include "../bitsery/traits/small-vector.h"
 #include "../common.h"
 
 // Serialization messages for `clap/events.h`
@@ -33,203 +31,23 @@
 namespace clap {
 namespace events {
 
-/**
- * The actual event data. `clap::events::Event` stores these as a variant.
- * Ideally we'd store only the non-header payload data, but the
- * `clap_input_events::get()` function requires us to return a pointer to the
- * header, so if we did that then we'd need to create a second buffer containing
- * the serialzed events.
- */
-namespace payload {
-
-/**
- * The payload for `clap_event_note`. This is used for multiple event types,
- * which are encoded through `event.header.type`.
- */
-struct Note {
-    clap_event_note_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_note_expression`.
- */
-struct NoteExpression {
-    clap_event_note_expression_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_param_value`.
- */
-struct ParamValue {
-    clap_event_param_value_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_param_mod`.
- */
-struct ParamMod {
-    clap_event_param_mod_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_param_gesture`. This is used for multiple event
- * types, which are encoded through `event.header.type`.
- */
-struct ParamGesture {
-    clap_event_param_gesture_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_transport`.
- */
-struct Transport {
-    clap_event_transport_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_midi`.
- */
-struct Midi {
-    clap_event_midi_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-/**
- * The payload for `clap_event_midi_sysex`.
- */
-struct MidiSysex {
-    clap_event_midi_sysex_t event;
-
-    /**
-     * The actual SysEx event data. The pointer in `event` is set to the string
-     * data after the event has been created. As long as this event is not moved
-     * that pointer will remain valid.
-     *
-     * We're not expecting a lot of SysEx events, and `std::string`'s small
-     * string optimization should make it possible to send small sysex events
-     * without allocations. An alternative that won't allocate as quickly would
-     * be to store the data in a vector and to only store a tag here, but I
-     * don't think it's necessary at the moment.
-     */
-    std::string buffer;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event.header);
-        s.value2b(event.port_index);
-
-        s.text1b(buffer, 1 << 16);
-
-        // NOTE: These will need to be set when retrieving the event using
-        //       `clap_input_events::get()`. We could set the pointer here, but
-        //       in the off chance that there are a lot more events than we can
-        //       handle and the vector is reallocated to avoid dropping events,
-        //       then these pointers would become dangling. Making sure these
-        //       are null until the event is retrieved is probably for the best.
-        event.buffer = nullptr;
-        event.size = 0;
-    }
-};
-
-/**
- * The payload for `clap_event_midi2`.
- */
-struct Midi2 {
-    clap_event_midi2_t event;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.object(event);
-    }
-};
-
-}  // namespace payload
-
-/**
- * Encodes a CLAP event. These can be parsed from a `clap_event_header_t*` and
- * reconstructed back to a `clap_event_header`.
- */
-struct alignas(16) Event {
-    /**
-     * Parse a CLAP event. Returns a nullopt if yabridge does not support the
-     * event.
-     */
-    static std::optional<Event> parse(const clap_event_header_t& generic_event);
-
-    /**
-     * Get the `clap_event_header_t*` representation for this event. The pointer
-     * is valid as long as this struct isn't moved.
-     */
-    const clap_event_header_t* get() const;
-
-    /**
-     * The actual event data. These also contain the header because storing the
-     * entire `clap_event_*_t` struct is the only way to serialize the event
-     * list in a way that doesn't require us to create a second event list in
-     * that format after deserializing the events. An alternative would be to
-     * write the event in the proper format to a buffer before returning it from
-     * `clap_input_events::get()`, but that would cause unexpected lifetime
-     * issues.
-     */
-    mutable std::variant<
-        payload::Note,
-        payload::NoteExpression,
-        payload::ParamValue,
-        payload::ParamMod,
-        payload::ParamGesture,
-        // Most events are about the same length, but having the transport in
-        // here sadly doubles this struct's size
-        // TODO: Pack the events at some point, this will require special
-        //       handling for SysEx events
-        payload::Transport,
-        payload::Midi,
-        payload::MidiSysex,
-        payload::Midi2>
-        payload;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.ext(payload, bitsery::ext::InPlaceVariant{});
-    }
-};
-
 /**
  * A list storing one or more CLAP events. Can be used for both input and output
  * events.
+ *
+ * The events are stored back to back in a single arena as their native
+ * `clap_event_*_t` structs, with every event starting at an eight byte aligned
+ * offset. The events' `header.size` fields act as length prefixes, and an
+ * index containing every event's offset lets `clap_input_events::get()` return
+ * a pointer into the arena without having to copy anything. SysEx payloads are
+ * stored in a separate buffer, and the pointers to that buffer are only set
+ * when the event is retrieved since the buffer may still be reallocated while
+ * events are being added.
+ *
+ * When serializing, all events are written one after the other as a type tag
+ * followed by the event's fields. We can't send the arena as is because the
+ * 32-bit Wine plugin host uses different struct layouts for events containing
+ * pointers or doubles.
  */
 class EventList {
    public:
@@ -242,7 +60,7 @@ class EventList {
 
     /**
      * Read data from a `clap_input_events_t` into this existing object. This
-     * minimizes reallocations by keeping `events_` as is.
+     * minimizes reallocations by keeping the arena as is.
      */
     void repopulate(const clap_input_events_t& in_events);
 
@@ -282,13 +100,199 @@ class EventList {
      */
     inline size_t size() const noexcept { return events_.size(); }
 
+    /**
+     * Copy an event to the end of the list. Returns `false` if yabridge does
+     * not support the event, in which case it will be dropped.
+     */
+    bool push(const clap_event_header_t& event);
+
+    /**
+     * Get the event at `index`. The pointer is valid until the next event is
+     * added or until this object is moved.
+     */
+    const clap_event_header_t* get(size_t index) const;
+
+    /**
+     * Call `f(std::type_identity<T>{})` with the event struct type `T`
+     * corresponding to a core event type. Returns `false` if the event type is
+     * not supported. SysEx events are handled separately because of their
+     * heap data, so they're not included here.
+     */
+    template <typename F>
+    static bool visit_event_type(uint16_t type, F&& f) {
+        switch (type) {
+            // The original event type can be restored from the header
+            case CLAP_EVENT_NOTE_ON:
+            case CLAP_EVENT_NOTE_OFF:
+            case CLAP_EVENT_NOTE_CHOKE:
+            case CLAP_EVENT_NOTE_END:
+                f(std::type_identity<clap_event_note_t>{});
+                return true;
+            case CLAP_EVENT_NOTE_EXPRESSION:
+                f(std::type_identity<clap_event_note_expression_t>{});
+                return true;
+            case CLAP_EVENT_PARAM_VALUE:
+                f(std::type_identity<clap_event_param_value_t>{});
+                return true;
+            case CLAP_EVENT_PARAM_MOD:
+                f(std::type_identity<clap_event_param_mod_t>{});
+                return true;
+            case CLAP_EVENT_PARAM_GESTURE_BEGIN:
+            case CLAP_EVENT_PARAM_GESTURE_END:
+                f(std::type_identity<clap_event_param_gesture_t>{});
+                return true;
+            case CLAP_EVENT_TRANSPORT:
+                f(std::type_identity<clap_event_transport_t>{});
+                return true;
+            case CLAP_EVENT_MIDI:
+                f(std::type_identity<clap_event_midi_t>{});
+                return true;
+            case CLAP_EVENT_MIDI2:
+                f(std::type_identity<clap_event_midi2_t>{});
+                return true;
+            default:
+                return false;
+        }
+    }
+
     template <typename S>
     void serialize(S& s) {
-        s.container(events_, 1 << 16);
+        s.ext(*this, PackedEventList{});
     }
 
+    /**
+     * (De)serializes this list. Events are written as a type tag followed by
+     * the event's fields, and SysEx events are followed by their data.
+     */
+    class PackedEventList {
+       public:
+        template <typename Ser, typename Fnc>
+        void serialize(Ser& ser, const EventList& list, Fnc&&) const {
+            bitsery::details::writeSize(ser.adapter(), list.events_.size());
+            for (size_t i = 0; i < list.events_.size(); i++) {
+                const clap_event_header_t& header = *list.get(i);
+                ser.value2b(header.type);
+                if (header.type == CLAP_EVENT_MIDI_SYSEX) {
+                    const auto& event =
+                        reinterpret_cast<const clap_event_midi_sysex_t&>(
+                            header);
+                    ser.object(event.header);
+                    ser.value2b(event.port_index);
+                    ser.value4b(event.size);
+                    ser.adapter().template writeBuffer<1>(event.buffer,
+                                                          event.size);
+                } else {
+                    visit_event_type(
+                        header.type, [&]<typename T>(std::type_identity<T>) {
+                            ser.object(reinterpret_cast<const T&>(header));
+                        });
+                }
+            }
+        }
+
+        template <typename Des, typename Fnc>
+        void deserialize(Des& des, EventList& list, Fnc&&) const {
+            list.clear();
+
+            size_t num_events{};
+            bitsery::details::readSize(
+                des.adapter(), num_events, max_events,
+                std::integral_constant<bool,
+                                       Des::TConfig::CheckDataErrors>{});
+            for (size_t i = 0; i < num_events; i++) {
+                uint16_t type{};
+                des.value2b(type);
+                if (type == CLAP_EVENT_MIDI_SYSEX) {
+                    clap_event_header_t header{};
+                    uint16_t port_index{};
+                    uint32_t size{};
+                    des.object(header);
+                    des.value2b(port_index);
+                    des.value4b(size);
+                    if (size > max_sysex_size) {
+                        des.adapter().error(bitsery::ReaderError::InvalidData);
+                        return;
+                    }
+
+                    auto& event = list.allocate_sysex(nullptr, size);
+                    event.header = header;
+                    event.port_index = port_index;
+                    des.adapter().template readBuffer<1>(
+                        list.sysex_data_.data() +
+                            list.events_.back().sysex_offset,
+                        size);
+                } else if (!visit_event_type(
+                               type, [&]<typename T>(std::type_identity<T>) {
+                                   des.object(list.allocate<T>());
+                               })) {
+                    des.adapter().error(bitsery::ReaderError::InvalidData);
+                    return;
+                }
+            }
+        }
+
+       private:
+        static constexpr size_t max_events = 1 << 16;
+        static constexpr uint32_t max_sysex_size = 1 << 16;
+    };
+
    private:
-    llvm::SmallVector<Event, 64> events_;
+    /**
+     * Where an event is stored.
+     */
+    struct EventLocation {
+        /**
+         * The event's offset in `arena_`, in bytes.
+         */
+        uint32_t offset;
+        /**
+         * For SysEx events, the offset of the event's data in `sysex_data_`.
+         */
+        uint32_t sysex_offset;
+    };
+
+    /**
+     * Reserve space for a new event of type `T` at the end of the arena, and
+     * return a reference to it. This reference is invalidated when the next
+     * event is allocated.
+     */
+    template <typename T>
+    T& allocate(uint32_t sysex_offset = 0) {
+        static_assert(alignof(T) <= alignof(uint64_t));
+
+        const size_t offset = arena_.size() * sizeof(uint64_t);
+        arena_.resize(arena_.size() +
+                      (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        events_.push_back(
+            EventLocation{.offset = static_cast<uint32_t>(offset),
+                          .sysex_offset = sysex_offset});
+
+        return *reinterpret_cast<T*>(
+            reinterpret_cast<uint8_t*>(arena_.data()) + offset);
+    }
+
+    /**
+     * Allocate a SysEx event, copying `size` bytes of data from `buffer` to
+     * `sysex_data_` if it's not a null pointer. The event's buffer pointer
+     * stays null until the event is retrieved.
+     */
+    clap_event_midi_sysex_t& allocate_sysex(const uint8_t* buffer,
+                                            uint32_t size);
+
+    /**
+     * The offsets of all events in `arena_`, in order.
+     */
+    llvm::SmallVector<EventLocation, 64> events_;
+    /**
+     * The events themselves, stored back to back. This uses 64-bit integers
+     * so every event is suitably aligned. SysEx events get their buffer
+     * pointer set in `get()`, hence why this is mutable.
+     */
+    mutable llvm::SmallVector<uint64_t, 512> arena_;
+    /**
+     * The data for all SysEx events.
+     */
+    llvm::SmallVector<uint8_t, 256> sysex_data_;
 
     // These are populated in the `input_events()` and `output_events()` methods
     clap_input_events_t input_events_vtable_{};
@@ -298,6 +302,21 @@ class EventList {
 }  // namespace events
 }  // namespace clap
 
+namespace bitsery {
+namespace traits {
+
+template <>
+struct ExtensionTraits<clap::events::EventList::PackedEventList,
+                       clap::events::EventList> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+
+}  // namespace traits
+}  // namespace bitsery
+
 template <typename S>
 void serialize(S& s, clap_event_header_t& event_header) {
     // Feels a bit weird serializing this, but assuming the host/plugin set it
@@ -395,8 +414,8 @@ void serialize(S& s, clap_event_midi_t& event) {
 }
 
 // `clap_event_midi_sysex_t` can't be serialized without special handling, so
-// we'll serialize it directly inside of `clap::events::payload::MidiSysex` to
-// reduce the risk of this causing problems in the future
+// it's serialized directly inside of `clap::events::EventList` together with
+// its data
 
 template <typename S>
 void serialize(S& s, clap_event_midi2_t& event) {
@@ -113,24 +113,6 @@ struct Get {
 
 }  // namespace plugin
 
-namespace host {
-
-/**
- * Message struct for `clap_host_note_name::changed()`.
- */
-struct Changed {
-    using Response = Ack;
-
-    native_size_t owner_instance_id;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.value8b(owner_instance_id);
-    }
-};
-
-}  // namespace host
-
 }  // namespace note_name
 }  // namespace ext
 }  // namespace clap
@@ -73,24 +73,6 @@ struct Load {
 
 }  // namespace plugin
 
-namespace host {
-
-/**
- * Message struct for `clap_host_state::mark_dirty()`.
- */
-struct MarkDirty {
-    using Response = Ack;
-
-    native_size_t owner_instance_id;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.value8b(owner_instance_id);
-    }
-};
-
-}  // namespace host
-
 }  // namespace state
 }  // namespace ext
 }  // namespace clap
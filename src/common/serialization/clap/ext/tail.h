@@ -44,24 +44,6 @@ struct Get {
 
 }  // namespace plugin
 
-namespace host {
-
-/**
- * Message struct for `clap_host_tail::changed()`.
- */
-struct Changed {
-    using Response = Ack;
-
-    native_size_t owner_instance_id;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.value8b(owner_instance_id);
-    }
-};
-
-}  // namespace host
-
 }  // namespace tail
 }  // namespace ext
 }  // namespace clap
@@ -57,24 +57,6 @@ struct Get {
 
 }  // namespace plugin
 
-namespace host {
-
-/**
- * Message struct for `clap_host_voice_info::changed()`.
- */
-struct Changed {
-    using Response = Ack;
-
-    native_size_t owner_instance_id;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.value8b(owner_instance_id);
-    }
-};
-
-}  // namespace host
-
 }  // namespace voice_info
 }  // namespace ext
 }  // namespace clap
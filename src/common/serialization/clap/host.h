@@ -116,30 +116,61 @@ struct SupportedHostExtensions {
 };
 
 /**
- * Message struct for `clap_host::request_restart()`.
+ * Bit flags for the host callbacks that are bridged through `Notify`. These
+ * callbacks don't return anything and calling them multiple times in a row has
+ * the same effect as calling them once.
  */
-struct RequestRestart {
-    using Response = Ack;
-
-    native_size_t owner_instance_id;
-
-    template <typename S>
-    void serialize(S& s) {
-        s.value8b(owner_instance_id);
-    }
+enum NotifyFlags : uint32_t {
+    /**
+     * `clap_host::request_restart()`.
+     */
+    notify_request_restart = 1 << 0,
+    /**
+     * `clap_host::request_process()`.
+     */
+    notify_request_process = 1 << 1,
+    /**
+     * `clap_host_latency::changed()`.
+     */
+    notify_latency_changed = 1 << 2,
+    /**
+     * `clap_host_note_name::changed()`.
+     */
+    notify_note_name_changed = 1 << 3,
+    /**
+     * `clap_host_state::mark_dirty()`.
+     */
+    notify_state_mark_dirty = 1 << 4,
+    /**
+     * `clap_host_voice_info::changed()`.
+     */
+    notify_voice_info_changed = 1 << 5,
 };
 
 /**
- * Message struct for `clap_host::request_process()`.
+ * Message struct for one or more of the host callbacks listed in
+ * `NotifyFlags`. The Wine plugin host coalesces these per plugin instance, so
+ * a plugin calling `clap_host_state::mark_dirty()` a thousand times in a row
+ * results in a single message. The native plugin acknowledges this message
+ * immediately and then calls the host's callbacks on the host's main thread
+ * without waiting for them to finish.
+ *
+ * `clap_host_tail::changed()` is sent back as part of the `Process` response
+ * instead since it has to be called from the audio thread.
  */
-struct RequestProcess {
+struct Notify {
     using Response = Ack;
 
     native_size_t owner_instance_id;
+    /**
+     * A bitmask of `NotifyFlags`.
+     */
+    uint32_t notifications;
 
     template <typename S>
     void serialize(S& s) {
         s.value8b(owner_instance_id);
+        s.value4b(notifications);
     }
 };
 
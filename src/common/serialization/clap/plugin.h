@@ -302,11 +302,24 @@ struct Reset {
 struct ProcessResponse {
     clap_process_status result;
     clap::process::Process::Response output_data;
+    /**
+     * How long the plugin spent processing audio. See `ProcessTiming`.
+     */
+    ProcessTiming timing;
+    /**
+     * Whether the plugin called `clap_host_tail::changed()` since the last
+     * processing cycle. That callback may only be made from the audio thread,
+     * so instead of sending it over a separate socket we'll call it on the
+     * host's audio thread after `clap_plugin::process()` returns.
+     */
+    bool tail_changed;
 
     template <typename S>
     void serialize(S& s) {
         s.value4b(result);
         s.object(output_data);
+        s.object(timing);
+        s.value1b(tail_changed);
     }
 };
 
@@ -337,12 +350,20 @@ struct Process {
      */
     std::optional<int> new_realtime_priority;
 
+    /**
+     * The CPU affinity of the host's audio thread, sent along with
+     * `new_realtime_priority`. See `get_cpu_affinity_mask()`.
+     */
+    std::optional<uint64_t> new_cpu_affinity_mask;
+
     template <typename S>
     void serialize(S& s) {
         s.value8b(instance_id);
         s.object(process);
         s.ext(new_realtime_priority, bitsery::ext::InPlaceOptional{},
               [](S& s, int& priority) { s.value4b(priority); });
+        s.ext(new_cpu_affinity_mask, bitsery::ext::InPlaceOptional{},
+              [](S& s, uint64_t& mask) { s.value8b(mask); });
     }
 };
 
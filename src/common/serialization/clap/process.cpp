@@ -21,8 +21,10 @@ namespace process {
 
 Process::Process() noexcept {}
 
-void Process::repopulate(const clap_process_t& process,
-                         AudioShmBuffer& shared_audio_buffers) {
+void Process::repopulate(
+    const clap_process_t& process,
+    AudioShmBuffer& shared_audio_buffers,
+    TransportDeltaState<clap_event_transport_t>& transport_state) {
     assert(process.in_events && process.out_events);
     if (process.audio_inputs_count > 0) {
         assert(process.audio_inputs);
@@ -38,11 +40,10 @@ void Process::repopulate(const clap_process_t& process,
     steady_time_ = process.steady_time;
     frames_count_ = process.frames_count;
 
-    if (process.transport) {
-        transport_.emplace(*process.transport);
-    } else {
-        transport_.reset();
-    }
+    // Only the fields that changed since the last processing cycle will be
+    // sent over. The Wine plugin host will reconstruct the rest.
+    transport_state.encode(transport_, process.transport,
+                           process.frames_count);
 
     // The actual audio is stored in an accompanying `AudioShmBuffer` object, so
     // these inputs and outputs objects are only used to serialize metadata
@@ -128,10 +129,20 @@ void Process::repopulate(const clap_process_t& process,
 
 const clap_process_t& Process::reconstruct(
     std::vector<std::vector<void*>>& input_pointers,
-    std::vector<std::vector<void*>>& output_pointers) {
+    std::vector<std::vector<void*>>& output_pointers,
+    TransportDeltaState<clap_event_transport_t>& transport_state) {
     reconstructed_process_data_.steady_time = steady_time_;
     reconstructed_process_data_.frames_count = frames_count_;
-    reconstructed_process_data_.transport = transport_ ? &*transport_ : nullptr;
+
+    // The plugin gets a copy of the decoded transport information so the delta
+    // decoding state can never be affected by the plugin
+    if (const clap_event_transport_t* transport =
+            transport_state.decode(transport_, frames_count_)) {
+        reconstructed_transport_ = *transport;
+        reconstructed_process_data_.transport = &reconstructed_transport_;
+    } else {
+        reconstructed_process_data_.transport = nullptr;
+    }
 
     // The actual audio data is contained within a shared memory object, and the
     // input and output pointers point to regions in that object. These pointers
@@ -22,12 +22,44 @@
 #include <llvm/small-vector.h>
 
 #include "../../audio-shm.h"
-#include "../../bitsery/ext/in-place-optional.h"
+#include "../bitsery/traits/small-vector.h"
+#include "../transport-delta.h"
 #include "audio-buffer.h"
 #include "events.h"
 
 // Serialization messages for `clap/process.h`
 
+/**
+ * The fields in `clap_event_transport_t`, used for delta encoding the transport
+ * information sent along with `clap::process::Process`.
+ */
+template <>
+struct TransportFields<clap_event_transport_t> {
+    static constexpr std::tuple fields{
+        &clap_event_transport_t::header,
+        &clap_event_transport_t::flags,
+        &clap_event_transport_t::song_pos_beats,
+        &clap_event_transport_t::song_pos_seconds,
+        &clap_event_transport_t::tempo,
+        &clap_event_transport_t::tempo_inc,
+        &clap_event_transport_t::loop_start_beats,
+        &clap_event_transport_t::loop_end_beats,
+        &clap_event_transport_t::loop_start_seconds,
+        &clap_event_transport_t::loop_end_seconds,
+        &clap_event_transport_t::bar_start,
+        &clap_event_transport_t::bar_number,
+        &clap_event_transport_t::tsig_num,
+        &clap_event_transport_t::tsig_denom};
+
+    static void predict(clap_event_transport_t& /*transport*/,
+                        int64_t /*num_samples*/) {
+        // CLAP doesn't have a song position in samples, and the fixed point
+        // beat and seconds positions depend on the tempo and sample rate, so we
+        // can't predict those exactly. During steady playback those two fields
+        // will thus always be sent.
+    }
+};
+
 namespace clap {
 namespace process {
 
@@ -73,9 +105,15 @@ class Process {
      * no direct link between this `Process` object and those buffers, but they
      * should be treated as a pair. This is a bit ugly, but optimizations sadly
      * never made code prettier.
+     *
+     * The transport information is delta encoded using `transport_state`, so
+     * only the fields that changed since the last call are sent. This object
+     * should be unique to the plugin instance.
      */
     void repopulate(const clap_process_t& process,
-                    AudioShmBuffer& shared_audio_buffers);
+                    AudioShmBuffer& shared_audio_buffers,
+                    TransportDeltaState<clap_event_transport_t>&
+                        transport_state);
 
     /**
      * Reconstruct the original `clap_process_t` object passed to `repopulate()`
@@ -94,10 +132,15 @@ class Process {
      * into it. The audio buffers thus always contain enough space for double
      * precision if a port supports it. The actual sample format used is stored
      * in our `clap::audio_buffer::AudioBuffer` serialization wrapper.
+     *
+     * The transport information is reconstructed from the changed fields using
+     * `transport_state`. Like the audio buffer pointers, this object belongs to
+     * the plugin instance and not to this object.
      */
     const clap_process_t& reconstruct(
         std::vector<std::vector<void*>>& input_pointers,
-        std::vector<std::vector<void*>>& output_pointers);
+        std::vector<std::vector<void*>>& output_pointers,
+        TransportDeltaState<clap_event_transport_t>& transport_state);
 
     /**
      * A serializable wrapper around the output fields of `clap_process_t`, so
@@ -160,7 +203,7 @@ class Process {
         s.value8b(steady_time_);
         s.value4b(frames_count_);
 
-        s.ext(transport_, bitsery::ext::InPlaceOptional{});
+        s.object(transport_);
 
         // Both `audio_inputs_` and `audio_outputs_` only store metadata. The
         // actual audio is sent using an accompanying `AudioShmBuffer` object.
@@ -181,8 +224,9 @@ class Process {
     int64_t steady_time_ = 0;
     uint32_t frames_count_ = 0;
 
-    // This is an optional field
-    std::optional<clap_event_transport_t> transport_;
+    // This is an optional field. It's delta encoded against the transport
+    // information sent during the previous processing cycle.
+    TransportDelta<clap_event_transport_t> transport_;
 
     /**
      * The audio input buffers for every port. We'll only serialize the metadata
@@ -236,6 +280,13 @@ class Process {
      */
     Response response_object_;
 
+    /**
+     * The transport information decoded from `transport_` during
+     * `reconstruct()`. `reconstructed_process_data_` points to this if the
+     * host provided transport information.
+     */
+    clap_event_transport_t reconstructed_transport_{};
+
     /**
      * The process data we reconstruct from the other fields during
      * `reconstruct()`.
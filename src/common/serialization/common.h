@@ -44,6 +44,33 @@ struct Ack {
     void serialize(S&) {}
 };
 
+/**
+ * How long the Windows plugin spent inside of its audio processing function
+ * during a single processing cycle. This is measured on the Wine side and sent
+ * back along with the process response, so the native side can tell how much
+ * of a processing cycle is spent in the plugin itself and how much is bridging
+ * overhead.
+ */
+struct ProcessTiming {
+    /**
+     * The CPU time used by the audio thread, in nanoseconds. This excludes any
+     * time spent waiting, and it also doesn't include work the plugin offloads
+     * to other threads.
+     */
+    uint64_t cpu_time_ns = 0;
+    /**
+     * The wall clock time spent in the plugin's process function, in
+     * nanoseconds.
+     */
+    uint64_t wall_time_ns = 0;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value8b(cpu_time_ns);
+        s.value8b(wall_time_ns);
+    }
+};
+
 /**
  * A simple wrapper around primitive values for serialization purposes. Bitsery
  * doesn't seem to like serializing plain primitives using `s.object()` even if
@@ -93,6 +120,12 @@ struct HostRequest {
     std::string plugin_path;
     std::string endpoint_base_dir;
     pid_t parent_pid;
+    /**
+     * Whether a group host process should keep the plugin's module loaded after
+     * the plugin exits. Set when the `share_plugin_image` option is enabled.
+     * Individually hosted plugins ignore this.
+     */
+    bool pin_module = false;
 
     template <typename S>
     void serialize(S& s) {
@@ -100,6 +133,7 @@ struct HostRequest {
         s.text1b(plugin_path, 4096);
         s.text1b(endpoint_base_dir, 4096);
         s.value4b(parent_pid);
+        s.value1b(pin_module);
     }
 };
 
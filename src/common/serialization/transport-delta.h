@@ -0,0 +1,287 @@
+// yabridge: a Wine plugin bridge
+// Copyright (C) 2020-2024 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+
+// Every audio processing request carries the host's transport information
+// (`ProcessContext` for VST3 and `clap_event_transport_t` for CLAP). During
+// steady playback almost none of those fields change between processing
+// cycles, and the ones that do, like the song position in samples, change in a
+// predictable way. So instead of sending the entire struct every cycle, both
+// sides keep track of the last transport information that went over the wire
+// and we only send the fields that differ from what the receiving side would
+// predict.
+//
+// VST2's `Vst2ProcessRequest` is sent as is using the fixed layout wire format,
+// so delta encoding its `VstTimeInfo` would not make the message any smaller.
+// That's why it always contains the full struct instead.
+
+/**
+ * Describes the layout of a transport information struct `T` so it can be
+ * delta encoded using `TransportDelta<T>`. This needs to be specialized for
+ * every struct we want to delta encode. Specializations should contain:
+ *
+ * - `static constexpr std::tuple fields`, a tuple of pointers to all of `T`'s
+ *   data members. These are identified by their index in the tuple, so there
+ *   can be at most 32 of them.
+ * - `static void predict(T& info, int64_t num_samples)`, a function that
+ *   advances the transport information from the last processing cycle by
+ *   `num_samples` samples. If the prediction is correct, then the fields it
+ *   touches don't need to be sent. This is purely an optimization, so a
+ *   specialization can also leave `info` untouched.
+ */
+template <typename T>
+struct TransportFields;
+
+/**
+ * Call `f(index, field)` for every field in a transport information struct of
+ * type `T`, as described by `TransportFields<T>`. Here `field` is a pointer to
+ * a data member of `T`.
+ */
+template <typename T, typename F>
+constexpr void for_each_transport_field(F&& f) {
+    std::apply(
+        [&](auto... fields) {
+            uint32_t index = 0;
+            (f(index++, fields), ...);
+        },
+        TransportFields<T>::fields);
+}
+
+/**
+ * A bitmask with a bit set for every field in `T`.
+ */
+template <typename T>
+constexpr uint32_t all_transport_fields() noexcept {
+    constexpr size_t num_fields =
+        std::tuple_size_v<decltype(TransportFields<T>::fields)>;
+    static_assert(num_fields <= 32,
+                  "Delta encoded transport structs can have at most 32 fields");
+
+    return static_cast<uint32_t>((uint64_t(1) << num_fields) - 1);
+}
+
+/**
+ * The bit corresponding to `member` in the bitmasks used by
+ * `TransportDelta<T>`, or 0 if `member` is not listed in
+ * `TransportFields<T>::fields`.
+ */
+template <typename T, typename M>
+constexpr uint32_t transport_field_bit(M T::*member) noexcept {
+    uint32_t bit = 0;
+    for_each_transport_field<T>([&](uint32_t index, auto field) {
+        if constexpr (std::is_same_v<decltype(field), M T::*>) {
+            if (field == member) {
+                bit = uint32_t(1) << index;
+            }
+        }
+    });
+
+    return bit;
+}
+
+/**
+ * The serialized delta encoded representation of an (optional) transport
+ * information struct. This is what gets sent along with the audio processing
+ * request instead of an `std::optional<T>`. Only the fields with their bit set
+ * in `changed_fields` are serialized. This object should be populated using
+ * `TransportDeltaState<T>::encode()` on the sending side, and it can be turned
+ * back into a full `T` using `TransportDeltaState<T>::decode()` on the
+ * receiving side.
+ *
+ * @tparam T The transport information struct. `TransportFields<T>` needs to be
+ *   specialized for this type.
+ */
+template <typename T>
+struct TransportDelta {
+    /**
+     * Whether the host provided any transport information during this cycle.
+     * This is the equivalent of the `std::optional<T>` we used to send.
+     */
+    bool has_value = false;
+
+    /**
+     * A bitmask of the fields in `value` that were changed compared to the
+     * prediction made from the last transport information that was sent. The
+     * bit indices correspond to the indices in `TransportFields<T>::fields`.
+     */
+    uint32_t changed_fields = 0;
+
+    /**
+     * The transport information. Only the fields with a bit set in
+     * `changed_fields` are meaningful, the other fields may contain stale
+     * values on the receiving side.
+     */
+    T value{};
+
+    template <typename S>
+    void serialize(S& s) {
+        s.boolValue(has_value);
+        if (!has_value) {
+            return;
+        }
+
+        s.value4b(changed_fields);
+        for_each_transport_field<T>([&](uint32_t index, auto field) {
+            if (!(changed_fields & (uint32_t(1) << index))) {
+                return;
+            }
+
+            using F = std::remove_reference_t<decltype(value.*field)>;
+            if constexpr (std::is_array_v<F>) {
+                s.container1b(value.*field);
+            } else if constexpr (std::is_arithmetic_v<F> ||
+                                 std::is_enum_v<F>) {
+                s.template value<sizeof(F)>(value.*field);
+            } else {
+                s.object(value.*field);
+            }
+        });
+    }
+};
+
+/**
+ * The state needed on either side of the connection to delta encode and decode
+ * transport information. The sending side uses `encode()` to populate a
+ * `TransportDelta<T>`, and the receiving side uses `decode()` to reconstruct
+ * the original object. Both sides need to see the same sequence of messages for
+ * this to work, so there should be a single object of this type per plugin
+ * instance on each side, and it should not be part of any thread local request
+ * objects.
+ *
+ * Whenever the host stops providing transport information, both sides will
+ * reset their state, and the next message will contain all fields.
+ *
+ * @note This class provides no thread safety guarantees. Hosts won't call a
+ *   plugin instance's process function from multiple threads at once, so this
+ *   is not an issue.
+ */
+template <typename T>
+class TransportDeltaState {
+   public:
+    /**
+     * Encode `current` into `delta`, sending only the fields that differ from
+     * what the receiving side will predict. This updates our state to match the
+     * receiving side's state after it has decoded `delta`.
+     *
+     * Fields that are not part of `field_mask` are never sent. The receiving
+     * side will keep whatever value it had for those fields, which is zero
+     * unless the mask changed at some point. Our own state mirrors that, so
+     * changing the mask between calls is fine.
+     *
+     * @param delta The delta encoded object that will be sent to the other
+     *   side.
+     * @param current The transport information provided by the host, or a null
+     *   pointer if the host didn't provide any.
+     * @param num_samples The number of samples in the current processing cycle.
+     *   The next cycle's prediction is based on this.
+     * @param field_mask A bitmask of the fields the receiving side cares about,
+     *   using the same bit indices as `TransportDelta<T>::changed_fields`.
+     */
+    void encode(TransportDelta<T>& delta,
+                const T* current,
+                int64_t num_samples,
+                uint32_t field_mask = all_transport_fields<T>()) {
+        if (!current) {
+            delta.has_value = false;
+            last_.reset();
+
+            return;
+        }
+
+        // This mirrors `decode()` below
+        const bool send_all_fields = !last_;
+        if (last_) {
+            TransportFields<T>::predict(*last_, last_num_samples_);
+        } else {
+            last_.emplace();
+        }
+
+        delta.has_value = true;
+        delta.value = *current;
+        delta.changed_fields = 0;
+        for_each_transport_field<T>([&](uint32_t index, auto field) {
+            const uint32_t bit = uint32_t(1) << index;
+            if (!(field_mask & bit)) {
+                std::memcpy(&(delta.value.*field), &((*last_).*field),
+                            sizeof((*last_).*field));
+            } else if (send_all_fields ||
+                       std::memcmp(&((*last_).*field), &(current->*field),
+                                   sizeof((*last_).*field)) != 0) {
+                delta.changed_fields |= bit;
+            }
+        });
+
+        last_ = delta.value;
+        last_num_samples_ = num_samples;
+    }
+
+    /**
+     * Reconstruct the transport information from a `TransportDelta<T>` created
+     * by `encode()` on the other side.
+     *
+     * @param delta The delta encoded object received from the other side.
+     * @param num_samples The number of samples in the current processing cycle.
+     *
+     * @return A pointer to the reconstructed transport information, or a null
+     *   pointer if the host did not provide any. This pointer stays valid until
+     *   the next call to `decode()`.
+     */
+    const T* decode(const TransportDelta<T>& delta, int64_t num_samples) {
+        if (!delta.has_value) {
+            last_.reset();
+
+            return nullptr;
+        }
+
+        if (last_) {
+            TransportFields<T>::predict(*last_, last_num_samples_);
+        } else {
+            // The sending side will have sent every field in this case
+            last_.emplace();
+        }
+
+        for_each_transport_field<T>([&](uint32_t index, auto field) {
+            if (delta.changed_fields & (uint32_t(1) << index)) {
+                std::memcpy(&((*last_).*field), &(delta.value.*field),
+                            sizeof((*last_).*field));
+            }
+        });
+
+        last_num_samples_ = num_samples;
+
+        return &*last_;
+    }
+
+   private:
+    /**
+     * The last transport information that was sent or received, or a nullopt
+     * if the host did not provide any during the last processing cycle.
+     */
+    std::optional<T> last_;
+
+    /**
+     * The number of samples processed during the last processing cycle. Used
+     * together with `TransportFields<T>::predict()`.
+     */
+    int64_t last_num_samples_ = 0;
+};
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <variant>
 
 #include <bitsery/traits/array.h>
@@ -528,65 +529,118 @@ struct Parameter {
     }
 };
 
+/**
+ * The response sent back to the native plugin once the Wine plugin host has
+ * finished processing audio. The output audio will have been written to the
+ * shared memory audio buffers at this point, so this acts as an acknowledgement
+ * that also contains the time the plugin spent processing audio.
+ */
+struct alignas(8) Vst2ProcessResponse {
+    static constexpr uint32_t wire_tag = 0x52503256;  // "V2PR"
+    static constexpr uint32_t wire_version = 2;
+
+    ProcessTiming timing;
+};
+
+static_assert(sizeof(Vst2ProcessResponse) == 16,
+              "Vst2ProcessResponse needs to have the same layout on every "
+              "architecture");
+
 /**
  * When the host calls `processReplacing()`, `processDoubleReplacing()`, or the
  * deprecated `process()` function on our VST2 plugin, we'll write the input
  * buffers to an `AudioShmBuffer` object that's shared between the native plugin
  * an the Wine plugin host, and we'll then send this object to the Wine plugin
  * host with the rest of the .
+ *
+ * This is sent every processing cycle, so it uses the fixed layout wire format
+ * instead of bitsery. See `FixedLayoutMessage` for more information. The fields
+ * are ordered so that they're naturally aligned regardless of whether `double`s
+ * are four or eight byte aligned, and the struct itself is eight byte aligned
+ * so the 32-bit and 64-bit versions have the same size.
  */
-struct Vst2ProcessRequest {
-    using Response = Ack;
+struct alignas(8) Vst2ProcessRequest {
+    using Response = Vst2ProcessResponse;
+
+    static constexpr uint32_t wire_tag = 0x51503256;  // "V2PQ"
+    static constexpr uint32_t wire_version = 4;
 
     /**
-     * The number of samples per channel. We'll trust the host to never provide
-     * more samples than the maximum it indicated during `effSetBlockSize`.
+     * We'll prefetch the current transport information as part of handling an
+     * audio processing call. This lets us a void an unnecessary callback (or in
+     * some cases, more than one) during every processing cycle. Only valid if
+     * `has_current_time_info` is set.
      */
-    int sample_frames;
+    VstTimeInfo current_time_info;
 
     /**
-     * Whether the host calling `processDoubleReplacing()` or
-     * `processReplacing()`. On Linux only REAPER seems to use double precision
-     * audio.
+     * The CPU affinity of the host's audio thread as returned by
+     * `get_cpu_affinity_mask()`, sent together with `new_realtime_priority`.
+     * The Wine plugin host will copy this when `audio_thread_cpus` is set to
+     * `"host"`. This is zero when it should not be updated, since an empty
+     * affinity mask is never valid.
      */
-    bool double_precision;
+    uint64_t new_cpu_affinity_mask;
 
     /**
-     * We'll prefetch the current transport information as part of handling an
-     * audio processing call. This lets us a void an unnecessary callback (or in
-     * some cases, more than one) during every processing cycle.
+     * The number of samples per channel. We'll trust the host to never provide
+     * more samples than the maximum it indicated during `effSetBlockSize`.
      */
-    std::optional<VstTimeInfo> current_time_info;
+    int32_t sample_frames;
 
     /**
      * Some plugins will also ask for the current process level during audio
      * processing. To prevent unnecessary expensive callbacks there, we'll
      * prefetch this information as well.
      */
-    int current_process_level;
+    int32_t current_process_level;
 
     /**
      * We'll periodically synchronize the realtime priority setting of the
      * host's audio thread with the Wine plugin host. We'll do this
      * approximately every ten seconds, as doing this getting and setting
      * scheduler information has a non trivial amount of overhead (even if it's
-     * only a single microsoecond).
+     * only a single microsoecond). Only valid if `has_new_realtime_priority`
+     * is set. We can't use an `std::optional` here since its layout is up to
+     * the standard library.
      */
-    std::optional<int> new_realtime_priority;
+    int32_t new_realtime_priority;
 
-    template <typename S>
-    void serialize(S& s) {
-        s.value4b(sample_frames);
-        s.value1b(double_precision);
+    /**
+     * Whether the host returned any transport information. If this is not set,
+     * then `current_time_info` should be ignored.
+     */
+    bool has_current_time_info;
 
-        s.ext(current_time_info, bitsery::ext::InPlaceOptional{});
-        s.value4b(current_process_level);
+    /**
+     * Whether the Wine plugin host should update its audio thread's realtime
+     * priority to `new_realtime_priority`.
+     */
+    bool has_new_realtime_priority;
 
-        s.ext(new_realtime_priority, bitsery::ext::InPlaceOptional{},
-              [](S& s, int& priority) { s.value4b(priority); });
-    }
+    /**
+     * Whether the host calling `processDoubleReplacing()` or
+     * `processReplacing()`. On Linux only REAPER seems to use double precision
+     * audio.
+     */
+    bool double_precision;
 };
 
+static_assert(offsetof(Vst2ProcessRequest, current_time_info) == 0 &&
+                  offsetof(Vst2ProcessRequest, new_cpu_affinity_mask) == 88 &&
+                  offsetof(Vst2ProcessRequest, sample_frames) == 96 &&
+                  offsetof(Vst2ProcessRequest, current_process_level) == 100 &&
+                  offsetof(Vst2ProcessRequest, new_realtime_priority) == 104 &&
+                  offsetof(Vst2ProcessRequest, has_current_time_info) == 108 &&
+                  offsetof(Vst2ProcessRequest, has_new_realtime_priority) ==
+                      109 &&
+                  offsetof(Vst2ProcessRequest, double_precision) == 110,
+              "Vst2ProcessRequest needs to have the same layout on every "
+              "architecture");
+static_assert(sizeof(Vst2ProcessRequest) == 112,
+              "Vst2ProcessRequest needs to have the same layout on every "
+              "architecture");
+
 /**
  * The serialization function for `AEffect` structs. This will s serialize all
  * of the values but it will not touch any of the pointer fields. That way you
@@ -94,8 +94,8 @@ using Vst3ControlRequest =
                  YaKeyswitchController::GetKeyswitchInfo,
                  YaMidiLearn::OnLiveMIDIControllerInput,
                  YaMidiMapping::GetMidiControllerAssignment,
-                 YaNoteExpressionController::GetNoteExpressionCount,
-                 YaNoteExpressionController::GetNoteExpressionInfo,
+                 YaMidiMapping::GetMidiControllerAssignments,
+                 YaNoteExpressionController::GetNoteExpressionInfos,
                  YaNoteExpressionController::GetNoteExpressionStringByValue,
                  YaNoteExpressionController::GetNoteExpressionValueByString,
                  YaNoteExpressionPhysicalUIMapping::GetNotePhysicalUIMapping,
@@ -123,10 +123,9 @@ using Vst3ControlRequest =
                  YaUnitData::UnitDataSupported,
                  YaUnitData::GetUnitData,
                  YaUnitData::SetUnitData,
-                 YaUnitInfo::GetUnitCount,
-                 YaUnitInfo::GetUnitInfo,
-                 YaUnitInfo::GetProgramListCount,
-                 YaUnitInfo::GetProgramListInfo,
+                 YaUnitInfo::GetUnitInfos,
+                 YaUnitInfo::GetProgramListInfos,
+                 YaUnitInfo::GetProgramNames,
                  YaUnitInfo::GetProgramName,
                  YaUnitInfo::GetProgramInfo,
                  YaUnitInfo::HasProgramPitchNames,
@@ -37,7 +37,8 @@ void YaParamValueQueue::repopulate(
     for (int i = 0; i < original_queue.getPointCount(); i++) {
         // We're skipping the assertions here and just assume that the function
         // returns `kResultOk`
-        original_queue.getPoint(i, queue_[i].first, queue_[i].second);
+        original_queue.getPoint(i, queue_[i].sample_offset,
+                                queue_[i].value);
     }
 }
 
@@ -73,8 +74,8 @@ tresult PLUGIN_API YaParamValueQueue::getPoint(
     Steinberg::Vst::ParamValue& value /*out*/) {
     // Indices are signed integers, fun
     if (index >= 0 && index < static_cast<int32>(queue_.size())) {
-        sampleOffset = queue_[index].first;
-        value = queue_[index].second;
+        sampleOffset = queue_[index].sample_offset;
+        value = queue_[index].value;
 
         return Steinberg::kResultOk;
     } else {
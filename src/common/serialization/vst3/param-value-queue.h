@@ -19,6 +19,7 @@
 #include <llvm/small-vector.h>
 #include <pluginterfaces/vst/ivstparameterchanges.h>
 
+#include "../../bitsery/ext/packed-container.h"
 #include "../../bitsery/traits/small-vector.h"
 #include "base.h"
 
@@ -72,14 +73,22 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
                                 Steinberg::Vst::ParamValue value,
                                 int32& index /*out*/) override;
 
+    /**
+     * A single point in the queue. These are sent over the wire as is using
+     * `bitsery::ext::PackedContainer`, so `value` is explicitly eight byte
+     * aligned to give this struct the same layout on every architecture.
+     */
+    struct Point {
+        int32 sample_offset;
+        alignas(8) Steinberg::Vst::ParamValue value;
+    };
+
+    static_assert(sizeof(Point) == 16);
+
     template <typename S>
     void serialize(S& s) {
         s.value4b(parameter_id_);
-        // TODO: Does bitsery have a built in way to serialize pairs?
-        s.container(queue_, 1 << 16, [](S& s, std::pair<int32, double>& pair) {
-            s.value4b(pair.first);
-            s.value8b(pair.second);
-        });
+        s.ext(queue_, bitsery::ext::PackedContainer{1 << 16});
     }
 
     /**
@@ -94,9 +103,9 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
      * the plugin and the host will insert the values in chronological order
      * (because, why would they not?).
      *
-     * This contains pairs of `(sample_offset, value)`.
+     * This contains `(sample_offset, value)` points.
      */
-    llvm::SmallVector<std::pair<int32, Steinberg::Vst::ParamValue>, 16> queue_;
+    llvm::SmallVector<Point, 16> queue_;
 };
 
 #pragma GCC diagnostic pop
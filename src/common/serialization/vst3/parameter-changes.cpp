@@ -16,6 +16,18 @@
 
 #include "parameter-changes.h"
 
+/**
+ * Map a parameter ID to a slot in `YaParameterChanges::index_`. Parameter IDs
+ * are often either sequential or hashes themselves, so a simple multiplicative
+ * hash is enough to spread them out.
+ */
+static size_t hash_parameter_id(Steinberg::Vst::ParamID id) noexcept {
+    uint32_t hash = static_cast<uint32_t>(id) * 0x9e3779b9u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
 YaParameterChanges::YaParameterChanges() noexcept {FUNKNOWN_CTOR}
 
 YaParameterChanges::~YaParameterChanges() noexcept {
@@ -24,6 +36,7 @@ YaParameterChanges::~YaParameterChanges() noexcept {
 
 void YaParameterChanges::clear() noexcept {
     queues_.clear();
+    index_stale_ = true;
 }
 
 void YaParameterChanges::repopulate(
@@ -35,6 +48,8 @@ void YaParameterChanges::repopulate(
         queues_[i].repopulate(
             *original_queues.getParameterData(static_cast<int>(i)));
     }
+
+    index_stale_ = true;
 }
 
 #pragma GCC diagnostic push
@@ -77,6 +92,19 @@ YaParameterChanges::getParameterData(int32 index) {
 Steinberg::Vst::IParamValueQueue* PLUGIN_API
 YaParameterChanges::addParameterData(const Steinberg::Vst::ParamID& id,
                                      int32& index /*out*/) {
+    if (index_stale_) {
+        rebuild_index();
+    }
+
+    // Like in the SDK's implementation, we'll return the existing queue if the
+    // plugin already added one for this parameter. Otherwise plugins that call
+    // this function for every point would cause us to send and write back
+    // hundreds of single point queues every processing cycle.
+    if (const int32 existing_index = find_queue(id); existing_index != -1) {
+        index = existing_index;
+        return &queues_[existing_index];
+    }
+
     index = static_cast<int32>(queues_.size());
 
     // Tiny hack, resizing avoids calling the constructor the second time we
@@ -84,5 +112,53 @@ YaParameterChanges::addParameterData(const Steinberg::Vst::ParamID& id,
     queues_.resize(queues_.size() + 1);
     queues_[index].clear_for_parameter(id);
 
+    // The index is kept at most half full so probe sequences stay short
+    if (queues_.size() * 2 > index_.size()) {
+        rebuild_index();
+    } else {
+        insert_into_index(id, index);
+    }
+
     return &queues_[index];
 }
+
+void YaParameterChanges::rebuild_index() {
+    size_t index_size = 32;
+    while (index_size < queues_.size() * 2) {
+        index_size *= 2;
+    }
+
+    // This reuses the existing capacity
+    index_.assign(index_size, -1);
+    for (size_t i = 0; i < queues_.size(); i++) {
+        // If the host passed us duplicate queues, then the first one wins
+        if (find_queue(queues_[i].parameter_id_) == -1) {
+            insert_into_index(queues_[i].parameter_id_, static_cast<int32>(i));
+        }
+    }
+
+    index_stale_ = false;
+}
+
+int32 YaParameterChanges::find_queue(
+    Steinberg::Vst::ParamID id) const noexcept {
+    const size_t mask = index_.size() - 1;
+    for (size_t slot = hash_parameter_id(id) & mask;;
+         slot = (slot + 1) & mask) {
+        const int32 queue_index = index_[slot];
+        if (queue_index == -1 || queues_[queue_index].parameter_id_ == id) {
+            return queue_index;
+        }
+    }
+}
+
+void YaParameterChanges::insert_into_index(Steinberg::Vst::ParamID id,
+                                           int32 queue_index) noexcept {
+    const size_t mask = index_.size() - 1;
+    size_t slot = hash_parameter_id(id) & mask;
+    while (index_[slot] != -1) {
+        slot = (slot + 1) & mask;
+    }
+
+    index_[slot] = queue_index;
+}
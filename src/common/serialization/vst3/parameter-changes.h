@@ -79,13 +79,54 @@ class YaParameterChanges : public Steinberg::Vst::IParameterChanges {
     template <typename S>
     void serialize(S& s) {
         s.container(queues_, 1 << 16);
+
+        // When deserializing, the queues may have changed completely
+        index_stale_ = true;
     }
 
    private:
+    /**
+     * Rebuild `index_` from `queues_`. This resizes the index to the smallest
+     * power of two that can hold twice the number of queues, so this only
+     * allocates when we see more queues than ever before.
+     */
+    void rebuild_index();
+
+    /**
+     * Find the index in `queues_` of the queue for parameter `id` using
+     * `index_`, or -1 if there is no such queue yet. `index_` must not be
+     * stale.
+     */
+    int32 find_queue(Steinberg::Vst::ParamID id) const noexcept;
+
+    /**
+     * Insert a queue index into `index_`. The caller needs to make sure that
+     * the index is at most half full after inserting it.
+     */
+    void insert_into_index(Steinberg::Vst::ParamID id,
+                           int32 queue_index) noexcept;
+
     /**
      * The parameter value changes queues.
      */
     llvm::SmallVector<YaParamValueQueue, 16> queues_;
+
+    /**
+     * An open addressing hash table with linear probing that maps parameter
+     * IDs to indices in `queues_`, with empty slots set to -1. This lets
+     * `addParameterData()` return the existing queue for a parameter in
+     * constant time instead of adding duplicate queues, which some plugins
+     * would otherwise do for every single point they output. The size is
+     * always a power of two.
+     */
+    llvm::SmallVector<int32, 32> index_;
+
+    /**
+     * Set when `queues_` was replaced wholesale, i.e. after clearing,
+     * repopulating or deserializing. The index is then lazily rebuilt the next
+     * time `addParameterData()` is called.
+     */
+    bool index_stale_ = true;
 };
 
 #pragma GCC diagnostic pop
@@ -226,11 +226,16 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
     struct ProcessResponse {
         UniversalTResult result;
         YaProcessData::Response output_data;
+        /**
+         * How long the plugin spent processing audio. See `ProcessTiming`.
+         */
+        ProcessTiming timing;
 
         template <typename S>
         void serialize(S& s) {
             s.object(result);
             s.object(output_data);
+            s.object(timing);
         }
     };
 
@@ -261,6 +266,12 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
          */
         std::optional<int> new_realtime_priority;
 
+        /**
+         * The CPU affinity of the host's audio thread, sent along with
+         * `new_realtime_priority`. See `get_cpu_affinity_mask()`.
+         */
+        std::optional<uint64_t> new_cpu_affinity_mask;
+
         template <typename S>
         void serialize(S& s) {
             s.value8b(instance_id);
@@ -268,6 +279,8 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
 
             s.ext(new_realtime_priority, bitsery::ext::InPlaceOptional{},
                   [](S& s, int& priority) { s.value4b(priority); });
+            s.ext(new_cpu_affinity_mask, bitsery::ext::InPlaceOptional{},
+                  [](S& s, uint64_t& mask) { s.value8b(mask); });
         }
     };
 
@@ -261,12 +261,22 @@ class YaComponent : public Steinberg::Vst::IComponent {
     struct SetActiveResponse {
         UniversalTResult result;
         std::optional<AudioShmBuffer::Config> updated_audio_buffers_config;
+        /**
+         * The plugin's `IProcessContextRequirements` flags, queried after the
+         * plugin has been activated. This is a nullopt if the plugin does not
+         * implement that interface or if it was deactivated, in which case
+         * the entire process context will be sent.
+         */
+        std::optional<uint32> process_context_requirements;
 
         template <typename S>
         void serialize(S& s) {
             s.object(result);
             s.ext(updated_audio_buffers_config,
                   bitsery::ext::InPlaceOptional{});
+            s.ext(process_context_requirements,
+                  bitsery::ext::InPlaceOptional{},
+                  [](S& s, uint32& flags) { s.value4b(flags); });
         }
     };
 
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstmidicontrollers.h>
 
+#include "../../../bitsery/ext/in-place-optional.h"
 #include "../../common.h"
 #include "../base.h"
 
@@ -102,6 +104,61 @@ class YaMidiMapping : public Steinberg::Vst::IMidiMapping {
         }
     };
 
+    /**
+     * The number of MIDI channels we'll query controller assignments for in
+     * `GetMidiControllerAssignments`.
+     */
+    static constexpr int16 num_midi_channels = 16;
+
+    /**
+     * The parameter IDs assigned to all MIDI controllers on all MIDI channels
+     * of an event bus.
+     *
+     * @see GetMidiControllerAssignments
+     */
+    struct GetMidiControllerAssignmentsResponse {
+        /**
+         * The assigned parameter IDs, indexed by `channel *
+         * Steinberg::Vst::kCountCtrlNumber + midi_controller_number`. Contains
+         * a nullopt for controllers the plugin did not return `kResultOk` for.
+         */
+        std::vector<std::optional<Steinberg::Vst::ParamID>> ids;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.container(
+                ids, num_midi_channels * Steinberg::Vst::kCountCtrlNumber,
+                [](S& s, auto& v) {
+                    s.ext(v, bitsery::ext::InPlaceOptional{},
+                          [](S& s, Steinberg::Vst::ParamID& id) {
+                              s.value4b(id);
+                          });
+                });
+        }
+    };
+
+    /**
+     * Query the parameter assignments for every MIDI controller on every MIDI
+     * channel of an event bus at once using
+     * `IMidiMapping::getMidiControllerAssignment()`. Hosts like Bitwig call
+     * that function for every possible controller when loading a plugin, so
+     * these assignments are fetched in bulk and then cached until the plugin
+     * restarts.
+     */
+    struct GetMidiControllerAssignments {
+        using Response = GetMidiControllerAssignmentsResponse;
+
+        native_size_t instance_id;
+
+        int32 bus_index;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+            s.value4b(bus_index);
+        }
+    };
+
     virtual tresult PLUGIN_API getMidiControllerAssignment(
         int32 busIndex,
         int16 channel,
@@ -18,6 +18,7 @@
 
 #include <pluginterfaces/vst/ivstnoteexpression.h>
 
+#include "../../../bitsery/ext/in-place-optional.h"
 #include "../../common.h"
 #include "../base.h"
 
@@ -68,68 +69,52 @@ class YaNoteExpressionController
     inline bool supported() const noexcept { return arguments_.supported; }
 
     /**
-     * Message to pass through a call to
-     * `INoteExpressionController::getNoteExpressionCount(bus_index, channel)`
-     * to the Wine plugin host.
+     * All note expression infos for a channel on an event bus.
+     *
+     * @see GetNoteExpressionInfos
      */
-    struct GetNoteExpressionCount {
-        using Response = PrimitiveResponse<int32>;
-
-        native_size_t instance_id;
-
-        int32 bus_index;
-        int16 channel;
-
-        template <typename S>
-        void serialize(S& s) {
-            s.value8b(instance_id);
-            s.value4b(bus_index);
-            s.value2b(channel);
-        }
-    };
-
-    virtual int32 PLUGIN_API getNoteExpressionCount(int32 busIndex,
-                                                    int16 channel) override = 0;
-
-    /**
-     * The response code and returned info for a call to
-     * `INoteExpressionController::getNoteExpressionInfo(bus_index, channel,
-     * note_expression_index, &info)`.
-     */
-    struct GetNoteExpressionInfoResponse {
-        UniversalTResult result;
-        Steinberg::Vst::NoteExpressionTypeInfo info;
+    struct GetNoteExpressionInfosResponse {
+        /**
+         * The note expression infos, indexed by note expression index. If the
+         * plugin returned an error for a note expression that should be in
+         * range, then this contains a nullopt value.
+         */
+        std::vector<std::optional<Steinberg::Vst::NoteExpressionTypeInfo>>
+            infos;
 
         template <typename S>
         void serialize(S& s) {
-            s.object(result);
-            s.object(info);
+            s.container(infos, 1 << 16, [](S& s, auto& v) {
+                s.ext(v, bitsery::ext::InPlaceOptional{});
+            });
         }
     };
 
     /**
-     * Message to pass through a call to
-     * `INoteExpressionController::getNoteExpressionInfo(bus_index, channel,
-     * note_expression_index, &info)` to the Wine plugin host.
+     * Get all note expression infos for a channel on an event bus using both
+     * `INoteExpressionController::getNoteExpressionCount(bus_index, channel)`
+     * and `INoteExpressionController::getNoteExpressionInfo(bus_index,
+     * channel, note_expression_index, &info)`. These are cached per bus and
+     * channel until the plugin restarts.
      */
-    struct GetNoteExpressionInfo {
-        using Response = GetNoteExpressionInfoResponse;
+    struct GetNoteExpressionInfos {
+        using Response = GetNoteExpressionInfosResponse;
 
         native_size_t instance_id;
 
         int32 bus_index;
         int16 channel;
-        int32 note_expression_index;
 
         template <typename S>
         void serialize(S& s) {
             s.value8b(instance_id);
             s.value4b(bus_index);
             s.value2b(channel);
-            s.value4b(note_expression_index);
         }
     };
 
+    virtual int32 PLUGIN_API getNoteExpressionCount(int32 busIndex,
+                                                    int16 channel) override = 0;
     virtual tresult PLUGIN_API getNoteExpressionInfo(
         int32 busIndex,
         int16 channel,
@@ -18,6 +18,7 @@
 
 #include <pluginterfaces/vst/ivstunits.h>
 
+#include "../../../bitsery/ext/in-place-optional.h"
 #include "../../common.h"
 #include "../base.h"
 #include "../bstream.h"
@@ -65,65 +66,75 @@ class YaUnitInfo : public Steinberg::Vst::IUnitInfo {
     inline bool supported() const noexcept { return arguments_.supported; }
 
     /**
-     * Message to pass through a call to `IUnitInfo::getUnitCount()` to the Wine
-     * plugin host.
+     * All of a plugin's unit infos.
+     *
+     * @see GetUnitInfos
      */
-    struct GetUnitCount {
-        using Response = PrimitiveResponse<int32>;
-
-        native_size_t instance_id;
+    struct GetUnitInfosResponse {
+        /**
+         * All of the plugin's unit infos. If the plugin returned an error for a
+         * unit that should be in range, then this contains a nullopt value.
+         */
+        std::vector<std::optional<Steinberg::Vst::UnitInfo>> infos;
 
         template <typename S>
         void serialize(S& s) {
-            s.value8b(instance_id);
+            s.container(infos, 1 << 16, [](S& s, auto& v) {
+                s.ext(v, bitsery::ext::InPlaceOptional{});
+            });
         }
     };
 
-    virtual int32 PLUGIN_API getUnitCount() override = 0;
-
     /**
-     * The response code and returned unit information for a call to
-     * `IUnitInfo::getUnitInfo(unit_index, &info)`.
+     * Get all of the plugin's unit information using both
+     * `IUnitInfo::getUnitCount()` and `IUnitInfo::getUnitInfo()`. Like with
+     * parameter infos, this is queried all at once and then cached until the
+     * plugin restarts or notifies the host about a change in its units.
      */
-    struct GetUnitInfoResponse {
-        UniversalTResult result;
-        Steinberg::Vst::UnitInfo info;
+    struct GetUnitInfos {
+        using Response = GetUnitInfosResponse;
+
+        native_size_t instance_id;
 
         template <typename S>
         void serialize(S& s) {
-            s.object(result);
-            s.object(info);
+            s.value8b(instance_id);
         }
     };
 
+    virtual int32 PLUGIN_API getUnitCount() override = 0;
+    virtual tresult PLUGIN_API
+    getUnitInfo(int32 unitIndex,
+                Steinberg::Vst::UnitInfo& info /*out*/) override = 0;
+
     /**
-     * Message to pass through a call to `IUnitInfo::getUnitInfo(unit_index,
-     * &info)` to the Wine plugin host.
+     * All of a plugin's program list infos.
+     *
+     * @see GetProgramListInfos
      */
-    struct GetUnitInfo {
-        using Response = GetUnitInfoResponse;
-
-        native_size_t instance_id;
-
-        int32 unit_index;
+    struct GetProgramListInfosResponse {
+        /**
+         * All of the plugin's program list infos. If the plugin returned an
+         * error for a program list that should be in range, then this contains
+         * a nullopt value.
+         */
+        std::vector<std::optional<Steinberg::Vst::ProgramListInfo>> infos;
 
         template <typename S>
         void serialize(S& s) {
-            s.value8b(instance_id);
-            s.value4b(unit_index);
+            s.container(infos, 1 << 16, [](S& s, auto& v) {
+                s.ext(v, bitsery::ext::InPlaceOptional{});
+            });
         }
     };
 
-    virtual tresult PLUGIN_API
-    getUnitInfo(int32 unitIndex,
-                Steinberg::Vst::UnitInfo& info /*out*/) override = 0;
-
     /**
-     * Message to pass through a call to `IUnitInfo::getProgramListCount()` to
-     * the Wine plugin host.
+     * Get all of the plugin's program list information using both
+     * `IUnitInfo::getProgramListCount()` and `IUnitInfo::getProgramListInfo()`.
+     * This is cached the same way as `GetUnitInfos`.
      */
-    struct GetProgramListCount {
-        using Response = PrimitiveResponse<int32>;
+    struct GetProgramListInfos {
+        using Response = GetProgramListInfosResponse;
 
         native_size_t instance_id;
 
@@ -134,45 +145,59 @@ class YaUnitInfo : public Steinberg::Vst::IUnitInfo {
     };
 
     virtual int32 PLUGIN_API getProgramListCount() override = 0;
+    virtual tresult PLUGIN_API getProgramListInfo(
+        int32 listIndex,
+        Steinberg::Vst::ProgramListInfo& info /*out*/) override = 0;
 
     /**
-     * The response code and returned unit information for a call to
-     * `IUnitInfo::getProgramListInfo(list_index, &info)`.
+     * The names of all programs in a program list.
+     *
+     * @see GetProgramNames
      */
-    struct GetProgramListInfoResponse {
-        UniversalTResult result;
-        Steinberg::Vst::ProgramListInfo info;
+    struct GetProgramNamesResponse {
+        /**
+         * The program names, indexed by program index. Contains a nullopt for
+         * programs the plugin returned an error for.
+         */
+        std::vector<std::optional<std::u16string>> names;
 
         template <typename S>
         void serialize(S& s) {
-            s.object(result);
-            s.object(info);
+            s.container(names, 1 << 16, [](S& s, auto& v) {
+                s.ext(v, bitsery::ext::InPlaceOptional{},
+                      [](S& s, std::u16string& name) {
+                          s.text2b(name,
+                                   std::extent_v<Steinberg::Vst::String128>);
+                      });
+            });
         }
     };
 
     /**
-     * Message to pass through a call to
-     * `IUnitInfo::getProgramListInfo(list_index, &info)` to the Wine plugin
-     * host.
+     * Get the names of all programs in a program list at once by calling
+     * `IUnitInfo::getProgramName(list_id, program_index, &name)` for every
+     * program in the list. Hosts tend to query every program name whenever
+     * they build a program menu, so the names are cached per program list
+     * until the plugin notifies the host that the list has changed. Single
+     * `GetProgramName` calls are still used for lists the plugin did not
+     * report in `GetProgramListInfos`.
      */
-    struct GetProgramListInfo {
-        using Response = GetProgramListInfoResponse;
+    struct GetProgramNames {
+        using Response = GetProgramNamesResponse;
 
         native_size_t instance_id;
 
-        int32 list_index;
+        Steinberg::Vst::ProgramListID list_id;
+        int32 program_count;
 
         template <typename S>
         void serialize(S& s) {
             s.value8b(instance_id);
-            s.value4b(list_index);
+            s.value4b(list_id);
+            s.value4b(program_count);
         }
     };
 
-    virtual tresult PLUGIN_API getProgramListInfo(
-        int32 listIndex,
-        Steinberg::Vst::ProgramListInfo& info /*out*/) override = 0;
-
     /**
      * The response code and returned name for a call to
      * `IUnitInfo::getProgramName(list_id, program_index, &name)`.
@@ -18,10 +18,67 @@
 
 #include "../../utils.h"
 
+namespace {
+
+/**
+ * The optional parts of `ProcessContext`, and the `IProcessContextRequirements`
+ * flag a plugin needs to set to receive them.
+ */
+struct ProcessContextRequirement {
+    uint32 requirement;
+    uint32 state_flag;
+    uint32 fields;
+};
+
+using Steinberg::Vst::IProcessContextRequirements;
+using Steinberg::Vst::ProcessContext;
+
+template <typename M>
+constexpr uint32 process_context_field(M ProcessContext::*member) {
+    return transport_field_bit<ProcessContext>(member);
+}
+
+constexpr ProcessContextRequirement process_context_requirements_table[] = {
+    {IProcessContextRequirements::kNeedSystemTime,
+     ProcessContext::kSystemTimeValid,
+     process_context_field(&ProcessContext::systemTime)},
+    {IProcessContextRequirements::kNeedContinousTimeSamples,
+     ProcessContext::kContTimeValid,
+     process_context_field(&ProcessContext::continousTimeSamples)},
+    {IProcessContextRequirements::kNeedProjectTimeMusic,
+     ProcessContext::kProjectTimeMusicValid,
+     process_context_field(&ProcessContext::projectTimeMusic)},
+    {IProcessContextRequirements::kNeedBarPositionMusic,
+     ProcessContext::kBarPositionValid,
+     process_context_field(&ProcessContext::barPositionMusic)},
+    {IProcessContextRequirements::kNeedCycleMusic, ProcessContext::kCycleValid,
+     process_context_field(&ProcessContext::cycleStartMusic) |
+         process_context_field(&ProcessContext::cycleEndMusic)},
+    {IProcessContextRequirements::kNeedSamplesToNextClock,
+     ProcessContext::kClockValid,
+     process_context_field(&ProcessContext::samplesToNextClock)},
+    {IProcessContextRequirements::kNeedTempo, ProcessContext::kTempoValid,
+     process_context_field(&ProcessContext::tempo)},
+    {IProcessContextRequirements::kNeedTimeSignature,
+     ProcessContext::kTimeSigValid,
+     process_context_field(&ProcessContext::timeSigNumerator) |
+         process_context_field(&ProcessContext::timeSigDenominator)},
+    {IProcessContextRequirements::kNeedChord, ProcessContext::kChordValid,
+     process_context_field(&ProcessContext::chord)},
+    {IProcessContextRequirements::kNeedFrameRate, ProcessContext::kSmpteValid,
+     process_context_field(&ProcessContext::smpteOffsetSubframes) |
+         process_context_field(&ProcessContext::frameRate)},
+};
+
+}  // namespace
+
 YaProcessData::YaProcessData() noexcept {}
 
-void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
-                               AudioShmBuffer& shared_audio_buffers) {
+void YaProcessData::repopulate(
+    const Steinberg::Vst::ProcessData& process_data,
+    AudioShmBuffer& shared_audio_buffers,
+    TransportDeltaState<Steinberg::Vst::ProcessContext>& process_context_state,
+    std::optional<uint32> process_context_requirements) {
     // In this function and in every function we call, we should be careful to
     // not use `push_back`/`emplace_back` anywhere. Resizing vectors and
     // modifying them in place performs much better because that avoids
@@ -108,16 +165,40 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
         output_events_.reset();
     }
 
-    if (process_data.processContext) {
-        process_context_.emplace(*process_data.processContext);
+    // Only the fields that changed since the last processing cycle will be
+    // sent over. The Wine plugin host will reconstruct the rest. If the plugin
+    // told us which parts of the process context it actually uses, then we'll
+    // also drop everything else. Most effects only need the tempo and the
+    // position in samples, and the system time and musical positions would
+    // otherwise have to be sent every cycle. The transport state flags are
+    // always sent since they're also used for predicting the song position.
+    if (process_data.processContext && process_context_requirements) {
+        ProcessContext trimmed_process_context = *process_data.processContext;
+
+        uint32_t field_mask = all_transport_fields<ProcessContext>();
+        for (const auto& [requirement, state_flag, fields] :
+             process_context_requirements_table) {
+            if (!(*process_context_requirements & requirement)) {
+                trimmed_process_context.state &= ~state_flag;
+                field_mask &= ~fields;
+            }
+        }
+
+        process_context_state.encode(process_context_,
+                                     &trimmed_process_context,
+                                     process_data.numSamples, field_mask);
     } else {
-        process_context_.reset();
+        process_context_state.encode(process_context_,
+                                     process_data.processContext,
+                                     process_data.numSamples);
     }
 }
 
 Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
     std::vector<std::vector<void*>>& input_pointers,
-    std::vector<std::vector<void*>>& output_pointers) {
+    std::vector<std::vector<void*>>& output_pointers,
+    TransportDeltaState<Steinberg::Vst::ProcessContext>&
+        process_context_state) {
     reconstructed_process_data_.processMode = process_mode_;
     reconstructed_process_data_.symbolicSampleSize = symbolic_sample_size_;
     reconstructed_process_data_.numSamples = num_samples_;
@@ -171,8 +252,14 @@ Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
         reconstructed_process_data_.outputEvents = nullptr;
     }
 
-    if (process_context_) {
-        reconstructed_process_data_.processContext = &*process_context_;
+    // We'll hand the plugin a copy of the decoded process context. Plugins
+    // shouldn't write to it, but if one does then that should not break the
+    // delta decoding during the next processing cycle.
+    if (const Steinberg::Vst::ProcessContext* process_context =
+            process_context_state.decode(process_context_, num_samples_)) {
+        reconstructed_process_context_ = *process_context;
+        reconstructed_process_data_.processContext =
+            &reconstructed_process_context_;
     } else {
         reconstructed_process_data_.processContext = nullptr;
     }
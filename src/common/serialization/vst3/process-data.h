@@ -23,12 +23,49 @@
 #include "../../audio-shm.h"
 #include "../../bitsery/ext/in-place-optional.h"
 #include "../../bitsery/ext/in-place-variant.h"
+#include "../transport-delta.h"
 #include "base.h"
 #include "event-list.h"
 #include "parameter-changes.h"
 
 // This header provides serialization wrappers around `ProcessData`
 
+/**
+ * The fields in `ProcessContext`, used for delta encoding the process context
+ * sent along with `YaProcessData`.
+ */
+template <>
+struct TransportFields<Steinberg::Vst::ProcessContext> {
+    using ProcessContext = Steinberg::Vst::ProcessContext;
+
+    static constexpr std::tuple fields{
+        &ProcessContext::state,
+        &ProcessContext::sampleRate,
+        &ProcessContext::projectTimeSamples,
+        &ProcessContext::systemTime,
+        &ProcessContext::continousTimeSamples,
+        &ProcessContext::projectTimeMusic,
+        &ProcessContext::barPositionMusic,
+        &ProcessContext::cycleStartMusic,
+        &ProcessContext::cycleEndMusic,
+        &ProcessContext::tempo,
+        &ProcessContext::timeSigNumerator,
+        &ProcessContext::timeSigDenominator,
+        &ProcessContext::chord,
+        &ProcessContext::smpteOffsetSubframes,
+        &ProcessContext::frameRate,
+        &ProcessContext::samplesToNextClock};
+
+    static void predict(ProcessContext& context, int64_t num_samples) {
+        // The continuous time always advances, the project time only advances
+        // while the transport is running
+        context.continousTimeSamples += num_samples;
+        if (context.state & ProcessContext::kPlaying) {
+            context.projectTimeSamples += num_samples;
+        }
+    }
+};
+
 /**
  * A serializable wrapper around `ProcessData`. We'll read all information from
  * the host so we can serialize it and provide an equivalent `ProcessData`
@@ -67,9 +104,22 @@ class YaProcessData {
      * no direct link between this `YaProcessData` object and those buffers, but
      * they should be treated as a pair. This is a bit ugly, but optimizations
      * sadly never made code prettier.
+     *
+     * The process context is delta encoded using `process_context_state`, so
+     * only the fields that changed since the last call are sent. This object
+     * should be unique to the plugin instance. If the plugin told us which
+     * parts of the process context it needs through
+     * `IProcessContextRequirements`, then `process_context_requirements`
+     * should contain those flags. The other optional fields will then never be
+     * sent, and their `k*Valid` flags are cleared so the Wine plugin host
+     * still ends up with a valid process context.
      */
-    void repopulate(const Steinberg::Vst::ProcessData& process_data,
-                    AudioShmBuffer& shared_audio_buffers);
+    void repopulate(
+        const Steinberg::Vst::ProcessData& process_data,
+        AudioShmBuffer& shared_audio_buffers,
+        TransportDeltaState<Steinberg::Vst::ProcessContext>&
+            process_context_state,
+        std::optional<uint32> process_context_requirements = std::nullopt);
 
     /**
      * Reconstruct the original `ProcessData` object passed to `repopulate()`
@@ -89,10 +139,18 @@ class YaProcessData {
      * but we'll accept these as void pointers since the stride will be
      * different depending on whether the host is going to be sending double or
      * single precision audio.
+     *
+     * The process context is reconstructed from the changed fields using
+     * `process_context_state`. Like the audio buffer pointers, this object
+     * belongs to the plugin instance and not to this object, since the Wine
+     * plugin host may receive into different `YaProcessData` objects for the
+     * same plugin instance.
      */
     Steinberg::Vst::ProcessData& reconstruct(
         std::vector<std::vector<void*>>& input_pointers,
-        std::vector<std::vector<void*>>& output_pointers);
+        std::vector<std::vector<void*>>& output_pointers,
+        TransportDeltaState<Steinberg::Vst::ProcessContext>&
+            process_context_state);
 
     /**
      * A serializable wrapper around the output fields of `ProcessData`, so we
@@ -172,7 +230,7 @@ class YaProcessData {
         s.ext(input_events_, bitsery::ext::InPlaceOptional{});
         s.ext(output_events_, bitsery::ext::InPlaceOptional{});
 
-        s.ext(process_context_, bitsery::ext::InPlaceOptional{});
+        s.object(process_context_);
 
         // We of course won't serialize the `reconstructed_process_data` and all
         // of the `output*` fields defined below it
@@ -239,9 +297,11 @@ class YaProcessData {
     std::optional<YaEventList> output_events_;
 
     /**
-     * Some more information about the project and transport.
+     * Some more information about the project and transport. This is delta
+     * encoded against the process context sent during the previous processing
+     * cycle.
      */
-    std::optional<Steinberg::Vst::ProcessContext> process_context_;
+    TransportDelta<Steinberg::Vst::ProcessContext> process_context_;
 
    private:
     // These last few members are used on the Wine plugin host side to
@@ -261,6 +321,13 @@ class YaProcessData {
      */
     Response response_object_;
 
+    /**
+     * The process context decoded from `process_context_` during
+     * `reconstruct()`. `reconstructed_process_data_` points to this if the
+     * host provided a process context.
+     */
+    Steinberg::Vst::ProcessContext reconstructed_process_context_{};
+
     /**
      * The process data we reconstruct from the other fields during
      * `reconstruct()`.
@@ -278,32 +345,6 @@ void serialize(S& s, Steinberg::Vst::AudioBusBuffers& buffers) {
     s.value8b(buffers.silenceFlags);
 }
 
-template <typename S>
-void serialize(S& s, Steinberg::Vst::ProcessContext& process_context) {
-    // The docs don't mention that things ever got added to this context (and
-    // that some fields thus may not exist for all hosts), so we'll just
-    // directly serialize everything. If it does end up being the case that new
-    // fields were added here we should serialize based on the bits set in the
-    // flags bitfield.
-    s.value4b(process_context.state);
-    s.value8b(process_context.sampleRate);
-    s.value8b(process_context.projectTimeSamples);
-    s.value8b(process_context.systemTime);
-    s.value8b(process_context.continousTimeSamples);
-    s.value8b(process_context.projectTimeMusic);
-    s.value8b(process_context.barPositionMusic);
-    s.value8b(process_context.cycleStartMusic);
-    s.value8b(process_context.cycleEndMusic);
-    s.value8b(process_context.tempo);
-    s.value4b(process_context.timeSigNumerator);
-    s.value4b(process_context.timeSigDenominator);
-    s.object(process_context.chord);
-    s.value4b(process_context.smpteOffsetSubframes);
-    s.value4b(process_context.smpteOffsetSubframes);
-    s.object(process_context.frameRate);
-    s.value4b(process_context.samplesToNextClock);
-}
-
 template <typename S>
 void serialize(S& s, Steinberg::Vst::Chord& chord) {
     s.value1b(chord.keyNote);
@@ -39,6 +39,28 @@ constexpr char disable_watchdog_timer_env_var[] = "YABRIDGE_NO_WATCHDOG";
  */
 constexpr char temp_dir_override_env_var[] = "YABRIDGE_TEMP_DIR";
 
+/**
+ * The stack size in kilobytes for threads spawned by yabridge. See
+ * `get_thread_stack_size()`.
+ */
+constexpr char thread_stack_size_env_var[] = "YABRIDGE_THREAD_STACK_SIZE";
+
+/**
+ * The CPU affinity this process was started with, captured during static
+ * initialization before any of our threads could have changed it. Restored by
+ * `reset_cpu_affinity()`.
+ */
+const std::optional<cpu_set_t> initial_cpu_affinity =
+    []() -> std::optional<cpu_set_t> {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+        return cpus;
+    } else {
+        return std::nullopt;
+    }
+}();
+
 fs::path get_temporary_directory() {
     // NOLINTNEXTLINE(concurrency-mt-unsafe)
     if (const auto directory = getenv(temp_dir_override_env_var)) {
@@ -61,10 +83,80 @@ std::optional<int> get_realtime_priority() noexcept {
     }
 }
 
+/**
+ * The cached result of `is_realtime_thread()` for the calling thread.
+ */
+static thread_local std::optional<bool> current_thread_is_realtime;
+
+bool is_realtime_thread() noexcept {
+    if (!current_thread_is_realtime) [[unlikely]] {
+        current_thread_is_realtime = get_realtime_priority().has_value();
+    }
+
+    return *current_thread_is_realtime;
+}
+
 bool set_realtime_priority(bool sched_fifo, int priority) noexcept {
     sched_param params{.sched_priority = (sched_fifo ? priority : 0)};
-    return sched_setscheduler(0, sched_fifo ? SCHED_FIFO : SCHED_OTHER,
-                              &params) == 0;
+    const bool success =
+        sched_setscheduler(0, sched_fifo ? SCHED_FIFO : SCHED_OTHER,
+                           &params) == 0;
+    if (success) {
+        current_thread_is_realtime = sched_fifo && priority > 0;
+    }
+
+    return success;
+}
+
+std::optional<uint64_t> get_cpu_affinity_mask() noexcept {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+        return std::nullopt;
+    }
+
+    uint64_t mask = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpus)) {
+            if (cpu >= 64) {
+                return std::nullopt;
+            }
+
+            mask |= uint64_t(1) << cpu;
+        }
+    }
+
+    return mask;
+}
+
+bool set_cpu_affinity_mask(uint64_t mask) noexcept {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if (mask & (uint64_t(1) << cpu)) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+
+    return mask != 0 && sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+bool set_cpu_affinity(const std::vector<uint16_t>& cpus) noexcept {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const uint16_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+
+    return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+}
+
+bool reset_cpu_affinity() noexcept {
+    return initial_cpu_affinity &&
+           sched_setaffinity(0, sizeof(*initial_cpu_affinity),
+                             &*initial_cpu_affinity) == 0;
 }
 
 std::optional<rlim_t> get_memlock_limit() noexcept {
@@ -94,6 +186,27 @@ bool is_watchdog_timer_disabled() {
     return disable_watchdog_env && disable_watchdog_env == "1"sv;
 }
 
+size_t get_thread_stack_size() noexcept {
+    // The environment doesn't change, so we only need to parse this once
+    static const size_t stack_size = []() -> size_t {
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+        const char* stack_size_env = getenv(thread_stack_size_env_var);
+        if (!stack_size_env) {
+            return 0;
+        }
+
+        char* end = nullptr;
+        const unsigned long long kilobytes = strtoull(stack_size_env, &end, 10);
+        if (end == stack_size_env || *end != '\0') {
+            return 0;
+        }
+
+        return static_cast<size_t>(kilobytes) * 1024;
+    }();
+
+    return stack_size;
+}
+
 size_t strlcpy_buffer(char* dst, const std::string& src, size_t size) {
     if (size == 0) {
         return src.size();
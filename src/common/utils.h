@@ -17,6 +17,7 @@
 #pragma once
 
 #include <optional>
+#include <vector>
 
 #include <sys/resource.h>
 #include <ghc/filesystem.hpp>
@@ -86,6 +87,16 @@ ghc::filesystem::path get_temporary_directory();
  */
 std::optional<int> get_realtime_priority() noexcept;
 
+/**
+ * Whether the calling thread uses a realtime scheduling policy. Unlike
+ * `get_realtime_priority()`, this only queries the scheduler the first time
+ * it's called on a thread. After that the result is cached, and the cache is
+ * only updated when the thread changes its own priority through
+ * `set_realtime_priority()`. This makes it cheap enough to call on every log
+ * message.
+ */
+bool is_realtime_thread() noexcept;
+
 /**
  * Set the scheduling policy to `SCHED_FIFO` with priority 5 for this process.
  * We explicitly don't do this for wineserver itself since from my testing that
@@ -109,6 +120,42 @@ std::optional<int> get_realtime_priority() noexcept;
  */
 bool set_realtime_priority(bool sched_fifo, int priority = 5) noexcept;
 
+/**
+ * Get the calling thread's CPU affinity as a bit mask, where bit `n` is set if
+ * the thread may run on CPU `n`. This is used to mirror the host's audio
+ * thread's affinity on the Wine plugin host's audio threads. Since this is sent
+ * over the wire as a single integer, this returns a nullopt if the thread may
+ * run on CPUs past the first 64, or if the affinity could not be queried.
+ */
+std::optional<uint64_t> get_cpu_affinity_mask() noexcept;
+
+/**
+ * Restrict the calling thread to the CPUs set in a mask returned by
+ * `get_cpu_affinity_mask()`.
+ *
+ * @return Whether the operation was successful or not. This will fail if the
+ *   mask is empty or if none of the CPUs are available to this process.
+ */
+bool set_cpu_affinity_mask(uint64_t mask) noexcept;
+
+/**
+ * Restrict the calling thread to a set of CPUs, as configured through the
+ * `audio_thread_cpus` and `gui_thread_cpus` options. Any threads spawned by
+ * this thread afterwards, including those created by the Windows plugin, will
+ * inherit this affinity.
+ *
+ * @return Whether the operation was successful or not. This will fail if none
+ *   of the CPUs are available to this process.
+ */
+bool set_cpu_affinity(const std::vector<uint16_t>& cpus) noexcept;
+
+/**
+ * Reset the calling thread's CPU affinity back to the affinity this process
+ * had when it was started. Used on the Wine side so audio threads spawned from
+ * a thread pinned to `gui_thread_cpus` don't inherit that restriction.
+ */
+bool reset_cpu_affinity() noexcept;
+
 /**
  * Get the (soft) `RLIMIT_MEMLOCK` resource limit. If this is set to some low
  * value, then we'll print a warning during initialization because mapping
@@ -140,6 +187,16 @@ std::optional<rlim_t> get_rttime_limit() noexcept;
  */
 bool is_watchdog_timer_disabled();
 
+/**
+ * The stack size in bytes to use for the threads yabridge spawns, as set
+ * through the `YABRIDGE_THREAD_STACK_SIZE` environment variable in kilobytes.
+ * Returns 0 if the variable is not set or invalid, in which case the platform's
+ * default should be used. This is usually 8 MiB on Linux. Only the address
+ * space gets reserved up front, but with hundreds of plugin instances that
+ * still adds up to several gigabytes.
+ */
+size_t get_thread_stack_size() noexcept;
+
 /**
  * Escape XML entities within a string. Used inside of desktop notifications.
  */
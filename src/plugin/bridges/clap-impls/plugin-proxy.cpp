@@ -267,10 +267,12 @@ clap_plugin_proxy::plugin_process(const struct clap_plugin* plugin,
     // We'll synchronize the scheduling priority of the audio thread on the Wine
     // plugin host with that of the host's audio thread every once in a while
     std::optional<int> new_realtime_priority = std::nullopt;
+    std::optional<uint64_t> new_cpu_affinity_mask = std::nullopt;
     time_t now = time(nullptr);
     if (now > self->last_audio_thread_priority_synchronization_ +
                   audio_thread_priority_synchronization_interval) {
         new_realtime_priority = get_realtime_priority();
+        new_cpu_affinity_mask = get_cpu_affinity_mask();
         self->last_audio_thread_priority_synchronization_ = now;
     }
 
@@ -280,9 +282,10 @@ clap_plugin_proxy::plugin_process(const struct clap_plugin* plugin,
     // itself.
     assert(self->process_buffers_);
     self->process_request_.instance_id = self->instance_id();
-    self->process_request_.process.repopulate(*process,
-                                              *self->process_buffers_);
+    self->process_request_.process.repopulate(
+        *process, *self->process_buffers_, self->transport_delta_state_);
     self->process_request_.new_realtime_priority = new_realtime_priority;
+    self->process_request_.new_cpu_affinity_mask = new_cpu_affinity_mask;
 
     // HACK: This is a bit ugly. This `clap::process::Process::Response` object
     //       actually contains pointers to the corresponding `YaProcessData`
@@ -302,9 +305,14 @@ clap_plugin_proxy::plugin_process(const struct clap_plugin* plugin,
 
     // We'll also receive the response into an existing object so we can also
     // avoid heap allocations there
+    const auto round_trip_start = std::chrono::steady_clock::now();
     self->bridge_.receive_audio_thread_message_into(
         MessageReference<clap::plugin::Process>(self->process_request_),
         self->process_response_);
+    self->process_timing_stats_.record(
+        self->bridge_.logger_.logger_, self->process_response_.timing,
+        std::chrono::steady_clock::now() - round_trip_start,
+        self->instance_id());
 
     // At this point the shared audio buffers should contain the output audio,
     // so we'll write that back to the host along with any metadata (which in
@@ -313,6 +321,12 @@ clap_plugin_proxy::plugin_process(const struct clap_plugin* plugin,
     self->process_request_.process.write_back_outputs(*process,
                                                       *self->process_buffers_);
 
+    // `clap_host_tail::changed()` has to be called from the audio thread, so
+    // the Wine plugin host sends it along with the process response
+    if (self->process_response_.tail_changed && self->host_extensions_.tail) {
+        self->host_extensions_.tail->changed(self->host_);
+    }
+
     return self->process_response_.result;
 }
 
@@ -38,6 +38,7 @@
 
 #include "../../common/serialization/clap/ext/params.h"
 #include "../../common/serialization/clap/plugin.h"
+#include "../../utils.h"
 
 // Forward declaration to avoid circular includes
 class ClapPluginBridge;
@@ -182,7 +183,7 @@ class clap_plugin_proxy {
      * plugin. This is needed to minimize blocking during those callbacks, as
      * certain CLAP extensions allow callbacks on the audio thread.
      */
-    std::jthread audio_thread_handler_;
+    NativeThread audio_thread_handler_;
 
    protected:
     static bool CLAP_ABI plugin_init(const struct clap_plugin* plugin);
@@ -359,6 +360,20 @@ class clap_plugin_proxy {
      */
     clap::plugin::ProcessResponse process_response_;
 
+    /**
+     * The transport information we sent to the Wine plugin host during the
+     * last processing cycle. This is used to delta encode the transport
+     * information in `process_request_`, so we only send the fields that
+     * changed.
+     */
+    TransportDeltaState<clap_event_transport_t> transport_delta_state_;
+
+    /**
+     * Running statistics for the time the plugin spends processing audio,
+     * written to the log periodically when the verbosity is high enough.
+     */
+    ProcessTimingStats process_timing_stats_;
+
     /**
      * The vtable for `clap_plugin`, requires that this object is never moved or
      * copied. We'll use the host data pointer instead of placing this vtable at
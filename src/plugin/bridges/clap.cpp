@@ -23,7 +23,7 @@ ClapPluginBridge::ClapPluginBridge(const ghc::filesystem::path& plugin_path)
           PluginType::clap,
           plugin_path,
           [](asio::io_context& io_context, const PluginInfo& info) {
-              return ClapSockets<std::jthread>(
+              return ClapSockets<NativeThread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path_.filename()
                                              .replace_extension("")
@@ -42,7 +42,7 @@ ClapPluginBridge::ClapPluginBridge(const ghc::filesystem::path& plugin_path)
     // messaging mechanism is how we relay the CLAP communication protocol. As a
     // first thing, the Wine plugin host will ask us for a copy of the
     // configuration.
-    host_callback_handler_ = std::jthread([&]() {
+    host_callback_handler_ = NativeThread([&]() {
         set_realtime_priority(true);
         pthread_setname_np(pthread_self(), "host-callbacks");
 
@@ -55,27 +55,47 @@ ClapPluginBridge::ClapPluginBridge(const ghc::filesystem::path& plugin_path)
 
                     return config_;
                 },
-                [&](const clap::host::RequestRestart& request)
-                    -> clap::host::RequestRestart::Response {
+                [&](const clap::host::Notify& request)
+                    -> clap::host::Notify::Response {
                     const auto& [plugin_proxy, _] =
                         get_proxy(request.owner_instance_id);
 
-                    run_on_main_thread(plugin_proxy, [host = plugin_proxy
-                                                                 .host_]() {
-                        host->request_restart(host);
-                    }).wait();
-
-                    return Ack{};
-                },
-                [&](const clap::host::RequestProcess& request)
-                    -> clap::host::RequestProcess::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    run_on_main_thread(plugin_proxy, [host = plugin_proxy
-                                                                 .host_]() {
-                        host->request_process(host);
-                    }).wait();
+                    // These notifications don't return anything, so we don't
+                    // need to wait for the host to handle them. The callbacks
+                    // will be run on the host's main thread the next time it
+                    // calls `clap_plugin::on_main_thread()`, or right away if
+                    // the host's main thread is currently waiting on a mutually
+                    // recursive function call.
+                    run_on_main_thread(
+                        plugin_proxy,
+                        [notifications = request.notifications,
+                         host = plugin_proxy.host_,
+                         extensions = &plugin_proxy.host_extensions_]() {
+                            if (notifications &
+                                clap::host::notify_request_restart) {
+                                host->request_restart(host);
+                            }
+                            if (notifications &
+                                clap::host::notify_request_process) {
+                                host->request_process(host);
+                            }
+                            if (notifications &
+                                clap::host::notify_latency_changed) {
+                                extensions->latency->changed(host);
+                            }
+                            if (notifications &
+                                clap::host::notify_note_name_changed) {
+                                extensions->note_name->changed(host);
+                            }
+                            if (notifications &
+                                clap::host::notify_state_mark_dirty) {
+                                extensions->state->mark_dirty(host);
+                            }
+                            if (notifications &
+                                clap::host::notify_voice_info_changed) {
+                                extensions->voice_info->changed(host);
+                            }
+                        });
 
                     return Ack{};
                 },
@@ -179,37 +199,6 @@ ClapPluginBridge::ClapPluginBridge(const ghc::filesystem::path& plugin_path)
 
                     return Ack{};
                 },
-                [&](const clap::ext::latency::host::Changed& request)
-                    -> clap::ext::latency::host::Changed::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    run_on_main_thread(
-                        plugin_proxy,
-                        [&, host = plugin_proxy.host_,
-                         latency = plugin_proxy.host_extensions_.latency]() {
-                            latency->changed(host);
-                        })
-                        .wait();
-
-                    return Ack{};
-                },
-                [&](const clap::ext::note_name::host::Changed& request)
-                    -> clap::ext::note_name::host::Changed::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    run_on_main_thread(
-                        plugin_proxy,
-                        [&, host = plugin_proxy.host_,
-                         note_name =
-                             plugin_proxy.host_extensions_.note_name]() {
-                            note_name->changed(host);
-                        })
-                        .wait();
-
-                    return Ack{};
-                },
                 [&](const clap::ext::note_ports::host::SupportedDialects&
                         request)
                     -> clap::ext::note_ports::host::SupportedDialects::
@@ -280,37 +269,6 @@ ClapPluginBridge::ClapPluginBridge(const ghc::filesystem::path& plugin_path)
 
                     return Ack{};
                 },
-                [&](const clap::ext::state::host::MarkDirty& request)
-                    -> clap::ext::state::host::MarkDirty::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    run_on_main_thread(
-                        plugin_proxy,
-                        [&, host = plugin_proxy.host_,
-                         state = plugin_proxy.host_extensions_.state]() {
-                            state->mark_dirty(host);
-                        })
-                        .wait();
-
-                    return Ack{};
-                },
-                [&](const clap::ext::voice_info::host::Changed& request)
-                    -> clap::ext::voice_info::host::Changed::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    run_on_main_thread(
-                        plugin_proxy,
-                        [&, host = plugin_proxy.host_,
-                         voice_info =
-                             plugin_proxy.host_extensions_.voice_info]() {
-                            voice_info->changed(host);
-                        })
-                        .wait();
-
-                    return Ack{};
-                },
             });
     });
 }
@@ -319,7 +277,6 @@ ClapPluginBridge::~ClapPluginBridge() noexcept {
     try {
         // Drop all work make sure all sockets are closed
         plugin_host_->terminate();
-        io_context_.stop();
     } catch (const std::system_error&) {
         // It could be that the sockets have already been closed or that the
         // process has already exited (at which point we probably won't be
@@ -377,7 +334,7 @@ void ClapPluginBridge::register_plugin_proxy(
     // host->plugin control messages and plugin->host callbacks
     std::promise<void> socket_listening_latch;
     plugin_proxies_.at(instance_id)
-        ->audio_thread_handler_ = std::jthread([&, instance_id]() {
+        ->audio_thread_handler_ = NativeThread([&, instance_id]() {
         set_realtime_priority(true);
 
         // XXX: Like with VST2 worker threads, when using plugin groups the
@@ -419,16 +376,6 @@ void ClapPluginBridge::register_plugin_proxy(
 
                     return Ack{};
                 },
-                [&](const clap::ext::tail::host::Changed& request)
-                    -> clap::ext::tail::host::Changed::Response {
-                    const auto& [plugin_proxy, _] =
-                        get_proxy(request.owner_instance_id);
-
-                    plugin_proxy.host_extensions_.tail->changed(
-                        plugin_proxy.host_);
-
-                    return Ack{};
-                },
             });
     });
 
@@ -38,7 +38,7 @@
  * for greppability reasons. The `Plugin` infix is added on the native plugin
  * side.
  */
-class ClapPluginBridge : PluginBridge<ClapSockets<std::jthread>> {
+class ClapPluginBridge : PluginBridge<ClapSockets<NativeThread>> {
    public:
     /**
      * Initializes the CLAP module by starting and setting up communicating with
@@ -229,7 +229,7 @@ class ClapPluginBridge : PluginBridge<ClapSockets<std::jthread>> {
      * Handles callbacks from the plugin to the host over the
      * `plugin_host_callback_` sockets.
      */
-    std::jthread host_callback_handler_;
+    NativeThread host_callback_handler_;
 
     /**
      * Our plugin factory, containing information about all plugins supported by
@@ -272,5 +272,5 @@ class ClapPluginBridge : PluginBridge<ClapSockets<std::jthread>> {
      * response. See the uses for `send_mutually_recursive_message()` for use
      * cases where this is needed.
      */
-    MutualRecursionHelper<std::jthread> mutual_recursion_;
+    MutualRecursionHelper<NativeThread> mutual_recursion_;
 };
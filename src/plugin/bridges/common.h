@@ -16,7 +16,6 @@
 
 #pragma once
 
-#include <future>
 #include <iomanip>
 
 #include <sys/resource.h>
@@ -25,6 +24,7 @@
 #include <config.h>
 #include <version.h>
 
+#include "../../common/communication/recorder.h"
 #include "../../common/configuration.h"
 #include "../../common/linking.h"
 #include "../../common/notifications.h"
@@ -84,15 +84,16 @@ class PluginBridge {
         : io_context_(),
           // This works for both individual files (VST2 and CLAP) and entire
           // directories (VST3)
-          config_(load_config_for(plugin_path)),
+          config_(load_plugin_config(plugin_type, plugin_path)),
           info_(plugin_type, plugin_path, config_.vst3_prefer_32bit),
           sockets_(create_socket_instance(io_context_, info_)),
           generic_logger_(Logger::create_from_environment(
               create_logger_prefix(sockets_.base_dir_))),
+          shared_io_context_(SharedIoContext::acquire()),
           plugin_host_(
-              config_.group
+              config_.group || config_.auto_group || config_.share_plugin_image
                   ? std::unique_ptr<HostProcess>(std::make_unique<GroupHost>(
-                        io_context_,
+                        shared_io_context_->context(),
                         generic_logger_,
                         config_,
                         sockets_,
@@ -101,10 +102,11 @@ class PluginBridge {
                             .plugin_type = plugin_type,
                             .plugin_path = info_.windows_plugin_path_.string(),
                             .endpoint_base_dir = sockets_.base_dir_.string(),
-                            .parent_pid = getpid()}))
+                            .parent_pid = getpid(),
+                            .pin_module = config_.share_plugin_image}))
                   : std::unique_ptr<HostProcess>(
                         std::make_unique<IndividualHost>(
-                            io_context_,
+                            shared_io_context_->context(),
                             generic_logger_,
                             config_,
                             sockets_,
@@ -115,19 +117,12 @@ class PluginBridge {
                                         .endpoint_base_dir =
                                             sockets_.base_dir_.string(),
                                         .parent_pid = getpid()}))),
-          has_realtime_priority_(has_realtime_priority_promise_.get_future()),
-          wine_io_handler_([&]() {
-              // We no longer run this thread with realtime scheduling because
-              // plugins that produce a lot of FIXMEs could in theory cause
-              // dropouts that way, but we still need to run this from a thread
-              // to check whether we support it
-              has_realtime_priority_promise_.set_value(
-                  set_realtime_priority(true));
-              set_realtime_priority(false);
-              pthread_setname_np(pthread_self(), "wine-stdio");
-
-              io_context_.run();
-          }) {}
+          recorder_(MessageRecorder::create_from_environment(
+              sockets_.base_dir_,
+              plugin_type_to_string(plugin_type),
+              info_.windows_plugin_path_.string(),
+              plugin_host_->path(),
+              generic_logger_)) {}
 
     virtual ~PluginBridge() noexcept = default;
 
@@ -153,7 +148,7 @@ class PluginBridge {
                  << plugin_type_to_string(info_.plugin_type_) << "'"
                  << std::endl;
         init_msg << "realtime:      ";
-        if (has_realtime_priority_.get()) {
+        if (shared_io_context_->has_realtime_priority()) {
             // Warn if `RLIMIT_RTTIME` is set to some low value. This can happen
             // when using PipeWire.
             if (auto rttime_limit = get_rttime_limit()) {
@@ -269,6 +264,13 @@ class PluginBridge {
         init_msg << "hosting mode:  '";
         if (config_.group) {
             init_msg << "plugin group \"" << *config_.group << "\"";
+        } else if (config_.auto_group) {
+            init_msg << "automatic plugin groups";
+            if (*config_.auto_group > 0) {
+                init_msg << " (" << *config_.auto_group << ")";
+            }
+        } else if (config_.share_plugin_image) {
+            init_msg << "shared plugin image";
         } else {
             init_msg << "individually";
         }
@@ -289,6 +291,16 @@ class PluginBridge {
                 "hack: pipes disabled, plugin output will go to \"" +
                 config_.disable_pipes->string() + "\"");
         }
+        if (config_.audio_buffer_huge_pages) {
+            other_options.push_back("audio buffers: huge pages");
+        }
+        if (config_.audio_thread_cpus) {
+            other_options.push_back(
+                "audio threads: CPUs " +
+                format_cpu_list(*config_.audio_thread_cpus));
+        } else if (config_.audio_thread_cpus_follow_host) {
+            other_options.push_back("audio threads: host's CPUs");
+        }
         if (config_.editor_coordinate_hack) {
             other_options.push_back("editor: coordinate hack");
         }
@@ -307,9 +319,23 @@ class PluginBridge {
                    << *config_.frame_rate << " fps";
             other_options.push_back(option.str());
         }
+        if (config_.idle_frame_rate) {
+            std::ostringstream option;
+            option << "idle frame rate: " << std::setprecision(2)
+                   << *config_.idle_frame_rate << " fps";
+            other_options.push_back(option.str());
+        }
+        if (config_.gui_thread_cpus) {
+            other_options.push_back("GUI thread: CPUs " +
+                                    format_cpu_list(*config_.gui_thread_cpus));
+        }
         if (config_.hide_daw) {
             other_options.push_back("hack: hide DAW name");
         }
+        if (config_.share_plugin_image &&
+            (config_.group || config_.auto_group)) {
+            other_options.push_back("keep module loaded");
+        }
         if (config_.vst3_prefer_32bit) {
             other_options.push_back("vst3: prefer 32-bit");
         }
@@ -361,12 +387,36 @@ class PluginBridge {
     }
 
     /**
-     * Connect the sockets, while starting another thread that will terminate
-     * the plugin (through `std::terminate`/SIGABRT) when the host process fails
-     * to start. This is the only way to stop listening on our sockets without
-     * moving everything over to asynchronous listeners (which may actually be a
-     * good idea just for this use case). Otherwise the plugin would be stuck
-     * loading indefinitely when Wine is not configured correctly.
+     * Load the configuration for `plugin_path` using `load_config_for()`, and
+     * reject options that do nothing for this type of plugin. These options are
+     * listed as invalid in the initialization message.
+     */
+    static Configuration load_plugin_config(
+        PluginType plugin_type,
+        const ghc::filesystem::path& plugin_path) {
+        Configuration config = load_config_for(plugin_path);
+
+        // All instances of a VST3 or CLAP plugin are already hosted in a
+        // single process that loads the plugin's module once. Outside of a
+        // plugin group, `share_plugin_image` would only move that process into
+        // a group host process of its own.
+        if (config.share_plugin_image && plugin_type != PluginType::vst2 &&
+            !config.group && !config.auto_group) {
+            config.share_plugin_image = false;
+            config.invalid_options.emplace_back("share_plugin_image");
+        }
+
+        return config;
+    }
+
+    /**
+     * Connect the sockets, while running a watchdog on the shared IO context
+     * that will terminate the plugin (through `std::terminate`/SIGABRT) when
+     * the host process fails to start. This is the only way to stop listening
+     * on our sockets without moving everything over to asynchronous listeners
+     * (which may actually be a good idea just for this use case). Otherwise
+     * the plugin would be stuck loading indefinitely when Wine is not
+     * configured correctly.
      *
      * TODO: Asynchronously connect our sockets so we can interrupt it, maybe
      */
@@ -374,16 +424,14 @@ class PluginBridge {
 #ifndef WITH_WINEDBG
         // If the Wine process fails to start, then nothing will connect to the
         // sockets and we'll be hanging here indefinitely. To prevent this,
-        // we'll periodically poll whether the Wine process is still running,
-        // and throw when it is not. The alternative would be to rewrite this to
-        // using `async_accept`, Asio timers, and another IO context, but
-        // I feel like this a much simpler solution.
-        host_watchdog_handler_ = std::jthread([&](std::stop_token st) {
-            using namespace std::literals::chrono_literals;
-
-            pthread_setname_np(pthread_self(), "watchdog");
-
-            while (!st.stop_requested()) {
+        // we'll check whether the Wine process is still running when it exits
+        // (or periodically for group hosts), and throw when it is not. These
+        // checks run on the process-wide shared IO context, so loading many
+        // plugins at once doesn't spawn a watchdog thread for every instance.
+        // The watchdog gets unregistered again when `host_watchdog` goes out
+        // of scope.
+        const auto host_watchdog = shared_io_context_->register_watchdog(
+            [&]() {
                 if (!plugin_host_->running()) {
                     generic_logger_.log(
                         "The Wine host process has exited unexpectedly. Check "
@@ -401,16 +449,11 @@ class PluginBridge {
 
                     std::terminate();
                 }
-
-                std::this_thread::sleep_for(20ms);
-            }
-        });
+            },
+            plugin_host_->pid());
 #endif
 
         sockets_.connect();
-#ifndef WITH_WINEDBG
-        host_watchdog_handler_.request_stop();
-#endif
     }
 
     /**
@@ -471,6 +514,17 @@ class PluginBridge {
      */
     Logger generic_logger_;
 
+    /**
+     * The IO context shared by all plugin instances in this process. This
+     * relays the Wine plugin host's STDOUT and STDERR output and runs the
+     * watchdog in `connect_sockets_guarded()`. This has to be declared before
+     * `plugin_host_` so the STDIO relays are closed before the context can be
+     * shut down.
+     *
+     * @see SharedIoContext
+     */
+    std::shared_ptr<SharedIoContext> shared_io_context_;
+
     /**
      * The Wine process hosting our plugins. In the case of group hosts a
      * `PluginBridge` instance doesn't actually own a process, but rather either
@@ -478,35 +532,13 @@ class PluginBridge {
      */
     std::unique_ptr<HostProcess> plugin_host_;
 
-   private:
-    /**
-     * The promise belonging to `has_realtime_priority_` below.
-     */
-    std::promise<bool> has_realtime_priority_promise_;
-
-   public:
-    /**
-     * Whether this process runs with realtime priority. This is set on the
-     * thread that's relaying STDOUT and STDERR output from Wine, hence the need
-     * for a future. We won't change the scheduler properties on the thread
-     * that's initializing the plugin because some DAWs may do that from the UI
-     * thread.
-     */
-    std::future<bool> has_realtime_priority_;
-
     /**
-     * Runs the Asio `io_context_` thread for logging the Wine process
-     * STDOUT and STDERR messages.
-     */
-    std::jthread wine_io_handler_;
-
-   private:
-    /**
-     * A thread used during the initialisation process to terminate listening on
-     * the sockets if the Wine process cannot start for whatever reason. This
-     * has to be defined here instead of in the constructor we can't simply
-     * detach the thread as it has to check whether the VST host is still
-     * running.
+     * Records all messages sent over `sockets_` to a capture file when the
+     * `YABRIDGE_CAPTURE_DIR` environment variable is set, and a null pointer
+     * otherwise. This is created before the sockets get connected in the
+     * derived class' constructor so every connection gets recorded.
+     *
+     * @see MessageRecorder
      */
-    std::jthread host_watchdog_handler_;
+    std::unique_ptr<MessageRecorder> recorder_;
 };
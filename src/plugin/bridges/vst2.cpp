@@ -41,7 +41,7 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
           PluginType::vst2,
           plugin_path,
           [](asio::io_context& io_context, const PluginInfo& info) {
-              return Vst2Sockets<std::jthread>(
+              return Vst2Sockets<NativeThread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path_.filename()
                                              .replace_extension("")
@@ -73,7 +73,7 @@ Vst2PluginBridge::Vst2PluginBridge(const ghc::filesystem::path& plugin_path,
     // For our communication we use simple threads and blocking operations
     // instead of asynchronous IO since communication has to be handled in
     // lockstep anyway
-    host_callback_handler_ = std::jthread([&]() {
+    host_callback_handler_ = NativeThread([&]() {
         set_realtime_priority(true);
         pthread_setname_np(pthread_self(), "host-callbacks");
 
@@ -197,10 +197,6 @@ Vst2PluginBridge::~Vst2PluginBridge() noexcept {
     try {
         // Drop all work make sure all sockets are closed
         plugin_host_->terminate();
-
-        // The `stop()` method will cause the IO context to just drop all of its
-        // outstanding work immediately
-        io_context_.stop();
     } catch (const std::system_error&) {
         // It could be that the sockets have already been closed or that the
         // process has already exited (at which point we probably won't be
@@ -642,8 +638,9 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
                                     ~static_cast<intptr_t>(0), nullptr, 0.0));
     if (returned_time_info) {
         request.current_time_info = *returned_time_info;
+        request.has_current_time_info = true;
     } else {
-        request.current_time_info.reset();
+        request.has_current_time_info = false;
     }
 
     // Some plugisn also ask for the current process level, so we'll prefetch
@@ -656,10 +653,14 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
     const time_t now = time(nullptr);
     if (now > last_audio_thread_priority_synchronization_ +
                   audio_thread_priority_synchronization_interval) {
-        request.new_realtime_priority = get_realtime_priority();
+        const std::optional<int> priority = get_realtime_priority();
+        request.new_realtime_priority = priority.value_or(0);
+        request.has_new_realtime_priority = priority.has_value();
+        request.new_cpu_affinity_mask = get_cpu_affinity_mask().value_or(0);
         last_audio_thread_priority_synchronization_ = now;
     } else {
-        request.new_realtime_priority.reset();
+        request.has_new_realtime_priority = false;
+        request.new_cpu_affinity_mask = 0;
     }
 
     // We reuse this audio buffers object both for the request and the response
@@ -692,12 +693,19 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
     // After writing audio to the shared memory buffers, we'll send the
     // processing request parameters to the Wine plugin host so it can start
     // processing audio. This is why we don't need any explicit synchronisation.
+    const auto round_trip_start = std::chrono::steady_clock::now();
     sockets_.host_plugin_process_replacing_.send(request);
 
-    // From the Wine side we'll send a zero byte struct back as an
-    // acknowledgement that audio processing has finished. At this point the
-    // audio will have been written to our buffers.
-    sockets_.host_plugin_process_replacing_.receive_single<Ack>();
+    // From the Wine side we'll send a response back as an acknowledgement that
+    // audio processing has finished. At this point the audio will have been
+    // written to our buffers. This response also contains the time the plugin
+    // spent processing audio, which we can compare to the total round trip
+    // time to get a sense of the bridging overhead.
+    const auto response = sockets_.host_plugin_process_replacing_
+                              .receive_single<Vst2ProcessRequest::Response>();
+    process_timing_stats_.record(
+        logger_.logger_, response.timing,
+        std::chrono::steady_clock::now() - round_trip_start);
 
     for (int channel = 0; channel < plugin_.numOutputs; channel++) {
         const T* output_channel =
@@ -34,7 +34,7 @@
  * for greppability reasons. The `Plugin` infix is added on the native plugin
  * side.
  */
-class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
+class Vst2PluginBridge : PluginBridge<Vst2Sockets<NativeThread>> {
    public:
     /**
      * Initializes the Wine plugin bridge. This sets up the sockets for event
@@ -138,7 +138,7 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
     /**
      * The thread that handles host callbacks.
      */
-    std::jthread host_callback_handler_;
+    NativeThread host_callback_handler_;
 
     /**
      * A mutex to prevent multiple simultaneous calls to `getParameter()` and
@@ -180,6 +180,12 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      */
     time_t last_audio_thread_priority_synchronization_ = 0;
 
+    /**
+     * Running statistics for the time the plugin spends processing audio,
+     * written to the log periodically when the verbosity is high enough.
+     */
+    ProcessTimingStats process_timing_stats_;
+
     /**
      * The VST host can query a plugin for arbitrary binary data such as
      * presets. It will expect the plugin to write back a pointer that points to
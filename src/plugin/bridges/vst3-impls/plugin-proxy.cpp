@@ -90,6 +90,15 @@ void Vst3PluginProxyImpl::clear_caches() noexcept {
 
     std::lock_guard lock(function_result_cache_mutex_);
     function_result_cache_ = FunctionResultCache{};
+    function_result_cache_generation_++;
+}
+
+void Vst3PluginProxyImpl::clear_unit_info_cache() noexcept {
+    std::lock_guard lock(function_result_cache_mutex_);
+    function_result_cache_.unit_info.reset();
+    function_result_cache_.program_list_info.reset();
+    function_result_cache_.program_names.clear();
+    function_result_cache_generation_++;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setAudioPresentationLatencySamples(
@@ -215,10 +224,12 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     // We'll synchronize the scheduling priority of the audio thread on the Wine
     // plugin host with that of the host's audio thread every once in a while
     std::optional<int> new_realtime_priority = std::nullopt;
+    std::optional<uint64_t> new_cpu_affinity_mask = std::nullopt;
     time_t now = time(nullptr);
     if (now > last_audio_thread_priority_synchronization_ +
                   audio_thread_priority_synchronization_interval) {
         new_realtime_priority = get_realtime_priority();
+        new_cpu_affinity_mask = get_cpu_affinity_mask();
         last_audio_thread_priority_synchronization_ = now;
     }
 
@@ -227,8 +238,11 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     // audio buffers, so they're not stored within the request object itself.
     assert(process_buffers_);
     process_request_.instance_id = instance_id();
-    process_request_.data.repopulate(data, *process_buffers_);
+    process_request_.data.repopulate(data, *process_buffers_,
+                                     process_context_delta_state_,
+                                     process_context_requirements_);
     process_request_.new_realtime_priority = new_realtime_priority;
+    process_request_.new_cpu_affinity_mask = new_cpu_affinity_mask;
 
     // HACK: This is a bit ugly. This `YaProcessData::Response` object actually
     //       contains pointers to the corresponding `YaProcessData` fields in
@@ -246,9 +260,13 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
 
     // We'll also receive the response into an existing object so we can also
     // avoid heap allocations there
+    const auto round_trip_start = std::chrono::steady_clock::now();
     bridge_.receive_audio_processor_message_into(
         MessageReference<YaAudioProcessor::Process>(process_request_),
         process_response_);
+    process_timing_stats_.record(
+        bridge_.logger_.logger_, process_response_.timing,
+        std::chrono::steady_clock::now() - round_trip_start, instance_id());
 
     // At this point the shared audio buffers should contain the output audio,
     // so we'll write that back to the host along with any metadata (which in
@@ -428,6 +446,8 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setActive(TBool state) {
         }
     }
 
+    process_context_requirements_ = response.process_context_requirements;
+
     return response.result;
 }
 
@@ -893,6 +913,33 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getMidiControllerAssignment(
     int16 channel,
     Steinberg::Vst::CtrlNumber midiControllerNumber,
     Steinberg::Vst::ParamID& id /*out*/) {
+    // Hosts will query every single MIDI controller on every channel, so we'll
+    // fetch all assignments for a bus at once and cache them until the plugin
+    // restarts. Anything outside of the ranges we prefetch is still passed
+    // through as is.
+    if (channel >= 0 && channel < YaMidiMapping::num_midi_channels &&
+        midiControllerNumber >= 0 &&
+        midiControllerNumber < Steinberg::Vst::kCountCtrlNumber) {
+        maybe_query_midi_controller_assignments(busIndex);
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (const auto assignments =
+                function_result_cache_.midi_controller_assignments.find(
+                    busIndex);
+            assignments !=
+            function_result_cache_.midi_controller_assignments.end()) {
+            if (const auto& result =
+                    assignments->second[(channel *
+                                         Steinberg::Vst::kCountCtrlNumber) +
+                                        midiControllerNumber]) {
+                id = *result;
+                return Steinberg::kResultOk;
+            } else {
+                return Steinberg::kResultFalse;
+            }
+        }
+    }
+
     const GetMidiControllerAssignmentResponse response =
         bridge_.send_message(YaMidiMapping::GetMidiControllerAssignment{
             .instance_id = instance_id(),
@@ -907,11 +954,17 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getMidiControllerAssignment(
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionCount(int32 busIndex,
                                                              int16 channel) {
-    return bridge_.send_message(
-        YaNoteExpressionController::GetNoteExpressionCount{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel});
+    // These are cached per bus and channel, see `getParameterCount()`
+    maybe_query_note_expression_info(busIndex, channel);
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (const auto infos = function_result_cache_.note_expression_info.find(
+            {busIndex, channel});
+        infos != function_result_cache_.note_expression_info.end()) {
+        return static_cast<int32>(infos->second.size());
+    } else {
+        return 0;
+    }
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionInfo(
@@ -919,16 +972,26 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionInfo(
     int16 channel,
     int32 noteExpressionIndex,
     Steinberg::Vst::NoteExpressionTypeInfo& info /*out*/) {
-    const GetNoteExpressionInfoResponse response =
-        bridge_.send_message(YaNoteExpressionController::GetNoteExpressionInfo{
-            .instance_id = instance_id(),
-            .bus_index = busIndex,
-            .channel = channel,
-            .note_expression_index = noteExpressionIndex});
+    if (noteExpressionIndex < 0) {
+        return Steinberg::kInvalidArgument;
+    }
 
-    info = response.info;
+    maybe_query_note_expression_info(busIndex, channel);
 
-    return response.result;
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (const auto infos = function_result_cache_.note_expression_info.find(
+            {busIndex, channel});
+        infos != function_result_cache_.note_expression_info.end() &&
+        noteExpressionIndex < static_cast<int32>(infos->second.size())) {
+        if (const auto& result = infos->second[noteExpressionIndex]) {
+            info = *result;
+            return Steinberg::kResultOk;
+        } else {
+            return Steinberg::kResultFalse;
+        }
+    } else {
+        return Steinberg::kInvalidArgument;
+    }
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getNoteExpressionStringByValue(
@@ -1165,37 +1228,74 @@ Vst3PluginProxyImpl::setUnitData(Steinberg::Vst::UnitID unitId,
 }
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getUnitCount() {
-    return bridge_.send_message(
-        YaUnitInfo::GetUnitCount{.instance_id = instance_id()});
+    // Just like parameter infos, unit and program list infos are fetched all at
+    // once and cached until the plugin tells the host that they have changed
+    maybe_query_unit_info();
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    return function_result_cache_.unit_info
+               ? static_cast<int32>(function_result_cache_.unit_info->size())
+               : 0;
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::getUnitInfo(int32 unitIndex,
                                  Steinberg::Vst::UnitInfo& info /*out*/) {
-    const GetUnitInfoResponse response =
-        bridge_.send_message(YaUnitInfo::GetUnitInfo{
-            .instance_id = instance_id(), .unit_index = unitIndex});
+    if (unitIndex < 0) {
+        return Steinberg::kInvalidArgument;
+    }
 
-    info = response.info;
+    maybe_query_unit_info();
 
-    return response.result;
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_.unit_info &&
+        unitIndex <
+            static_cast<int32>(function_result_cache_.unit_info->size())) {
+        if (const auto& result =
+                (*function_result_cache_.unit_info)[unitIndex]) {
+            info = *result;
+            return Steinberg::kResultOk;
+        } else {
+            return Steinberg::kResultFalse;
+        }
+    } else {
+        return Steinberg::kInvalidArgument;
+    }
 }
 
 int32 PLUGIN_API Vst3PluginProxyImpl::getProgramListCount() {
-    return bridge_.send_message(
-        YaUnitInfo::GetProgramListCount{.instance_id = instance_id()});
+    maybe_query_program_list_info();
+
+    std::lock_guard lock(function_result_cache_mutex_);
+    return function_result_cache_.program_list_info
+               ? static_cast<int32>(
+                     function_result_cache_.program_list_info->size())
+               : 0;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::getProgramListInfo(
     int32 listIndex,
     Steinberg::Vst::ProgramListInfo& info /*out*/) {
-    const GetProgramListInfoResponse response =
-        bridge_.send_message(YaUnitInfo::GetProgramListInfo{
-            .instance_id = instance_id(), .list_index = listIndex});
+    if (listIndex < 0) {
+        return Steinberg::kInvalidArgument;
+    }
 
-    info = response.info;
+    maybe_query_program_list_info();
 
-    return response.result;
+    std::lock_guard lock(function_result_cache_mutex_);
+    if (function_result_cache_.program_list_info &&
+        listIndex < static_cast<int32>(
+                        function_result_cache_.program_list_info->size())) {
+        if (const auto& result =
+                (*function_result_cache_.program_list_info)[listIndex]) {
+            info = *result;
+            return Steinberg::kResultOk;
+        } else {
+            return Steinberg::kResultFalse;
+        }
+    } else {
+        return Steinberg::kInvalidArgument;
+    }
 }
 
 tresult PLUGIN_API
@@ -1203,6 +1303,27 @@ Vst3PluginProxyImpl::getProgramName(Steinberg::Vst::ProgramListID listId,
                                     int32 programIndex,
                                     Steinberg::Vst::String128 name /*out*/) {
     if (name) {
+        // Hosts will query every program's name when building a program list,
+        // so we'll fetch all names for a program list at once. This only works
+        // for program lists the plugin told us about, so we'll fall back to
+        // fetching individual names for anything else.
+        if (programIndex >= 0 && maybe_query_program_names(listId)) {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (const auto names =
+                    function_result_cache_.program_names.find(listId);
+                names != function_result_cache_.program_names.end() &&
+                programIndex < static_cast<int32>(names->second.size())) {
+                if (const auto& result = names->second[programIndex]) {
+                    std::copy(result->begin(), result->end(), name);
+                    name[result->size()] = 0;
+
+                    return Steinberg::kResultOk;
+                } else {
+                    return Steinberg::kResultFalse;
+                }
+            }
+        }
+
         const GetProgramNameResponse response = bridge_.send_message(
             YaUnitInfo::GetProgramName{.instance_id = instance_id(),
                                        .list_id = listId,
@@ -1358,6 +1479,173 @@ void Vst3PluginProxyImpl::maybe_query_parameter_info() {
     }
 }
 
+void Vst3PluginProxyImpl::maybe_query_midi_controller_assignments(
+    int32 bus_index) {
+    // If the cache gets cleared while we're waiting for the response, then
+    // that response may already be outdated and we'll need to query the plugin
+    // again
+    while (true) {
+        uint64_t generation;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.midi_controller_assignments.contains(
+                    bus_index)) {
+                return;
+            }
+
+            generation = function_result_cache_generation_;
+        }
+
+        GetMidiControllerAssignmentsResponse response = bridge_.send_message(
+            YaMidiMapping::GetMidiControllerAssignments{
+                .instance_id = instance_id(), .bus_index = bus_index});
+
+        // The plugin should always return an assignment for every controller,
+        // but we index into this directly so we can't take any chances
+        response.ids.resize(YaMidiMapping::num_midi_channels *
+                            Steinberg::Vst::kCountCtrlNumber);
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_generation_ == generation) {
+            function_result_cache_.midi_controller_assignments.try_emplace(
+                bus_index, std::move(response.ids));
+            return;
+        }
+    }
+}
+
+void Vst3PluginProxyImpl::maybe_query_note_expression_info(int32 bus_index,
+                                                           int16 channel) {
+    // See `maybe_query_midi_controller_assignments()`
+    while (true) {
+        uint64_t generation;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.note_expression_info.contains(
+                    {bus_index, channel})) {
+                return;
+            }
+
+            generation = function_result_cache_generation_;
+        }
+
+        GetNoteExpressionInfosResponse response = bridge_.send_message(
+            YaNoteExpressionController::GetNoteExpressionInfos{
+                .instance_id = instance_id(),
+                .bus_index = bus_index,
+                .channel = channel});
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_generation_ == generation) {
+            function_result_cache_.note_expression_info.try_emplace(
+                std::pair(bus_index, channel), std::move(response.infos));
+            return;
+        }
+    }
+}
+
+void Vst3PluginProxyImpl::maybe_query_unit_info() {
+    // See `maybe_query_midi_controller_assignments()`
+    while (true) {
+        uint64_t generation;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.unit_info) {
+                return;
+            }
+
+            generation = function_result_cache_generation_;
+        }
+
+        GetUnitInfosResponse response = bridge_.send_message(
+            YaUnitInfo::GetUnitInfos{.instance_id = instance_id()});
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_generation_ == generation) {
+            if (!function_result_cache_.unit_info) {
+                function_result_cache_.unit_info = std::move(response.infos);
+            }
+
+            return;
+        }
+    }
+}
+
+void Vst3PluginProxyImpl::maybe_query_program_list_info() {
+    // See `maybe_query_midi_controller_assignments()`
+    while (true) {
+        uint64_t generation;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.program_list_info) {
+                return;
+            }
+
+            generation = function_result_cache_generation_;
+        }
+
+        GetProgramListInfosResponse response = bridge_.send_message(
+            YaUnitInfo::GetProgramListInfos{.instance_id = instance_id()});
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_generation_ == generation) {
+            if (!function_result_cache_.program_list_info) {
+                function_result_cache_.program_list_info =
+                    std::move(response.infos);
+            }
+
+            return;
+        }
+    }
+}
+
+bool Vst3PluginProxyImpl::maybe_query_program_names(
+    Steinberg::Vst::ProgramListID list_id) {
+    // See `maybe_query_midi_controller_assignments()`. The program count we
+    // query the names for comes from the program list info, so that may also
+    // have changed if the cache was cleared in the meantime.
+    while (true) {
+        maybe_query_program_list_info();
+
+        uint64_t generation;
+        int32 program_count = 0;
+        {
+            std::lock_guard lock(function_result_cache_mutex_);
+            if (function_result_cache_.program_names.contains(list_id)) {
+                return true;
+            }
+
+            if (!function_result_cache_.program_list_info) {
+                return false;
+            }
+
+            const auto list_info = std::find_if(
+                function_result_cache_.program_list_info->begin(),
+                function_result_cache_.program_list_info->end(),
+                [&](const auto& info) { return info && info->id == list_id; });
+            if (list_info == function_result_cache_.program_list_info->end()) {
+                return false;
+            }
+
+            generation = function_result_cache_generation_;
+            program_count = (*list_info)->programCount;
+        }
+
+        GetProgramNamesResponse response =
+            bridge_.send_message(YaUnitInfo::GetProgramNames{
+                .instance_id = instance_id(),
+                .list_id = list_id,
+                .program_count = program_count});
+
+        std::lock_guard lock(function_result_cache_mutex_);
+        if (function_result_cache_generation_ == generation) {
+            function_result_cache_.program_names.try_emplace(
+                list_id, std::move(response.names));
+            return true;
+        }
+    }
+}
+
 void Vst3PluginProxyImpl::clear_bus_cache() noexcept {
     std::lock_guard lock(processing_bus_cache_mutex_);
     if (processing_bus_cache_) {
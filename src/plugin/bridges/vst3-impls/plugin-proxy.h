@@ -76,6 +76,17 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     void clear_caches() noexcept;
 
+    /**
+     * Clear only the cached unit, program list, and program name information.
+     * We'll do this when the plugin calls
+     * `IUnitHandler::notifyProgramListChange()` or
+     * `IUnitHandler::notifyUnitByBusChange()`, before passing that call on to
+     * the host.
+     *
+     * @see function_result_cache_
+     */
+    void clear_unit_info_cache() noexcept;
+
     // From `IAudioPresentationLatency`
     tresult PLUGIN_API
     setAudioPresentationLatencySamples(Steinberg::Vst::BusDirection dir,
@@ -406,6 +417,47 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     void maybe_query_parameter_info();
 
+    /**
+     * Query all MIDI controller assignments for an event bus and write the
+     * results to `function_result_cache_` if necessary. Unlike
+     * `maybe_query_parameter_info()`, the cache is not locked while waiting for
+     * the Wine plugin host to respond, so the plugin can still notify the host
+     * about changes during that time. If the cache gets cleared while waiting,
+     * then the response is discarded and the plugin is queried again. The same
+     * applies to the other `maybe_query_*()` functions below.
+     */
+    void maybe_query_midi_controller_assignments(int32 bus_index);
+
+    /**
+     * Query all note expression infos for a channel on an event bus and write
+     * the results to `function_result_cache_` if necessary.
+     */
+    void maybe_query_note_expression_info(int32 bus_index, int16 channel);
+
+    /**
+     * Query information for all of the plugin's units and write the results to
+     * `function_result_cache_` if necessary.
+     */
+    void maybe_query_unit_info();
+
+    /**
+     * Query information for all of the plugin's program lists and write the
+     * results to `function_result_cache_` if necessary.
+     */
+    void maybe_query_program_list_info();
+
+    /**
+     * Query the names of all programs in a program list and write the results
+     * to `function_result_cache_` if necessary. This needs the list's program
+     * count, so `maybe_query_program_list_info()` should have been called
+     * first.
+     *
+     * @return Whether the program list is known and its names are now cached.
+     *   If this returns false, then the name should be queried using a single
+     *   `GetProgramName` call instead.
+     */
+    bool maybe_query_program_names(Steinberg::Vst::ProgramListID list_id);
+
     /**
      * Clear the bus count and information cache. We need this cache for REAPER
      * as it makes `num_inputs + num_outputs + 2` function calls to retrieve
@@ -469,6 +521,30 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     YaAudioProcessor::ProcessResponse process_response_;
 
+    /**
+     * The process context we sent to the Wine plugin host during the last
+     * processing cycle. This is used to delta encode the process context in
+     * `process_request_`, so we only send the fields that changed.
+     */
+    TransportDeltaState<Steinberg::Vst::ProcessContext>
+        process_context_delta_state_;
+
+    /**
+     * The flags the plugin returned from
+     * `IProcessContextRequirements::getProcessContextRequirements()` when it
+     * was last activated, or a nullopt if the plugin doesn't implement that
+     * interface. The Wine plugin host queries these during
+     * `IComponent::setActive()`. This is used to only send the parts of the
+     * process context the plugin asked for.
+     */
+    std::optional<uint32> process_context_requirements_;
+
+    /**
+     * Running statistics for the time the plugin spends processing audio,
+     * written to the log periodically when the verbosity is high enough.
+     */
+    ProcessTimingStats process_timing_stats_;
+
     /**
      * A shared memory object to share audio buffers between the native plugin
      * and the Wine plugin host. Copying audio is the most significant source of
@@ -550,6 +626,51 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
          */
         std::vector<std::optional<Steinberg::Vst::ParameterInfo>>
             parameter_info;
+        /**
+         * Memoizes `IMidiMapping::getMidiControllerAssignment()` per event bus.
+         * Hosts will call this function for every possible MIDI controller on
+         * every channel, which would otherwise result in thousands of round
+         * trips when loading a plugin. These are indexed by `channel *
+         * Steinberg::Vst::kCountCtrlNumber + midi_controller_number`, and
+         * contain nullopts for unassigned controllers.
+         */
+        std::map<int32, std::vector<std::optional<Steinberg::Vst::ParamID>>>
+            midi_controller_assignments;
+        /**
+         * Memoizes `INoteExpressionController::getNoteExpressionCount()` and
+         * `INoteExpressionController::getNoteExpressionInfo()` per event bus
+         * and channel.
+         */
+        std::map<std::pair<int32, int16>,
+                 std::vector<
+                     std::optional<Steinberg::Vst::NoteExpressionTypeInfo>>>
+            note_expression_info;
+        /**
+         * Memoizes `IUnitInfo::getUnitCount()` and `IUnitInfo::getUnitInfo()`.
+         * A nullopt means that this information has not yet been queried.
+         *
+         * @see clear_unit_info_cache
+         */
+        std::optional<std::vector<std::optional<Steinberg::Vst::UnitInfo>>>
+            unit_info;
+        /**
+         * Memoizes `IUnitInfo::getProgramListCount()` and
+         * `IUnitInfo::getProgramListInfo()`.
+         *
+         * @see clear_unit_info_cache
+         */
+        std::optional<
+            std::vector<std::optional<Steinberg::Vst::ProgramListInfo>>>
+            program_list_info;
+        /**
+         * Memoizes `IUnitInfo::getProgramName()` per program list, indexed by
+         * program index.
+         *
+         * @see clear_unit_info_cache
+         */
+        std::map<Steinberg::Vst::ProgramListID,
+                 std::vector<std::optional<std::u16string>>>
+            program_names;
     };
 
     /**
@@ -567,5 +688,14 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      * @see clear_caches
      */
     FunctionResultCache function_result_cache_;
+    /**
+     * Incremented every time (part of) `function_result_cache_` gets cleared.
+     * The `maybe_query_*()` functions that don't hold on to the lock while
+     * waiting for the plugin's response use this to detect that the cache was
+     * cleared in the meantime, in which case the response may already be
+     * outdated and should not be cached. Protected by
+     * `function_result_cache_mutex_`.
+     */
+    uint64_t function_result_cache_generation_ = 0;
     std::mutex function_result_cache_mutex_;
 };
@@ -29,7 +29,7 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
           PluginType::vst3,
           plugin_path,
           [](asio::io_context& io_context, const PluginInfo& info) {
-              return Vst3Sockets<std::jthread>(
+              return Vst3Sockets<NativeThread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path_.filename()
                                              .replace_extension("")
@@ -48,7 +48,7 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
     // messaging mechanism is how we relay the VST3 communication protocol. As a
     // first thing, the Wine plugin host will ask us for a copy of the
     // configuration.
-    host_callback_handler_ = std::jthread([&]() {
+    host_callback_handler_ = NativeThread([&]() {
         set_realtime_priority(true);
         pthread_setname_np(pthread_self(), "host-callbacks");
 
@@ -396,6 +396,11 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
+                    // The host will likely query the program list's names
+                    // again in response to this, so the cached program lists
+                    // and names need to be invalidated first
+                    proxy_object.clear_unit_info_cache();
+
                     return proxy_object.unit_handler_->notifyProgramListChange(
                         request.list_id, request.program_index);
                 },
@@ -404,6 +409,8 @@ Vst3PluginBridge::Vst3PluginBridge(const ghc::filesystem::path& plugin_path)
                     const auto& [proxy_object, _] =
                         get_proxy(request.owner_instance_id);
 
+                    proxy_object.clear_unit_info_cache();
+
                     return proxy_object.unit_handler_2_
                         ->notifyUnitByBusChange();
                 },
@@ -415,7 +422,6 @@ Vst3PluginBridge::~Vst3PluginBridge() noexcept {
     try {
         // Drop all work make sure all sockets are closed
         plugin_host_->terminate();
-        io_context_.stop();
     } catch (const std::system_error&) {
         // It could be that the sockets have already been closed or that the
         // process has already exited (at which point we probably won't be
@@ -46,7 +46,7 @@ class Vst3PluginProxyImpl;
  * for greppability reasons. The `Plugin` infix is added on the native plugin
  * side.
  */
-class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
+class Vst3PluginBridge : PluginBridge<Vst3Sockets<NativeThread>> {
    public:
     /**
      * Initializes the VST3 module by starting and setting up communicating with
@@ -201,7 +201,7 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      * Handles callbacks from the plugin to the host over the
      * `plugin_host_callback_` sockets.
      */
-    std::jthread host_callback_handler_;
+    NativeThread host_callback_handler_;
 
     /**
      * Our plugin factory. All information about the plugin and its supported
@@ -244,5 +244,5 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      * execute functions from that same calling thread while we're waiting for a
      * response. This is used in `Vst3PlugViewProxyImpl::run_loop_tasks()`.
      */
-    MutualRecursionHelper<std::jthread> mutual_recursion_;
+    MutualRecursionHelper<NativeThread> mutual_recursion_;
 };
@@ -16,6 +16,7 @@
 
 #include "host-process.h"
 
+#include <asio/post.hpp>
 #include <asio/read_until.hpp>
 
 #include "../common/utils.h"
@@ -23,7 +24,44 @@
 namespace fs = ghc::filesystem;
 
 HostProcess::HostProcess(asio::io_context& io_context, Sockets& sockets)
-    : sockets_(sockets), stdout_pipe_(io_context), stderr_pipe_(io_context) {}
+    : sockets_(sockets),
+      stdout_relay_(std::make_shared<StdioRelay>(io_context, "[Wine STDOUT] ")),
+      stderr_relay_(
+          std::make_shared<StdioRelay>(io_context, "[Wine STDERR] ")) {}
+
+HostProcess::~HostProcess() noexcept {
+    // The pipes may only be touched from the IO context's thread. Closing them
+    // cancels the pending reads, after which the relays will be freed.
+    for (auto& relay : {stdout_relay_, stderr_relay_}) {
+        asio::post(relay->pipe.get_executor(),
+                   [relay]() { relay->pipe.close(); });
+    }
+}
+
+HostProcess::StdioRelay::StdioRelay(asio::io_context& io_context,
+                                    std::string prefix)
+    : pipe(io_context), prefix(std::move(prefix)) {}
+
+void HostProcess::StdioRelay::relay_lines(std::shared_ptr<StdioRelay> relay) {
+    // This is `Logger::async_log_pipe_lines()`, but with the relay kept alive
+    // by the completion handler
+    StdioRelay& self = *relay;
+    asio::async_read_until(
+        self.pipe, self.buffer, '\n',
+        [relay = std::move(relay)](const std::error_code& error, size_t) {
+            // When we get an error code then that likely means that the pipe
+            // has been closed and we have reached the end of the file
+            if (error) {
+                return;
+            }
+
+            std::string line;
+            std::getline(std::istream(&relay->buffer), line);
+            relay->logger->log(relay->prefix + line);
+
+            relay_lines(relay);
+        });
+}
 
 Process::Handle HostProcess::launch_host(
     const ghc::filesystem::path& host_path,
@@ -78,7 +116,8 @@ Process::Handle HostProcess::launch_host(
         //       nondescriptive `JS_EXEC_FAILED` error message.
         config.disable_pipes
             ? child.spawn_child_redirected(*config.disable_pipes)
-            : child.spawn_child_piped(stdout_pipe_, stderr_pipe_));
+            : child.spawn_child_piped(stdout_relay_->pipe,
+                                        stderr_relay_->pipe));
 
     // See the above comment
     if (config.disable_pipes) {
@@ -90,10 +129,10 @@ Process::Handle HostProcess::launch_host(
         // Print the Wine host's STDOUT and STDERR streams to the log file. This
         // should be done before trying to accept the sockets as otherwise we
         // will miss all output.
-        logger.async_log_pipe_lines(stdout_pipe_, stdout_buffer_,
-                                    "[Wine STDOUT] ");
-        logger.async_log_pipe_lines(stderr_pipe_, stderr_buffer_,
-                                    "[Wine STDERR] ");
+        for (auto& relay : {stdout_relay_, stderr_relay_}) {
+            relay->logger.emplace(logger);
+            StdioRelay::relay_lines(relay);
+        }
     }
 
     return child_handle;
@@ -148,12 +187,16 @@ bool IndividualHost::running() {
     return handle_.running();
 }
 
+std::optional<pid_t> IndividualHost::pid() noexcept {
+    return handle_.pid();
+}
+
 void IndividualHost::terminate() {
     // NOTE: This technically shouldn't be needed, but in Wine 6.5 sending
     //       SIGKILL to a Wine process no longer terminates the threads spawned
     //       by that process, so if we don't manually close the sockets there
     //       will still be threads listening on those sockets which in turn also
-    //       prevents us from joining our `std::jthread`s on the plugin side.
+    //       prevents us from joining our threads on the plugin side.
     sockets_.close();
 
     // This will also reap the terminated process
@@ -179,8 +222,24 @@ GroupHost::GroupHost(asio::io_context& io_context,
     // will try to connect to the socket once more in the case that another
     // process is now listening on it.
     const fs::path endpoint_base_dir = sockets.base_dir_;
+    std::string group_name;
+    if (config.group) {
+        group_name = *config.group;
+    } else if (config.auto_group) {
+        group_name = choose_auto_group(
+            plugin_info.normalize_wine_prefix(), plugin_info.plugin_arch_,
+            *config.auto_group, host_request.endpoint_base_dir);
+        logger.log("Automatically placing this plugin in plugin group \"" +
+                   group_name + "\"");
+    } else {
+        // With `share_plugin_image` every plugin gets a group of its own
+        assert(config.share_plugin_image);
+        group_name = "image-" + std::to_string(std::hash<std::string>{}(
+                                    plugin_info.windows_plugin_path_.string()));
+    }
+
     const fs::path group_socket_path = generate_group_endpoint(
-        *config.group, plugin_info.normalize_wine_prefix(),
+        group_name, plugin_info.normalize_wine_prefix(),
         plugin_info.plugin_arch_);
     const auto connect = [&io_context, host_request, endpoint_base_dir,
                           group_socket_path]() {
@@ -206,7 +265,7 @@ GroupHost::GroupHost(asio::io_context& io_context,
         group_host.detach();
 
         group_host_connect_handler_ =
-            std::jthread([this, connect, group_host = std::move(group_host)]() {
+            NativeThread([this, connect, group_host = std::move(group_host)]() {
                 set_realtime_priority(true);
                 pthread_setname_np(pthread_self(), "group-connect");
 
@@ -251,6 +310,13 @@ bool GroupHost::running() noexcept {
     return !startup_failed_;
 }
 
+std::optional<pid_t> GroupHost::pid() noexcept {
+    // We may be connecting to a group host process spawned by another plugin
+    // instance, and `startup_failed_` is only set after the connection thread
+    // has given up, so this needs to be polled
+    return std::nullopt;
+}
+
 void GroupHost::terminate() {
     // There's no need to manually terminate group host processes as they will
     // shut down automatically after all plugins have exited. Manually closing
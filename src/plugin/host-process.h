@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <thread>
 
 #include <asio/local/stream_protocol.hpp>
@@ -37,7 +39,12 @@
  */
 class HostProcess {
    public:
-    virtual ~HostProcess() noexcept = default;
+    /**
+     * Closes the STDIO redirection pipes. Since the IO context may be shared
+     * with other plugin instances and thus outlive this object, the relays are
+     * only freed after their last pending read has been cancelled.
+     */
+    virtual ~HostProcess() noexcept;
 
     /**
      * Return the full path to the host application in use. The host application
@@ -52,6 +59,13 @@ class HostProcess {
      */
     virtual bool running() = 0;
 
+    /**
+     * The process ID of the Wine plugin host process, if this object owns one.
+     * This lets the watchdog wait for the process to exit instead of having to
+     * poll `running()`.
+     */
+    virtual std::optional<pid_t> pid() noexcept = 0;
+
     /**
      * Kill the process or cause the plugin that's being hosted to exit.
      */
@@ -101,17 +115,38 @@ class HostProcess {
     Sockets& sockets_;
 
    private:
+    /**
+     * Everything needed to forward one of the Wine process' output streams to
+     * the logger. This is shared with the pending read operations on the IO
+     * context, so it stays alive until those have finished.
+     */
+    struct StdioRelay {
+        StdioRelay(asio::io_context& io_context, std::string prefix);
+
+        /**
+         * Read the next line from `pipe`, log it, and repeat until the pipe
+         * gets closed.
+         */
+        static void relay_lines(std::shared_ptr<StdioRelay> relay);
+
+        asio::posix::stream_descriptor pipe;
+        asio::streambuf buffer;
+        /**
+         * A copy of the plugin instance's logger, since the plugin instance
+         * may be gone by the time the last line gets relayed.
+         */
+        std::optional<Logger> logger;
+        const std::string prefix;
+    };
+
     /**
      * The STDOUT stream of the Wine process we can forward to the logger.
      */
-    asio::posix::stream_descriptor stdout_pipe_;
+    std::shared_ptr<StdioRelay> stdout_relay_;
     /**
      * The STDERR stream of the Wine process we can forward to the logger.
      */
-    asio::posix::stream_descriptor stderr_pipe_;
-
-    asio::streambuf stdout_buffer_;
-    asio::streambuf stderr_buffer_;
+    std::shared_ptr<StdioRelay> stderr_relay_;
 };
 
 /**
@@ -149,6 +184,7 @@ class IndividualHost : public HostProcess {
 
     ghc::filesystem::path path() override;
     bool running() override;
+    std::optional<pid_t> pid() noexcept override;
     void terminate() override;
 
    private:
@@ -179,7 +215,10 @@ class GroupHost : public HostProcess {
      * @param logger The `Logger` instance the redirected STDIO streams will be
      *   written to.
      * @param config The configuration for this plugin instance. The group name
-     *   will be retrieved from here.
+     *   will be retrieved from here. If only `auto_group` is set, then the
+     *   group will be chosen using `choose_auto_group()`. If only
+     *   `share_plugin_image` is set, then the group is derived from the
+     *   plugin's path.
      * @param sockets The socket endpoints that will be used for communication
      *   with the plugin. When the plugin shuts down, we'll close all of the
      *   sockets used by the plugin.
@@ -197,6 +236,7 @@ class GroupHost : public HostProcess {
 
     ghc::filesystem::path path() override;
     bool running() noexcept override;
+    std::optional<pid_t> pid() noexcept override;
     void terminate() override;
 
    private:
@@ -230,5 +270,5 @@ class GroupHost : public HostProcess {
      * TODO: Replace the polling with inotify to prevent delays and to reduce
      *       wasting resources
      */
-    std::jthread group_host_connect_handler_;
+    NativeThread group_host_connect_handler_;
 };
@@ -16,19 +16,161 @@
 
 #include "utils.h"
 
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
 #include <sstream>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <asio/post.hpp>
 
 // Generated inside of the build directory
 #include <config.h>
 
 #include "../common/configuration.h"
+#include "../common/group-status.h"
 #include "../common/notifications.h"
 #include "../common/toml++.h"
 #include "../common/utils.h"
 
 namespace fs = ghc::filesystem;
 
+/**
+ * How long the result of searching for a `yabridge.toml` file starting from a
+ * directory gets reused. When a project gets loaded, all plugins are usually
+ * loaded within a couple of seconds so this avoids walking up the directory
+ * tree hundreds of times, while new `yabridge.toml` files created later will
+ * still be picked up.
+ */
+constexpr std::chrono::seconds config_search_cache_duration(10);
+
+/**
+ * The maximum number of entries in the caches below. Hosts that scan large
+ * plugin directories during a long session would otherwise keep adding new
+ * entries for every plugin path and directory they have ever seen. Looking
+ * these up again is cheap compared to parsing a `yabridge.toml` file, so once a
+ * cache gets this large we simply start over.
+ */
+constexpr size_t max_config_cache_entries = 1024;
+
+/**
+ * When `auto_group` is enabled without an explicit number of groups, we'll use
+ * one group host process for every this many CPU cores.
+ */
+constexpr unsigned int cpu_cores_per_auto_group = 4;
+
+/**
+ * How much the audio and GUI thread loads weigh in when comparing groups in
+ * `choose_auto_group()`, relative to a single hosted plugin instance. A fully
+ * loaded main thread is the main reason not to put everything in a single
+ * group, so that weighs in the most.
+ */
+constexpr double auto_group_audio_load_weight = 4.0;
+constexpr double auto_group_gui_load_weight = 8.0;
+
+namespace {
+
+/**
+ * A line in the journal used by `choose_auto_group()`.
+ */
+struct AutoGroupPlacement {
+    uint32_t group_idx;
+    uint64_t placed_ns;
+    /**
+     * The placed plugin's socket endpoint base directory. The group host lists
+     * these in `GroupHostStatus::recently_accepted` once it accepts the plugin.
+     */
+    std::string endpoint_base_dir;
+};
+
+/**
+ * The result of searching for a `yabridge.toml` file, starting from some
+ * directory.
+ */
+struct CachedConfigSearch {
+    std::optional<fs::path> config_file;
+    std::chrono::steady_clock::time_point searched_at;
+};
+
+/**
+ * A parsed `yabridge.toml` file, and the configurations for up to
+ * `max_config_cache_entries` plugins that have been matched against it so far.
+ * The file's identity and modification time are used to detect changes, and
+ * the matches are discarded together with the parsed file when it changes.
+ */
+struct CachedConfigFile {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    timespec modified;
+
+    ConfigFile file;
+    std::unordered_map<std::string, Configuration> matches;
+
+    bool is_up_to_date(const struct stat& info) const noexcept {
+        return info.st_dev == device && info.st_ino == inode &&
+               info.st_size == size &&
+               info.st_mtim.tv_sec == modified.tv_sec &&
+               info.st_mtim.tv_nsec == modified.tv_nsec;
+    }
+};
+
+/**
+ * These caches are shared between all plugin instances in this process. Since
+ * plugins may be loaded from multiple threads at once, all access goes through
+ * `config_cache_mutex`.
+ */
+std::mutex config_cache_mutex;
+std::unordered_map<std::string, CachedConfigSearch> config_search_cache;
+std::unordered_map<std::string, CachedConfigFile> config_file_cache;
+
+/**
+ * `find_dominating_file("yabridge.toml", yabridge_path)`, but with the search
+ * from `yabridge_path`'s parent directory upwards being cached for
+ * `config_search_cache_duration`. Must be called with `config_cache_mutex`
+ * held.
+ */
+std::optional<fs::path> find_config_file(const fs::path& yabridge_path) {
+    // VST3 plugins may be loaded from a bundle directory, which can contain its
+    // own config file
+    if (const fs::path candidate = yabridge_path / "yabridge.toml";
+        fs::exists(candidate)) {
+        return candidate;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const fs::path directory = yabridge_path.parent_path();
+    if (config_search_cache.size() >= max_config_cache_entries) {
+        std::erase_if(config_search_cache, [&](const auto& entry) {
+            return now - entry.second.searched_at >
+                   config_search_cache_duration;
+        });
+        if (config_search_cache.size() >= max_config_cache_entries) {
+            config_search_cache.clear();
+        }
+    }
+
+    CachedConfigSearch& search = config_search_cache[directory.string()];
+    if (search.searched_at == std::chrono::steady_clock::time_point{} ||
+        now - search.searched_at > config_search_cache_duration) {
+        search.config_file = find_dominating_file("yabridge.toml", directory);
+        search.searched_at = now;
+    }
+
+    return search.config_file;
+}
+
+}  // namespace
+
 // These functions are used to populate the fields in `PluginInfo`. See the
 // docstrings for the corresponding fields for more information on what we're
 // actually doing here.
@@ -322,6 +464,237 @@ std::variant<OverridenWinePrefix, fs::path, DefaultWinePrefix> find_wine_prefix(
     return dosdevices_dir->parent_path();
 }
 
+void ProcessTimingStats::record(Logger& logger,
+                                const ProcessTiming& timing,
+                                std::chrono::steady_clock::duration round_trip,
+                                std::optional<size_t> instance_id) {
+    if (logger.verbosity_ < Logger::Verbosity::most_events) [[likely]] {
+        return;
+    }
+
+    const uint64_t round_trip_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(round_trip)
+            .count());
+
+    num_cycles_++;
+    cpu_time_.add(timing.cpu_time_ns);
+    wall_time_.add(timing.wall_time_ns);
+    overhead_.add(round_trip_ns > timing.wall_time_ns
+                      ? round_trip_ns - timing.wall_time_ns
+                      : 0);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - window_start_ < report_interval) {
+        return;
+    }
+
+    const auto format_accumulator = [&](const Accumulator& accumulator) {
+        std::ostringstream formatted;
+        formatted << std::fixed << std::setprecision(1)
+                  << (accumulator.total_ns / num_cycles_) / 1000.0
+                  << " us avg, " << accumulator.peak_ns / 1000.0 << " us peak";
+
+        return formatted.str();
+    };
+
+    std::ostringstream message;
+    if (instance_id) {
+        message << "[instance #" << *instance_id << "] ";
+    }
+    message << "Processed " << num_cycles_
+            << " buffers, plugin CPU time: " << format_accumulator(cpu_time_)
+            << ", plugin wall time: " << format_accumulator(wall_time_)
+            << ", bridging overhead: " << format_accumulator(overhead_);
+    logger.log(message.str());
+
+    *this = ProcessTimingStats{};
+}
+
+NativeThread::NativeThread() noexcept {}
+
+NativeThread::~NativeThread() noexcept {
+    if (handle_) {
+        pthread_join(*handle_, nullptr);
+    }
+}
+
+NativeThread::NativeThread(NativeThread&& o) noexcept
+    : handle_(std::move(o.handle_)) {
+    o.handle_.reset();
+}
+
+NativeThread& NativeThread::operator=(NativeThread&& o) noexcept {
+    // Just like `std::jthread`, we'll wait for the old thread to finish first
+    if (handle_) {
+        pthread_join(*handle_, nullptr);
+    }
+
+    handle_ = std::move(o.handle_);
+    o.handle_.reset();
+
+    return *this;
+}
+
+void NativeThread::start(void* (*entry_point)(void*), void* data) {
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+
+    // A stack size of zero means that we should use glibc's default, which is
+    // based on `RLIMIT_STACK` and is usually 8 MiB
+    if (const size_t stack_size = get_thread_stack_size(); stack_size > 0) {
+        pthread_attr_setstacksize(
+            &attributes,
+            std::max(stack_size, static_cast<size_t>(PTHREAD_STACK_MIN)));
+    }
+
+    pthread_t thread;
+    const int error =
+        pthread_create(&thread, &attributes, entry_point, data);
+    pthread_attr_destroy(&attributes);
+    if (error != 0) {
+        throw std::system_error(error, std::system_category(),
+                                "Could not create a new thread");
+    }
+
+    handle_ = thread;
+}
+
+std::shared_ptr<SharedIoContext> SharedIoContext::acquire() {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<SharedIoContext> instance;
+
+    std::lock_guard lock(instance_mutex);
+    if (auto existing_instance = instance.lock()) {
+        return existing_instance;
+    }
+
+    // The constructor is private, so we can't use `std::make_shared()`
+    std::shared_ptr<SharedIoContext> new_instance(new SharedIoContext());
+    instance = new_instance;
+
+    return new_instance;
+}
+
+SharedIoContext::SharedIoContext()
+    : context_(),
+      work_guard_(asio::make_work_guard(context_)),
+      watchdog_timer_(context_) {
+    std::promise<bool> has_realtime_priority_promise;
+    has_realtime_priority_ = has_realtime_priority_promise.get_future().share();
+
+    thread_ = NativeThread(
+        [this](std::promise<bool> has_realtime_priority_promise) {
+            // We no longer run this thread with realtime scheduling because
+            // plugins that produce a lot of FIXMEs could in theory cause
+            // dropouts that way, but we still need to run this from a thread
+            // to check whether we support it
+            has_realtime_priority_promise.set_value(
+                set_realtime_priority(true));
+            set_realtime_priority(false);
+            pthread_setname_np(pthread_self(), "yabridge-io");
+
+            context_.run();
+        },
+        std::move(has_realtime_priority_promise));
+}
+
+SharedIoContext::~SharedIoContext() noexcept {
+    work_guard_.reset();
+    context_.stop();
+
+    // The thread gets joined here, since it's the first member to be destroyed
+}
+
+bool SharedIoContext::has_realtime_priority() const {
+    return has_realtime_priority_.get();
+}
+
+SharedIoContext::WatchdogGuard::WatchdogGuard(SharedIoContext& context,
+                                              size_t watchdog_id) noexcept
+    : context_(context), watchdog_id_(watchdog_id) {}
+
+SharedIoContext::WatchdogGuard::~WatchdogGuard() noexcept {
+    // The watchdogs are run while holding this mutex, so once we've removed
+    // the watchdog it can no longer be running
+    std::lock_guard lock(context_.watchdogs_mutex_);
+    const auto watchdog = context_.watchdogs_.find(watchdog_id_);
+    if (watchdog == context_.watchdogs_.end()) {
+        return;
+    }
+
+    // The pidfd may only be touched from the IO context's thread. Closing it
+    // cancels the pending wait, which then frees the pidfd.
+    if (auto pidfd = watchdog->second.pidfd) {
+        asio::post(context_.context_, [pidfd]() { pidfd->close(); });
+    }
+
+    context_.watchdogs_.erase(watchdog);
+}
+
+SharedIoContext::WatchdogGuard SharedIoContext::register_watchdog(
+    std::function<void()> check,
+    std::optional<pid_t> pid) {
+    std::lock_guard lock(watchdogs_mutex_);
+    const size_t watchdog_id = next_watchdog_id_++;
+
+    if (const int pidfd_fd = pid ? open_pidfd(*pid) : -1; pidfd_fd != -1) {
+        auto pidfd = std::make_shared<asio::posix::stream_descriptor>(
+            context_, pidfd_fd);
+        watchdogs_.emplace(watchdog_id, Watchdog{.check = std::move(check),
+                                                 .pidfd = pidfd});
+
+        // The pidfd becomes readable once the process has exited
+        pidfd->async_wait(
+            asio::posix::stream_descriptor::wait_read,
+            [this, watchdog_id, pidfd](const std::error_code& error) {
+                if (error.failed()) {
+                    return;
+                }
+
+                std::lock_guard lock(watchdogs_mutex_);
+                if (const auto watchdog = watchdogs_.find(watchdog_id);
+                    watchdog != watchdogs_.end()) {
+                    watchdog->second.check();
+                }
+            });
+    } else {
+        watchdogs_.emplace(
+            watchdog_id, Watchdog{.check = std::move(check), .pidfd = nullptr});
+
+        // The timer only runs while there are watchdogs to poll
+        if (!watchdogs_scheduled_) {
+            watchdogs_scheduled_ = true;
+            asio::post(context_, [this]() { schedule_watchdogs(); });
+        }
+    }
+
+    return WatchdogGuard(*this, watchdog_id);
+}
+
+void SharedIoContext::schedule_watchdogs() {
+    watchdog_timer_.expires_after(watchdog_interval);
+    watchdog_timer_.async_wait([this](const std::error_code& error) {
+        if (error.failed()) {
+            return;
+        }
+
+        std::lock_guard lock(watchdogs_mutex_);
+        bool has_polled_watchdogs = false;
+        for (const auto& [_, watchdog] : watchdogs_) {
+            if (!watchdog.pidfd) {
+                watchdog.check();
+                has_polled_watchdogs = true;
+            }
+        }
+
+        if (has_polled_watchdogs) {
+            schedule_watchdogs();
+        } else {
+            watchdogs_scheduled_ = false;
+        }
+    });
+}
+
 bool equals_case_insensitive(const std::string& a, const std::string& b) {
     return std::equal(a.begin(), a.end(), b.begin(),
                       [](const char& a_char, const char& b_char) {
@@ -340,6 +713,32 @@ std::string join_quoted_strings(std::vector<std::string>& strings) {
     return joined_strings.str();
 }
 
+std::string format_cpu_list(const std::vector<uint16_t>& cpus) {
+    std::vector<uint16_t> sorted_cpus(cpus);
+    std::sort(sorted_cpus.begin(), sorted_cpus.end());
+    sorted_cpus.erase(std::unique(sorted_cpus.begin(), sorted_cpus.end()),
+                      sorted_cpus.end());
+
+    // Consecutive CPUs are collapsed into `first-last` ranges
+    std::ostringstream formatted_cpus{};
+    for (size_t i = 0; i < sorted_cpus.size();) {
+        size_t range_end = i;
+        while (range_end + 1 < sorted_cpus.size() &&
+               sorted_cpus[range_end + 1] == sorted_cpus[range_end] + 1) {
+            range_end++;
+        }
+
+        formatted_cpus << (i == 0 ? "" : ",") << sorted_cpus[i];
+        if (range_end > i) {
+            formatted_cpus << "-" << sorted_cpus[range_end];
+        }
+
+        i = range_end + 1;
+    }
+
+    return formatted_cpus.str();
+}
+
 std::string create_logger_prefix(const fs::path& endpoint_base_dir) {
     // Use the name of the base directory used for our sockets as the logger
     // prefix, but strip the `yabridge-` part since that's redundant
@@ -398,36 +797,188 @@ ghc::filesystem::path generate_group_endpoint(
     return get_temporary_directory() / socket_name.str();
 }
 
+std::string choose_auto_group(const fs::path& wine_prefix,
+                              const LibArchitecture architecture,
+                              uint32_t num_groups,
+                              const std::string& endpoint_base_dir) {
+    if (num_groups == 0) {
+        num_groups = std::max(
+            1u, std::thread::hardware_concurrency() / cpu_cores_per_auto_group);
+    }
+
+    // The journal's lock makes sure that plugins loaded at the same time see
+    // each other's placements. The journal itself contains a `<group_idx>
+    // <time_ns> <endpoint_base_dir>` line for every recent placement. If
+    // anything goes wrong here we'll still pick a group, just without the
+    // journal.
+    const fs::path journal_path =
+        generate_group_endpoint("auto", wine_prefix, architecture)
+            .replace_extension(".journal");
+    const int journal_fd =
+        open(journal_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (journal_fd != -1) {
+        flock(journal_fd, LOCK_EX);
+    }
+
+    std::vector<GroupHostStatus> statuses(num_groups);
+    for (uint32_t i = 0; i < num_groups; i++) {
+        if (auto status = GroupHostStatus::read(group_status_path(
+                generate_group_endpoint("auto-" + std::to_string(i),
+                                        wine_prefix, architecture)))) {
+            statuses[i] = *status;
+        }
+    }
+
+    // Placements the group host has not yet reported as accepted are counted
+    // as pending instances. Other plugins may still be connecting to the same
+    // group, so this has to be checked for every placement individually.
+    const uint64_t now_ns = group_status_time_ns();
+    const uint64_t placement_timeout_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            group_status_accept_history)
+            .count();
+    std::vector<AutoGroupPlacement> placements;
+    std::vector<uint64_t> pending_instances(num_groups, 0);
+    if (journal_fd != -1) {
+        std::ifstream journal(journal_path.string());
+        for (std::string line; std::getline(journal, line);) {
+            AutoGroupPlacement placement{};
+            std::istringstream line_stream(line);
+            if (!(line_stream >> placement.group_idx >> placement.placed_ns) ||
+                line_stream.get() != ' ' ||
+                !std::getline(line_stream, placement.endpoint_base_dir)) {
+                continue;
+            }
+
+            if (placement.group_idx >= num_groups ||
+                placement.placed_ns + placement_timeout_ns < now_ns) {
+                continue;
+            }
+
+            const auto& accepted =
+                statuses[placement.group_idx].recently_accepted;
+            if (std::any_of(accepted.begin(), accepted.end(),
+                            [&](const GroupHostStatus::AcceptedPlugin& plugin) {
+                                return plugin.endpoint_base_dir ==
+                                       placement.endpoint_base_dir;
+                            })) {
+                continue;
+            }
+
+            pending_instances[placement.group_idx]++;
+            placements.push_back(std::move(placement));
+        }
+    }
+
+    uint32_t chosen_idx = 0;
+    double lowest_load = std::numeric_limits<double>::infinity();
+    for (uint32_t i = 0; i < num_groups; i++) {
+        const double load =
+            static_cast<double>(statuses[i].num_instances +
+                                pending_instances[i]) +
+            (statuses[i].audio_load * auto_group_audio_load_weight) +
+            (statuses[i].gui_load * auto_group_gui_load_weight);
+        if (load < lowest_load) {
+            chosen_idx = i;
+            lowest_load = load;
+        }
+    }
+
+    if (journal_fd != -1) {
+        placements.push_back(
+            AutoGroupPlacement{.group_idx = chosen_idx,
+                               .placed_ns = now_ns,
+                               .endpoint_base_dir = endpoint_base_dir});
+
+        std::ofstream journal(journal_path.string(),
+                              std::ios::out | std::ios::trunc);
+        for (const auto& placement : placements) {
+            journal << placement.group_idx << " " << placement.placed_ns << " "
+                    << placement.endpoint_base_dir << "\n";
+        }
+        journal.close();
+
+        // This also releases the lock
+        close(journal_fd);
+    }
+
+    return "auto-" + std::to_string(chosen_idx);
+}
+
 Configuration load_config_for(const fs::path& yabridge_path) {
+    // Projects can contain hundreds of plugins, so parsing the same
+    // `yabridge.toml` file for every one of them adds up. The file is only
+    // parsed again when it has been changed.
+    std::unique_lock lock(config_cache_mutex);
+
     // First find the closest `yabridge.tmol` file for the plugin, falling back
     // to default configuration settings if it doesn't exist
-    const std::optional<fs::path> config_file =
-        find_dominating_file("yabridge.toml", yabridge_path);
+    std::optional<fs::path> config_file = find_config_file(yabridge_path);
+    struct stat config_file_info {};
+    if (config_file && stat(config_file->c_str(), &config_file_info) != 0) {
+        // The file has been removed since we last searched for it
+        config_search_cache.clear();
+        config_file = find_config_file(yabridge_path);
+        if (config_file &&
+            stat(config_file->c_str(), &config_file_info) != 0) {
+            config_file.reset();
+        }
+    }
     if (!config_file) {
         return Configuration();
     }
 
-    try {
-        return Configuration(*config_file, yabridge_path);
-    } catch (const toml::parse_error& error) {
-        Logger logger = Logger::create_exception_logger();
-
-        // Parsing failures should be non-fatal since that leads to a pretty
-        // confusing user experience (see
-        // https://github.com/robbert-vdh/yabridge/issues/282). They should,
-        // however, still result in a visible error.
-        logger.log("");
-        logger.log("The configuration file at '" + config_file->string() +
-                   "' could not be parsed:");
-        logger.log(error.what());
-        logger.log("");
+    const std::string config_key = config_file->string();
+    if (auto cached = config_file_cache.find(config_key);
+        cached == config_file_cache.end() ||
+        !cached->second.is_up_to_date(config_file_info)) {
+        try {
+            config_file_cache.insert_or_assign(
+                config_key, CachedConfigFile{
+                                .device = config_file_info.st_dev,
+                                .inode = config_file_info.st_ino,
+                                .size = config_file_info.st_size,
+                                .modified = config_file_info.st_mtim,
+                                .file = ConfigFile(*config_file),
+                                .matches = {}});
+        } catch (const toml::parse_error& error) {
+            config_file_cache.erase(config_key);
+            lock.unlock();
+
+            Logger logger = Logger::create_exception_logger();
+
+            // Parsing failures should be non-fatal since that leads to a pretty
+            // confusing user experience (see
+            // https://github.com/robbert-vdh/yabridge/issues/282). They should,
+            // however, still result in a visible error.
+            logger.log("");
+            logger.log("The configuration file at '" + config_file->string() +
+                       "' could not be parsed:");
+            logger.log(error.what());
+            logger.log("");
+
+            send_notification(
+                "Failed to parse yabridge.toml file",
+                "The configuration file at '" + config_file->string() +
+                    "' could not be parsed: " +
+                    std::string(error.description()),
+                std::nullopt);
+
+            return Configuration();
+        }
+    }
 
-        send_notification(
-            "Failed to parse yabridge.toml file",
-            "The configuration file at '" + config_file->string() +
-                "' could not be parsed: " + std::string(error.description()),
-            std::nullopt);
+    CachedConfigFile& cached = config_file_cache.at(config_key);
+    if (const auto match = cached.matches.find(yabridge_path.string());
+        match != cached.matches.end()) {
+        return match->second;
+    }
 
-        return Configuration();
+    if (cached.matches.size() >= max_config_cache_entries) {
+        cached.matches.clear();
     }
+
+    return cached.matches
+        .emplace(yabridge_path.string(), cached.file.match(yabridge_path))
+        .first->second;
 }
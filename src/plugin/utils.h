@@ -16,12 +16,27 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <variant>
 
+#include <pthread.h>
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <asio/posix/stream_descriptor.hpp>
+#include <asio/steady_timer.hpp>
+
 #include "../common/configuration.h"
 #include "../common/logging/common.h"
 #include "../common/plugins.h"
 #include "../common/process.h"
+#include "../common/serialization/common.h"
 #include "../common/utils.h"
 
 /**
@@ -157,6 +172,251 @@ struct PluginInfo {
             wine_prefix_;
 };
 
+/**
+ * Keeps track of the process timings reported by the Wine plugin host for a
+ * single plugin instance. When the logging verbosity is set to at least
+ * `most_events`, the average and peak plugin CPU time, plugin wall clock time,
+ * and bridging overhead are written to the log every `report_interval`. This
+ * makes it possible to find out which plugins in a large project are using up
+ * the DSP budget.
+ *
+ * @note This is only ever used from the audio thread, so it doesn't do any
+ *   synchronization.
+ */
+class ProcessTimingStats {
+   public:
+    /**
+     * How often the accumulated statistics should be written to the log.
+     */
+    static constexpr std::chrono::seconds report_interval{10};
+
+    /**
+     * Record the timings for a single processing cycle. This does nothing
+     * unless `logger`'s verbosity is at least `most_events`.
+     *
+     * @param logger The logger to write the statistics to.
+     * @param timing The plugin's CPU and wall clock time, as reported by the
+     *   Wine plugin host.
+     * @param round_trip The time spent waiting for the Wine plugin host to
+     *   process audio on the native side. The difference between this and the
+     *   wall clock time reported by the Wine plugin host is the bridging
+     *   overhead.
+     * @param instance_id The instance ID for VST3 and CLAP plugins. Added to
+     *   the log message so the plugin instance can be identified.
+     */
+    void record(Logger& logger,
+                const ProcessTiming& timing,
+                std::chrono::steady_clock::duration round_trip,
+                std::optional<size_t> instance_id = std::nullopt);
+
+   private:
+    /**
+     * The running totals and peaks for one of the measured quantities.
+     */
+    struct Accumulator {
+        uint64_t total_ns = 0;
+        uint64_t peak_ns = 0;
+
+        void add(uint64_t ns) noexcept {
+            total_ns += ns;
+            peak_ns = std::max(peak_ns, ns);
+        }
+    };
+
+    std::chrono::steady_clock::time_point window_start_ =
+        std::chrono::steady_clock::now();
+    uint64_t num_cycles_ = 0;
+    Accumulator cpu_time_;
+    Accumulator wall_time_;
+    Accumulator overhead_;
+};
+
+/**
+ * A simple RAII wrapper around pthreads that imitates `std::jthread`, including
+ * implicit joining on destruction. This is the native counterpart to
+ * `Win32Thread`, and it exists so the threads yabridge spawns on the plugin
+ * side use the stack size from `YABRIDGE_THREAD_STACK_SIZE`. `std::jthread`
+ * has no way to configure this.
+ *
+ * @throw std::system_error If the thread could not be created.
+ */
+class NativeThread {
+   public:
+    /**
+     * Constructor that does not start any thread yet.
+     */
+    NativeThread() noexcept;
+
+    /**
+     * Constructor that immediately starts running the thread. This works
+     * equivalently to `std::jthread`.
+     *
+     * @param fn The thread entry point that should be run.
+     * @param args The arguments passed to the entry point function.
+     */
+    template <typename Function, typename... Args>
+    explicit NativeThread(Function fn, Args... args) {
+        auto entry_point = [f = std::move(fn),
+                            ... args = std::move(args)]() mutable {
+            f(std::move(args)...);
+        };
+        using EntryPoint = decltype(entry_point);
+
+        // The entry point gets deleted again by the new thread
+        auto data = std::make_unique<EntryPoint>(std::move(entry_point));
+        start(
+            [](void* data) -> void* {
+                std::unique_ptr<EntryPoint> entry_point(
+                    static_cast<EntryPoint*>(data));
+                (*entry_point)();
+
+                return nullptr;
+            },
+            data.get());
+        data.release();
+    }
+
+    /**
+     * Join the thread on shutdown, just like `std::jthread` does.
+     */
+    ~NativeThread() noexcept;
+
+    NativeThread(const NativeThread&) = delete;
+    NativeThread& operator=(const NativeThread&) = delete;
+
+    NativeThread(NativeThread&&) noexcept;
+    NativeThread& operator=(NativeThread&&) noexcept;
+
+   private:
+    /**
+     * Start a thread with the stack size configured through
+     * `YABRIDGE_THREAD_STACK_SIZE` that runs `entry_point(data)`.
+     */
+    void start(void* (*entry_point)(void*), void* data);
+
+    /**
+     * The thread that's running, if this object was not default constructed
+     * and hasn't been moved from.
+     */
+    std::optional<pthread_t> handle_;
+};
+
+/**
+ * A process-wide Asio IO context shared by every yabridge plugin instance in
+ * this process, run from a single thread. This relays the Wine plugin hosts'
+ * STDOUT and STDERR output and runs the watchdogs that check whether the Wine
+ * plugin host is still alive while an instance is connecting to it. Before
+ * this every instance spawned its own threads for these things, which quickly
+ * adds up when loading hundreds of plugins. Processes are watched using pidfds
+ * registered with this context's epoll instance, so a watchdog only wakes this
+ * thread up when the process it's watching has actually exited.
+ *
+ * The thread is started when the first plugin instance calls `acquire()`, and
+ * it's joined again when the last instance drops its reference, so no threads
+ * are left behind after the plugin library gets unloaded.
+ */
+class SharedIoContext {
+   public:
+    /**
+     * How often the watchdogs that can't wait for a pidfd are run.
+     */
+    static constexpr std::chrono::milliseconds watchdog_interval{20};
+
+    /**
+     * Get the process-wide instance, creating it and starting its thread if
+     * there is no instance yet.
+     */
+    static std::shared_ptr<SharedIoContext> acquire();
+
+    /**
+     * Stop the IO context and join its thread. Any outstanding work is
+     * dropped.
+     */
+    ~SharedIoContext() noexcept;
+
+    SharedIoContext(const SharedIoContext&) = delete;
+    SharedIoContext& operator=(const SharedIoContext&) = delete;
+
+    /**
+     * Whether the thread running this context was able to enable realtime
+     * scheduling. This is tested on this thread instead of on the thread that
+     * initializes the plugin because some DAWs may do that from their UI
+     * thread. The thread itself does not keep running with realtime
+     * scheduling, since plugins that print a lot of FIXMEs could then cause
+     * dropouts.
+     */
+    bool has_realtime_priority() const;
+
+    /**
+     * Unregisters a watchdog when it gets dropped. After this object has been
+     * destroyed, the watchdog function is guaranteed to no longer be running.
+     */
+    class WatchdogGuard {
+       public:
+        WatchdogGuard(SharedIoContext& context, size_t watchdog_id) noexcept;
+        ~WatchdogGuard() noexcept;
+
+        WatchdogGuard(const WatchdogGuard&) = delete;
+        WatchdogGuard& operator=(const WatchdogGuard&) = delete;
+
+       private:
+        SharedIoContext& context_;
+        size_t watchdog_id_;
+    };
+
+    /**
+     * Call `check` from this context's thread until the returned guard gets
+     * dropped. If `pid` is set, then `check` will be called once that process
+     * exits. Otherwise, or if we could not open a pidfd for the process, then
+     * `check` will be called every `watchdog_interval` instead.
+     */
+    [[nodiscard]] WatchdogGuard register_watchdog(
+        std::function<void()> check,
+        std::optional<pid_t> pid = std::nullopt);
+
+    /**
+     * The IO context that should be used for the plugin hosts' STDIO relays.
+     */
+    inline asio::io_context& context() noexcept { return context_; }
+
+   private:
+    SharedIoContext();
+
+    /**
+     * Run all polled watchdogs after `watchdog_interval`, and keep doing so for
+     * as long as there are polled watchdogs. Only called from this context's
+     * thread.
+     */
+    void schedule_watchdogs();
+
+    struct Watchdog {
+        std::function<void()> check;
+        /**
+         * The pidfd for the process we're watching, or a null pointer if
+         * `check` should be polled instead. This is shared with the pending
+         * wait on the pidfd.
+         */
+        std::shared_ptr<asio::posix::stream_descriptor> pidfd;
+    };
+
+    asio::io_context context_;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
+    asio::steady_timer watchdog_timer_;
+
+    std::mutex watchdogs_mutex_;
+    std::unordered_map<size_t, Watchdog> watchdogs_;
+    size_t next_watchdog_id_ = 0;
+    bool watchdogs_scheduled_ = false;
+
+    std::shared_future<bool> has_realtime_priority_;
+
+    /**
+     * Runs `context_`. This is declared last so it's joined before any of the
+     * other members are destroyed.
+     */
+    NativeThread thread_;
+};
+
 /**
  * Returns equality for two strings when ignoring casing. Used for comparing
  * filenames inside of Wine prefixes since Windows/Wine does case folding for
@@ -172,6 +432,13 @@ bool equals_case_insensitive(const std::string& a, const std::string& b);
  */
 std::string join_quoted_strings(std::vector<std::string>& strings);
 
+/**
+ * Format a list of CPU numbers from the `audio_thread_cpus` and
+ * `gui_thread_cpus` options in the same compact format used by `isolcpus`, e.g.
+ * `"2-3,6"`. This is used to format the initialisation message.
+ */
+std::string format_cpu_list(const std::vector<uint16_t>& cpus);
+
 /**
  * Create a logger prefix based on the endpoint base directory used for the
  * sockets for easy identification. This will result in a prefix of the form
@@ -232,6 +499,38 @@ ghc::filesystem::path generate_group_endpoint(
     const ghc::filesystem::path& wine_prefix,
     const LibArchitecture architecture);
 
+/**
+ * Decide which automatic plugin group a new plugin instance should be hosted
+ * in when the `auto_group` option is enabled. There are `num_groups` of these
+ * groups per Wine prefix and architecture, named `auto-0` through
+ * `auto-<num_groups - 1>`. The group whose group host process is the least
+ * busy according to its `GroupHostStatus` gets picked. Group host processes
+ * that are not running yet count as completely idle, so new group host
+ * processes get started until all `num_groups` are in use.
+ *
+ * Since a group host process only reports a new plugin after that plugin has
+ * connected to it, placements are also recorded in a small journal file that
+ * is locked while making the decision. That way a project containing hundreds
+ * of plugins that are all loaded at the same time still gets spread out over
+ * all groups. A placement stops counting as pending once the group host lists
+ * its endpoint in `GroupHostStatus::recently_accepted`.
+ *
+ * @param wine_prefix The name of the Wine prefix in use. This should be
+ *   obtained from `PluginInfo::normalize_wine_prefix()`.
+ * @param architecture The architecture the plugin is using.
+ * @param num_groups The number of automatic groups to distribute plugins over.
+ *   If this is 0, then this is derived from the number of CPU cores.
+ * @param endpoint_base_dir The new plugin's socket endpoint base directory, as
+ *   sent to the group host in `HostRequest::endpoint_base_dir`. This is used
+ *   to match the placement with the group host's acknowledgement.
+ *
+ * @return The name of the group the plugin should be hosted in.
+ */
+std::string choose_auto_group(const ghc::filesystem::path& wine_prefix,
+                              const LibArchitecture architecture,
+                              uint32_t num_groups,
+                              const std::string& endpoint_base_dir);
+
 /**
  * Load the configuration that belongs to a copy of or symlink to
  * `libyabridge-{clap,vst2,vst3}.so`. If no configuration file could be found
@@ -245,6 +544,11 @@ ghc::filesystem::path generate_group_endpoint(
  * This function will also take any optional compile-time features that have not
  * been enabled into account.
  *
+ * Parsed configuration files are cached for the lifetime of the process and
+ * they are only parsed again when their modification time or inode changes,
+ * so loading many plugins that share the same `yabridge.toml` file only parses
+ * that file once.
+ *
  * @param yabridge_path The path to the .so file that's being loaded.by the VST
  *   host. This will be used both for the starting location of the search and to
  *   determine which section in the config file to use.
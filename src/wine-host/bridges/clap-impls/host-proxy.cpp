@@ -23,6 +23,9 @@
 //       is because otherwise it's very easy to run into a deadlock when both
 //       sides use `clap_host::request_callback()`+`clap_plugin::on_main_thread`
 //       at the same time
+// NOTE: Callbacks without a return value that are idempotent (like
+//       `clap_host_state::mark_dirty()`) don't wait for the host at all. See
+//       `clap_host_proxy::notify()`.
 
 clap_host_proxy::clap_host_proxy(ClapBridge& bridge,
                                  size_t owner_instance_id,
@@ -158,21 +161,17 @@ clap_host_proxy::host_get_extension(const struct clap_host* host,
 void CLAP_ABI
 clap_host_proxy::host_request_restart(const struct clap_host* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_mutually_recursive_main_thread_message(
-        clap::host::RequestRestart{.owner_instance_id =
-                                       self->owner_instance_id()});
+    self->notify(clap::host::notify_request_restart);
 }
 
 void CLAP_ABI
 clap_host_proxy::host_request_process(const struct clap_host* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_mutually_recursive_main_thread_message(
-        clap::host::RequestProcess{.owner_instance_id =
-                                       self->owner_instance_id()});
+    self->notify(clap::host::notify_request_process);
 }
 
 void CLAP_ABI
@@ -321,11 +320,9 @@ void CLAP_ABI clap_host_proxy::ext_gui_closed(const clap_host_t* host,
 
 void CLAP_ABI clap_host_proxy::ext_latency_changed(const clap_host_t* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_mutually_recursive_main_thread_message(
-        clap::ext::latency::host::Changed{.owner_instance_id =
-                                              self->owner_instance_id()});
+    self->notify(clap::host::notify_latency_changed);
 }
 
 void CLAP_ABI clap_host_proxy::ext_log_log(const clap_host_t* host,
@@ -383,11 +380,9 @@ void CLAP_ABI clap_host_proxy::ext_log_log(const clap_host_t* host,
 
 void CLAP_ABI clap_host_proxy::ext_note_name_changed(const clap_host_t* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_mutually_recursive_main_thread_message(
-        clap::ext::note_name::host::Changed{.owner_instance_id =
-                                                self->owner_instance_id()});
+    self->notify(clap::host::notify_note_name_changed);
 }
 
 uint32_t CLAP_ABI
@@ -449,19 +444,19 @@ clap_host_proxy::ext_params_request_flush(const clap_host_t* host) {
 
 void CLAP_ABI clap_host_proxy::ext_state_mark_dirty(const clap_host_t* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_mutually_recursive_main_thread_message(
-        clap::ext::state::host::MarkDirty{.owner_instance_id =
-                                              self->owner_instance_id()});
+    self->notify(clap::host::notify_state_mark_dirty);
 }
 
 void CLAP_ABI clap_host_proxy::ext_tail_changed(const clap_host_t* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
 
-    self->bridge_.send_audio_thread_message(clap::ext::tail::host::Changed{
-        .owner_instance_id = self->owner_instance_id()});
+    // This will be picked up after the current or next processing cycle, and
+    // the native plugin will then call the host's callback from the audio
+    // thread
+    self->has_pending_tail_change_.store(true);
 }
 
 bool CLAP_ABI
@@ -555,10 +550,47 @@ clap_host_proxy::ext_thread_check_is_audio_thread(const clap_host_t* host) {
 
 void CLAP_ABI clap_host_proxy::ext_voice_info_changed(const clap_host_t* host) {
     assert(host && host->host_data);
-    auto self = static_cast<const clap_host_proxy*>(host->host_data);
+    auto self = static_cast<clap_host_proxy*>(host->host_data);
+
+    self->notify(clap::host::notify_voice_info_changed);
+}
+
+void clap_host_proxy::flush_notifications() {
+    const uint32_t notifications = pending_notifications_.exchange(0);
+    if (notifications == 0) {
+        return;
+    }
+
+    // The host may query the plugin in response to these notifications, so
+    // this has to allow mutual recursion just like the old synchronous
+    // callbacks did
+    bridge_.send_mutually_recursive_main_thread_message(
+        clap::host::Notify{.owner_instance_id = owner_instance_id(),
+                           .notifications = notifications});
+}
 
-    self->bridge_.send_main_thread_message(clap::ext::voice_info::host::Changed{
-        .owner_instance_id = self->owner_instance_id()});
+void clap_host_proxy::notify(uint32_t notifications) {
+    // If other notifications are already pending, then the task scheduled for
+    // those will also send these
+    if (pending_notifications_.fetch_or(notifications) != 0) {
+        return;
+    }
+
+    // This object may no longer exist by the time the task runs, so we'll
+    // look it up again through the plugin instance. The instance's lock also
+    // prevents it from being removed while we're sending the notifications.
+    // The same goes for the bridge itself.
+    bridge_.schedule_task_while_alive(
+        [&bridge = bridge_, instance_id = owner_instance_id_]() {
+            try {
+                const auto& [instance, _] = bridge.get_instance(instance_id);
+
+                instance.host_proxy->flush_notifications();
+            } catch (const std::out_of_range&) {
+                // The plugin has been removed in the meantime. See
+                // `host_request_callback()`.
+            }
+        });
 }
 
 void clap_host_proxy::async_schedule_timer_support_timer(clap_id timer_id) {
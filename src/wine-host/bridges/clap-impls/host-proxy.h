@@ -83,6 +83,26 @@ class clap_host_proxy {
      */
     inline size_t owner_instance_id() const { return owner_instance_id_; }
 
+    /**
+     * Send any pending `clap::host::Notify` notifications to the native plugin
+     * right now instead of waiting for the task scheduled in `notify()` to run.
+     * This is called after `clap_plugin::init()` and `clap_plugin::activate()`
+     * because the host needs to receive latency changes made during those
+     * calls before they return. Must be called from the main thread.
+     */
+    void flush_notifications();
+
+    /**
+     * Check whether the plugin has called `clap_host_tail::changed()` since the
+     * last time this function was called. Called from the audio thread after
+     * `clap_plugin::process()`, so the callback can be made on the host's
+     * audio thread as part of the process response.
+     */
+    inline bool take_tail_changed() noexcept {
+        return has_pending_tail_change_.load(std::memory_order_relaxed) &&
+               has_pending_tail_change_.exchange(false);
+    }
+
     /**
      * The extensions supported by the host, set just before calling
      * `clap_plugin::init()` on the bridged plugin. We'll allow the plugin to
@@ -160,6 +180,15 @@ class clap_host_proxy {
      */
     void async_schedule_timer_support_timer(clap_id timer_id);
 
+    /**
+     * Mark one or more of the host callbacks from `clap::host::NotifyFlags` as
+     * pending. If no other notifications were pending, then we'll schedule a
+     * task on the main thread that sends all pending notifications to the
+     * native plugin in a single message. The plugin's calling thread never has
+     * to wait for the host.
+     */
+    void notify(uint32_t notifications);
+
     ClapBridge& bridge_;
     size_t owner_instance_id_;
     clap::host::Host host_args_;
@@ -201,6 +230,21 @@ class clap_host_proxy {
      */
     std::atomic_bool has_pending_host_callbacks_ = false;
 
+    /**
+     * A bitmask of `clap::host::NotifyFlags` for the notifications that have
+     * not yet been sent to the native plugin. A task to send these is scheduled
+     * when this changes from zero to a nonzero value.
+     *
+     * @see notify
+     */
+    std::atomic_uint32_t pending_notifications_ = 0;
+
+    /**
+     * Set when the plugin calls `clap_host_tail::changed()`, and cleared again
+     * in `take_tail_changed()`.
+     */
+    std::atomic_bool has_pending_tail_change_ = false;
+
     /**
      * Any timers the plugin has registered through the `timer-support`
      * extension. The timers are registered on the `bridge_`'s IO context.
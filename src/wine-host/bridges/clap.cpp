@@ -18,6 +18,7 @@
 
 #include <codecvt>
 #include <locale>
+#include <tuple>
 
 #include <clap/factory/plugin-factory.h>
 
@@ -157,6 +158,7 @@ ClapBridge::ClapBridge(MainContext& main_context,
 
     // Allow this plugin to configure the main context's tick rate
     main_context.update_timer_interval(config_.event_loop_interval());
+    apply_gui_thread_affinity(config_);
 }
 
 bool ClapBridge::inhibits_event_loop() noexcept {
@@ -263,6 +265,12 @@ void ClapBridge::run() {
                             request.supported_host_extensions;
 
                         const bool result = plugin->init(plugin);
+
+                        // NOTE: McRocklin Suite changes the latency during the
+                        //       init call, and the host should know about that
+                        //       before this function returns
+                        instance.host_proxy->flush_notifications();
+
                         if (result) {
                             // This mimics the same behavior we had to implement
                             // for VST2 and VST3. The Win32 message loop is
@@ -310,11 +318,17 @@ void ClapBridge::run() {
                 const auto& [instance, _] = get_instance(request.instance_id);
 
                 return main_context_
-                    .run_in_context([&, plugin = instance.plugin.get()]() {
+                    .run_in_context([&, plugin = instance.plugin.get(),
+                                     &instance = instance]() {
                         const bool result = plugin->activate(
                             plugin, request.sample_rate,
                             request.min_frames_count, request.max_frames_count);
 
+                        // Plugins are supposed to report latency changes while
+                        // being activated, so those have to reach the host
+                        // before this function returns
+                        instance.host_proxy->flush_notifications();
+
                         const std::optional<AudioShmBuffer::Config>
                             updated_audio_buffers_config =
                                 setup_shared_audio_buffers(request.instance_id,
@@ -965,8 +979,8 @@ std::optional<AudioShmBuffer::Config> ClapBridge::setup_shared_audio_buffers(
             offsets[port].resize(info.channel_count);
             for (size_t channel = 0; channel < info.channel_count; channel++) {
                 offsets[port][channel] = current_offset;
-                current_offset +=
-                    activate_request.max_frames_count * sample_size;
+                current_offset += AudioShmBuffer::aligned_channel_size(
+                    activate_request.max_frames_count, sample_size);
             }
         }
 
@@ -993,6 +1007,9 @@ std::optional<AudioShmBuffer::Config> ClapBridge::setup_shared_audio_buffers(
     AudioShmBuffer::Config buffer_config{
         .name = sockets_.base_dir_.filename().string() + "-" +
                 std::to_string(instance_id),
+        .backing = config_.audio_buffer_huge_pages
+                       ? AudioShmBuffer::Config::Backing::memfd_hugetlb
+                       : AudioShmBuffer::Config::Backing::posix_shm,
         .size = buffer_size,
         .input_offsets = std::move(input_bus_offsets),
         .output_offsets = std::move(output_bus_offsets)};
@@ -1041,7 +1058,9 @@ std::optional<AudioShmBuffer::Config> ClapBridge::setup_shared_audio_buffers(
                               port, channel);
                       });
 
-    return buffer_config;
+    // The buffer may have created a memfd or fallen back to a different
+    // backing, so the native plugin needs the updated configuration
+    return instance.process_buffers->config_;
 }
 
 void ClapBridge::register_plugin_instance(
@@ -1064,6 +1083,7 @@ void ClapBridge::register_plugin_instance(
     object_instances_.at(instance_id)
         .audio_thread_handler = Win32Thread([&, instance_id]() {
         set_realtime_priority(true);
+        apply_audio_thread_affinity(config_);
 
         // XXX: Like with VST2 worker threads, when using plugin groups the
         //      thread names from different plugins will clash. Not a huge
@@ -1118,6 +1138,8 @@ void ClapBridge::register_plugin_instance(
                         set_realtime_priority(true,
                                               *request.new_realtime_priority);
                     }
+                    apply_host_audio_thread_affinity(
+                        config_, request.new_cpu_affinity_mask);
 
                     const auto& [instance, _] =
                         get_instance(request.instance_id);
@@ -1135,27 +1157,44 @@ void ClapBridge::register_plugin_instance(
                     //       thread while the plugin is in offline processing
                     //       mode. So as a precaution, we'll also do offline
                     //       processing for CLAP plugins on the GUI thread.
+                    //       The timer needs to be started on the thread that
+                    //       calls the plugin, since it also measures that
+                    //       thread's CPU time.
                     clap_process_status result;
+                    ProcessTiming timing;
                     auto& reconstructed = request.process.reconstruct(
                         instance.process_buffers_input_pointers,
-                        instance.process_buffers_output_pointers);
+                        instance.process_buffers_output_pointers,
+                        instance.transport_delta_state);
                     if (instance.render_mode == CLAP_RENDER_OFFLINE) {
-                        result =
+                        std::tie(result, timing) =
                             main_context_
-                                .run_in_context([&instance = instance,
-                                                 &reconstructed]() {
-                                    return instance.plugin->process(
-                                        instance.plugin.get(), &reconstructed);
+                                .run_in_context([&, &instance = instance]() {
+                                    const ProcessTimer process_timer(
+                                        process_timing_enabled());
+                                    const clap_process_status result =
+                                        instance.plugin->process(
+                                            instance.plugin.get(),
+                                            &reconstructed);
+
+                                    return std::pair(result,
+                                                     process_timer.elapsed());
                                 })
                                 .get();
                     } else {
+                        const ProcessTimer process_timer(
+                            process_timing_enabled());
                         result = instance.plugin->process(instance.plugin.get(),
                                                           &reconstructed);
+                        timing = process_timer.elapsed();
                     }
 
                     return clap::plugin::ProcessResponse{
                         .result = result,
-                        .output_data = request.process.create_response()};
+                        .output_data = request.process.create_response(),
+                        .timing = timing,
+                        .tail_changed =
+                            instance.host_proxy->take_tail_changed()};
                 },
                 [&](clap::ext::params::plugin::Flush& request)
                     -> clap::ext::params::plugin::Flush::Response {
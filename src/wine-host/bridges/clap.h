@@ -143,6 +143,15 @@ struct ClapPluginInstance {
      */
     std::vector<std::vector<void*>> process_buffers_output_pointers;
 
+    /**
+     * The transport information is delta encoded against the transport
+     * information sent during the previous processing cycle. This is used to
+     * reconstruct the full `clap_event_transport_t` from the changed fields in
+     * `clap::process::Process`. This can't be part of that object itself since
+     * that object is thread local on the Wine side.
+     */
+    TransportDeltaState<clap_event_transport_t> transport_delta_state;
+
     /**
      * This instance's editor, if it has an open editor. Embedding here works
      * exactly the same as how it works for VST2 plugins.
@@ -55,7 +55,7 @@ HostBridge::HostBridge(MainContext& main_context,
       main_context_(main_context),
       generic_logger_(Logger::create_wine_stderr()),
       parent_pid_(parent_pid),
-      watchdog_guard_(main_context.register_watchdog(*this)) {}
+      watchdog_guard_(main_context.register_watchdog(*this, parent_pid)) {}
 
 void HostBridge::handle_events() noexcept {
     MSG msg;
@@ -73,13 +73,47 @@ void HostBridge::handle_events() noexcept {
     }
 }
 
+void HostBridge::apply_gui_thread_affinity(const Configuration& config) {
+    // This is only ever called from the main thread
+    static bool gui_thread_affinity_applied = false;
+    if (!config.gui_thread_cpus) {
+        return;
+    }
+
+    if (gui_thread_affinity_applied) {
+        generic_logger_.log(
+            "NOTE: The main thread's affinity has already been set by another "
+            "plugin in this group, ignoring 'gui_thread_cpus'");
+        return;
+    }
+
+    gui_thread_affinity_applied = true;
+    if (!set_cpu_affinity(*config.gui_thread_cpus)) {
+        generic_logger_.log(
+            "WARNING: Could not restrict the main thread to the CPUs from "
+            "'gui_thread_cpus'");
+    }
+}
+
+void HostBridge::apply_audio_thread_affinity(const Configuration& config) {
+    if (config.audio_thread_cpus) {
+        if (!set_cpu_affinity(*config.audio_thread_cpus)) {
+            generic_logger_.log(
+                "WARNING: Could not restrict the audio thread to the CPUs "
+                "from 'audio_thread_cpus'");
+        }
+    } else if (config.gui_thread_cpus) {
+        reset_cpu_affinity();
+    }
+}
+
 void HostBridge::shutdown_if_dangling() {
     // If the parent process has exited and this plugin bridge instance is
     // outliving the process it's supposed to be connected to (because in some
     // situations sockets won't get closed when this happens so we'd hang on
     // `recv()`), then we'll close the sockets here so that the plugin bridge
-    // exits gracefully. This will be periodically called from `MainContext`'s
-    // watchdog thread.
+    // exits gracefully. This will be called from `MainContext`'s watchdog
+    // thread when a native host process exits.
     if (!pid_running(parent_pid_)) {
         std::cerr << "WARNING: The native plugin host seems to have died."
                   << std::endl;
@@ -18,8 +18,12 @@
 
 #include "../use-linux-asio.h"
 
+#include <concepts>
+#include <memory>
+
 #include <ghc/filesystem.hpp>
 
+#include "../../common/configuration.h"
 #include "../../common/logging/common.h"
 #include "../utils.h"
 
@@ -107,6 +111,25 @@ class HostBridge {
      */
     MainContext& main_context_;
 
+    /**
+     * Run `fn` on the main thread using `main_context_.schedule_task()`, but
+     * only if this bridge still exists by the time the task runs. Use this
+     * instead of `main_context_.schedule_task()` for deferred tasks that
+     * capture the bridge. Bridges are only ever destroyed from the main thread,
+     * so checking the bridge's lifetime token from within the task cannot
+     * race with the bridge's destruction.
+     */
+    template <std::invocable F>
+    void schedule_task_while_alive(F&& fn) {
+        main_context_.schedule_task(
+            [lifetime_token = std::weak_ptr<bool>(lifetime_token_),
+             fn = std::forward<F>(fn)]() mutable {
+                if (!lifetime_token.expired()) {
+                    fn();
+                }
+            });
+    }
+
    protected:
     /**
      * Used as part of the watchdog that shuts down a plugin when the remote
@@ -116,6 +139,52 @@ class HostBridge {
      */
     virtual void close_sockets() = 0;
 
+    /**
+     * Restrict the calling thread to the plugin's `gui_thread_cpus`, if that
+     * option is set. This should be called from the main thread after the
+     * plugin's configuration has been received.
+     *
+     * All plugins in a plugin group share a single main thread, so this is
+     * only done once per Wine plugin host process. The first plugin that sets
+     * `gui_thread_cpus` decides the affinity for the whole group, and the
+     * option is ignored for every plugin loaded after that.
+     */
+    void apply_gui_thread_affinity(const Configuration& config);
+
+    /**
+     * Restrict the calling audio thread to the plugin's `audio_thread_cpus`.
+     * If only `gui_thread_cpus` is set, then this resets the thread back to
+     * the process's original affinity instead so the audio thread doesn't
+     * inherit the main thread's restrictions. When the audio threads follow
+     * the host's affinity, that affinity is applied later during audio
+     * processing using `apply_host_audio_thread_affinity()`.
+     */
+    void apply_audio_thread_affinity(const Configuration& config);
+
+    /**
+     * Copy the CPU affinity of the host's audio thread sent along with a
+     * processing request, if `audio_thread_cpus` is set to `"host"`. This is
+     * called from the audio thread, so it doesn't do any logging.
+     */
+    static void apply_host_audio_thread_affinity(
+        const Configuration& config,
+        std::optional<uint64_t> new_cpu_affinity_mask) noexcept {
+        if (config.audio_thread_cpus_follow_host && new_cpu_affinity_mask) {
+            set_cpu_affinity_mask(*new_cpu_affinity_mask);
+        }
+    }
+
+    /**
+     * Whether the audio processing functions should measure how long the
+     * plugin spent processing audio using a `ProcessTimer`. The native plugin
+     * only logs these timings when the verbosity level is at least
+     * `most_events` (see `ProcessTimingStats`), and the Wine plugin host uses
+     * the same verbosity level.
+     */
+    bool process_timing_enabled() const noexcept {
+        return generic_logger_.verbosity_ >= Logger::Verbosity::most_events;
+    }
+
     /**
      * A logger, just like we have on the plugin side. This is normally not
      * needed because we can just print to STDERR, but this way we can
@@ -129,15 +198,22 @@ class HostBridge {
     /**
      * The process ID of the native plugin host we are bridging for. This should
      * be the parent, but it might not be because of Wine's startup script,
-     * `WINELOADER`s and Wine's `start.exe` behaviour. We'll periodically check
-     * if this process is still alive, and close the sockets if it is not to
-     * prevent dangling processes.
+     * `WINELOADER`s and Wine's `start.exe` behaviour. We'll check if this
+     * process is still alive when it exits, and close the sockets if it is not
+     * to prevent dangling processes.
      */
     const pid_t parent_pid_;
 
     /**
-     * A guard that, while in scope, will cause `shutdown_if_dangling()` to
-     * periodically be called.
+     * A guard that, while in scope, will cause `shutdown_if_dangling()` to be
+     * called when the native host process exits.
      */
     MainContext::WatchdogGuard watchdog_guard_;
+
+    /**
+     * Expires when this bridge gets destroyed. Tasks scheduled with
+     * `schedule_task_while_alive()` hold a weak reference to this so they can
+     * tell whether the bridge still exists.
+     */
+    const std::shared_ptr<bool> lifetime_token_ = std::make_shared<bool>(true);
 };
@@ -18,6 +18,7 @@
 
 #include "../use-linux-asio.h"
 
+#include <time.h>
 #include <unistd.h>
 #include <regex>
 
@@ -61,6 +62,11 @@ asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
  */
 std::string create_logger_prefix(const fs::path& socket_path);
 
+/**
+ * Read one of the CPU time clocks, in nanoseconds.
+ */
+uint64_t cpu_time_ns(clockid_t clock) noexcept;
+
 StdIoCapture::StdIoCapture(asio::io_context& io_context, int file_descriptor)
     : pipe_(io_context),
       target_fd_(file_descriptor),
@@ -99,7 +105,9 @@ GroupBridge::GroupBridge(ghc::filesystem::path group_socket_path)
       group_socket_acceptor_(
           create_acceptor_if_inactive(main_context_.context_,
                                       group_socket_endpoint_)),
-      shutdown_timer_(main_context_.context_) {
+      shutdown_timer_(main_context_.context_),
+      status_path_(group_status_path(group_socket_path)),
+      status_timer_(main_context_.context_) {
     // Write this process's original STDOUT and STDERR streams to the logger
     logger_.async_log_pipe_lines(stdout_redirect_.pipe_, stdout_buffer_,
                                  "[STDOUT] ");
@@ -118,6 +126,7 @@ GroupBridge::~GroupBridge() noexcept {
     // here we need to do it manually
     // TODO: Encapsulate this, destructors are evil
     fs::remove(group_socket_endpoint_.path());
+    fs::remove(status_path_);
 
     stdio_context_.stop();
 }
@@ -157,16 +166,26 @@ void GroupBridge::handle_plugin_run(size_t plugin_id, HostBridge* bridge) {
         // The join is implicit because we're using Win32Thread (which mimics
         // std::jthread)
         active_plugins_.erase(plugin_id);
-    });
 
-    // Defer actually shutting down the process to allow for fast plugin
-    // scanning by allowing plugins to reuse the same group host process
-    maybe_schedule_shutdown(4s);
+        status_.num_instances = active_plugins_.size();
+        status_.write(status_path_);
+
+        // Defer actually shutting down the process to allow for fast plugin
+        // scanning by allowing plugins to reuse the same group host process.
+        // Modules pinned for `share_plugin_image` should survive the host
+        // closing and reopening a plugin, so those keep the process alive for
+        // longer. This is checked here since `pinned_modules_` is only
+        // accessed from the main thread.
+        maybe_schedule_shutdown(pinned_modules_.empty()
+                                    ? std::chrono::steady_clock::duration(4s)
+                                    : pinned_module_idle_timeout);
+    });
 }
 
 void GroupBridge::handle_incoming_connections() {
     accept_requests();
     async_handle_events();
+    async_publish_status();
 
     // If we don't get a request to host a plugin within five seconds, we'll
     // shut the process down again.
@@ -200,6 +219,14 @@ void GroupBridge::accept_requests() {
             const auto request = read_object<HostRequest>(socket);
             write_object(socket, HostResponse{.pid = getpid()});
 
+            // Other plugins may be deciding which group to join right now, so
+            // this new plugin should immediately be reflected in our status
+            status_.num_instances = active_plugins_.size() + 1;
+            status_.recently_accepted.push_back(GroupHostStatus::AcceptedPlugin{
+                .accepted_ns = group_status_time_ns(),
+                .endpoint_base_dir = request.endpoint_base_dir});
+            status_.write(status_path_);
+
             // The plugin has to be initiated on the IO context's thread because
             // this has to be done on the same thread that's handling messages,
             // and all window messages have to be handled from the same thread.
@@ -252,6 +279,14 @@ void GroupBridge::accept_requests() {
                 logger_.log("Finished initializing '" + request.plugin_path +
                             "'");
 
+                // VST3 plugins are a special case since they are often bundles,
+                // but all instances of a VST3 plugin already share a single
+                // module within a `Vst3Bridge`
+                if (request.pin_module &&
+                    request.plugin_type != PluginType::vst3) {
+                    pin_module(request.plugin_path);
+                }
+
                 // Start listening for dispatcher events sent to the plugin's
                 // socket on another thread. Parts of the actual event handling
                 // will still be posted to this IO context so that any events
@@ -357,6 +392,63 @@ void GroupBridge::maybe_schedule_shutdown(
     });
 }
 
+void GroupBridge::async_publish_status() {
+    // This runs on the main thread, so the thread CPU time clock measures how
+    // busy the main thread is
+    const uint64_t now_ns = group_status_time_ns();
+    const uint64_t process_cpu_ns = cpu_time_ns(CLOCK_PROCESS_CPUTIME_ID);
+    const uint64_t main_thread_cpu_ns = cpu_time_ns(CLOCK_THREAD_CPUTIME_ID);
+    if (last_status_update_ns_ > 0 && now_ns > last_status_update_ns_) {
+        const double elapsed_ns =
+            static_cast<double>(now_ns - last_status_update_ns_);
+        const double main_thread_ns =
+            static_cast<double>(main_thread_cpu_ns - last_main_thread_cpu_ns_);
+        const double other_threads_ns =
+            static_cast<double>(process_cpu_ns - last_process_cpu_ns_) -
+            main_thread_ns;
+
+        status_.gui_load = main_thread_ns / elapsed_ns;
+        status_.audio_load = std::max(other_threads_ns, 0.0) / elapsed_ns;
+    }
+
+    last_status_update_ns_ = now_ns;
+    last_process_cpu_ns_ = process_cpu_ns;
+    last_main_thread_cpu_ns_ = main_thread_cpu_ns;
+
+    {
+        std::lock_guard lock(active_plugins_mutex_);
+        status_.num_instances = active_plugins_.size();
+    }
+    status_.write(status_path_);
+
+    status_timer_.expires_after(group_status_update_interval);
+    status_timer_.async_wait([this](const std::error_code& error) {
+        if (error) {
+            return;
+        }
+
+        async_publish_status();
+    });
+}
+
+void GroupBridge::pin_module(const std::string& plugin_path) {
+    if (pinned_modules_.contains(plugin_path)) {
+        return;
+    }
+
+    // Loading the library again only increases its reference count, since the
+    // plugin we just initialized has already loaded it
+    if (HMODULE handle = LoadLibrary(plugin_path.c_str())) {
+        pinned_modules_.emplace(plugin_path,
+                                std::unique_ptr<std::remove_pointer_t<HMODULE>,
+                                                decltype(&FreeLibrary)>(
+                                    handle, FreeLibrary));
+        logger_.log("Keeping '" + plugin_path + "' loaded");
+    } else {
+        logger_.log("WARNING: Could not pin '" + plugin_path + "'");
+    }
+}
+
 std::string create_logger_prefix(const fs::path& socket_path) {
     // The group socket filename will be in the format
     // '/tmp/yabridge-group-<group_name>-<wine_prefix_id>-<architecture>.sock',
@@ -382,3 +474,11 @@ std::string create_logger_prefix(const fs::path& socket_path) {
 
     return "[" + socket_name + "] ";
 }
+
+uint64_t cpu_time_ns(clockid_t clock) noexcept {
+    timespec time;
+    clock_gettime(clock, &time);
+
+    return static_cast<uint64_t>(time.tv_sec) * 1'000'000'000 +
+           static_cast<uint64_t>(time.tv_nsec);
+}
@@ -24,10 +24,18 @@
 #include <asio/local/stream_protocol.hpp>
 #include <asio/posix/stream_descriptor.hpp>
 
+#include "../common/group-status.h"
 #include "../common/logging/common.h"
 #include "../utils.h"
 #include "common.h"
 
+/**
+ * How long a group host process that has kept a plugin's module loaded for
+ * `share_plugin_image` stays alive after its last plugin has exited. Without
+ * any pinned modules the process shuts down after a few seconds.
+ */
+constexpr std::chrono::minutes pinned_module_idle_timeout(10);
+
 /**
  * Encapsulate capturing the STDOUT or STDERR stream by opening a pipe and
  * reopening the passed file descriptor as one of the ends of the newly opened
@@ -201,6 +209,25 @@ class GroupBridge {
      */
     void maybe_schedule_shutdown(std::chrono::steady_clock::duration delay);
 
+    /**
+     * Periodically measure this process's CPU usage and write it to the status
+     * file along with the number of hosted plugins. See `GroupHostStatus`.
+     */
+    void async_publish_status();
+
+    /**
+     * Load the plugin module at `plugin_path` one more time and keep it loaded
+     * until this process exits. This is used for `share_plugin_image`, so the
+     * plugin's module and anything it sets up during initialization don't get
+     * torn down and loaded again whenever the last instance of the plugin is
+     * closed while the host opens a new one, for instance when reloading a
+     * project. While any modules are pinned, the process stays alive for
+     * `pinned_module_idle_timeout` after the last plugin has exited. Does
+     * nothing if the module has already been pinned. Must be called from the
+     * main thread.
+     */
+    void pin_module(const std::string& plugin_path);
+
     /**
      * The logging facility used for this group host process. Since we can't
      * identify which plugin is generating (debug) output, every line will only
@@ -249,6 +276,16 @@ class GroupBridge {
      */
     asio::local::stream_protocol::acceptor group_socket_acceptor_;
 
+    /**
+     * Modules kept loaded by `pin_module()`, indexed by their path. This is
+     * declared before `active_plugins_` so the plugins are always unloaded
+     * first. Only accessed from the main thread.
+     */
+    std::unordered_map<
+        std::string,
+        std::unique_ptr<std::remove_pointer_t<HMODULE>, decltype(&FreeLibrary)>>
+        pinned_modules_;
+
     /**
      * A map of threads that are currently hosting a plugin within this process
      * along with their plugin instance. After a plugin has exited or its
@@ -288,4 +325,27 @@ class GroupBridge {
      * timer when multiple plugins exit at the same time.
      */
     std::mutex shutdown_timer_mutex_;
+
+    /**
+     * The status file next to the group socket. Native plugins using automatic
+     * plugin groups read this to decide which group host process should host
+     * a new plugin.
+     */
+    const ghc::filesystem::path status_path_;
+    /**
+     * The last status written to `status_path_`. This is only accessed from
+     * the main IO context's thread.
+     */
+    GroupHostStatus status_;
+    /**
+     * Updates `status_` every `group_status_update_interval`.
+     */
+    asio::steady_timer status_timer_;
+    /**
+     * The process and main thread CPU times and the wall clock time at the
+     * last status update, used to compute the loads in `status_`.
+     */
+    uint64_t last_process_cpu_ns_ = 0;
+    uint64_t last_main_thread_cpu_ns_ = 0;
+    uint64_t last_status_update_ns_ = 0;
 };
@@ -66,6 +66,10 @@ Vst2Bridge* current_bridge_instance = nullptr;
  * NOTE: Similarly, REAPER calls `effProgramName()` in response to
  *       `audioMasterUpdateDisplay()`, and PG-8X also requires that to be called
  *       from the same thread that called `audioMasterUpdateDisplay()`.
+ * NOTE: `audioMasterUpdateDisplay()` is now sent asynchronously from the main
+ *       thread (see `Vst2Bridge::host_callback()`), so the plugin's own thread
+ *       is no longer blocked while the host responds. The host's responses
+ *       will still be handled on the thread sending the callback.
  */
 static const std::unordered_set<int> mutually_recursive_callbacks{
     audioMasterUpdateDisplay};
@@ -231,9 +235,11 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
 
     // Allow this plugin to configure the main context's tick rate
     main_context.update_timer_interval(config_.event_loop_interval());
+    apply_gui_thread_affinity(config_);
 
     parameters_handler_ = Win32Thread([&]() {
         set_realtime_priority(true);
+        apply_audio_thread_affinity(config_);
         pthread_setname_np(pthread_self(), "parameters");
 
         sockets_.host_plugin_parameters_.receive_multi<Parameter>(
@@ -261,6 +267,7 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
 
     process_replacing_handler_ = Win32Thread([&]() {
         set_realtime_priority(true);
+        apply_audio_thread_affinity(config_);
         pthread_setname_np(pthread_self(), "audio");
 
         // Most plugins will already enable FTZ, but there are a handful of
@@ -277,9 +284,9 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             // the audio thread
             std::optional<decltype(time_info_cache_)::Guard>
                 time_info_cache_guard =
-                    process_request.current_time_info
+                    process_request.has_current_time_info
                         ? std::optional(time_info_cache_.set(
-                              *process_request.current_time_info))
+                              process_request.current_time_info))
                         : std::nullopt;
 
             // We'll also prefetch the process level, since some plugins
@@ -290,9 +297,13 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             // As suggested by Jack Winter, we'll synchronize this thread's
             // audio processing priority with that of the host's audio
             // thread every once in a while
-            if (process_request.new_realtime_priority) {
+            if (process_request.has_new_realtime_priority) {
                 set_realtime_priority(true,
-                                      *process_request.new_realtime_priority);
+                                      process_request.new_realtime_priority);
+            }
+            if (process_request.new_cpu_affinity_mask != 0) {
+                apply_host_audio_thread_affinity(
+                    config_, process_request.new_cpu_affinity_mask);
             }
 
             // Let the plugin process the MIDI events that were received
@@ -361,6 +372,7 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             };
 
             assert(process_buffers_);
+            const ProcessTimer process_timer(process_timing_enabled());
             if (process_request.double_precision) {
                 // XXX: Clangd doesn't let you specify template parameters
                 //      for templated lambdas. This argument should get
@@ -374,7 +386,9 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
             // so we can just send that object back. Like on the plugin side
             // we cannot reuse the request object because a plugin may have
             // a different number of input and output channels
-            sockets_.host_plugin_process_replacing_.send(Ack{}, buffer);
+            sockets_.host_plugin_process_replacing_.send(
+                Vst2ProcessRequest::Response{.timing = process_timer.elapsed()},
+                buffer);
 
             // See the docstrong on `should_clear_midi_events` for why we
             // don't just clear `next_buffer_midi_events` here
@@ -706,6 +720,30 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
                 editor_->resize(index, value);
             }
         } break;
+        // Some plugins call this after every parameter change, and the return
+        // value doesn't mean anything. Instead of making the plugin wait for
+        // the host every time, we'll send a single `audioMasterUpdateDisplay()`
+        // from the main thread for all calls made in the meantime.
+        case audioMasterUpdateDisplay: {
+            if (!has_pending_update_display_.exchange(true)) {
+                schedule_task_while_alive([this]() {
+                    has_pending_update_display_.store(false);
+
+                    HostCallbackDataConverter converter(
+                        plugin_, last_time_info_, mutual_recursion_);
+                    try {
+                        sockets_.plugin_host_callback_.send_event(
+                            converter, std::nullopt, audioMasterUpdateDisplay,
+                            0, 0, nullptr, 0.0);
+                    } catch (const std::system_error&) {
+                        // The sockets may already have been closed if the
+                        // plugin is shutting down
+                    }
+                });
+            }
+
+            return 1;
+        } break;
     }
 
     HostCallbackDataConverter converter(effect, last_time_info_,
@@ -813,13 +851,15 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
     std::vector<uint32_t> input_channel_offsets(plugin_->numInputs);
     for (int channel = 0; channel < plugin_->numInputs; channel++) {
         input_channel_offsets[channel] = current_offset;
-        current_offset += *max_samples_per_block_ * sample_size;
+        current_offset += AudioShmBuffer::aligned_channel_size(
+            *max_samples_per_block_, sample_size);
     }
 
     std::vector<uint32_t> output_channel_offsets(plugin_->numOutputs);
     for (int channel = 0; channel < plugin_->numOutputs; channel++) {
         output_channel_offsets[channel] = current_offset;
-        current_offset += *max_samples_per_block_ * sample_size;
+        current_offset += AudioShmBuffer::aligned_channel_size(
+            *max_samples_per_block_, sample_size);
     }
 
     // The size of the buffer is in bytes, and it will depend on whether the
@@ -831,6 +871,9 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
     // side
     AudioShmBuffer::Config buffer_config{
         .name = sockets_.base_dir_.filename().string(),
+        .backing = config_.audio_buffer_huge_pages
+                       ? AudioShmBuffer::Config::Backing::memfd_hugetlb
+                       : AudioShmBuffer::Config::Backing::posix_shm,
         .size = buffer_size,
         .input_offsets = {std::move(input_channel_offsets)},
         .output_offsets = {std::move(output_channel_offsets)}};
@@ -864,7 +907,9 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
         }
     }
 
-    return buffer_config;
+    // The buffer may have created a memfd or fallen back to a different
+    // backing, so the native plugin needs the updated configuration
+    return process_buffers_->config_;
 }
 
 intptr_t VST_CALL_CONV host_callback_proxy(AEffect* effect,
@@ -18,6 +18,8 @@
 
 #include "../use-linux-asio.h"
 
+#include <atomic>
+
 #include <vestige/aeffectx.h>
 #include <windows.h>
 
@@ -201,6 +203,13 @@ class Vst2Bridge : public HostBridge {
      */
     bool is_initialized_ = false;
 
+    /**
+     * Whether the plugin has called `audioMasterUpdateDisplay()` and that call
+     * has not yet been sent to the host. These calls are coalesced and sent
+     * from the main thread. See `Vst2Bridge::host_callback()`.
+     */
+    std::atomic_bool has_pending_update_display_ = false;
+
     /**
      * The thread that responds to `getParameter` and `setParameter` requests.
      */
@@ -73,8 +73,11 @@ Vst3ComponentHandlerProxyImpl::restartComponent(int32 flags) {
 }
 
 tresult PLUGIN_API Vst3ComponentHandlerProxyImpl::setDirty(TBool state) {
-    return bridge_.send_message(YaComponentHandler2::SetDirty{
-        .owner_instance_id = owner_instance_id(), .state = state});
+    // Hosts don't do anything meaningful with the result, so there's no need
+    // to block the plugin on this
+    bridge_.post_set_dirty(owner_instance_id(), state);
+
+    return Steinberg::kResultOk;
 }
 
 tresult PLUGIN_API
@@ -17,6 +17,7 @@
 #include "vst3.h"
 
 #include <bitset>
+#include <tuple>
 
 #include "vst3-impls/component-handler-proxy.h"
 #include "vst3-impls/connection-point-proxy.h"
@@ -109,6 +110,7 @@ Vst3Bridge::Vst3Bridge(MainContext& main_context,
 
     // Allow this plugin to configure the main context's tick rate
     main_context.update_timer_interval(config_.event_loop_interval());
+    apply_gui_thread_affinity(config_);
 }
 
 bool Vst3Bridge::inhibits_event_loop() noexcept {
@@ -644,33 +646,68 @@ void Vst3Bridge::run() {
                 return YaMidiMapping::GetMidiControllerAssignmentResponse{
                     .result = result, .id = id};
             },
-            [&](const YaNoteExpressionController::GetNoteExpressionCount&
+            [&](const YaMidiMapping::GetMidiControllerAssignments& request)
+                -> YaMidiMapping::GetMidiControllerAssignments::Response {
+                const auto& [instance, _] = get_instance(request.instance_id);
+
+                // Hosts will query every possible controller on every channel,
+                // so we'll do that here in one go instead of doing a round trip
+                // for every one of those calls
+                std::vector<std::optional<Steinberg::Vst::ParamID>> ids;
+                ids.reserve(YaMidiMapping::num_midi_channels *
+                            Steinberg::Vst::kCountCtrlNumber);
+                for (int16 channel = 0;
+                     channel < YaMidiMapping::num_midi_channels; channel++) {
+                    for (int16 controller = 0;
+                         controller < Steinberg::Vst::kCountCtrlNumber;
+                         controller++) {
+                        Steinberg::Vst::ParamID id;
+                        if (instance.interfaces.midi_mapping
+                                ->getMidiControllerAssignment(
+                                    request.bus_index, channel, controller,
+                                    id) == Steinberg::kResultOk) {
+                            ids.push_back(id);
+                        } else {
+                            ids.push_back(std::nullopt);
+                        }
+                    }
+                }
+
+                return YaMidiMapping::GetMidiControllerAssignmentsResponse{
+                    .ids = std::move(ids)};
+            },
+            [&](const YaNoteExpressionController::GetNoteExpressionInfos&
                     request)
-                -> YaNoteExpressionController::GetNoteExpressionCount::
+                -> YaNoteExpressionController::GetNoteExpressionInfos::
                     Response {
                         const auto& [instance, _] =
                             get_instance(request.instance_id);
 
-                        return instance.interfaces.note_expression_controller
-                            ->getNoteExpressionCount(request.bus_index,
-                                                     request.channel);
-                    },
-            [&](const YaNoteExpressionController::GetNoteExpressionInfo&
-                    request)
-                -> YaNoteExpressionController::GetNoteExpressionInfo::Response {
-                const auto& [instance, _] = get_instance(request.instance_id);
-
-                Steinberg::Vst::NoteExpressionTypeInfo info{};
-                const tresult result =
-                    instance.interfaces.note_expression_controller
-                        ->getNoteExpressionInfo(
-                            request.bus_index, request.channel,
-                            request.note_expression_index, info);
+                        const int32 num_note_expressions =
+                            instance.interfaces.note_expression_controller
+                                ->getNoteExpressionCount(request.bus_index,
+                                                         request.channel);
+
+                        std::vector<std::optional<
+                            Steinberg::Vst::NoteExpressionTypeInfo>>
+                            infos;
+                        infos.reserve(std::max(num_note_expressions, 0));
+                        for (int32 i = 0; i < num_note_expressions; i++) {
+                            Steinberg::Vst::NoteExpressionTypeInfo info{};
+                            if (instance.interfaces.note_expression_controller
+                                    ->getNoteExpressionInfo(
+                                        request.bus_index, request.channel, i,
+                                        info) == Steinberg::kResultOk) {
+                                infos.push_back(std::move(info));
+                            } else {
+                                infos.push_back(std::nullopt);
+                            }
+                        }
 
-                return YaNoteExpressionController::
-                    GetNoteExpressionInfoResponse{.result = result,
-                                                  .info = std::move(info)};
-            },
+                        return YaNoteExpressionController::
+                            GetNoteExpressionInfosResponse{
+                                .infos = std::move(infos)};
+                    },
             [&](const YaNoteExpressionController::
                     GetNoteExpressionStringByValue& request)
                 -> YaNoteExpressionController::GetNoteExpressionStringByValue::
@@ -1180,41 +1217,78 @@ void Vst3Bridge::run() {
                     static_cast<YaHostApplication*>(
                         plugin_factory_host_context_));
             },
-            [&](const YaUnitInfo::GetUnitCount& request)
-                -> YaUnitInfo::GetUnitCount::Response {
+            [&](const YaUnitInfo::GetUnitInfos& request)
+                -> YaUnitInfo::GetUnitInfos::Response {
                 const auto& [instance, _] = get_instance(request.instance_id);
 
-                return instance.interfaces.unit_info->getUnitCount();
-            },
-            [&](const YaUnitInfo::GetUnitInfo& request)
-                -> YaUnitInfo::GetUnitInfo::Response {
-                const auto& [instance, _] = get_instance(request.instance_id);
+                const int32 num_units =
+                    instance.interfaces.unit_info->getUnitCount();
 
-                Steinberg::Vst::UnitInfo info{};
-                const tresult result =
-                    instance.interfaces.unit_info->getUnitInfo(
-                        request.unit_index, info);
+                std::vector<std::optional<Steinberg::Vst::UnitInfo>> infos;
+                infos.reserve(std::max(num_units, 0));
+                for (int32 i = 0; i < num_units; i++) {
+                    Steinberg::Vst::UnitInfo info{};
+                    if (instance.interfaces.unit_info->getUnitInfo(i, info) ==
+                        Steinberg::kResultOk) {
+                        infos.push_back(std::move(info));
+                    } else {
+                        infos.push_back(std::nullopt);
+                    }
+                }
 
-                return YaUnitInfo::GetUnitInfoResponse{.result = result,
-                                                       .info = std::move(info)};
+                return YaUnitInfo::GetUnitInfosResponse{.infos =
+                                                            std::move(infos)};
             },
-            [&](const YaUnitInfo::GetProgramListCount& request)
-                -> YaUnitInfo::GetProgramListCount::Response {
+            [&](const YaUnitInfo::GetProgramListInfos& request)
+                -> YaUnitInfo::GetProgramListInfos::Response {
                 const auto& [instance, _] = get_instance(request.instance_id);
 
-                return instance.interfaces.unit_info->getProgramListCount();
+                const int32 num_program_lists =
+                    instance.interfaces.unit_info->getProgramListCount();
+
+                std::vector<std::optional<Steinberg::Vst::ProgramListInfo>>
+                    infos;
+                infos.reserve(std::max(num_program_lists, 0));
+                for (int32 i = 0; i < num_program_lists; i++) {
+                    Steinberg::Vst::ProgramListInfo info{};
+                    if (instance.interfaces.unit_info->getProgramListInfo(
+                            i, info) == Steinberg::kResultOk) {
+                        infos.push_back(std::move(info));
+                    } else {
+                        infos.push_back(std::nullopt);
+                    }
+                }
+
+                return YaUnitInfo::GetProgramListInfosResponse{
+                    .infos = std::move(infos)};
             },
-            [&](const YaUnitInfo::GetProgramListInfo& request)
-                -> YaUnitInfo::GetProgramListInfo::Response {
-                const auto& [instance, _] = get_instance(request.instance_id);
+            [&](const YaUnitInfo::GetProgramNames& request)
+                -> YaUnitInfo::GetProgramNames::Response {
+                // NOTE: Just like with `GetProgramName` below, this will likely
+                //       be requested in response to
+                //       `IUnitHandler::notifyProgramListChange`
+                return do_mutual_recursion_on_off_thread(
+                    [&]() -> YaUnitInfo::GetProgramNamesResponse {
+                        const auto& [instance, _] =
+                            get_instance(request.instance_id);
 
-                Steinberg::Vst::ProgramListInfo info{};
-                const tresult result =
-                    instance.interfaces.unit_info->getProgramListInfo(
-                        request.list_index, info);
+                        std::vector<std::optional<std::u16string>> names;
+                        names.reserve(std::max(request.program_count, 0));
+                        for (int32 i = 0; i < request.program_count; i++) {
+                            Steinberg::Vst::String128 name{0};
+                            if (instance.interfaces.unit_info->getProgramName(
+                                    request.list_id, i, name) ==
+                                Steinberg::kResultOk) {
+                                names.push_back(
+                                    tchar_pointer_to_u16string(name));
+                            } else {
+                                names.push_back(std::nullopt);
+                            }
+                        }
 
-                return YaUnitInfo::GetProgramListInfoResponse{
-                    .result = result, .info = std::move(info)};
+                        return YaUnitInfo::GetProgramNamesResponse{
+                            .names = std::move(names)};
+                    });
             },
             [&](const YaUnitInfo::GetProgramName& request)
                 -> YaUnitInfo::GetProgramName::Response {
@@ -1346,6 +1420,33 @@ void Vst3Bridge::register_context_menu(Vst3ContextMenuProxyImpl& context_menu) {
         std::ref<Vst3ContextMenuProxyImpl>(context_menu));
 }
 
+void Vst3Bridge::post_set_dirty(size_t instance_id, bool state) {
+    {
+        const auto& [instance, _] = get_instance(instance_id);
+
+        // If there already was a pending call, then the task scheduled for that
+        // call will send this new state instead
+        if (instance.pending_dirty_state.exchange(state) != -1) {
+            return;
+        }
+    }
+
+    schedule_task_while_alive([this, instance_id]() {
+        // The instance may have been removed in the meantime. Holding on to
+        // this lock while sending the message also ensures that the instance
+        // is still alive on the native plugin side.
+        std::shared_lock lock(object_instances_mutex_);
+        const auto instance = object_instances_.find(instance_id);
+        if (instance == object_instances_.end()) {
+            return;
+        }
+
+        const int state = instance->second.pending_dirty_state.exchange(-1);
+        send_message(YaComponentHandler2::SetDirty{
+            .owner_instance_id = instance_id, .state = state == 1});
+    });
+}
+
 void Vst3Bridge::unregister_context_menu(
     Vst3ContextMenuProxyImpl& context_menu) {
     const auto& [owner_instance, _] =
@@ -1422,7 +1523,8 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
 
             for (size_t channel = 0; channel < num_channels; channel++) {
                 bus_offsets[bus][channel] = current_offset;
-                current_offset += setup->maxSamplesPerBlock * sample_size;
+                current_offset += AudioShmBuffer::aligned_channel_size(
+                    setup->maxSamplesPerBlock, sample_size);
             }
         }
 
@@ -1468,6 +1570,9 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
     AudioShmBuffer::Config buffer_config{
         .name = sockets_.base_dir_.filename().string() + "-" +
                 std::to_string(instance_id),
+        .backing = config_.audio_buffer_huge_pages
+                       ? AudioShmBuffer::Config::Backing::memfd_hugetlb
+                       : AudioShmBuffer::Config::Backing::posix_shm,
         .size = buffer_size,
         .input_offsets = std::move(input_bus_offsets_vector),
         .output_offsets = std::move(output_bus_offsets_vector)};
@@ -1525,7 +1630,9 @@ std::optional<AudioShmBuffer::Config> Vst3Bridge::setup_shared_audio_buffers(
             }
         });
 
-    return buffer_config;
+    // The buffer may have created a memfd or fallen back to a different
+    // backing, so the native plugin needs the updated configuration
+    return instance.process_buffers->config_;
 }
 
 size_t Vst3Bridge::register_object_instance(
@@ -1545,6 +1652,7 @@ size_t Vst3Bridge::register_object_instance(
         object_instances_.at(instance_id)
             .audio_processor_handler = Win32Thread([&, instance_id]() {
             set_realtime_priority(true);
+            apply_audio_thread_affinity(config_);
 
             // XXX: Like with VST2 worker threads, when using plugin groups the
             //      thread names from different plugins will clash. Not a huge
@@ -1656,6 +1764,8 @@ size_t Vst3Bridge::register_object_instance(
                             set_realtime_priority(
                                 true, *request.new_realtime_priority);
                         }
+                        apply_host_audio_thread_affinity(
+                            config_, request.new_cpu_affinity_mask);
 
                         const auto& [instance, _] =
                             get_instance(request.instance_id);
@@ -1672,30 +1782,47 @@ size_t Vst3Bridge::register_object_instance(
                         //       processing is done from the audio thread while
                         //       the plugin is in offline processing mode. Yes
                         //       that's as silly as it sounds.
+                        //       The timer needs to be started on the thread
+                        //       that calls the plugin, since it also measures
+                        //       that thread's CPU time.
                         tresult result;
+                        ProcessTiming timing;
                         auto& reconstructed = request.data.reconstruct(
                             instance.process_buffers_input_pointers,
-                            instance.process_buffers_output_pointers);
+                            instance.process_buffers_output_pointers,
+                            instance.process_context_delta_state);
                         if (instance.process_setup &&
                             instance.process_setup->processMode ==
                                 Steinberg::Vst::kOffline) {
-                            result = main_context_
-                                         .run_in_context([&instance = instance,
-                                                          &reconstructed]() {
-                                             return instance.interfaces
-                                                 .audio_processor->process(
-                                                     reconstructed);
-                                         })
-                                         .get();
+                            std::tie(result, timing) =
+                                main_context_
+                                    .run_in_context(
+                                        [&, &instance = instance]() {
+                                            const ProcessTimer process_timer(
+                                                process_timing_enabled());
+                                            const tresult result =
+                                                instance.interfaces
+                                                    .audio_processor->process(
+                                                        reconstructed);
+
+                                            return std::pair(
+                                                result,
+                                                process_timer.elapsed());
+                                        })
+                                    .get();
                         } else {
+                            const ProcessTimer process_timer(
+                                process_timing_enabled());
                             result =
                                 instance.interfaces.audio_processor->process(
                                     reconstructed);
+                            timing = process_timer.elapsed();
                         }
 
                         return YaAudioProcessor::ProcessResponse{
                             .result = result,
-                            .output_data = request.data.create_response()};
+                            .output_data = request.data.create_response(),
+                            .timing = timing};
                     },
                     [&](const YaAudioProcessor::GetTailSamples& request)
                         -> YaAudioProcessor::GetTailSamples::Response {
@@ -1798,10 +1925,26 @@ size_t Vst3Bridge::register_object_instance(
                                         setup_shared_audio_buffers(
                                             request.instance_id);
 
+                                // The native plugin uses this to only send
+                                // the parts of the process context the
+                                // plugin actually needs
+                                std::optional<uint32>
+                                    process_context_requirements;
+                                if (request.state &&
+                                    instance.interfaces
+                                        .process_context_requirements) {
+                                    process_context_requirements =
+                                        instance.interfaces
+                                            .process_context_requirements
+                                            ->getProcessContextRequirements();
+                                }
+
                                 return YaComponent::SetActiveResponse{
                                     .result = result,
                                     .updated_audio_buffers_config = std::move(
-                                        updated_audio_buffers_config)};
+                                        updated_audio_buffers_config),
+                                    .process_context_requirements =
+                                        process_context_requirements};
                             });
                     },
                     [&](const YaPrefetchableSupport::GetPrefetchableSupport&
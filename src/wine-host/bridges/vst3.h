@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <shared_mutex>
@@ -167,6 +168,14 @@ struct Vst3PluginInstance {
         registered_context_menus;
     std::mutex registered_context_menus_mutex;
 
+    /**
+     * The state passed to the last `IComponentHandler2::setDirty()` call that
+     * has not yet been sent to the host, or -1 if there is no pending call.
+     *
+     * @relates Vst3Bridge::post_set_dirty
+     */
+    std::atomic_int pending_dirty_state = -1;
+
     /**
      * A shared memory object we'll write the input audio buffers to on the
      * native plugin side. We'll then let the plugin write its outputs here on
@@ -195,6 +204,16 @@ struct Vst3PluginInstance {
      */
     std::vector<std::vector<void*>> process_buffers_output_pointers;
 
+    /**
+     * The process context is delta encoded against the process context sent
+     * during the previous processing cycle. This is used to reconstruct the
+     * full `ProcessContext` from the changed fields in `YaProcessData`. This
+     * can't be part of `YaProcessData` itself since that object is thread
+     * local on the Wine side.
+     */
+    TransportDeltaState<Steinberg::Vst::ProcessContext>
+        process_context_delta_state;
+
     /**
      * This instance's editor, if it has an open editor. Embedding here works
      * exactly the same as how it works for VST2 plugins.
@@ -317,6 +336,14 @@ class Vst3Bridge : public HostBridge {
      */
     void register_context_menu(Vst3ContextMenuProxyImpl& context_menu);
 
+    /**
+     * Relay `IComponentHandler2::setDirty()` to the host without making the
+     * plugin wait for it. The call is sent from the main thread, and any calls
+     * made in the meantime are coalesced so only the last state is sent. Some
+     * plugins call this function on every parameter change.
+     */
+    void post_set_dirty(size_t instance_id, bool state);
+
     /**
      * Remove a previously registered context menu from `object_instances`. This
      * is called from the destructor of `Vst3ContextMenuProxyImpl` just before
@@ -16,8 +16,12 @@
 
 #include "editor.h"
 
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 
 #include <llvm/small-vector.h>
 
@@ -50,6 +54,19 @@ using namespace std::literals::string_literals;
  */
 constexpr size_t idle_timer_id = 1337;
 
+/**
+ * The interval for the idle timer while the editor is not visible. We still
+ * need to handle X11 events in the meantime to know when the editor becomes
+ * visible again.
+ */
+constexpr std::chrono::milliseconds hidden_editor_idle_interval(250);
+
+/**
+ * When the `idle_frame_rate` option is set, editors switch to that lower frame
+ * rate once the user has not interacted with them for this long.
+ */
+constexpr std::chrono::seconds editor_interaction_timeout(3);
+
 /**
  * The X11 event mask for the host window, which in most DAWs except for Ardour
  * and REAPER will be the same as `parent_window_`.
@@ -67,6 +84,12 @@ constexpr uint32_t parent_event_mask =
     host_event_mask | XCB_EVENT_MASK_FOCUS_CHANGE |
     XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW;
 
+/**
+ * The X11 event mask for the root window. We cache whether the Wine window is
+ * active, so we need to know when `_NET_ACTIVE_WINDOW` changes.
+ */
+constexpr uint32_t root_event_mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+
 /**
  * The X11 event mask for our wrapper window. We will forward synthetic keyboard
  * events sent by the host to the Wine window.
@@ -116,6 +139,14 @@ constexpr uint32_t xembed_focus_first = 1;
  */
 static const HCURSOR arrow_cursor = LoadCursor(nullptr, IDC_ARROW);
 
+/**
+ * Atoms that have already been looked up using `get_atom_by_name()` or
+ * `prefetch_atoms()`. All of our X11 connections connect to the same display,
+ * so these can be shared between connections.
+ */
+static std::mutex atom_cache_mutex;
+static std::unordered_map<std::string, xcb_atom_t> atom_cache;
+
 /**
  * Find the the ancestors for the given window. This returns a list of window
  * IDs that starts with `starting_at`, and then iteratively contains the parent
@@ -263,6 +294,7 @@ Editor::Editor(MainContext& main_context,
     : use_coordinate_hack_(config.editor_coordinate_hack),
       use_force_dnd_(config.editor_force_dnd),
       use_xembed_(config.editor_xembed),
+      main_context_(main_context),
       logger_(logger),
       x11_connection_(xcb_connect(nullptr, nullptr), xcb_disconnect),
       dnd_proxy_handle_(WineXdndProxy::get_handle()),
@@ -300,12 +332,19 @@ Editor::Editor(MainContext& main_context,
                                    nullptr,
                                    GetModuleHandle(nullptr),
                                    this)),
-      idle_timer_(
-          Win32Timer(win32_window_.handle_,
-                     idle_timer_id,
-                     std::chrono::duration_cast<std::chrono::milliseconds>(
-                         config.event_loop_interval())
-                         .count())),
+      idle_timer_interval_(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              config.event_loop_interval())),
+      throttled_idle_timer_interval_(
+          config.idle_event_loop_interval()
+              ? std::optional(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        *config.idle_event_loop_interval()))
+              : std::nullopt),
+      current_idle_timer_interval_(idle_timer_interval_),
+      idle_timer_(Win32Timer(win32_window_.handle_,
+                             idle_timer_id,
+                             idle_timer_interval_.count())),
       idle_timer_proc_([this, timer_proc = std::move(timer_proc)]() mutable {
           handle_x11_events();
           if (timer_proc) {
@@ -339,7 +378,11 @@ Editor::Editor(MainContext& main_context,
       host_window_(find_host_window(*x11_connection_,
                                     parent_window_,
                                     xcb_wm_state_property_)
-                       .value_or(parent_window_)) {
+                       .value_or(parent_window_)),
+      root_window_(get_root_window(*x11_connection_, parent_window_)) {
+    main_context_.set_editor_timer_interval(this,
+                                            current_idle_timer_interval_);
+
     logger.log_editor_trace([&]() {
         return "DEBUG: host_window: " + std::to_string(host_window_);
     });
@@ -360,6 +403,8 @@ Editor::Editor(MainContext& main_context,
     // clicks on the window (which should trigger a `WM_PARENTNOTIFY`).
     active_window_property_ =
         get_atom_by_name(*x11_connection_, active_window_property_name);
+    xcb_change_window_attributes(x11_connection_.get(), root_window_,
+                                 XCB_CW_EVENT_MASK, &root_event_mask);
     if (!supports_ewmh_active_window()) {
         std::cerr << "WARNING: The current window manager does not support the"
                   << std::endl;
@@ -369,6 +414,33 @@ Editor::Editor(MainContext& main_context,
                   << std::endl;
     }
 
+#ifdef WITH_XCB_DAMAGE
+    // We'll use XDamage to find out whether the plugin is still drawing to its
+    // editor when `idle_frame_rate` is set. The extension's version has to be
+    // negotiated before it can be used.
+    if (throttled_idle_timer_interval_) {
+        const xcb_query_extension_reply_t* damage_extension =
+            xcb_get_extension_data(x11_connection_.get(), &xcb_damage_id);
+        if (damage_extension && damage_extension->present) {
+            const std::unique_ptr<xcb_damage_query_version_reply_t>
+                version_reply(xcb_damage_query_version_reply(
+                    x11_connection_.get(),
+                    xcb_damage_query_version(x11_connection_.get(),
+                                             XCB_DAMAGE_MAJOR_VERSION,
+                                             XCB_DAMAGE_MINOR_VERSION),
+                    nullptr));
+            if (version_reply) {
+                damage_first_event_ = damage_extension->first_event;
+                wine_window_damage_ = xcb_generate_id(x11_connection_.get());
+                xcb_damage_create(x11_connection_.get(), wine_window_damage_,
+                                  wine_window_,
+                                  XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+                xcb_flush(x11_connection_.get());
+            }
+        }
+    }
+#endif
+
     // When using XEmbed we'll need the atoms for the corresponding properties
     xcb_xembed_message_ =
         get_atom_by_name(*x11_connection_, xembed_message_name);
@@ -476,10 +548,17 @@ void Editor::handle_x11_events() noexcept {
                 return "DEBUG: Performing spooled local coordinate fix";
             });
 
-            fix_local_coordinates();
+            fix_local_coordinates(true);
             should_fix_local_coordinates_ = false;
         }
 
+        // We reset this cache when `_NET_ACTIVE_WINDOW` changes, but we can't
+        // rely on that alone. If the window manager doesn't update that
+        // property on the root window, or if that event gets lost, then we
+        // would keep acting on an outdated focus state. We'll reuse the cached
+        // result only within a single batch of events.
+        is_wine_window_active_cache_.reset();
+
         std::unique_ptr<xcb_generic_event_t> generic_event;
         while (generic_event.reset(xcb_poll_for_event(x11_connection_.get())),
                generic_event != nullptr) {
@@ -487,6 +566,21 @@ void Editor::handle_x11_events() noexcept {
                 generic_event->response_type & xcb_event_type_mask;
             const bool is_synthetic_event =
                 generic_event->response_type & ~xcb_event_type_mask;
+
+#ifdef WITH_XCB_DAMAGE
+            // XDamage events don't have a fixed event type, so they can't be
+            // handled in the switch below
+            if (damage_first_event_ &&
+                event_type == *damage_first_event_ + XCB_DAMAGE_NOTIFY) {
+                xcb_damage_subtract(x11_connection_.get(), wine_window_damage_,
+                                    XCB_NONE, XCB_NONE);
+                xcb_flush(x11_connection_.get());
+                note_redraw();
+
+                continue;
+            }
+#endif
+
             switch (event_type) {
                 // NOTE: When reopening a closed editor window in REAPER, REAPER
                 //       will initialize the editor first, and only then will it
@@ -512,6 +606,11 @@ void Editor::handle_x11_events() noexcept {
                                std::to_string(event->event);
                     });
 
+                    // The window tree changed, so any cached results based on
+                    // it are no longer valid
+                    is_wine_window_active_cache_.reset();
+                    wine_window_ancestors_cache_.reset();
+
                     redetect_host_window();
 
                     // If the `editor_force_dnd` option is set, we'll strip
@@ -561,6 +660,15 @@ void Editor::handle_x11_events() noexcept {
                     if (event->window == host_window_ ||
                         event->window == parent_window_ ||
                         event->window == wrapper_window_.window_) {
+                        // Only repeated events for the host's windows while
+                        // dragging them around can be deduplicated. The
+                        // wrapper window gets reconfigured when the editor is
+                        // resized, and Wine needs to be told about that
+                        // regardless of whether the window has moved.
+                        if (event->window == wrapper_window_.window_) {
+                            last_local_coordinates_.reset();
+                        }
+
                         if (!use_xembed_) {
                             // NOTE: See the docstring on this field. This
                             //       avoids flickering with some window manager
@@ -575,7 +683,7 @@ void Editor::handle_x11_events() noexcept {
 
                                 should_fix_local_coordinates_ = true;
                             } else {
-                                fix_local_coordinates();
+                                fix_local_coordinates(true);
                             }
                         }
                     }
@@ -598,6 +706,43 @@ void Editor::handle_x11_events() noexcept {
                             do_xembed();
                         }
                     }
+
+                    if (event->window == parent_window_) {
+                        parent_window_obscured_ =
+                            event->state == XCB_VISIBILITY_FULLY_OBSCURED;
+                        update_suspended();
+                    }
+                } break;
+                // There's no point in drawing the editor while the window is
+                // minimized, on another virtual desktop, or otherwise hidden,
+                // so we'll suspend the editor until the window gets mapped
+                // again
+                case XCB_MAP_NOTIFY:
+                case XCB_UNMAP_NOTIFY: {
+                    const xcb_window_t window =
+                        event_type == XCB_MAP_NOTIFY
+                            ? reinterpret_cast<xcb_map_notify_event_t*>(
+                                  generic_event.get())
+                                  ->window
+                            : reinterpret_cast<xcb_unmap_notify_event_t*>(
+                                  generic_event.get())
+                                  ->window;
+                    logger_.log_editor_trace([&]() {
+                        return "DEBUG: "s +
+                               (event_type == XCB_MAP_NOTIFY ? "MapNotify"
+                                                             : "UnmapNotify") +
+                               " for window " + std::to_string(window);
+                    });
+
+                    const bool unmapped = event_type == XCB_UNMAP_NOTIFY;
+                    if (window == host_window_) {
+                        host_window_unmapped_ = unmapped;
+                    }
+                    if (window == parent_window_) {
+                        parent_window_unmapped_ = unmapped;
+                    }
+
+                    update_suspended();
                 } break;
                 // We want to grab keyboard input focus when the user hovers
                 // over our embedded Wine window AND that window is a child of
@@ -630,6 +775,11 @@ void Editor::handle_x11_events() noexcept {
 
                     if (window == parent_window_ ||
                         window == wrapper_window_.window_) {
+                        if (event_type == XCB_ENTER_NOTIFY) {
+                            pointer_in_editor_ = true;
+                        }
+                        note_user_interaction();
+
                         if (!use_xembed_) {
                             fix_local_coordinates();
                         }
@@ -656,6 +806,11 @@ void Editor::handle_x11_events() noexcept {
                         reinterpret_cast<xcb_leave_notify_event_t*>(
                             generic_event.get());
 
+                    if (event->child == wrapper_window_.window_) {
+                        pointer_in_editor_ = false;
+                        note_user_interaction();
+                    }
+
                     // HACK: We need to do a `WindowFromPoint()` query inside of
                     //       `is_cursor_in_wine_window()`, and
                     //       `GetCursorPos()`'s value only updates once every
@@ -720,6 +875,22 @@ void Editor::handle_x11_events() noexcept {
                         set_input_focus(false);
                     }
                 } break;
+                // We only listen for property changes on the root window,
+                // where the window manager updates `_NET_ACTIVE_WINDOW`
+                // whenever another window gets activated
+                case XCB_PROPERTY_NOTIFY: {
+                    const auto event =
+                        reinterpret_cast<xcb_property_notify_event_t*>(
+                            generic_event.get());
+                    if (event->window == root_window_ &&
+                        event->atom == active_window_property_) {
+                        logger_.log_editor_trace([&]() {
+                            return "DEBUG: Active window changed"s;
+                        });
+
+                        is_wine_window_active_cache_.reset();
+                    }
+                } break;
                 // We need to forward synthetic keyboard events sent by the host
                 // from the wrapper window to the Wine window
                 // NOTE: We're _only_ forwarding synthetic events sent by the
@@ -745,6 +916,8 @@ void Editor::handle_x11_events() noexcept {
 
                     if (is_synthetic_event &&
                         event->event == wrapper_window_.window_) {
+                        note_user_interaction();
+
                         const uint32_t event_mask =
                             event_type == XCB_KEY_PRESS
                                 ? XCB_EVENT_MASK_KEY_PRESS
@@ -782,7 +955,7 @@ HWND Editor::win32_handle() const noexcept {
     return win32_window_.handle_;
 }
 
-void Editor::fix_local_coordinates() const {
+void Editor::fix_local_coordinates(bool only_if_moved) const {
     if (use_xembed_) {
         return;
     }
@@ -798,8 +971,6 @@ void Editor::fix_local_coordinates() const {
     // window created by the plugin itself. In this case it doesn't matter that
     // the Win32 window is larger than the part of the client area the plugin
     // draws to since any excess will be clipped off by the parent window.
-    const xcb_window_t root = get_root_window(*x11_connection_, parent_window_);
-
     // We can't directly use the `event.x` and `event.y` coordinates because the
     // parent window may also be embedded inside another window.
     // NOTE: Tracktion Waveform uses client side decorations, and for VST2
@@ -811,7 +982,7 @@ void Editor::fix_local_coordinates() const {
     xcb_generic_error_t* error = nullptr;
     const xcb_translate_coordinates_cookie_t translate_cookie =
         xcb_translate_coordinates(x11_connection_.get(),
-                                  wrapper_window_.window_, root, 0, 0);
+                                  wrapper_window_.window_, root_window_, 0, 0);
     const std::unique_ptr<xcb_translate_coordinates_reply_t>
         translated_coordinates(xcb_translate_coordinates_reply(
             x11_connection_.get(), translate_cookie, &error));
@@ -830,6 +1001,13 @@ void Editor::fix_local_coordinates() const {
     translated_event.x = translated_coordinates->dst_x;
     translated_event.y = translated_coordinates->dst_y;
 
+    const std::pair<int16_t, int16_t> local_coordinates(translated_event.x,
+                                                        translated_event.y);
+    if (only_if_moved && last_local_coordinates_ == local_coordinates) {
+        return;
+    }
+    last_local_coordinates_ = local_coordinates;
+
     logger_.log_editor_trace([&]() {
         return "DEBUG: Spoofing local coordinates to (" +
                std::to_string(translated_event.x) + ", " +
@@ -926,8 +1104,60 @@ void Editor::set_input_focus(bool grab) const {
     xcb_flush(x11_connection_.get());
 }
 
+Editor::~Editor() noexcept {
+    main_context_.remove_editor_timer_interval(this);
+
+#ifdef WITH_XCB_DAMAGE
+    if (wine_window_damage_ != XCB_NONE) {
+        xcb_damage_destroy(x11_connection_.get(), wine_window_damage_);
+        xcb_flush(x11_connection_.get());
+    }
+#endif
+}
+
 void Editor::run_timer_proc() {
+    if (suspended_) {
+        handle_x11_events();
+        return;
+    }
+
     idle_timer_proc_();
+
+    // Interacting with the editor immediately unthrottles it in
+    // `note_user_interaction()` and `note_redraw()`, so we only need to check
+    // for the opposite
+    const auto now = std::chrono::steady_clock::now();
+    if (throttled_idle_timer_interval_ && !throttled_ && !pointer_in_editor_ &&
+        now - last_user_interaction_ >= editor_interaction_timeout &&
+        now - last_redraw_ >= editor_interaction_timeout) {
+        logger_.log_editor_trace(
+            []() { return "DEBUG: No recent user interaction, throttling"s; });
+
+        throttled_ = true;
+        update_idle_timer();
+    }
+}
+
+void Editor::note_redraw() noexcept {
+    last_redraw_ = std::chrono::steady_clock::now();
+    if (throttled_) {
+        logger_.log_editor_trace(
+            []() { return "DEBUG: Editor redrawn, unthrottling"s; });
+
+        throttled_ = false;
+        update_idle_timer();
+    }
+}
+
+void Editor::note_user_interaction() noexcept {
+    last_user_interaction_ = std::chrono::steady_clock::now();
+    if (throttled_) {
+        logger_.log_editor_trace(
+            []() { return "DEBUG: User interaction, unthrottling"s; });
+
+        throttled_ = false;
+        update_idle_timer();
+    }
 }
 
 std::optional<uint16_t> Editor::get_active_modifiers() const noexcept {
@@ -1001,17 +1231,28 @@ bool Editor::is_wine_window_active() const {
         return false;
     }
 
-    // We will only grab focus when the Wine window is active. To do this we'll
-    // read the `_NET_ACTIVE_WINDOW` property from the root window (which can
-    // change when the window gets moved to another screen, so we won't cache
-    // this).
-    const xcb_window_t root_window =
-        get_root_window(*x11_connection_, wine_window_);
+    if (is_wine_window_active_cache_) {
+        return *is_wine_window_active_cache_;
+    }
 
+    // We will only grab focus when the Wine window is active. To do this we'll
+    // read the `_NET_ACTIVE_WINDOW` property from the root window. The window
+    // tree rarely changes, so we can send this request first and then look up
+    // the ancestors in the meantime if they're not already cached.
     xcb_generic_error_t* error = nullptr;
     const xcb_get_property_cookie_t property_cookie =
-        xcb_get_property(x11_connection_.get(), false, root_window,
+        xcb_get_property(x11_connection_.get(), false, root_window_,
                          active_window_property_, XCB_ATOM_WINDOW, 0, 1);
+    if (!wine_window_ancestors_cache_) {
+        try {
+            wine_window_ancestors_cache_ =
+                find_ancestor_windows(*x11_connection_, wine_window_);
+        } catch (...) {
+            xcb_discard_reply(x11_connection_.get(), property_cookie.sequence);
+            throw;
+        }
+    }
+
     const std::unique_ptr<xcb_get_property_reply_t> property_reply(
         xcb_get_property_reply(x11_connection_.get(), property_cookie, &error));
     THROW_X11_ERROR(error);
@@ -1019,8 +1260,14 @@ bool Editor::is_wine_window_active() const {
     const xcb_window_t active_window = *static_cast<xcb_window_t*>(
         xcb_get_property_value(property_reply.get()));
 
-    return is_child_window_or_same(*x11_connection_, wine_window_,
-                                   active_window);
+    // This is equivalent to `is_child_window_or_same(wine_window_,
+    // active_window)`
+    is_wine_window_active_cache_ =
+        std::find(wine_window_ancestors_cache_->begin(),
+                  wine_window_ancestors_cache_->end(),
+                  active_window) != wine_window_ancestors_cache_->end();
+
+    return *is_wine_window_active_cache_;
 }
 
 void Editor::redetect_host_window() noexcept {
@@ -1055,6 +1302,60 @@ void Editor::redetect_host_window() noexcept {
 
     host_window_ = new_host_window;
     xcb_flush(x11_connection_.get());
+
+    // We don't know anything about the new window yet, but it is most likely
+    // mapped if the host just reparented us into it
+    host_window_unmapped_ = false;
+    update_suspended();
+}
+
+void Editor::update_suspended() noexcept {
+    const bool should_suspend = host_window_unmapped_ ||
+                                parent_window_unmapped_ ||
+                                parent_window_obscured_;
+    if (should_suspend == suspended_) {
+        return;
+    }
+
+    logger_.log_editor_trace([&]() {
+        return should_suspend ? "DEBUG: Editor is hidden, suspending"s
+                              : "DEBUG: Editor is visible again, resuming"s;
+    });
+
+    // `WM_SETREDRAW` clears the window's `WS_VISIBLE` style without unmapping
+    // it. Invalidating the plugin's windows then becomes a no-op, so plugins
+    // that repaint on their own timers stop drawing until we turn redrawing
+    // back on again.
+    suspended_ = should_suspend;
+    update_idle_timer();
+    if (suspended_) {
+        SendMessage(win32_window_.handle_, WM_SETREDRAW, FALSE, 0);
+    } else {
+        SendMessage(win32_window_.handle_, WM_SETREDRAW, TRUE, 0);
+        RedrawWindow(win32_window_.handle_, nullptr, nullptr,
+                     RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN);
+    }
+}
+
+void Editor::update_idle_timer() noexcept {
+    std::chrono::milliseconds interval = idle_timer_interval_;
+    if (throttled_ && throttled_idle_timer_interval_) {
+        interval = *throttled_idle_timer_interval_;
+    }
+    if (suspended_) {
+        interval = std::max(interval, hidden_editor_idle_interval);
+    }
+
+    if (interval == current_idle_timer_interval_) {
+        return;
+    }
+
+    // Setting a timer with the same ID replaces the old timer
+    current_idle_timer_interval_ = interval;
+    idle_timer_ = Win32Timer(win32_window_.handle_, idle_timer_id,
+                             current_idle_timer_interval_.count());
+    main_context_.set_editor_timer_interval(this,
+                                            current_idle_timer_interval_);
 }
 
 bool Editor::supports_ewmh_active_window() const {
@@ -1070,15 +1371,12 @@ bool Editor::supports_ewmh_active_window() const {
         return false;
     }
 
-    const xcb_window_t root_window =
-        get_root_window(*x11_connection_, wine_window_);
-
     // If the `_NET_ACTIVE_WINDOW` property does not exist on the root window,
     // the returned property type will be `XCB_ATOM_NONE` as specified in the
     // X11 manual
     xcb_generic_error_t* error = nullptr;
     const xcb_get_property_cookie_t property_cookie =
-        xcb_get_property(x11_connection_.get(), false, root_window,
+        xcb_get_property(x11_connection_.get(), false, root_window_,
                          active_window_property_, XCB_ATOM_WINDOW, 0, 1);
     const std::unique_ptr<xcb_get_property_reply_t> property_reply(
         xcb_get_property_reply(x11_connection_.get(), property_cookie, &error));
@@ -1113,6 +1411,12 @@ void Editor::send_xembed_message(xcb_window_t window,
 }
 
 void Editor::do_reparent(xcb_window_t child, xcb_window_t new_parent) const {
+    if (child == wine_window_) {
+        last_local_coordinates_.reset();
+        is_wine_window_active_cache_.reset();
+        wine_window_ancestors_cache_.reset();
+    }
+
     const xcb_void_cookie_t reparent_cookie = xcb_reparent_window_checked(
         x11_connection_.get(), child, new_parent, 0, 0);
     if (std::unique_ptr<xcb_generic_error_t> reparent_error(
@@ -1241,7 +1545,13 @@ LRESULT CALLBACK window_proc(HWND handle,
         case WM_PARENTNOTIFY: {
             auto editor = reinterpret_cast<Editor*>(
                 GetWindowLongPtr(handle, GWLP_USERDATA));
-            if (!editor || editor->supports_ewmh_active_window()) {
+            if (!editor) {
+                break;
+            }
+
+            // This is also sent when the user clicks on the plugin's window
+            editor->note_user_interaction();
+            if (editor->supports_ewmh_active_window()) {
                 break;
             }
 
@@ -1313,27 +1623,35 @@ std::optional<xcb_window_t> find_host_window(
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     xcb_window_t starting_at,
     xcb_atom_t xcb_wm_state_property) {
-    // See the docstring for why this works the way it does
+    // See the docstring for why this works the way it does. We'll request the
+    // properties for all ancestors at once so this only needs a single round
+    // trip, and then take the topmost window that has `WM_STATE` set.
     const auto ancestors = find_ancestor_windows(x11_connection, starting_at);
-    for (auto window = ancestors.rbegin(); window != ancestors.rend();
-         window++) {
+    llvm::SmallVector<xcb_get_property_cookie_t, 8> property_cookies;
+    for (const xcb_window_t& window : ancestors) {
+        property_cookies.push_back(
+            xcb_get_property(&x11_connection, false, window,
+                             xcb_wm_state_property, XCB_ATOM_WINDOW, 0, 1));
+    }
+
+    // All replies need to be read, even after we've found a match
+    std::optional<xcb_window_t> host_window;
+    for (size_t i = 0; i < ancestors.size(); i++) {
         xcb_generic_error_t* error = nullptr;
-        const xcb_get_property_cookie_t property_cookie =
-            xcb_get_property(&x11_connection, false, *window,
-                             xcb_wm_state_property, XCB_ATOM_WINDOW, 0, 1);
         const std::unique_ptr<xcb_get_property_reply_t> property_reply(
-            xcb_get_property_reply(&x11_connection, property_cookie, &error));
+            xcb_get_property_reply(&x11_connection, property_cookies[i],
+                                   &error));
         if (error) {
             free(error);
             continue;
         }
 
         if (property_reply->type != XCB_NONE) {
-            return *window;
+            host_window = ancestors[i];
         }
     }
 
-    return std::nullopt;
+    return host_window;
 }
 
 bool is_child_window_or_same(
@@ -1367,6 +1685,14 @@ bool is_child_window_or_same(
 
 xcb_atom_t get_atom_by_name(xcb_connection_t& x11_connection,
                             const char* atom_name) {
+    {
+        std::lock_guard lock(atom_cache_mutex);
+        if (const auto atom = atom_cache.find(atom_name);
+            atom != atom_cache.end()) {
+            return atom->second;
+        }
+    }
+
     xcb_generic_error_t* error = nullptr;
     xcb_intern_atom_cookie_t atom_cookie =
         xcb_intern_atom(&x11_connection, true, strlen(atom_name), atom_name);
@@ -1374,9 +1700,47 @@ xcb_atom_t get_atom_by_name(xcb_connection_t& x11_connection,
         xcb_intern_atom_reply(&x11_connection, atom_cookie, &error));
     THROW_X11_ERROR(error);
 
+    // Atoms that don't exist yet may still be created later by another
+    // application, so we won't cache those
+    if (atom_reply->atom != XCB_ATOM_NONE) {
+        std::lock_guard lock(atom_cache_mutex);
+        atom_cache.emplace(atom_name, atom_reply->atom);
+    }
+
     return atom_reply->atom;
 }
 
+void prefetch_atoms(xcb_connection_t& x11_connection,
+                    std::initializer_list<const char*> atom_names) {
+    llvm::SmallVector<std::pair<const char*, xcb_intern_atom_cookie_t>, 16>
+        atom_cookies;
+    {
+        std::lock_guard lock(atom_cache_mutex);
+        for (const char* atom_name : atom_names) {
+            if (!atom_cache.contains(atom_name)) {
+                atom_cookies.emplace_back(
+                    atom_name, xcb_intern_atom(&x11_connection, true,
+                                               strlen(atom_name), atom_name));
+            }
+        }
+    }
+
+    for (const auto& [atom_name, atom_cookie] : atom_cookies) {
+        xcb_generic_error_t* error = nullptr;
+        const std::unique_ptr<xcb_intern_atom_reply_t> atom_reply(
+            xcb_intern_atom_reply(&x11_connection, atom_cookie, &error));
+        if (error) {
+            free(error);
+            continue;
+        }
+
+        if (atom_reply->atom != XCB_ATOM_NONE) {
+            std::lock_guard lock(atom_cache_mutex);
+            atom_cache.emplace(atom_name, atom_reply->atom);
+        }
+    }
+}
+
 Size get_maximum_screen_dimensions(xcb_connection_t& x11_connection) noexcept {
     xcb_screen_iterator_t iter =
         xcb_setup_roots_iterator(xcb_get_setup(&x11_connection));
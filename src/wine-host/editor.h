@@ -16,16 +16,23 @@
 
 #pragma once
 
+#include <chrono>
+#include <initializer_list>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include <windows.h>
 #include <function2/function2.hpp>
+#include <llvm/small-vector.h>
 
 // Use the native version of xcb
 #pragma push_macro("_WIN32")
 #undef _WIN32
+#ifdef WITH_XCB_DAMAGE
+#include <xcb/damage.h>
+#endif
 #include <xcb/xcb.h>
 #pragma pop_macro("_WIN32")
 
@@ -57,13 +64,25 @@ constexpr char yabridge_window_class_name[] = "yabridge plugin";
 /**
  * Get the atom with the specified name. May throw when
  * `xcb_intern_atom_reply()` returns an error. Returns `XCB_ATOM_NONE` when the
- * atom doesn't exist. We define this here because we'll also need to fetch a
- * whole bunch of atoms for the We define this here because we'll also need to
- * fetch a whole bunch of atoms for the XDND protocol in `xdnd-proxy.cpp`.
+ * atom doesn't exist. Atoms stay valid for as long as the X server is running,
+ * so existing atoms are cached for the entire process and only the first
+ * lookup for an atom needs a round trip to the X server. We define this here
+ * because we'll also need to fetch a whole bunch of atoms for the XDND protocol
+ * in `xdnd-proxy.cpp`.
  */
 xcb_atom_t get_atom_by_name(xcb_connection_t& x11_connection,
                             const char* atom_name);
 
+/**
+ * Look up several atoms at once and add them to the cache used by
+ * `get_atom_by_name()`. All requests are sent before waiting for the first
+ * reply, so this only needs a single round trip to the X server instead of one
+ * round trip per atom. Errors are ignored here, since `get_atom_by_name()` will
+ * simply try again.
+ */
+void prefetch_atoms(xcb_connection_t& x11_connection,
+                    std::initializer_list<const char*> atom_names);
+
 /**
  * Check if the cursor is within a Wine window. We can of course only detect
  * Wine applications within the current prefix. This ignores the extended client
@@ -194,6 +213,12 @@ class Editor {
         const size_t parent_window_handle,
         std::optional<fu2::unique_function<void()>> timer_proc = std::nullopt);
 
+    /**
+     * Stop counting this editor's timer interval towards the main context's
+     * event loop interval.
+     */
+    ~Editor() noexcept;
+
     /**
      * Resize the `wrapper_window_` to this new size. We need to manually call
      * this whenever the plugin requests a resize, or when the host resizes the
@@ -239,8 +264,13 @@ class Editor {
      * WMs may continuously send this message while dragging a window around. To
      * avoid flickering, the main `handle_x11_events()` function will wait to
      * call this function until the all mouse buttons have been released.
+     *
+     * @param only_if_moved If set, don't send anything to Wine if the window
+     *   is still at the position we last told Wine about. Some hosts send a
+     *   constant stream of `ConfigureNotify` events, and every spoofed event
+     *   makes Wine reconfigure its window.
      */
-    void fix_local_coordinates() const;
+    void fix_local_coordinates(bool only_if_moved = false) const;
 
     /**
      * Steal or release keyboard focus. This is done whenever the user clicks on
@@ -272,6 +302,24 @@ class Editor {
      */
     void run_timer_proc();
 
+    /**
+     * Record that the user has interacted with the editor. When the
+     * `idle_frame_rate` option is set, this switches the editor back to its
+     * normal frame rate, and the editor stays at that rate until the user has
+     * stopped interacting with it for a couple of seconds.
+     */
+    void note_user_interaction() noexcept;
+
+    /**
+     * Record that the plugin has redrawn its editor. Like
+     * `note_user_interaction()`, this prevents the editor from being throttled
+     * with `idle_frame_rate`, so editors with meters or other animations keep
+     * running at their full frame rate. Redraws are detected using XDamage, so
+     * when yabridge is built without `xcb-damage` or when the X server doesn't
+     * support it, editors are throttled based on user interaction alone.
+     */
+    void note_redraw() noexcept;
+
     /**
      * Get the editor's (or, the wrapper window's) current size.
      */
@@ -326,7 +374,8 @@ class Editor {
     /**
      * Returns `true` if the currently active window (as per
      * `_NET_ACTIVE_WINDOW`) contains `wine_window_`. If the window manager does
-     * not support this hint, this will always return false.
+     * not support this hint, this will always return false. The result is
+     * cached in `is_wine_window_active_cache_`.
      *
      * @see Editor::supports_ewmh_active_window
      */
@@ -339,6 +388,25 @@ class Editor {
      */
     void redetect_host_window() noexcept;
 
+    /**
+     * Suspend or resume the editor depending on whether the editor is still
+     * visible to the user, based on `host_window_unmapped_`,
+     * `parent_window_unmapped_`, and `parent_window_obscured_`. While
+     * suspended, `idle_timer_` runs at `hidden_editor_idle_interval` and only
+     * handles X11 events so we'll notice when the window becomes visible
+     * again, and redrawing is disabled for `win32_window_` and all of its
+     * children.
+     */
+    void update_suspended() noexcept;
+
+    /**
+     * Restart `idle_timer_` if its interval should change because the editor
+     * got suspended or resumed, or because it got throttled or unthrottled
+     * when using `idle_frame_rate`. This also informs the main context about
+     * the new interval.
+     */
+    void update_idle_timer() noexcept;
+
     /**
      * Send an XEmbed message to a window. This does not include a flush. See
      * the spec for more information:
@@ -362,6 +430,13 @@ class Editor {
      */
     void do_xembed() const;
 
+    /**
+     * The main context the editor's idle timer interval gets reported to.
+     *
+     * @see MainContext::set_editor_timer_interval
+     */
+    MainContext& main_context_;
+
     /**
      * The logger instance we will print debug tracing information to.
      */
@@ -400,6 +475,23 @@ class Editor {
      */
     DeferredWin32Window win32_window_;
 
+    /**
+     * The interval for `idle_timer_` while the editor is visible. This is based
+     * on the `frame_rate` option.
+     */
+    const std::chrono::milliseconds idle_timer_interval_;
+
+    /**
+     * The interval for `idle_timer_` while the user is not interacting with
+     * the editor, if the `idle_frame_rate` option is set.
+     */
+    const std::optional<std::chrono::milliseconds>
+        throttled_idle_timer_interval_;
+    /**
+     * The interval `idle_timer_` is currently running at.
+     */
+    std::chrono::milliseconds current_idle_timer_interval_;
+
     /**
      * A timer we'll use to periodically run the X11 event loop plus
      * `idle_timer_proc_`, if that is set. We handle X11 events from within the
@@ -461,6 +553,11 @@ class Editor {
      *       the mouse is within the window.
      */
     xcb_window_t host_window_;
+    /**
+     * The root window of the screen the editor is on. Windows can't move
+     * between X11 screens, so this never changes.
+     */
+    const xcb_window_t root_window_;
 
     /**
      * Used to delay calling `fix_local_coordinates()` when dragging windows
@@ -471,6 +568,72 @@ class Editor {
      */
     bool should_fix_local_coordinates_ = false;
 
+    /**
+     * The root window coordinates last sent to Wine in
+     * `fix_local_coordinates()`. This gets reset when the Wine window is
+     * reparented, since Wine will then receive real coordinates again, and
+     * when the wrapper window is reconfigured so resizes are never skipped.
+     */
+    mutable std::optional<std::pair<int16_t, int16_t>> last_local_coordinates_;
+
+    /**
+     * Whether `host_window_` or `parent_window_` is currently unmapped. The
+     * window manager unmaps windows that are minimized or that are on another
+     * virtual desktop, and Ardour unmaps the editor window instead of closing
+     * the editor.
+     */
+    bool host_window_unmapped_ = false;
+    bool parent_window_unmapped_ = false;
+    /**
+     * Whether `parent_window_` is fully covered by other windows, based on the
+     * last `VisibilityNotify` event. Compositing window managers usually never
+     * report this.
+     */
+    bool parent_window_obscured_ = false;
+    /**
+     * Whether the editor is currently suspended because it is not visible.
+     *
+     * @see update_suspended
+     */
+    bool suspended_ = false;
+
+    /**
+     * Whether the mouse cursor is currently inside of the editor. We'll never
+     * throttle the editor while this is the case.
+     */
+    bool pointer_in_editor_ = false;
+    /**
+     * The last time `note_user_interaction()` was called.
+     */
+    std::chrono::steady_clock::time_point last_user_interaction_ =
+        std::chrono::steady_clock::now();
+    /**
+     * The last time the plugin drew to its editor, according to XDamage. If
+     * the X server does not support XDamage, then this is never updated.
+     */
+    std::chrono::steady_clock::time_point last_redraw_{};
+    /**
+     * Whether the editor is currently running at `idle_frame_rate` because the
+     * user hasn't interacted with it and the plugin hasn't redrawn its editor
+     * for a while.
+     */
+    bool throttled_ = false;
+
+#ifdef WITH_XCB_DAMAGE
+    /**
+     * The first event number used by the XDamage extension, or a nullopt if
+     * the X server doesn't support XDamage.
+     */
+    std::optional<uint8_t> damage_first_event_;
+    /**
+     * A damage object tracking `wine_window_`, used to detect when the plugin
+     * redraws its editor. We only use this as a signal for `idle_frame_rate`,
+     * so the damage is subtracted again immediately. Set to `XCB_NONE` if
+     * XDamage is not supported.
+     */
+    xcb_damage_damage_t wine_window_damage_ = XCB_NONE;
+#endif
+
     /**
      * The atom corresponding to `_NET_ACTIVE_WINDOW`.
      */
@@ -481,6 +644,20 @@ class Editor {
      * `supports_ewmh_active_window()`.
      */
     mutable std::optional<bool> supports_ewmh_active_window_cache_;
+    /**
+     * The result of the last `is_wine_window_active()` call. This gets reset
+     * at the start of every `handle_x11_events()` call, when the root window's
+     * `_NET_ACTIVE_WINDOW` property changes, or when any of the windows we're
+     * listening to get reparented.
+     */
+    mutable std::optional<bool> is_wine_window_active_cache_;
+    /**
+     * `wine_window_` and all of its ancestors, as returned by
+     * `find_ancestor_windows()`. Used in `is_wine_window_active()`, and reset
+     * whenever any of the windows we're listening to get reparented.
+     */
+    mutable std::optional<llvm::SmallVector<xcb_window_t, 8>>
+        wine_window_ancestors_cache_;
 
     /**
      * The atom corresponding to `_XEMBED`.
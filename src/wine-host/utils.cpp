@@ -16,8 +16,11 @@
 
 #include "utils.h"
 
+#include <algorithm>
 #include <iostream>
 
+#include <asio/post.hpp>
+
 #include "bridges/common.h"
 
 using namespace std::literals::chrono_literals;
@@ -50,6 +53,37 @@ Win32Thread& Win32Thread::operator=(Win32Thread&& o) noexcept {
     return *this;
 }
 
+/**
+ * The difference between two `timespec`s in nanoseconds.
+ */
+static uint64_t timespec_diff_ns(const timespec& start,
+                                 const timespec& end) noexcept {
+    return static_cast<uint64_t>(end.tv_sec - start.tv_sec) * 1'000'000'000 +
+           static_cast<uint64_t>(end.tv_nsec - start.tv_nsec);
+}
+
+ProcessTimer::ProcessTimer(bool enabled) noexcept : enabled_(enabled) {
+    if (enabled_) {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start_cpu_time_);
+        clock_gettime(CLOCK_MONOTONIC, &start_wall_time_);
+    }
+}
+
+ProcessTiming ProcessTimer::elapsed() const noexcept {
+    if (!enabled_) {
+        return ProcessTiming{};
+    }
+
+    timespec cpu_time;
+    timespec wall_time;
+    clock_gettime(CLOCK_MONOTONIC, &wall_time);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time);
+
+    return ProcessTiming{
+        .cpu_time_ns = timespec_diff_ns(start_cpu_time_, cpu_time),
+        .wall_time_ns = timespec_diff_ns(start_wall_time_, wall_time)};
+}
+
 Win32Timer::Win32Timer() noexcept {}
 
 Win32Timer::Win32Timer(HWND window_handle,
@@ -101,7 +135,8 @@ void MainContext::run() {
     } else {
         // To account for hosts terminating before the bridged plugin has
         // initialized, we'll do the first watchdog check five seconds. After
-        // this we'll run the timer on a 30 second interval.
+        // this we'll only run the timer on a 30 second interval if we
+        // couldn't use pidfds for all bridges.
         async_handle_watchdog_timer(5s);
 
         watchdog_handler_ = Win32Thread([&]() {
@@ -129,11 +164,35 @@ void MainContext::update_timer_interval(
     timer_interval_ = new_interval;
 }
 
+void MainContext::set_editor_timer_interval(
+    const void* editor,
+    std::chrono::steady_clock::duration interval) noexcept {
+    editor_timer_intervals_[editor] = interval;
+}
+
+void MainContext::remove_editor_timer_interval(const void* editor) noexcept {
+    editor_timer_intervals_.erase(editor);
+}
+
+std::chrono::steady_clock::duration MainContext::effective_timer_interval()
+    const noexcept {
+    // The editor intervals may never be longer than the base interval, since
+    // that is also used for the non-editor event handling
+    std::chrono::steady_clock::duration interval = timer_interval_;
+    for (const auto& [editor, editor_interval] : editor_timer_intervals_) {
+        interval = std::min(interval, editor_interval);
+    }
+
+    return interval;
+}
+
 MainContext::WatchdogGuard::WatchdogGuard(
     HostBridge& bridge,
     std::unordered_set<HostBridge*>& watched_bridges,
-    std::mutex& watched_bridges_mutex)
+    std::mutex& watched_bridges_mutex,
+    std::shared_ptr<asio::posix::stream_descriptor> parent_pidfd)
     : bridge_(&bridge),
+      parent_pidfd_(std::move(parent_pidfd)),
       watched_bridges_(watched_bridges),
       watched_bridges_mutex_(watched_bridges_mutex) {
     std::lock_guard lock(watched_bridges_mutex);
@@ -144,11 +203,19 @@ MainContext::WatchdogGuard::~WatchdogGuard() noexcept {
     if (is_active_) {
         std::lock_guard lock(watched_bridges_mutex_.get());
         watched_bridges_.get().erase(bridge_);
+
+        // The pidfd may only be touched from the watchdog thread. Closing it
+        // cancels the pending wait, which then frees the pidfd.
+        if (parent_pidfd_) {
+            asio::post(parent_pidfd_->get_executor(),
+                       [pidfd = parent_pidfd_]() { pidfd->close(); });
+        }
     }
 }
 
 MainContext::WatchdogGuard::WatchdogGuard(WatchdogGuard&& o) noexcept
     : bridge_(std::move(o.bridge_)),
+      parent_pidfd_(std::move(o.parent_pidfd_)),
       watched_bridges_(std::move(o.watched_bridges_)),
       watched_bridges_mutex_(std::move(o.watched_bridges_mutex_)) {
     o.is_active_ = false;
@@ -157,6 +224,7 @@ MainContext::WatchdogGuard::WatchdogGuard(WatchdogGuard&& o) noexcept
 MainContext::WatchdogGuard& MainContext::WatchdogGuard::operator=(
     WatchdogGuard&& o) noexcept {
     bridge_ = std::move(o.bridge_);
+    parent_pidfd_ = std::move(o.parent_pidfd_);
     watched_bridges_ = std::move(o.watched_bridges_);
     watched_bridges_mutex_ = std::move(o.watched_bridges_mutex_);
     o.is_active_ = false;
@@ -164,10 +232,36 @@ MainContext::WatchdogGuard& MainContext::WatchdogGuard::operator=(
     return *this;
 }
 
-MainContext::WatchdogGuard MainContext::register_watchdog(HostBridge& bridge) {
+MainContext::WatchdogGuard MainContext::register_watchdog(HostBridge& bridge,
+                                                          pid_t parent_pid) {
+    // Instead of periodically checking whether the native host is still
+    // running, we'll wait for its pidfd to become readable
+    std::shared_ptr<asio::posix::stream_descriptor> parent_pidfd;
+    if (!is_watchdog_timer_disabled()) {
+        if (const int pidfd_fd = open_pidfd(parent_pid); pidfd_fd != -1) {
+            parent_pidfd = std::make_shared<asio::posix::stream_descriptor>(
+                watchdog_context_, pidfd_fd);
+            parent_pidfd->async_wait(
+                asio::posix::stream_descriptor::wait_read,
+                [&, parent_pidfd](const std::error_code& error) {
+                    if (error) {
+                        return;
+                    }
+
+                    check_watched_bridges();
+                });
+        } else if (!poll_watchdog_.exchange(true)) {
+            // Either the kernel doesn't support pidfds or the process has
+            // already exited, so we'll need to keep the timer running
+            asio::post(watchdog_context_,
+                       [&]() { async_handle_watchdog_timer(5s); });
+        }
+    }
+
     // The guard's constructor and destructor will handle actually registering
     // and unregistering the bridge from `watched_bridges`
-    return WatchdogGuard(bridge, watched_bridges_, watched_bridges_mutex_);
+    return WatchdogGuard(bridge, watched_bridges_, watched_bridges_mutex_,
+                         std::move(parent_pidfd));
 }
 
 void MainContext::async_handle_watchdog_timer(
@@ -178,15 +272,21 @@ void MainContext::async_handle_watchdog_timer(
             return;
         }
 
-        // When the `WatchdogGuard` field on `HostBridge` gets destroyed, that
-        // bridge instance will be removed from `watched_bridges`. So if our
-        // call to `HostBridge::shutdown_if_dangling()` shuts the plugin down,
-        // the instance will be removed after this lambda exits.
-        std::lock_guard lock(watched_bridges_mutex_);
-        for (auto& bridge : watched_bridges_) {
-            bridge->shutdown_if_dangling();
-        }
+        check_watched_bridges();
 
-        async_handle_watchdog_timer(30s);
+        if (poll_watchdog_) {
+            async_handle_watchdog_timer(30s);
+        }
     });
 }
+
+void MainContext::check_watched_bridges() {
+    // When the `WatchdogGuard` field on `HostBridge` gets destroyed, that
+    // bridge instance will be removed from `watched_bridges`. So if our call
+    // to `HostBridge::shutdown_if_dangling()` shuts the plugin down, the
+    // instance will be removed after this function returns.
+    std::lock_guard lock(watched_bridges_mutex_);
+    for (auto& bridge : watched_bridges_) {
+        bridge->shutdown_if_dangling();
+    }
+}
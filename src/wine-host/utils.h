@@ -18,16 +18,21 @@
 
 #include "use-linux-asio.h"
 
+#include <time.h>
+#include <atomic>
 #include <future>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <windows.h>
 #include <asio/dispatch.hpp>
 #include <asio/io_context.hpp>
+#include <asio/posix/stream_descriptor.hpp>
 #include <function2/function2.hpp>
 
+#include "../common/serialization/common.h"
 #include "../common/utils.h"
 
 // Forward declaration for use in our watchdog in `MainContext`
@@ -74,7 +79,8 @@ class Win32Thread {
 
     /**
      * Constructor that immediately starts running the thread. This works
-     * equivalently to `std::jthread`.
+     * equivalently to `std::jthread`. The thread's stack reservation can be
+     * changed with the `YABRIDGE_THREAD_STACK_SIZE` environment variable.
      *
      * @param entry_point The thread entry point that should be run.
      * @param parameter The parameter passed to the entry point function.
@@ -83,7 +89,7 @@ class Win32Thread {
     Win32Thread(Function fn, Args... args)
         : handle_(CreateThread(
                       nullptr,
-                      0,
+                      get_thread_stack_size(),
                       reinterpret_cast<LPTHREAD_START_ROUTINE>(
                           win32_thread_trampoline),
                       // `std::function` does not support functions with move
@@ -96,7 +102,9 @@ class Win32Thread {
                            ... args = std::move(args)]() mutable {
                               f(std::move(args)...);
                           }),
-                      0,
+                      get_thread_stack_size() > 0
+                          ? STACK_SIZE_PARAM_IS_A_RESERVATION
+                          : 0,
                       nullptr),
                   CloseHandle) {}
 
@@ -121,6 +129,35 @@ class Win32Thread {
         handle_;
 };
 
+/**
+ * Measures the CPU time used by the current thread and the elapsed wall clock
+ * time between this object's construction and a call to `elapsed()`. Used to
+ * measure how long a plugin spends in its audio processing function.
+ *
+ * Reading the thread's CPU time requires a system call, so this should only be
+ * enabled when the native plugin will actually log these timings. See
+ * `HostBridge::process_timing_enabled()`.
+ */
+class ProcessTimer {
+   public:
+    /**
+     * Start the timer. If `enabled` is false, then this won't do anything and
+     * `elapsed()` will return zeroes.
+     */
+    explicit ProcessTimer(bool enabled) noexcept;
+
+    /**
+     * Return the CPU time and wall clock time since this object was created.
+     * This should be called from the same thread the object was created on.
+     */
+    ProcessTiming elapsed() const noexcept;
+
+   private:
+    bool enabled_;
+    timespec start_cpu_time_{};
+    timespec start_wall_time_{};
+};
+
 /**
  * A simple RAII wrapper around `SetTimer`. Does not support timer procs since
  * we don't use them.
@@ -156,7 +193,9 @@ class Win32Timer {
  * a watchdog to shutdown a plugin instance's sockets when the process that
  * spawned it is no longer active. This approach also works with plugin groups
  * since closing a plugin's sockets will only cause that one plugin to
- * terminate.
+ * terminate. The native host processes are watched through pidfds registered
+ * with that IO context, so the watchdog thread only wakes up when one of those
+ * processes has actually exited.
  */
 class MainContext {
    public:
@@ -182,15 +221,43 @@ class MainContext {
     void update_timer_interval(
         std::chrono::steady_clock::duration new_interval) noexcept;
 
+    /**
+     * Set the interval a plugin editor's idle timer is currently running at.
+     * Win32 timers only fire while the message loop is being pumped, so while
+     * any editors are open the event loop runs at the shortest of these
+     * intervals if that is shorter than the interval set with
+     * `update_timer_interval()`. This way a single editor running at a high
+     * frame rate no longer depends on which plugin happened to be loaded last.
+     * Editors running at a lower frame rate never slow down the event loop
+     * itself, since that also handles events for the rest of the process. Must
+     * be called from the GUI thread.
+     *
+     * @param editor The editor, used only to identify it.
+     * @param interval The editor's current timer interval.
+     *
+     * @see remove_editor_timer_interval
+     */
+    void set_editor_timer_interval(
+        const void* editor,
+        std::chrono::steady_clock::duration interval) noexcept;
+
+    /**
+     * Stop considering an editor's timer interval. This should be called when
+     * the editor gets closed. Must be called from the GUI thread.
+     */
+    void remove_editor_timer_interval(const void* editor) noexcept;
+
     /**
      * The RAII guard used to register and unregister host bridge instances from
      * our watchdog.
      */
     class WatchdogGuard {
        public:
-        WatchdogGuard(HostBridge& bridge,
-                      std::unordered_set<HostBridge*>& watched_bridges,
-                      std::mutex& watched_bridges_mutex);
+        WatchdogGuard(
+            HostBridge& bridge,
+            std::unordered_set<HostBridge*>& watched_bridges,
+            std::mutex& watched_bridges_mutex,
+            std::shared_ptr<asio::posix::stream_descriptor> parent_pidfd);
         ~WatchdogGuard() noexcept;
 
         WatchdogGuard(const WatchdogGuard&) = delete;
@@ -212,6 +279,13 @@ class MainContext {
          */
         HostBridge* bridge_;
 
+        /**
+         * A pidfd for the bridge's native host process, or a null pointer if
+         * we could not open one and the watchdog has to fall back to polling.
+         * This is closed again when the guard gets dropped.
+         */
+        std::shared_ptr<asio::posix::stream_descriptor> parent_pidfd_;
+
         // References to the same two fields on `MainContext`, so we don't have
         // to use `friend`
         std::reference_wrapper<std::unordered_set<HostBridge*>>
@@ -220,14 +294,16 @@ class MainContext {
     };
 
     /**
-     * Register a bridge instance for our watchdog. We'll periodically check if
-     * the remote (native) host process that should be connected to the bridge
-     * instance is still alive, and we'll shut down the bridge if it is not to
-     * prevent dangling processes. The returned guard should be stored as a
-     * field in `HostBridge`, and the watchdog will automatically be
-     * unregistered once this guard drops from scope.
+     * Register a bridge instance for our watchdog. We'll check if the remote
+     * (native) host process that should be connected to the bridge instance is
+     * still alive when `parent_pid` exits, and we'll shut down the bridge if it
+     * is not to prevent dangling processes. If we cannot open a pidfd for the
+     * process, then we'll fall back to checking this periodically. The
+     * returned guard should be stored as a field in `HostBridge`, and the
+     * watchdog will automatically be unregistered once this guard drops from
+     * scope.
      */
-    WatchdogGuard register_watchdog(HostBridge& bridge);
+    WatchdogGuard register_watchdog(HostBridge& bridge, pid_t parent_pid);
 
     /**
      * Returns `true` if the calling thread is the GUI thread, aka the thread
@@ -284,9 +360,11 @@ class MainContext {
     void async_handle_events(F handler, P predicate) {
         // Try to keep a steady framerate, but add in delays to let other events
         // get handled if the GUI message handling somehow takes very long.
+        const std::chrono::steady_clock::duration interval =
+            effective_timer_interval();
         events_timer_.expires_at(
-            std::max(events_timer_.expiry() + timer_interval_,
-                     std::chrono::steady_clock::now() + timer_interval_ / 4));
+            std::max(events_timer_.expiry() + interval,
+                     std::chrono::steady_clock::now() + interval / 4));
         events_timer_.async_wait(
             [&, handler, predicate](const std::error_code& error) {
                 if (error) {
@@ -309,8 +387,17 @@ class MainContext {
 
    private:
     /**
-     * Start a timer to periodically check whether the host processes belong to
-     * all active plugin bridges are still alive. We will shut down the plugin
+     * The interval `async_handle_events()` should currently run at. This is
+     * the shortest of `timer_interval_` and the timer intervals of all open
+     * editors.
+     */
+    std::chrono::steady_clock::duration effective_timer_interval()
+        const noexcept;
+
+    /**
+     * Start a timer to check whether the host processes belong to all active
+     * plugin bridges are still alive. This is only repeated while there are
+     * bridges we could not open a pidfd for. We will shut down the plugin
      * instances where this is not the case, so that this process can gracefully
      * terminate. In some cases Unix Domain Sockets are left in a state where
      * it's impossible to tell that the remote isn't alive anymore, and where
@@ -319,6 +406,12 @@ class MainContext {
     void async_handle_watchdog_timer(
         std::chrono::steady_clock::duration interval);
 
+    /**
+     * Call `HostBridge::shutdown_if_dangling()` on all watched bridges. Called
+     * from the watchdog thread.
+     */
+    void check_watched_bridges();
+
     /**
      * The **Windows** thread ID the context is running on, which will be our
      * GUI thread. Will be a nullopt until `MainContext::run()` has been called.
@@ -340,6 +433,15 @@ class MainContext {
     std::chrono::steady_clock::duration timer_interval_ =
         std::chrono::milliseconds(1000) / 60;
 
+    /**
+     * The current idle timer intervals for all open editors. Only accessed
+     * from the GUI thread.
+     *
+     * @see set_editor_timer_interval
+     */
+    std::unordered_map<const void*, std::chrono::steady_clock::duration>
+        editor_timer_intervals_;
+
     /**
      * The IO context used for the watchdog described below.
      */
@@ -361,6 +463,13 @@ class MainContext {
     std::unordered_set<HostBridge*> watched_bridges_;
     std::mutex watched_bridges_mutex_;
 
+    /**
+     * Set when we could not open a pidfd for one of the watched bridges'
+     * native host processes. Those can only be checked by polling, so the
+     * watchdog timer will keep running from that point onwards.
+     */
+    std::atomic_bool poll_watchdog_ = false;
+
     /**
      * The thread where we run our watchdog timer, to shut down plugins after
      * the native plugin host process they're supposed to be connected to has